@@ -0,0 +1,10 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef APP_AZURE_IOT_CONFIG_H
+#define APP_AZURE_IOT_CONFIG_H
+
+// The Azure IoT configuration of the project, for the host build. Nothing of it is used on the host.
+
+#endif // APP_AZURE_IOT_CONFIG_H
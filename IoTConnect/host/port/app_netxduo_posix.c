@@ -0,0 +1,76 @@
+//
+// Copyright: Avnet 2023
+//
+
+// The part of NetXDuo/App/app_netxduo.c that starts the app, for the host build of iotconnect_app.c.
+// The network is the one of the host and its clock is synced, so app_startup() runs right away on a thread
+// of its own. There is no cloud on the host (see iotconnect.h), so it initializes everything and then keeps
+// retrying the connection, with the samples going to the journal.
+//
+// Usage: rot_sample_app <cpid> <env> <duid> [symmetric key]
+// Without a symmetric key, the app authenticates with the PSA auth driver, which has no device identity on the
+// host, so app_startup() fails.
+
+#include <stdio.h>
+#include <string.h>
+#include "tx_api.h"
+#include "nx_api.h"
+#include "nxd_dns.h"
+#include "nx_azure_iot_adu_agent_psa_driver.h"
+#include "boot_phases.h"
+#include "metadata.h"
+
+#define APP_THREAD_PRIORITY 4
+
+extern bool app_startup(NX_IP *ip_ptr, NX_PACKET_POOL *pool_ptr, NX_DNS *dns_ptr);
+
+static NX_IP ip;
+static NX_PACKET_POOL pool;
+static NX_DNS dns;
+static TX_THREAD app_thread;
+static TX_SEMAPHORE app_done;
+
+// The firmware driver of the project, on the PSA update port
+void nx_azure_iot_adu_agent_ns_driver(NX_AZURE_IOT_ADU_AGENT_DRIVER *driver_req_ptr) {
+    static nx_azure_iot_adu_agent_psa_driver_context_t ctx = {.active_image_id = 0x0101, .download_image_id = 0x0102};
+    nx_azure_iot_adu_agent_psa_driver(driver_req_ptr, &ctx);
+}
+
+static void app_thread_entry(ULONG input) {
+    (void) input;
+    app_startup(&ip, &pool, &dns);
+    tx_semaphore_put(&app_done);
+}
+
+static void copy_setting(char *setting, size_t size, const char *value) {
+    strncpy(setting, value, size - 1);
+    setting[size - 1] = 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        printf("Usage: %s <cpid> <env> <duid> [symmetric key]\n", argv[0]);
+        return 2;
+    }
+    metadata_storage *md = metadata_get_values();
+    copy_setting(md->cpid, sizeof(md->cpid), argv[1]);
+    copy_setting(md->env, sizeof(md->env), argv[2]);
+    copy_setting(md->duid, sizeof(md->duid), argv[3]);
+    copy_setting(md->symmetric_key, sizeof(md->symmetric_key), argc > 4 ? argv[4] : "");
+
+    if (boot_phases_init() || nx_dns_create(&dns, &ip, NULL)
+            || tx_semaphore_create(&app_done, "App Done", 0)) {
+        printf("Failed to initialize\n");
+        return 1;
+    }
+    boot_phases_mark(BOOT_PHASE_IP_ADDRESS);
+    boot_phases_mark(BOOT_PHASE_DNS_READY);
+    boot_phases_mark(BOOT_PHASE_TIME_SYNCED);
+    if (tx_thread_create(&app_thread, "App", app_thread_entry, 0, NULL, 0, APP_THREAD_PRIORITY,
+            APP_THREAD_PRIORITY, TX_NO_TIME_SLICE, TX_AUTO_START)) {
+        printf("Failed to start the app thread\n");
+        return 1;
+    }
+    tx_semaphore_get(&app_done, TX_WAIT_FOREVER);
+    return 1; // app_startup() returns on errors only
+}
@@ -0,0 +1,38 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "app_platform.h"
+
+// app_platform.h for the host build. The "cycles" are nanoseconds of the monotonic clock, so that profiles
+// taken on the host read in the same unit as on the device with app_platform_cycles_per_us().
+
+uint32_t app_platform_time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) ((uint64_t) ts.tv_sec * 1000 + (uint64_t) ts.tv_nsec / 1000000);
+}
+
+void app_platform_sleep_ms(uint32_t ms) {
+    struct timespec ts = {(time_t) (ms / 1000), (long) (ms % 1000) * 1000000L};
+    while (0 != nanosleep(&ts, &ts)) {
+    }
+}
+
+uint32_t app_platform_cycles(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) ((uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec);
+}
+
+uint32_t app_platform_cycles_per_us(void) {
+    return 1000;
+}
+
+void app_platform_reset(void) {
+    fflush(NULL);
+    exit(EXIT_SUCCESS);
+}
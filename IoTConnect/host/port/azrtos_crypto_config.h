@@ -0,0 +1,28 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef AZRTOS_CRYPTO_CONFIG_H
+#define AZRTOS_CRYPTO_CONFIG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The crypto configuration of the SDK that an auth driver hands to the TLS setup, for the host build.
+// Only the custom ECDSA method that the driver fills in is kept, as there is no TLS on the host.
+
+#include "nx_crypto.h"
+#include "nx_secure_tls_api.h"
+
+typedef struct {
+    NX_CRYPTO_METHOD custom_crypto_method_storage;
+} IotcAzccCryptoConfig;
+
+int iotcazcc_init_with_ec_curve_secp256(IotcAzccCryptoConfig *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AZRTOS_CRYPTO_CONFIG_H
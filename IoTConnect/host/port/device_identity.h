@@ -0,0 +1,28 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef DEVICE_IDENTITY_H
+#define DEVICE_IDENTITY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The device identity of the project, for the host build. On the device, the certificate is read from the
+// secure side and the key is the ID of a PSA key. On the host, a test provides both.
+
+#include "nx_api.h"
+
+UINT device_identity_retrieve_credentials(const UCHAR **cert, UINT *cert_size, const UCHAR **key, UINT *key_size);
+
+// Sets the certificate and the PSA key ID that device_identity_retrieve_credentials() answers, and counts
+// the calls. Without a certificate, it fails like the device without a provisioned identity.
+void device_identity_host_set(const UCHAR *cert, UINT cert_size, uint32_t key_id);
+unsigned int device_identity_host_retrievals(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DEVICE_IDENTITY_H
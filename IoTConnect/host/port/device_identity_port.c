@@ -0,0 +1,79 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include "device_identity.h"
+#include "nx_crypto.h"
+
+static const UCHAR *identity_cert;
+static UINT identity_cert_size;
+static uint32_t identity_key_id;
+static unsigned int retrievals;
+
+void device_identity_host_set(const UCHAR *cert, UINT cert_size, uint32_t key_id) {
+    identity_cert = cert;
+    identity_cert_size = cert_size;
+    identity_key_id = key_id;
+}
+
+unsigned int device_identity_host_retrievals(void) {
+    return retrievals;
+}
+
+UINT device_identity_retrieve_credentials(const UCHAR **cert, UINT *cert_size, const UCHAR **key, UINT *key_size) {
+    retrievals++;
+    if (NULL == identity_cert) {
+        return NX_NOT_SUCCESSFUL;
+    }
+    *cert = identity_cert;
+    *cert_size = identity_cert_size;
+    *key = (const UCHAR *) &identity_key_id;
+    *key_size = sizeof(identity_key_id);
+    return NX_SUCCESS;
+}
+
+// The ECDSA method of the project signs with the PSA key in the secure image. There is no TLS on the host to
+// call it, and no key to sign with.
+static UINT ecdsa_psa_init(NX_CRYPTO_METHOD *method, UCHAR *key, NX_CRYPTO_KEY_SIZE key_size_in_bits,
+        VOID **handler, VOID *crypto_metadata, ULONG crypto_metadata_size) {
+    (void) method;
+    (void) key;
+    (void) key_size_in_bits;
+    (void) handler;
+    (void) crypto_metadata;
+    (void) crypto_metadata_size;
+    return NX_CRYPTO_SUCCESS;
+}
+
+static UINT ecdsa_psa_cleanup(VOID *crypto_metadata) {
+    (void) crypto_metadata;
+    return NX_CRYPTO_SUCCESS;
+}
+
+static UINT ecdsa_psa_operation(UINT op, VOID *handle, NX_CRYPTO_METHOD *method, UCHAR *key,
+        NX_CRYPTO_KEY_SIZE key_size_in_bits, UCHAR *input, ULONG input_length_in_byte, UCHAR *iv_ptr,
+        UCHAR *output, ULONG output_length_in_byte, VOID *crypto_metadata, ULONG crypto_metadata_size,
+        VOID *packet_ptr, VOID (*nx_crypto_hw_process_callback)(VOID *, UINT)) {
+    (void) op;
+    (void) handle;
+    (void) method;
+    (void) key;
+    (void) key_size_in_bits;
+    (void) input;
+    (void) input_length_in_byte;
+    (void) iv_ptr;
+    (void) output;
+    (void) output_length_in_byte;
+    (void) crypto_metadata;
+    (void) crypto_metadata_size;
+    (void) packet_ptr;
+    (void) nx_crypto_hw_process_callback;
+    return NX_CRYPTO_NOT_SUCCESSFUL;
+}
+
+NX_CRYPTO_METHOD crypto_method_ecdsa_psa_crypto = {
+    0,
+    ecdsa_psa_init,
+    ecdsa_psa_cleanup,
+    ecdsa_psa_operation
+};
@@ -0,0 +1,12 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef IOTC_ALGORITHMS_H
+#define IOTC_ALGORITHMS_H
+
+// The sizes of the SDK ECDSA helpers that the PSA auth driver uses, for the host build
+
+#define TO_SIGNATURE_SIZE   64 // r and s of secp256r1, 32 bytes each
+
+#endif // IOTC_ALGORITHMS_H
@@ -0,0 +1,44 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef IOTC_AUTH_DRIVER_H
+#define IOTC_AUTH_DRIVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The auth driver interfaces of the SDK, for the host build: the X.509 identity that the connection asks for,
+// and the dynamic device identity (DDIM) calls that get an operational certificate from IoTConnect.
+
+#include <stddef.h>
+#include <stdint.h>
+#include "azrtos_crypto_config.h"
+
+#define IOTC_COMMON_NAME_MAX_LEN    64
+
+typedef void *IotcAuthInterfaceContext;
+
+typedef struct {
+    int (*get_serial)(IotcAuthInterfaceContext context, uint8_t *serial, size_t *size);
+    int (*get_cert)(IotcAuthInterfaceContext context, uint8_t **cert, size_t *cert_size);
+    int (*get_private_key)(IotcAuthInterfaceContext context, uint8_t **key, size_t *key_size);
+    IotcAzccCryptoConfig *(*get_crypto_config)(IotcAuthInterfaceContext context);
+    unsigned int (*get_azrtos_private_key_type)(IotcAuthInterfaceContext context);
+} IotcAuthInterface;
+
+typedef struct {
+    int (*get_bootstrap_cert)(IotcAuthInterfaceContext context, uint8_t **cert, size_t *cert_size);
+    int (*generate_csr)(IotcAuthInterfaceContext context, const char *cn, uint8_t **csr, size_t *len);
+    int (*sign_hash)(IotcAuthInterfaceContext context, uint8_t *input_hash, uint8_t *output);
+    char *(*extract_bootstrap_cn)(IotcAuthInterfaceContext context);
+    char *(*extract_operational_cn)(IotcAuthInterfaceContext context);
+    int (*store_operational_cert)(IotcAuthInterfaceContext context, uint8_t *cert, size_t cert_len);
+} IotcDdimInterface;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTC_AUTH_DRIVER_H
@@ -0,0 +1,55 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "iotconnect.h"
+#include "azrtos_crypto_config.h"
+#include "std_component.h"
+
+static IotConnectClientConfig config;
+
+IotConnectClientConfig *iotconnect_sdk_init_and_get_config(void) {
+    memset(&config, 0, sizeof(config));
+    return &config;
+}
+
+int iotconnect_sdk_init(IotConnectAzrtosConfig *azrtos_config) {
+    (void) azrtos_config;
+    printf("No IoTConnect cloud on the host\r\n");
+    return -1;
+}
+
+bool iotconnect_sdk_is_connected(void) {
+    return false;
+}
+
+void iotconnect_sdk_poll(int wait_time_ms) {
+    tx_thread_sleep((ULONG) wait_time_ms * TX_TIMER_TICKS_PER_SECOND / 1000);
+}
+
+void iotconnect_sdk_send_packet(const char *data) {
+    (void) data;
+}
+
+int iotcazcc_init_with_ec_curve_secp256(IotcAzccCryptoConfig *crypto_config) {
+    memset(crypto_config, 0, sizeof(*crypto_config));
+    return 0;
+}
+
+UINT std_component_init(STD_COMPONENT *handle, UCHAR *component_name, UINT component_name_length) {
+    memset(handle, 0, sizeof(*handle));
+    handle->component_name = component_name;
+    handle->component_name_length = component_name_length;
+    return NX_AZURE_IOT_SUCCESS;
+}
+
+UINT std_component_read_sensor_values(STD_COMPONENT *handle) {
+    handle->Temperature = STD_COMPONENT_HOST_TEMPERATURE;
+    return NX_AZURE_IOT_SUCCESS;
+}
+
+void std_component_on_button_pushed(STD_COMPONENT *handle) {
+    handle->ButtonCounter++;
+}
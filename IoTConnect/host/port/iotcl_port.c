@@ -0,0 +1,67 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "iotconnect_lib.h"
+
+static IotclConfig config = {
+    {"avtds", "poc", "stm32h5-0123456789"},
+    {"5a2b3c4d-0000-4000-8000-0123456789ab"}
+};
+
+IotclConfig *iotcl_get_config(void) {
+    return &config;
+}
+
+struct IotclEventDataTag {
+    char *command;
+    char *url;
+    char *sw_version;
+};
+
+static char *clone(const char *s) {
+    return s ? strdup(s) : NULL;
+}
+
+IotclEventData iotcl_host_event_create(const char *command, const char *url, const char *sw_version) {
+    IotclEventData data = (IotclEventData) calloc(1, sizeof(*data));
+    if (NULL == data) {
+        return NULL;
+    }
+    data->command = clone(command);
+    data->url = clone(url);
+    data->sw_version = clone(sw_version);
+    return data;
+}
+
+char *iotcl_clone_command(IotclEventData data) {
+    return clone(data->command);
+}
+
+char *iotcl_clone_download_url(IotclEventData data, size_t index) {
+    return 0 == index ? clone(data->url) : NULL;
+}
+
+char *iotcl_clone_sw_version(IotclEventData data) {
+    return clone(data->sw_version);
+}
+
+// The ack has only the status and the message of the library's ack
+char *iotcl_create_ack_string_and_destroy_event(IotclEventData data, bool success, const char *message) {
+    const char *format = "{\"d\":{\"st\":%d,\"msg\":\"%s\"}}";
+    const int st = success ? 7 : 4;
+    const char *msg = message ? message : "";
+    const int length = snprintf(NULL, 0, format, st, msg);
+    char *ack = (char *) malloc((size_t) length + 1);
+    if (ack) {
+        snprintf(ack, (size_t) length + 1, format, st, msg);
+    }
+    free(data->command);
+    free(data->url);
+    free(data->sw_version);
+    free(data);
+    return ack;
+}
@@ -0,0 +1,69 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef IOTCONNECT_H
+#define IOTCONNECT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The IoTConnect client of the SDK, for the host build. There is no cloud on the host: iotconnect_sdk_init()
+// fails as if the cloud could not be reached, so the app keeps the samples in its journal and retries.
+// That is enough to build and start app_startup() on the host.
+
+#include <stdbool.h>
+#include "nx_api.h"
+#include "nxd_dns.h"
+#include "iotconnect_common.h"
+#include "iotconnect_lib.h"
+#include "iotc_auth_driver.h"
+
+typedef enum {
+    IOTC_KEY = 1,
+    IOTC_X509
+} IotConnectAuthType;
+
+typedef void (*IotConnectStatusCallback)(IotConnectConnectionStatus data);
+typedef void (*IotclOtaCallback)(IotclEventData data);
+typedef void (*IotclCommandCallback)(IotclEventData data);
+
+typedef struct {
+    IotConnectAuthType type;
+    union {
+        char *symmetric_key;
+        struct {
+            IotcAuthInterface auth_interface;
+            IotcAuthInterfaceContext auth_interface_context;
+        } x509;
+    } data;
+} IotConnectAuthInfo;
+
+typedef struct {
+    char *env;
+    char *cpid;
+    char *duid;
+    IotConnectAuthInfo auth;
+    IotclOtaCallback ota_cb;
+    IotclCommandCallback cmd_cb;
+    IotConnectStatusCallback status_cb;
+} IotConnectClientConfig;
+
+typedef struct {
+    NX_IP *ip_ptr;
+    NX_PACKET_POOL *pool_ptr;
+    NX_DNS *dns_ptr;
+} IotConnectAzrtosConfig;
+
+IotConnectClientConfig *iotconnect_sdk_init_and_get_config(void);
+int iotconnect_sdk_init(IotConnectAzrtosConfig *azrtos_config);
+bool iotconnect_sdk_is_connected(void);
+void iotconnect_sdk_poll(int wait_time_ms);
+void iotconnect_sdk_send_packet(const char *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTCONNECT_H
@@ -0,0 +1,16 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef IOTCONNECT_COMMON_H
+#define IOTCONNECT_COMMON_H
+
+// The connection states that the SDK reports to the app, for the host build
+
+typedef enum {
+    MQTT_CONNECTED,
+    MQTT_DISCONNECTED,
+    MQTT_FAILED
+} IotConnectConnectionStatus;
+
+#endif // IOTCONNECT_COMMON_H
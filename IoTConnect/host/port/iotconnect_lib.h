@@ -0,0 +1,48 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef IOTCONNECT_LIB_H
+#define IOTCONNECT_LIB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The part of the iotc-c-lib configuration that the telemetry writer reads, for the host build.
+// iotcl_port.c holds one configuration, which tests can change through iotcl_get_config().
+// And the event calls of the app's OTA and command handlers, on events that a test makes with
+// iotcl_host_event_create().
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+    struct {
+        const char *cpid;
+        const char *env;
+        const char *duid;
+    } device;
+    struct {
+        const char *dtg;
+    } telemetry;
+} IotclConfig;
+
+IotclConfig *iotcl_get_config(void);
+
+typedef struct IotclEventDataTag *IotclEventData;
+
+// Any of the strings can be NULL. The event is released by the ack.
+IotclEventData iotcl_host_event_create(const char *command, const char *url, const char *sw_version);
+
+// The clones are allocated with malloc(), as in the library
+char *iotcl_clone_command(IotclEventData data);
+char *iotcl_clone_download_url(IotclEventData data, size_t index);
+char *iotcl_clone_sw_version(IotclEventData data);
+char *iotcl_create_ack_string_and_destroy_event(IotclEventData data, bool success, const char *message);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IOTCONNECT_LIB_H
@@ -0,0 +1,112 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef NX_API_H
+#define NX_API_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The subset of the NetX Duo API that the app modules use, for the host build: packets from the heap and
+// UDP sockets on POSIX sockets. Addresses and ports are in host byte order, as in NetX. The TCP connections
+// of the Web HTTP client are in nx_web_http_client.h.
+
+#include "tx_api.h"
+
+#define NX_SUCCESS              0x00
+#define NX_NO_PACKET            0x01
+#define NX_INVALID_PACKET       0x12
+#define NX_NO_PACKET_AVAILABLE  NX_NO_PACKET
+#define NX_NOT_BOUND            0x24
+#define NX_NO_FREE_PORTS        0x45
+#define NX_NOT_SUCCESSFUL       0x43
+#define NX_NOT_CONNECTED        0x38
+#define NX_NULL                 0
+#define NX_TRUE                 1
+#define NX_FALSE                0
+#define NX_SIZE_ERROR           0x09
+#define NX_OVERFLOW             0x03
+#define NX_INVALID_PARAMETERS   0x4D
+#define NX_PTR_ERROR            0x07
+#define NX_IP_PERIODIC_RATE     TX_TIMER_TICKS_PER_SECOND
+#define NX_UDP_PACKET           44
+#define NX_IP_NORMAL            0x00000000UL
+#define NX_FRAGMENT_OKAY        0x00000000UL
+#define NX_IP_TIME_TO_LIVE      0x80
+#define NX_ANY_PORT             0
+#define NX_IP_VERSION_V4        0x4
+
+#ifndef NX_PACKET_PAYLOAD_SIZE
+#define NX_PACKET_PAYLOAD_SIZE  1536
+#endif
+
+#define NX_PARAMETER_NOT_USED(p) ((void) (p))
+
+#define IP_ADDRESS(a, b, c, d)  ((((ULONG) (a)) << 24) | (((ULONG) (b)) << 16) | (((ULONG) (c)) << 8) | ((ULONG) (d)))
+
+typedef struct NX_IP_STRUCT {
+    // Host only: UDP sends go to this port instead of the one given, so that a test can run a
+    // server for a well known port, like DNS on 53, without privileges. 0 keeps the port.
+    UINT host_udp_port_override;
+    // Host only: the same for TCP connections, like HTTPS on 443
+    UINT host_tcp_port_override;
+} NX_IP;
+
+typedef struct NXD_ADDRESS_STRUCT {
+    ULONG nxd_ip_version;
+    union {
+        ULONG v4;
+    } nxd_ip_address;
+} NXD_ADDRESS;
+
+// A pool with a total of 0 does not count its packets
+typedef struct NX_PACKET_POOL_STRUCT {
+    ULONG nx_packet_pool_total;
+    ULONG nx_packet_pool_available;
+    ULONG nx_packet_pool_empty_requests;
+} NX_PACKET_POOL;
+
+typedef struct NX_PACKET_STRUCT {
+    NX_PACKET_POOL *pool;
+    ULONG nx_packet_length;
+    UCHAR data[NX_PACKET_PAYLOAD_SIZE];
+} NX_PACKET;
+
+typedef struct NX_UDP_SOCKET_STRUCT {
+    NX_IP *ip;
+    int fd;
+    CHAR *name;
+} NX_UDP_SOCKET;
+
+UINT nx_packet_allocate(NX_PACKET_POOL *pool_ptr, NX_PACKET **packet_ptr, ULONG packet_type, ULONG wait_option);
+UINT nx_packet_data_append(NX_PACKET *packet_ptr, VOID *data_start, ULONG data_size, NX_PACKET_POOL *pool_ptr,
+        ULONG wait_option);
+UINT nx_packet_data_retrieve(NX_PACKET *packet_ptr, VOID *buffer_start, ULONG *bytes_copied);
+UINT nx_packet_data_extract_offset(NX_PACKET *packet_ptr, ULONG offset, VOID *buffer_start, ULONG buffer_length,
+        ULONG *bytes_copied);
+UINT nx_packet_length_get(NX_PACKET *packet_ptr, ULONG *length);
+UINT nx_packet_release(NX_PACKET *packet_ptr);
+UINT nx_packet_pool_info_get(NX_PACKET_POOL *pool_ptr, ULONG *total_packets, ULONG *free_packets,
+        ULONG *empty_pool_requests, ULONG *empty_pool_suspensions, ULONG *invalid_packet_releases);
+
+UINT nx_udp_socket_create(NX_IP *ip_ptr, NX_UDP_SOCKET *socket_ptr, CHAR *name, ULONG type_of_service,
+        ULONG fragment, UINT time_to_live, ULONG queue_maximum);
+UINT nx_udp_socket_bind(NX_UDP_SOCKET *socket_ptr, UINT port, ULONG wait_option);
+UINT nx_udp_socket_unbind(NX_UDP_SOCKET *socket_ptr);
+UINT nx_udp_socket_delete(NX_UDP_SOCKET *socket_ptr);
+// Releases the packet on success, like NetX
+UINT nx_udp_socket_send(NX_UDP_SOCKET *socket_ptr, NX_PACKET *packet_ptr, ULONG ip_address, UINT port);
+UINT nx_udp_socket_receive(NX_UDP_SOCKET *socket_ptr, NX_PACKET **packet_ptr, ULONG wait_option);
+
+// The NetX utilities that the ADU driver uses
+UINT _nx_utility_base64_decode(UCHAR *base64name, UINT base64name_size, UCHAR *name, UINT name_size,
+        UINT *bytes_copied);
+UINT _nx_utility_string_to_uint(CHAR *input_string, UINT string_length, UINT *number);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NX_API_H
@@ -0,0 +1,45 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef NX_AZURE_IOT_ADU_AGENT_H
+#define NX_AZURE_IOT_ADU_AGENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The driver interface of the Azure IoT ADU agent, for the host build: the request that the agent, or the
+// IoTConnect OTA download, passes to the firmware driver.
+
+#include "nx_api.h"
+
+#define NX_AZURE_IOT_SUCCESS                        0x0
+#define NX_AZURE_IOT_FAILURE                        0x20001
+
+#define NX_AZURE_IOT_ADU_AGENT_DRIVER_INITIALIZE    0
+#define NX_AZURE_IOT_ADU_AGENT_DRIVER_UPDATE_CHECK  1
+#define NX_AZURE_IOT_ADU_AGENT_DRIVER_PREPROCESS    2
+#define NX_AZURE_IOT_ADU_AGENT_DRIVER_WRITE         3
+#define NX_AZURE_IOT_ADU_AGENT_DRIVER_INSTALL       4
+#define NX_AZURE_IOT_ADU_AGENT_DRIVER_APPLY         5
+
+typedef struct NX_AZURE_IOT_ADU_AGENT_DRIVER_STRUCT {
+    UINT nx_azure_iot_adu_agent_driver_command;
+    const UCHAR *nx_azure_iot_adu_agent_driver_installed_criteria;
+    UINT nx_azure_iot_adu_agent_driver_installed_criteria_length;
+    UINT nx_azure_iot_adu_agent_driver_firmware_size;
+    const UCHAR *nx_azure_iot_adu_agent_driver_firmware_sha256;
+    UINT nx_azure_iot_adu_agent_driver_firmware_sha256_length;
+    UINT nx_azure_iot_adu_agent_driver_firmware_data_offset;
+    UCHAR *nx_azure_iot_adu_agent_driver_firmware_data_ptr;
+    UINT nx_azure_iot_adu_agent_driver_firmware_data_size;
+    ULONG *nx_azure_iot_adu_agent_driver_return_ptr;
+    UINT nx_azure_iot_adu_agent_driver_status;
+} NX_AZURE_IOT_ADU_AGENT_DRIVER;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NX_AZURE_IOT_ADU_AGENT_H
@@ -0,0 +1,38 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef NX_AZURE_IOT_ADU_AGENT_PSA_DRIVER_H
+#define NX_AZURE_IOT_ADU_AGENT_PSA_DRIVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The header of the PSA firmware driver of the ST package, for the host build of
+// NetXDuo/App/nx_azure_iot_adu_agent_psa_driver.c: the driver context and the flash programming unit.
+
+#include <string.h>
+#include "nx_azure_iot_adu_agent.h"
+#include "psa/update.h"
+
+#define FLASH0_PROG_UNIT    PSA_FWU_PORT_PROG_UNIT
+
+typedef struct {
+    psa_image_id_t active_image_id;
+    psa_image_id_t download_image_id;
+    UINT firmware_size_total;
+    UINT firmware_size_count;
+    UINT write_buffer_count;
+    UCHAR sha256[PSA_FWU_MAX_DIGEST_SIZE + 1];  // and the terminator of the base64 decoder
+    UINT sha256_size;
+} nx_azure_iot_adu_agent_psa_driver_context_t;
+
+void nx_azure_iot_adu_agent_psa_driver(NX_AZURE_IOT_ADU_AGENT_DRIVER *driver_req_ptr,
+        nx_azure_iot_adu_agent_psa_driver_context_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NX_AZURE_IOT_ADU_AGENT_PSA_DRIVER_H
@@ -0,0 +1,13 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef NX_AZURE_IOT_CIPHERSUITES_H
+#define NX_AZURE_IOT_CIPHERSUITES_H
+
+// The TLS cipher suites of the Azure IoT middleware, for the host build: the crypto method types only,
+// as there is no TLS on the host.
+
+#include "nx_crypto.h"
+
+#endif // NX_AZURE_IOT_CIPHERSUITES_H
@@ -0,0 +1,40 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef NX_CRYPTO_H
+#define NX_CRYPTO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The NetX crypto method table, for the host build: the entry points that the PSA auth driver takes over from
+// the ECDSA method of the project and wraps for the auth profiler. There are no crypto methods on the host.
+
+#include <string.h>
+#include "nx_api.h"
+
+#define NX_CRYPTO_SUCCESS           0x00
+#define NX_CRYPTO_NOT_SUCCESSFUL    0x20001
+
+#define NX_CRYPTO_MEMCPY            memcpy
+
+typedef UINT NX_CRYPTO_KEY_SIZE;
+
+typedef struct NX_CRYPTO_METHOD_STRUCT {
+    UINT nx_crypto_algorithm;
+    UINT (*nx_crypto_init)(struct NX_CRYPTO_METHOD_STRUCT *method, UCHAR *key, NX_CRYPTO_KEY_SIZE key_size_in_bits,
+            VOID **handler, VOID *crypto_metadata, ULONG crypto_metadata_size);
+    UINT (*nx_crypto_cleanup)(VOID *crypto_metadata);
+    UINT (*nx_crypto_operation)(UINT op, VOID *handle, struct NX_CRYPTO_METHOD_STRUCT *method, UCHAR *key,
+            NX_CRYPTO_KEY_SIZE key_size_in_bits, UCHAR *input, ULONG input_length_in_byte, UCHAR *iv_ptr,
+            UCHAR *output, ULONG output_length_in_byte, VOID *crypto_metadata, ULONG crypto_metadata_size,
+            VOID *packet_ptr, VOID (*nx_crypto_hw_process_callback)(VOID *, UINT));
+} NX_CRYPTO_METHOD;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NX_CRYPTO_H
@@ -0,0 +1,335 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "nx_api.h"
+#include "nxd_dns.h"
+
+UINT nx_packet_allocate(NX_PACKET_POOL *pool_ptr, NX_PACKET **packet_ptr, ULONG packet_type, ULONG wait_option) {
+    (void) packet_type;
+    (void) wait_option;
+    if (pool_ptr && pool_ptr->nx_packet_pool_total) {
+        if (0 == pool_ptr->nx_packet_pool_available) {
+            pool_ptr->nx_packet_pool_empty_requests++;
+            return NX_NO_PACKET;
+        }
+        pool_ptr->nx_packet_pool_available--;
+    }
+    NX_PACKET *packet = (NX_PACKET *) calloc(1, sizeof(NX_PACKET));
+    if (NULL == packet) {
+        return NX_NO_PACKET;
+    }
+    packet->pool = pool_ptr;
+    *packet_ptr = packet;
+    return NX_SUCCESS;
+}
+
+UINT nx_packet_data_append(NX_PACKET *packet_ptr, VOID *data_start, ULONG data_size, NX_PACKET_POOL *pool_ptr,
+        ULONG wait_option) {
+    (void) pool_ptr;
+    (void) wait_option;
+    if (packet_ptr->nx_packet_length + data_size > sizeof(packet_ptr->data)) {
+        return NX_NO_PACKET;
+    }
+    memcpy(&packet_ptr->data[packet_ptr->nx_packet_length], data_start, data_size);
+    packet_ptr->nx_packet_length += data_size;
+    return NX_SUCCESS;
+}
+
+UINT nx_packet_data_retrieve(NX_PACKET *packet_ptr, VOID *buffer_start, ULONG *bytes_copied) {
+    memcpy(buffer_start, packet_ptr->data, packet_ptr->nx_packet_length);
+    *bytes_copied = packet_ptr->nx_packet_length;
+    return NX_SUCCESS;
+}
+
+UINT nx_packet_data_extract_offset(NX_PACKET *packet_ptr, ULONG offset, VOID *buffer_start, ULONG buffer_length,
+        ULONG *bytes_copied) {
+    if (offset > packet_ptr->nx_packet_length) {
+        return NX_INVALID_PARAMETERS; // NX_PACKET_OFFSET_ERROR in NetX
+    }
+    ULONG length = packet_ptr->nx_packet_length - offset;
+    if (length > buffer_length) {
+        length = buffer_length;
+    }
+    memcpy(buffer_start, &packet_ptr->data[offset], length);
+    *bytes_copied = length;
+    return NX_SUCCESS;
+}
+
+UINT nx_packet_length_get(NX_PACKET *packet_ptr, ULONG *length) {
+    *length = packet_ptr->nx_packet_length;
+    return NX_SUCCESS;
+}
+
+UINT nx_packet_release(NX_PACKET *packet_ptr) {
+    if (NULL == packet_ptr) {
+        return NX_INVALID_PACKET;
+    }
+    if (packet_ptr->pool && packet_ptr->pool->nx_packet_pool_total) {
+        packet_ptr->pool->nx_packet_pool_available++;
+    }
+    free(packet_ptr);
+    return NX_SUCCESS;
+}
+
+UINT nx_packet_pool_info_get(NX_PACKET_POOL *pool_ptr, ULONG *total_packets, ULONG *free_packets,
+        ULONG *empty_pool_requests, ULONG *empty_pool_suspensions, ULONG *invalid_packet_releases) {
+    if (NULL == pool_ptr) {
+        return NX_PTR_ERROR;
+    }
+    if (total_packets) {
+        *total_packets = pool_ptr->nx_packet_pool_total;
+    }
+    if (free_packets) {
+        *free_packets = pool_ptr->nx_packet_pool_available;
+    }
+    if (empty_pool_requests) {
+        *empty_pool_requests = pool_ptr->nx_packet_pool_empty_requests;
+    }
+    if (empty_pool_suspensions) {
+        *empty_pool_suspensions = 0;
+    }
+    if (invalid_packet_releases) {
+        *invalid_packet_releases = 0;
+    }
+    return NX_SUCCESS;
+}
+
+UINT nx_udp_socket_create(NX_IP *ip_ptr, NX_UDP_SOCKET *socket_ptr, CHAR *name, ULONG type_of_service,
+        ULONG fragment, UINT time_to_live, ULONG queue_maximum) {
+    (void) type_of_service;
+    (void) fragment;
+    (void) time_to_live;
+    (void) queue_maximum;
+    socket_ptr->ip = ip_ptr;
+    socket_ptr->name = name;
+    socket_ptr->fd = -1;
+    return NX_SUCCESS;
+}
+
+UINT nx_udp_socket_bind(NX_UDP_SOCKET *socket_ptr, UINT port, ULONG wait_option) {
+    (void) wait_option;
+    socket_ptr->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (socket_ptr->fd < 0) {
+        return NX_NO_FREE_PORTS;
+    }
+    struct sockaddr_in address = {0};
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t) port);
+    if (bind(socket_ptr->fd, (struct sockaddr *) &address, sizeof(address))) {
+        close(socket_ptr->fd);
+        socket_ptr->fd = -1;
+        return NX_NO_FREE_PORTS;
+    }
+    return NX_SUCCESS;
+}
+
+UINT nx_udp_socket_unbind(NX_UDP_SOCKET *socket_ptr) {
+    if (socket_ptr->fd < 0) {
+        return NX_NOT_BOUND;
+    }
+    close(socket_ptr->fd);
+    socket_ptr->fd = -1;
+    return NX_SUCCESS;
+}
+
+UINT nx_udp_socket_delete(NX_UDP_SOCKET *socket_ptr) {
+    if (socket_ptr->fd >= 0) {
+        nx_udp_socket_unbind(socket_ptr);
+    }
+    return NX_SUCCESS;
+}
+
+UINT nx_udp_socket_send(NX_UDP_SOCKET *socket_ptr, NX_PACKET *packet_ptr, ULONG ip_address, UINT port) {
+    if (socket_ptr->fd < 0) {
+        return NX_NOT_BOUND;
+    }
+    if (socket_ptr->ip && socket_ptr->ip->host_udp_port_override) {
+        port = socket_ptr->ip->host_udp_port_override;
+    }
+    struct sockaddr_in address = {0};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl((uint32_t) ip_address);
+    address.sin_port = htons((uint16_t) port);
+    if (sendto(socket_ptr->fd, packet_ptr->data, packet_ptr->nx_packet_length, 0, (struct sockaddr *) &address,
+            sizeof(address)) < 0) {
+        return NX_NOT_SUCCESSFUL;
+    }
+    nx_packet_release(packet_ptr);
+    return NX_SUCCESS;
+}
+
+UINT nx_udp_socket_receive(NX_UDP_SOCKET *socket_ptr, NX_PACKET **packet_ptr, ULONG wait_option) {
+    if (socket_ptr->fd < 0) {
+        return NX_NOT_BOUND;
+    }
+    struct timeval timeout = {0, 1}; // TX_NO_WAIT
+    if (TX_WAIT_FOREVER == wait_option) {
+        timeout.tv_usec = 0;
+    } else if (wait_option) {
+        timeout.tv_sec = (time_t) (wait_option / NX_IP_PERIODIC_RATE);
+        timeout.tv_usec = (suseconds_t) (wait_option % NX_IP_PERIODIC_RATE) * (1000000 / NX_IP_PERIODIC_RATE);
+    }
+    setsockopt(socket_ptr->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    NX_PACKET *packet;
+    if (NX_SUCCESS != nx_packet_allocate(NULL, &packet, NX_UDP_PACKET, wait_option)) {
+        return NX_NO_PACKET;
+    }
+    const ssize_t length = recv(socket_ptr->fd, packet->data, sizeof(packet->data), 0);
+    if (length < 0) {
+        nx_packet_release(packet);
+        return NX_NO_PACKET;
+    }
+    packet->nx_packet_length = (ULONG) length;
+    *packet_ptr = packet;
+    return NX_SUCCESS;
+}
+
+UINT nx_dns_create(NX_DNS *dns_ptr, NX_IP *ip_ptr, UCHAR *domain_name) {
+    (void) domain_name;
+    memset(dns_ptr, 0, sizeof(*dns_ptr));
+    dns_ptr->nx_dns_ip_ptr = ip_ptr;
+    return NX_SUCCESS;
+}
+
+UINT nx_dns_server_add(NX_DNS *dns_ptr, ULONG server_address) {
+    for (UINT i = 0; i < NX_DNS_MAX_SERVERS; i++) {
+        if (0 == dns_ptr->nx_dns_server_ip_array[i]) {
+            dns_ptr->nx_dns_server_ip_array[i] = server_address;
+            return NX_SUCCESS;
+        }
+    }
+    return NX_NO_FREE_PORTS;
+}
+
+UINT nx_dns_server_get(NX_DNS *dns_ptr, UINT index, ULONG *dns_server_address) {
+    if (index >= NX_DNS_MAX_SERVERS) {
+        return NX_DNS_PARAM_ERROR;
+    }
+    *dns_server_address = dns_ptr->nx_dns_server_ip_array[index];
+    return *dns_server_address ? NX_SUCCESS : NX_DNS_NO_SERVER;
+}
+
+UINT nx_dns_host_by_name_get(NX_DNS *dns_ptr, UCHAR *host_name, ULONG *host_address_ptr, ULONG wait_option) {
+    if (NULL == dns_ptr || NULL == host_name || NULL == host_address_ptr) {
+        return NX_DNS_PARAM_ERROR;
+    }
+    if (0 == dns_ptr->nx_dns_server_ip_array[0]) {
+        return NX_DNS_NO_SERVER;
+    }
+    dns_ptr->lookups++;
+
+    UCHAR query[300] = {0x12, 0x34, 0x01, 0x00, 0x00, 0x01};
+    size_t length = 12;
+    const char *label = (const char *) host_name;
+    while (*label && length < sizeof(query) - 64 - 6) {
+        const char *dot = strchr(label, '.');
+        const size_t label_length = dot ? (size_t) (dot - label) : strlen(label);
+        if (0 == label_length || label_length > 63) {
+            return NX_DNS_PARAM_ERROR;
+        }
+        query[length++] = (UCHAR) label_length;
+        memcpy(&query[length], label, label_length);
+        length += label_length;
+        label += label_length + (dot ? 1 : 0);
+    }
+    static const UCHAR question_end[] = {0, 0, 1, 0, 1}; // root label, type A, class IN
+    memcpy(&query[length], question_end, sizeof(question_end));
+    length += sizeof(question_end);
+
+    NX_UDP_SOCKET socket;
+    NX_PACKET *packet;
+    UINT status = NX_DNS_QUERY_FAILED;
+    nx_udp_socket_create(dns_ptr->nx_dns_ip_ptr, &socket, "DNS Client", NX_IP_NORMAL, NX_FRAGMENT_OKAY,
+            NX_IP_TIME_TO_LIVE, 4);
+    if (NX_SUCCESS == nx_udp_socket_bind(&socket, NX_ANY_PORT, wait_option)
+            && NX_SUCCESS == nx_packet_allocate(dns_ptr->nx_dns_packet_pool_ptr, &packet, NX_UDP_PACKET, wait_option)) {
+        if (NX_SUCCESS != nx_packet_data_append(packet, query, (ULONG) length, NULL, wait_option)
+                || NX_SUCCESS != nx_udp_socket_send(&socket, packet, dns_ptr->nx_dns_server_ip_array[0], 53)) {
+            nx_packet_release(packet);
+        } else if (NX_SUCCESS == nx_udp_socket_receive(&socket, &packet, wait_option)) {
+            // the answer follows the echoed question: a name pointer, type, class, TTL and the address
+            const UCHAR *answer = &packet->data[length];
+            if (packet->nx_packet_length >= length + 16 && (packet->data[7] > 0) && 0 == (packet->data[3] & 0x0F)
+                    && 0xC0 == (answer[0] & 0xC0) && 1 == answer[3] && 4 == answer[11]) {
+                *host_address_ptr = IP_ADDRESS(answer[12], answer[13], answer[14], answer[15]);
+                status = NX_SUCCESS;
+            }
+            nx_packet_release(packet);
+        }
+    }
+    nx_udp_socket_delete(&socket);
+    return status;
+}
+
+static int base64_value(UCHAR c) {
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 52;
+    }
+    if ('+' == c) {
+        return 62;
+    }
+    if ('/' == c) {
+        return 63;
+    }
+    return -1;
+}
+
+UINT _nx_utility_base64_decode(UCHAR *base64name, UINT base64name_size, UCHAR *name, UINT name_size,
+        UINT *bytes_copied) {
+    if (NULL == base64name || NULL == name || NULL == bytes_copied) {
+        return NX_INVALID_PARAMETERS;
+    }
+    ULONG bits = 0;
+    UINT bit_count = 0;
+    UINT length = 0;
+    for (UINT i = 0; i < base64name_size && '=' != base64name[i]; i++) {
+        const int value = base64_value(base64name[i]);
+        if (value < 0) {
+            return NX_INVALID_PARAMETERS;
+        }
+        bits = (bits << 6) | (ULONG) value;
+        bit_count += 6;
+        if (bit_count >= 8) {
+            bit_count -= 8;
+            if (length + 1 >= name_size) { // NetX terminates the output
+                return NX_SIZE_ERROR;
+            }
+            name[length++] = (UCHAR) (bits >> bit_count);
+        }
+    }
+    name[length] = 0;
+    *bytes_copied = length;
+    return NX_SUCCESS;
+}
+
+UINT _nx_utility_string_to_uint(CHAR *input_string, UINT string_length, UINT *number) {
+    if (NULL == input_string || NULL == number || 0 == string_length) {
+        return NX_INVALID_PARAMETERS;
+    }
+    ULONG64 value = 0;
+    for (UINT i = 0; i < string_length; i++) {
+        if (input_string[i] < '0' || input_string[i] > '9') {
+            return NX_INVALID_PARAMETERS;
+        }
+        value = value * 10 + (ULONG64) (input_string[i] - '0');
+        if (value > 0xFFFFFFFFULL) {
+            return NX_OVERFLOW;
+        }
+    }
+    *number = (UINT) value;
+    return NX_SUCCESS;
+}
@@ -0,0 +1,99 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef NX_SECURE_TLS_API_H
+#define NX_SECURE_TLS_API_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The NetX Secure TLS session setup that the OTA download uses, for the host build. There is no TLS on the
+// host: the session only keeps the buffers it is given, so that a test can check where they are and that
+// they are large enough, and the connection runs in plain TCP.
+// Certificates are parsed for the fields that the app and the PSA auth driver read, and not verified.
+
+#include "nx_api.h"
+#include "nx_crypto.h"
+
+#define NX_SECURE_TLS_SUCCESS                       0x00
+#define NX_SECURE_TLS_INSUFFICIENT_METADATA_SPACE   0x108
+#define NX_SECURE_TLS_INVALID_PARAMETER             0x10F
+#define NX_SECURE_X509_INVALID_CERTIFICATE          0x183
+#define NX_SECURE_X509_KEY_TYPE_NONE                0
+#define NX_SECURE_X509_KEY_TYPE_HARDWARE            0x80000000UL
+
+// What nx_secure_tls_metadata_size_calculate() answers on the host. The real size depends on the ciphers.
+#ifndef NX_SECURE_TLS_HOST_METADATA_SIZE
+#define NX_SECURE_TLS_HOST_METADATA_SIZE            (8 * 1024)
+#endif
+#define NX_SECURE_TLS_HOST_MAX_REMOTE_CERTS         4
+
+typedef struct NX_SECURE_TLS_CRYPTO_STRUCT {
+    UINT unused;
+} NX_SECURE_TLS_CRYPTO;
+
+typedef struct NX_SECURE_X509_DISTINGUISHED_NAME_STRUCT {
+    const UCHAR *nx_secure_x509_common_name;
+    USHORT nx_secure_x509_common_name_length;
+} NX_SECURE_X509_DISTINGUISHED_NAME;
+
+typedef struct NX_SECURE_EC_PUBLIC_KEY_STRUCT {
+    const UCHAR *nx_secure_ec_public_key;   // the uncompressed point
+    USHORT nx_secure_ec_public_key_length;
+} NX_SECURE_EC_PUBLIC_KEY;
+
+// Pointers are into the certificate data
+typedef struct NX_SECURE_X509_CERT_STRUCT {
+    const UCHAR *certificate_data;
+    USHORT certificate_data_length;
+    UCHAR *buffer;          // of a remote certificate
+    UINT buffer_size;
+    NX_SECURE_X509_DISTINGUISHED_NAME nx_secure_x509_distinguished_name;   // of the subject
+    const UCHAR *nx_secure_x509_not_before;
+    USHORT nx_secure_x509_not_before_length;
+    const UCHAR *nx_secure_x509_not_after;
+    USHORT nx_secure_x509_not_after_length;
+    union {
+        NX_SECURE_EC_PUBLIC_KEY ec_public_key;
+    } nx_secure_x509_public_key;
+} NX_SECURE_X509_CERT;
+
+typedef struct NX_SECURE_X509_DNS_NAME_STRUCT {
+    CHAR name[256];
+    USHORT length;
+} NX_SECURE_X509_DNS_NAME;
+
+typedef struct NX_SECURE_TLS_SESSION_STRUCT {
+    VOID *metadata;
+    ULONG metadata_size;
+    UCHAR *packet_buffer;
+    ULONG packet_buffer_size;
+    NX_SECURE_X509_CERT *trusted_cert;
+    NX_SECURE_X509_CERT *remote_certs[NX_SECURE_TLS_HOST_MAX_REMOTE_CERTS];
+    UINT remote_cert_count;
+    const NX_SECURE_X509_DNS_NAME *sni_name;
+} NX_SECURE_TLS_SESSION;
+
+UINT nx_secure_tls_metadata_size_calculate(const NX_SECURE_TLS_CRYPTO *crypto_table, ULONG *metadata_size);
+UINT nx_secure_tls_session_create(NX_SECURE_TLS_SESSION *session_ptr, const NX_SECURE_TLS_CRYPTO *crypto_table,
+        VOID *metadata_area, ULONG metadata_size);
+UINT nx_secure_tls_session_delete(NX_SECURE_TLS_SESSION *session_ptr);
+UINT nx_secure_tls_session_packet_buffer_set(NX_SECURE_TLS_SESSION *session_ptr, UCHAR *buffer_ptr,
+        ULONG buffer_size);
+UINT nx_secure_x509_certificate_initialize(NX_SECURE_X509_CERT *certificate, UCHAR *certificate_data,
+        USHORT length, UCHAR *raw_data_buffer, USHORT buffer_size, const UCHAR *private_key,
+        USHORT priv_len, UINT private_key_type);
+UINT nx_secure_tls_trusted_certificate_add(NX_SECURE_TLS_SESSION *session_ptr, NX_SECURE_X509_CERT *certificate_ptr);
+UINT nx_secure_tls_remote_certificate_allocate(NX_SECURE_TLS_SESSION *session_ptr,
+        NX_SECURE_X509_CERT *certificate, UCHAR *raw_certificate_buffer, UINT buffer_size);
+UINT nx_secure_x509_dns_name_initialize(NX_SECURE_X509_DNS_NAME *dns_name, const UCHAR *name_string, UINT length);
+UINT nx_secure_tls_session_sni_extension_set(NX_SECURE_TLS_SESSION *session_ptr,
+        NX_SECURE_X509_DNS_NAME *dns_name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NX_SECURE_TLS_API_H
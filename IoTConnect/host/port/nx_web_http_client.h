@@ -0,0 +1,74 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef NX_WEB_HTTP_CLIENT_H
+#define NX_WEB_HTTP_CLIENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The NetX Duo Web HTTP client, for the host build: one request at a time on a POSIX TCP socket. The secure
+// connect calls the TLS setup callback like NetX does, and then talks plain HTTP (see nx_secure_tls_api.h).
+// The response body is passed on in packets of the client's pool, of up to NX_PACKET_PAYLOAD_SIZE bytes,
+// and the packet with the last byte of the body comes with NX_WEB_HTTP_GET_DONE.
+
+#include <stdbool.h>
+#include "nx_api.h"
+#include "nx_secure_tls_api.h"
+
+#define NX_WEB_HTTP_METHOD_GET                  1
+
+#define NX_WEB_HTTP_ERROR                       0x30000
+#define NX_WEB_HTTP_FAILED                      0x30002
+#define NX_WEB_HTTP_GET_DONE                    0x3000C
+#define NX_WEB_HTTP_REQUEST_UNSUCCESSFUL_CODE   0x3001E
+
+#define NX_WEB_HTTP_HOST_REQUEST_SIZE           1024
+#define NX_WEB_HTTP_HOST_HEADER_SIZE            1024
+
+typedef struct NX_WEB_HTTP_CLIENT_STRUCT NX_WEB_HTTP_CLIENT;
+
+typedef VOID (*nx_web_http_client_response_header_fn)(NX_WEB_HTTP_CLIENT *client_ptr, CHAR *field_name,
+        UINT field_name_length, CHAR *field_value, UINT field_value_length);
+typedef UINT (*nx_web_http_client_tls_setup_fn)(NX_WEB_HTTP_CLIENT *client_ptr, NX_SECURE_TLS_SESSION *tls_session);
+
+struct NX_WEB_HTTP_CLIENT_STRUCT {
+    CHAR *nx_web_http_client_name;
+    NX_IP *nx_web_http_client_ip_ptr;
+    NX_PACKET_POOL *nx_web_http_client_packet_pool_ptr;
+    NX_SECURE_TLS_SESSION nx_web_http_client_tls_session;
+    nx_web_http_client_response_header_fn nx_web_http_client_response_header_callback;
+    // host only
+    int fd;
+    CHAR request[NX_WEB_HTTP_HOST_REQUEST_SIZE];
+    UINT request_length;
+    bool headers_done;
+    UCHAR pending[NX_WEB_HTTP_HOST_HEADER_SIZE];   // body bytes received with the headers
+    UINT pending_length;
+    UINT pending_offset;
+    ULONG content_length;
+    ULONG body_received;
+};
+
+UINT nx_web_http_client_create(NX_WEB_HTTP_CLIENT *client_ptr, CHAR *client_name, NX_IP *ip_ptr,
+        NX_PACKET_POOL *pool_ptr, ULONG window_size);
+UINT nx_web_http_client_delete(NX_WEB_HTTP_CLIENT *client_ptr);
+UINT nx_web_http_client_response_header_callback_set(NX_WEB_HTTP_CLIENT *client_ptr,
+        nx_web_http_client_response_header_fn callback_function);
+UINT nx_web_http_client_secure_connect(NX_WEB_HTTP_CLIENT *client_ptr, NXD_ADDRESS *server_ip, UINT server_port,
+        nx_web_http_client_tls_setup_fn tls_setup, ULONG wait_option);
+UINT nx_web_http_client_request_initialize(NX_WEB_HTTP_CLIENT *client_ptr, UINT method, CHAR *resource, CHAR *host,
+        UINT input_size, UINT transfer_encoding_chunked, CHAR *username, CHAR *password, ULONG wait_option);
+UINT nx_web_http_client_request_header_add(NX_WEB_HTTP_CLIENT *client_ptr, CHAR *field_name, UINT name_length,
+        CHAR *field_value, UINT value_length, UINT wait_option);
+UINT nx_web_http_client_request_send(NX_WEB_HTTP_CLIENT *client_ptr, ULONG wait_option);
+UINT nx_web_http_client_response_body_get(NX_WEB_HTTP_CLIENT *client_ptr, NX_PACKET **packet_pptr,
+        ULONG wait_option);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NX_WEB_HTTP_CLIENT_H
@@ -0,0 +1,451 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "nx_web_http_client.h"
+
+const NX_SECURE_TLS_CRYPTO nx_crypto_tls_ciphers = {0};
+
+UINT nx_secure_tls_metadata_size_calculate(const NX_SECURE_TLS_CRYPTO *crypto_table, ULONG *metadata_size) {
+    (void) crypto_table;
+    *metadata_size = NX_SECURE_TLS_HOST_METADATA_SIZE;
+    return NX_SECURE_TLS_SUCCESS;
+}
+
+UINT nx_secure_tls_session_create(NX_SECURE_TLS_SESSION *session_ptr, const NX_SECURE_TLS_CRYPTO *crypto_table,
+        VOID *metadata_area, ULONG metadata_size) {
+    (void) crypto_table;
+    if (NULL == metadata_area) {
+        return NX_SECURE_TLS_INVALID_PARAMETER;
+    }
+    if (metadata_size < NX_SECURE_TLS_HOST_METADATA_SIZE) {
+        return NX_SECURE_TLS_INSUFFICIENT_METADATA_SPACE;
+    }
+    memset(session_ptr, 0, sizeof(*session_ptr));
+    session_ptr->metadata = metadata_area;
+    session_ptr->metadata_size = metadata_size;
+    memset(metadata_area, 0, metadata_size); // like the cipher state that NetX keeps there
+    return NX_SECURE_TLS_SUCCESS;
+}
+
+// Clears the metadata like NetX clears the keys. The buffers stay recorded in the session, for tests.
+UINT nx_secure_tls_session_delete(NX_SECURE_TLS_SESSION *session_ptr) {
+    if (session_ptr->metadata) {
+        memset(session_ptr->metadata, 0, session_ptr->metadata_size);
+    }
+    return NX_SECURE_TLS_SUCCESS;
+}
+
+UINT nx_secure_tls_session_packet_buffer_set(NX_SECURE_TLS_SESSION *session_ptr, UCHAR *buffer_ptr,
+        ULONG buffer_size) {
+    if (NULL == buffer_ptr || 0 == buffer_size) {
+        return NX_SECURE_TLS_INVALID_PARAMETER;
+    }
+    session_ptr->packet_buffer = buffer_ptr;
+    session_ptr->packet_buffer_size = buffer_size;
+    return NX_SECURE_TLS_SUCCESS;
+}
+
+#define DER_SEQUENCE    0x30
+#define DER_SET         0x31
+#define DER_OID         0x06
+#define DER_BIT_STRING  0x03
+#define DER_VERSION     0xA0    // [0] of the TBSCertificate
+
+static const UCHAR oid_common_name[] = {0x55, 0x04, 0x03};
+
+typedef struct {
+    UCHAR tag;
+    const UCHAR *content;
+    ULONG length;
+} der_element;
+
+// Reads the element at *p and moves *p past it. Returns false if it does not end before end.
+static bool der_next(const UCHAR **p, const UCHAR *end, der_element *element) {
+    const UCHAR *q = *p;
+    if (end - q < 2) {
+        return false;
+    }
+    element->tag = *q++;
+    ULONG length = *q++;
+    if (length & 0x80) {
+        UINT count = length & 0x7F;
+        if (0 == count || count > 2 || end - q < (long) count) {
+            return false;
+        }
+        for (length = 0; count > 0; count--) {
+            length = (length << 8) | *q++;
+        }
+    }
+    if ((ULONG) (end - q) < length) {
+        return false;
+    }
+    element->content = q;
+    element->length = length;
+    *p = q + length;
+    return true;
+}
+
+// Finds the common name among the attributes of the name
+static bool parse_common_name(const der_element *name, NX_SECURE_X509_DISTINGUISHED_NAME *distinguished_name) {
+    const UCHAR *p = name->content;
+    const UCHAR *end = p + name->length;
+    while (p < end) {
+        der_element set;
+        if (!der_next(&p, end, &set) || DER_SET != set.tag) {
+            return false;
+        }
+        const UCHAR *q = set.content;
+        const UCHAR *set_end = q + set.length;
+        while (q < set_end) {
+            der_element attribute;
+            der_element type;
+            der_element value;
+            if (!der_next(&q, set_end, &attribute) || DER_SEQUENCE != attribute.tag) {
+                return false;
+            }
+            const UCHAR *r = attribute.content;
+            const UCHAR *attribute_end = r + attribute.length;
+            if (!der_next(&r, attribute_end, &type) || DER_OID != type.tag || !der_next(&r, attribute_end, &value)) {
+                return false;
+            }
+            if (sizeof(oid_common_name) == type.length
+                    && 0 == memcmp(type.content, oid_common_name, sizeof(oid_common_name))) {
+                distinguished_name->nx_secure_x509_common_name = value.content;
+                distinguished_name->nx_secure_x509_common_name_length = (USHORT) value.length;
+            }
+        }
+    }
+    return true;
+}
+
+// Walks the TBSCertificate to the subject, the validity and the public key
+static bool parse_certificate(const UCHAR *data, USHORT length, NX_SECURE_X509_CERT *certificate) {
+    const UCHAR *p = data;
+    der_element element;
+    if (!der_next(&p, data + length, &element) || DER_SEQUENCE != element.tag) {
+        return false;
+    }
+    p = element.content;
+    if (!der_next(&p, element.content + element.length, &element) || DER_SEQUENCE != element.tag) {
+        return false;
+    }
+    p = element.content;
+    const UCHAR *end = element.content + element.length;
+    der_element signature, issuer, validity, subject, public_key_info;
+    if (!der_next(&p, end, &element) || (DER_VERSION == element.tag && !der_next(&p, end, &element))
+            || !der_next(&p, end, &signature) || !der_next(&p, end, &issuer)
+            || !der_next(&p, end, &validity) || DER_SEQUENCE != validity.tag
+            || !der_next(&p, end, &subject) || DER_SEQUENCE != subject.tag
+            || !der_next(&p, end, &public_key_info) || DER_SEQUENCE != public_key_info.tag) {
+        return false;
+    }
+
+    der_element not_before, not_after;
+    p = validity.content;
+    end = validity.content + validity.length;
+    if (!der_next(&p, end, &not_before) || !der_next(&p, end, &not_after)) {
+        return false;
+    }
+    certificate->nx_secure_x509_not_before = not_before.content;
+    certificate->nx_secure_x509_not_before_length = (USHORT) not_before.length;
+    certificate->nx_secure_x509_not_after = not_after.content;
+    certificate->nx_secure_x509_not_after_length = (USHORT) not_after.length;
+
+    // the key of any algorithm, without the unused bits count of the BIT STRING
+    der_element algorithm, key;
+    p = public_key_info.content;
+    end = public_key_info.content + public_key_info.length;
+    if (!der_next(&p, end, &algorithm) || !der_next(&p, end, &key) || DER_BIT_STRING != key.tag
+            || key.length < 2 || 0 != key.content[0]) {
+        return false;
+    }
+    certificate->nx_secure_x509_public_key.ec_public_key.nx_secure_ec_public_key = key.content + 1;
+    certificate->nx_secure_x509_public_key.ec_public_key.nx_secure_ec_public_key_length = (USHORT) (key.length - 1);
+
+    return parse_common_name(&subject, &certificate->nx_secure_x509_distinguished_name);
+}
+
+UINT nx_secure_x509_certificate_initialize(NX_SECURE_X509_CERT *certificate, UCHAR *certificate_data,
+        USHORT length, UCHAR *raw_data_buffer, USHORT buffer_size, const UCHAR *private_key,
+        USHORT priv_len, UINT private_key_type) {
+    (void) raw_data_buffer;
+    (void) buffer_size;
+    (void) private_key;
+    (void) priv_len;
+    (void) private_key_type;
+    if (NULL == certificate_data || 0 == length) {
+        return NX_SECURE_TLS_INVALID_PARAMETER;
+    }
+    memset(certificate, 0, sizeof(*certificate));
+    if (!parse_certificate(certificate_data, length, certificate)) {
+        return NX_SECURE_X509_INVALID_CERTIFICATE;
+    }
+    certificate->certificate_data = certificate_data;
+    certificate->certificate_data_length = length;
+    return NX_SECURE_TLS_SUCCESS;
+}
+
+UINT nx_secure_tls_trusted_certificate_add(NX_SECURE_TLS_SESSION *session_ptr, NX_SECURE_X509_CERT *certificate_ptr) {
+    session_ptr->trusted_cert = certificate_ptr;
+    return NX_SECURE_TLS_SUCCESS;
+}
+
+UINT nx_secure_tls_remote_certificate_allocate(NX_SECURE_TLS_SESSION *session_ptr,
+        NX_SECURE_X509_CERT *certificate, UCHAR *raw_certificate_buffer, UINT buffer_size) {
+    if (NULL == raw_certificate_buffer || 0 == buffer_size
+            || session_ptr->remote_cert_count == NX_SECURE_TLS_HOST_MAX_REMOTE_CERTS) {
+        return NX_SECURE_TLS_INVALID_PARAMETER;
+    }
+    memset(certificate, 0, sizeof(*certificate));
+    certificate->buffer = raw_certificate_buffer;
+    certificate->buffer_size = buffer_size;
+    session_ptr->remote_certs[session_ptr->remote_cert_count++] = certificate;
+    return NX_SECURE_TLS_SUCCESS;
+}
+
+UINT nx_secure_x509_dns_name_initialize(NX_SECURE_X509_DNS_NAME *dns_name, const UCHAR *name_string, UINT length) {
+    if (length >= sizeof(dns_name->name)) {
+        return NX_SECURE_TLS_INVALID_PARAMETER;
+    }
+    memcpy(dns_name->name, name_string, length);
+    dns_name->name[length] = 0;
+    dns_name->length = (USHORT) length;
+    return NX_SECURE_TLS_SUCCESS;
+}
+
+UINT nx_secure_tls_session_sni_extension_set(NX_SECURE_TLS_SESSION *session_ptr,
+        NX_SECURE_X509_DNS_NAME *dns_name) {
+    session_ptr->sni_name = dns_name;
+    return NX_SECURE_TLS_SUCCESS;
+}
+
+static void set_timeout(int fd, ULONG wait_option) {
+    struct timeval timeout = {0, 1}; // TX_NO_WAIT
+    if (TX_WAIT_FOREVER == wait_option) {
+        timeout.tv_usec = 0;
+    } else if (wait_option) {
+        timeout.tv_sec = (time_t) (wait_option / NX_IP_PERIODIC_RATE);
+        timeout.tv_usec = (suseconds_t) (wait_option % NX_IP_PERIODIC_RATE) * (1000000 / NX_IP_PERIODIC_RATE);
+    }
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+static bool append_request(NX_WEB_HTTP_CLIENT *client_ptr, const char *data, size_t length) {
+    if (client_ptr->request_length + length > sizeof(client_ptr->request)) {
+        return false;
+    }
+    memcpy(&client_ptr->request[client_ptr->request_length], data, length);
+    client_ptr->request_length += (UINT) length;
+    return true;
+}
+
+UINT nx_web_http_client_create(NX_WEB_HTTP_CLIENT *client_ptr, CHAR *client_name, NX_IP *ip_ptr,
+        NX_PACKET_POOL *pool_ptr, ULONG window_size) {
+    (void) window_size;
+    memset(client_ptr, 0, sizeof(*client_ptr));
+    client_ptr->nx_web_http_client_name = client_name;
+    client_ptr->nx_web_http_client_ip_ptr = ip_ptr;
+    client_ptr->nx_web_http_client_packet_pool_ptr = pool_ptr;
+    client_ptr->fd = -1;
+    return NX_SUCCESS;
+}
+
+UINT nx_web_http_client_delete(NX_WEB_HTTP_CLIENT *client_ptr) {
+    if (client_ptr->fd >= 0) {
+        close(client_ptr->fd);
+        client_ptr->fd = -1;
+    }
+    nx_secure_tls_session_delete(&client_ptr->nx_web_http_client_tls_session);
+    return NX_SUCCESS;
+}
+
+UINT nx_web_http_client_response_header_callback_set(NX_WEB_HTTP_CLIENT *client_ptr,
+        nx_web_http_client_response_header_fn callback_function) {
+    client_ptr->nx_web_http_client_response_header_callback = callback_function;
+    return NX_SUCCESS;
+}
+
+UINT nx_web_http_client_secure_connect(NX_WEB_HTTP_CLIENT *client_ptr, NXD_ADDRESS *server_ip, UINT server_port,
+        nx_web_http_client_tls_setup_fn tls_setup, ULONG wait_option) {
+    if (NX_IP_VERSION_V4 != server_ip->nxd_ip_version || NULL == tls_setup) {
+        return NX_INVALID_PARAMETERS;
+    }
+    UINT status = tls_setup(client_ptr, &client_ptr->nx_web_http_client_tls_session);
+    if (status) {
+        return status;
+    }
+    const NX_IP *ip = client_ptr->nx_web_http_client_ip_ptr;
+    if (ip && ip->host_tcp_port_override) {
+        server_port = ip->host_tcp_port_override;
+    }
+    client_ptr->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (client_ptr->fd < 0) {
+        return NX_NOT_SUCCESSFUL;
+    }
+    set_timeout(client_ptr->fd, wait_option);
+    struct sockaddr_in address = {0};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl((uint32_t) server_ip->nxd_ip_address.v4);
+    address.sin_port = htons((uint16_t) server_port);
+    if (connect(client_ptr->fd, (struct sockaddr *) &address, sizeof(address))) {
+        close(client_ptr->fd);
+        client_ptr->fd = -1;
+        return NX_NOT_CONNECTED;
+    }
+    return NX_SUCCESS;
+}
+
+UINT nx_web_http_client_request_initialize(NX_WEB_HTTP_CLIENT *client_ptr, UINT method, CHAR *resource, CHAR *host,
+        UINT input_size, UINT transfer_encoding_chunked, CHAR *username, CHAR *password, ULONG wait_option) {
+    (void) input_size;
+    (void) transfer_encoding_chunked;
+    (void) username;
+    (void) password;
+    (void) wait_option;
+    if (NX_WEB_HTTP_METHOD_GET != method || client_ptr->fd < 0) {
+        return NX_WEB_HTTP_ERROR;
+    }
+    const int length = snprintf(client_ptr->request, sizeof(client_ptr->request), "GET %s HTTP/1.1\r\nHost: %s\r\n",
+            resource, host);
+    if (length < 0 || (size_t) length >= sizeof(client_ptr->request)) {
+        return NX_WEB_HTTP_ERROR;
+    }
+    client_ptr->request_length = (UINT) length;
+    client_ptr->headers_done = false;
+    client_ptr->pending_length = 0;
+    client_ptr->pending_offset = 0;
+    client_ptr->content_length = 0;
+    client_ptr->body_received = 0;
+    return NX_SUCCESS;
+}
+
+UINT nx_web_http_client_request_header_add(NX_WEB_HTTP_CLIENT *client_ptr, CHAR *field_name, UINT name_length,
+        CHAR *field_value, UINT value_length, UINT wait_option) {
+    (void) wait_option;
+    if (!append_request(client_ptr, field_name, name_length) || !append_request(client_ptr, ": ", 2)
+            || !append_request(client_ptr, field_value, value_length) || !append_request(client_ptr, "\r\n", 2)) {
+        return NX_WEB_HTTP_ERROR;
+    }
+    return NX_SUCCESS;
+}
+
+UINT nx_web_http_client_request_send(NX_WEB_HTTP_CLIENT *client_ptr, ULONG wait_option) {
+    (void) wait_option;
+    if (!append_request(client_ptr, "\r\n", 2)) {
+        return NX_WEB_HTTP_ERROR;
+    }
+    const char *p = client_ptr->request;
+    size_t left = client_ptr->request_length;
+    while (left > 0) {
+        const ssize_t n = send(client_ptr->fd, p, left, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return NX_NOT_CONNECTED;
+        }
+        p += n;
+        left -= (size_t) n;
+    }
+    return NX_SUCCESS;
+}
+
+// Reads the status line and the header fields, and passes the fields to the callback
+static UINT read_headers(NX_WEB_HTTP_CLIENT *client_ptr) {
+    char header[NX_WEB_HTTP_HOST_HEADER_SIZE + 1];
+    size_t received = 0;
+    char *end = NULL;
+    while (NULL == end) {
+        if (received == NX_WEB_HTTP_HOST_HEADER_SIZE) {
+            return NX_WEB_HTTP_FAILED;
+        }
+        const ssize_t n = recv(client_ptr->fd, &header[received], NX_WEB_HTTP_HOST_HEADER_SIZE - received, 0);
+        if (n <= 0) {
+            return NX_NOT_CONNECTED;
+        }
+        received += (size_t) n;
+        header[received] = 0;
+        end = strstr(header, "\r\n\r\n");
+    }
+    const size_t header_length = (size_t) (end + 4 - header);
+    client_ptr->pending_length = (UINT) (received - header_length);
+    memcpy(client_ptr->pending, &header[header_length], client_ptr->pending_length);
+    end[2] = 0; // keep the end of the last field
+
+    if (0 != strncmp(header, "HTTP/1.", 7) || ' ' != header[8] || '2' != header[9]) {
+        return NX_WEB_HTTP_REQUEST_UNSUCCESSFUL_CODE;
+    }
+    char *line = strstr(header, "\r\n") + 2;
+    char *line_end;
+    while (NULL != (line_end = strstr(line, "\r\n"))) {
+        char *colon = memchr(line, ':', (size_t) (line_end - line));
+        if (colon) {
+            char *value = colon + 1;
+            while (' ' == *value) {
+                value++;
+            }
+            if (0 == strncasecmp(line, "Content-Length", (size_t) (colon - line))) {
+                client_ptr->content_length = strtoul(value, NULL, 10);
+            }
+            if (client_ptr->nx_web_http_client_response_header_callback) {
+                client_ptr->nx_web_http_client_response_header_callback(client_ptr, line, (UINT) (colon - line),
+                        value, (UINT) (line_end - value));
+            }
+        }
+        line = line_end + 2;
+    }
+    client_ptr->headers_done = true;
+    return NX_SUCCESS;
+}
+
+UINT nx_web_http_client_response_body_get(NX_WEB_HTTP_CLIENT *client_ptr, NX_PACKET **packet_pptr,
+        ULONG wait_option) {
+    if (client_ptr->fd < 0) {
+        return NX_NOT_CONNECTED;
+    }
+    set_timeout(client_ptr->fd, wait_option);
+    if (!client_ptr->headers_done) {
+        const UINT status = read_headers(client_ptr);
+        if (status) {
+            return status;
+        }
+    }
+    if (client_ptr->body_received >= client_ptr->content_length) {
+        return NX_WEB_HTTP_GET_DONE; // an empty body, without a packet in this port
+    }
+    NX_PACKET *packet;
+    if (NX_SUCCESS != nx_packet_allocate(client_ptr->nx_web_http_client_packet_pool_ptr, &packet, 0, wait_option)) {
+        return NX_NO_PACKET;
+    }
+    ULONG wanted = client_ptr->content_length - client_ptr->body_received;
+    if (wanted > sizeof(packet->data)) {
+        wanted = sizeof(packet->data);
+    }
+    if (client_ptr->pending_offset < client_ptr->pending_length) {
+        ULONG n = client_ptr->pending_length - client_ptr->pending_offset;
+        if (n > wanted) {
+            n = wanted;
+        }
+        memcpy(packet->data, &client_ptr->pending[client_ptr->pending_offset], n);
+        client_ptr->pending_offset += (UINT) n;
+        packet->nx_packet_length = n;
+    } else {
+        const ssize_t n = recv(client_ptr->fd, packet->data, wanted, 0);
+        if (n <= 0) {
+            nx_packet_release(packet);
+            return NX_NOT_CONNECTED;
+        }
+        packet->nx_packet_length = (ULONG) n;
+    }
+    client_ptr->body_received += packet->nx_packet_length;
+    *packet_pptr = packet;
+    return client_ptr->body_received >= client_ptr->content_length ? NX_WEB_HTTP_GET_DONE : NX_SUCCESS;
+}
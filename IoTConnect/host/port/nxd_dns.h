@@ -0,0 +1,45 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef NXD_DNS_H
+#define NXD_DNS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The NetX Duo DNS client, for the host build: a server list, and a host_by_name_get() that resolves with
+// one plain A query to the first server, like the NetX client does without a cache.
+
+#include "nx_api.h"
+
+#define NX_DNS_MAX_SERVERS      5
+#define NX_DNS_NO_SERVER        0xA1
+#define NX_DNS_QUERY_FAILED     0xA3
+#define NX_DNS_PARAM_ERROR      0xA8
+
+typedef struct NX_DNS_STRUCT {
+    NX_IP *nx_dns_ip_ptr;
+    NX_PACKET_POOL *nx_dns_packet_pool_ptr;
+    ULONG nx_dns_server_ip_array[NX_DNS_MAX_SERVERS];
+    ULONG lookups;          // host only: the host_by_name_get() calls that went to a server
+} NX_DNS;
+
+UINT nx_dns_create(NX_DNS *dns_ptr, NX_IP *ip_ptr, UCHAR *domain_name);
+UINT nx_dns_server_add(NX_DNS *dns_ptr, ULONG server_address);
+UINT nx_dns_server_get(NX_DNS *dns_ptr, UINT index, ULONG *dns_server_address);
+
+// As in NetX, the API name maps to the checking entry point, or to the plain one without error checking
+#ifdef NX_DISABLE_ERROR_CHECKING
+#define nx_dns_host_by_name_get _nx_dns_host_by_name_get
+#else
+#define nx_dns_host_by_name_get _nxe_dns_host_by_name_get
+#endif
+UINT nx_dns_host_by_name_get(NX_DNS *dns_ptr, UCHAR *host_name, ULONG *host_address_ptr, ULONG wait_option);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NXD_DNS_H
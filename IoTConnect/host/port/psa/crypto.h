@@ -0,0 +1,116 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef PSA_CRYPTO_H
+#define PSA_CRYPTO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "psa/error.h"
+
+// The multi-part PSA hash API with SHA-256 only, in software, for the host build.
+// And the key API that the PSA auth driver uses. The keys are in the secure image, so there are none on the
+// host, and those calls fail with PSA_ERROR_NOT_SUPPORTED.
+
+typedef uint32_t psa_algorithm_t;
+
+#define PSA_ALG_SHA_256             ((psa_algorithm_t) 0x02000009)
+#define PSA_HASH_LENGTH(alg)        ((PSA_ALG_SHA_256 == (alg)) ? 32u : 0u)
+#define PSA_HASH_MAX_SIZE           32
+#define PSA_ALG_ECDSA(hash_alg)     ((psa_algorithm_t) (0x06000600 | ((hash_alg) & 0x000000ff)))
+
+typedef uint32_t psa_key_id_t;
+typedef uint32_t psa_key_lifetime_t;
+typedef uint16_t psa_key_type_t;
+typedef uint8_t psa_ecc_family_t;
+typedef uint32_t psa_key_usage_t;
+
+#define PSA_KEY_LIFETIME_VOLATILE               ((psa_key_lifetime_t) 0x00000000)
+#define PSA_KEY_LIFETIME_PERSISTENT             ((psa_key_lifetime_t) 0x00000001)
+#define PSA_ECC_FAMILY_SECP_R1                  ((psa_ecc_family_t) 0x12)
+#define PSA_KEY_TYPE_ECC_KEY_PAIR(curve)        ((psa_key_type_t) (0x7100 | (curve)))
+#define PSA_KEY_USAGE_SIGN_HASH                 ((psa_key_usage_t) 0x00001000)
+
+typedef struct psa_key_attributes_s {
+    psa_key_id_t id;
+    psa_key_lifetime_t lifetime;
+    psa_key_type_t type;
+    size_t bits;
+    psa_key_usage_t usage;
+    psa_algorithm_t alg;
+} psa_key_attributes_t;
+
+#define PSA_KEY_ATTRIBUTES_INIT     {0}
+
+static inline void psa_set_key_id(psa_key_attributes_t *attributes, psa_key_id_t key) {
+    attributes->id = key;
+}
+
+static inline void psa_set_key_lifetime(psa_key_attributes_t *attributes, psa_key_lifetime_t lifetime) {
+    attributes->lifetime = lifetime;
+}
+
+static inline void psa_set_key_type(psa_key_attributes_t *attributes, psa_key_type_t type) {
+    attributes->type = type;
+}
+
+static inline void psa_set_key_bits(psa_key_attributes_t *attributes, size_t bits) {
+    attributes->bits = bits;
+}
+
+static inline void psa_set_key_usage_flags(psa_key_attributes_t *attributes, psa_key_usage_t usage_flags) {
+    attributes->usage = usage_flags;
+}
+
+static inline void psa_set_key_algorithm(psa_key_attributes_t *attributes, psa_algorithm_t alg) {
+    attributes->alg = alg;
+}
+
+static inline void psa_reset_key_attributes(psa_key_attributes_t *attributes) {
+    const psa_key_attributes_t init = PSA_KEY_ATTRIBUTES_INIT;
+    *attributes = init;
+}
+
+typedef struct psa_hash_operation_s {
+    psa_algorithm_t alg;    // 0 when inactive
+    uint32_t state[8];
+    uint64_t length;
+    uint8_t block[64];
+    size_t block_length;
+} psa_hash_operation_t;
+
+#define PSA_HASH_OPERATION_INIT     {0}
+
+static inline psa_hash_operation_t psa_hash_operation_init(void) {
+    const psa_hash_operation_t operation = PSA_HASH_OPERATION_INIT;
+    return operation;
+}
+
+psa_status_t psa_crypto_init(void);
+psa_status_t psa_hash_setup(psa_hash_operation_t *operation, psa_algorithm_t alg);
+psa_status_t psa_hash_update(psa_hash_operation_t *operation, const uint8_t *input, size_t input_length);
+psa_status_t psa_hash_finish(psa_hash_operation_t *operation, uint8_t *hash, size_t hash_size, size_t *hash_length);
+psa_status_t psa_hash_verify(psa_hash_operation_t *operation, const uint8_t *hash, size_t hash_length);
+psa_status_t psa_hash_abort(psa_hash_operation_t *operation);
+psa_status_t psa_hash_clone(const psa_hash_operation_t *source_operation, psa_hash_operation_t *target_operation);
+psa_status_t psa_hash_compute(psa_algorithm_t alg, const uint8_t *input, size_t input_length, uint8_t *hash,
+        size_t hash_size, size_t *hash_length);
+psa_status_t psa_hash_compare(psa_algorithm_t alg, const uint8_t *input, size_t input_length, const uint8_t *hash,
+        size_t hash_length);
+
+psa_status_t psa_generate_key(const psa_key_attributes_t *attributes, psa_key_id_t *key);
+psa_status_t psa_destroy_key(psa_key_id_t key);
+psa_status_t psa_export_public_key(psa_key_id_t key, uint8_t *data, size_t data_size, size_t *data_length);
+psa_status_t psa_sign_hash(psa_key_id_t key, psa_algorithm_t alg, const uint8_t *hash, size_t hash_length,
+        uint8_t *signature, size_t signature_size, size_t *signature_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSA_CRYPTO_H
@@ -0,0 +1,53 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef PSA_INTERNAL_TRUSTED_STORAGE_H
+#define PSA_INTERNAL_TRUSTED_STORAGE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "psa/error.h"
+
+// PSA Internal Trusted Storage in RAM, for the host build. Like the TF-M ITS partition, it takes at most
+// ITS_NUM_ASSETS assets of at most ITS_MAX_ASSET_SIZE bytes each, and answers PSA_ERROR_INSUFFICIENT_STORAGE
+// past that. The defaults are those of the TF-M configuration.
+
+#ifndef ITS_NUM_ASSETS
+#define ITS_NUM_ASSETS          10
+#endif
+#ifndef ITS_MAX_ASSET_SIZE
+#define ITS_MAX_ASSET_SIZE      512
+#endif
+
+typedef uint64_t psa_storage_uid_t;
+typedef uint32_t psa_storage_create_flags_t;
+
+#define PSA_STORAGE_FLAG_NONE           0u
+#define PSA_STORAGE_FLAG_WRITE_ONCE     (1u << 0)
+
+struct psa_storage_info_t {
+    size_t capacity;
+    size_t size;
+    psa_storage_create_flags_t flags;
+};
+
+psa_status_t psa_its_set(psa_storage_uid_t uid, size_t data_length, const void *p_data,
+        psa_storage_create_flags_t create_flags);
+psa_status_t psa_its_get(psa_storage_uid_t uid, size_t data_offset, size_t data_size, void *p_data,
+        size_t *p_data_length);
+psa_status_t psa_its_get_info(psa_storage_uid_t uid, struct psa_storage_info_t *p_info);
+psa_status_t psa_its_remove(psa_storage_uid_t uid);
+
+// Host only: removes all assets, like a fresh device
+void psa_its_port_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSA_INTERNAL_TRUSTED_STORAGE_H
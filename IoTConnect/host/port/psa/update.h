@@ -0,0 +1,85 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef PSA_UPDATE_H
+#define PSA_UPDATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "psa/error.h"
+
+// The TF-M legacy firmware update API, for the host build. psa_fwu_ram.c keeps the staging slots in RAM and
+// behaves like the TF-M partition where the ADU driver depends on it:
+// - the first write after a boot or an abort erases the staging slot,
+// - flash that is already programmed cannot be programmed again without an erase,
+// - the digest of the query is the SHA-256 of the staged bytes,
+// - a write takes the time set with psa_fwu_port_set_write_time_us(), to model the flash and the secure call.
+
+#ifndef PSA_FWU_MAX_BLOCK_SIZE
+#define PSA_FWU_MAX_BLOCK_SIZE      1024
+#endif
+#define PSA_FWU_MAX_DIGEST_SIZE     32
+#ifndef PSA_FWU_PORT_SLOT_SIZE
+#define PSA_FWU_PORT_SLOT_SIZE      (1024 * 1024)
+#endif
+#define PSA_FWU_PORT_PROG_UNIT      16
+
+#define PSA_IMAGE_UNDEFINED         0
+#define PSA_IMAGE_CANDIDATE         1
+#define PSA_IMAGE_INSTALLED         2
+#define PSA_IMAGE_REJECTED          3
+#define PSA_IMAGE_PENDING_INSTALL   4
+#define PSA_IMAGE_REBOOT_NEEDED     5
+
+#define PSA_SUCCESS_REBOOT          ((psa_status_t) +1)
+#define PSA_SUCCESS_RESTART         ((psa_status_t) +2)
+#define PSA_ERROR_DEPENDENCY_NEEDED ((psa_status_t) -156)
+
+typedef uint32_t psa_image_id_t;
+
+typedef struct psa_image_version_t {
+    uint8_t iv_major;
+    uint8_t iv_minor;
+    uint16_t iv_revision;
+    uint32_t iv_build_num;
+} psa_image_version_t;
+
+typedef struct psa_image_info_t {
+    psa_image_version_t version;
+    uint8_t state;
+    uint8_t digest[PSA_FWU_MAX_DIGEST_SIZE];
+} psa_image_info_t;
+
+psa_status_t psa_fwu_write(psa_image_id_t image_id, size_t block_offset, const void *block, size_t block_size);
+psa_status_t psa_fwu_install(psa_image_id_t image_id, psa_image_id_t *dependency_uuid,
+        psa_image_version_t *dependency_version);
+psa_status_t psa_fwu_abort(psa_image_id_t image_id);
+psa_status_t psa_fwu_query(psa_image_id_t image_id, psa_image_info_t *info);
+psa_status_t psa_fwu_request_reboot(void);
+psa_status_t psa_fwu_accept(psa_image_id_t image_id);
+
+// Host only: erases the slots and forgets everything, like a new device
+void psa_fwu_port_reset(void);
+// Host only: a reboot. The staged bytes stay in flash, the state of the update in RAM is lost.
+void psa_fwu_port_reboot(void);
+// Host only: the image in the active slot, which the query reports as installed
+void psa_fwu_port_set_active(psa_image_id_t image_id, const psa_image_version_t *version);
+// Host only: the time that a write of PSA_FWU_MAX_BLOCK_SIZE bytes takes. Smaller writes take proportionally less.
+void psa_fwu_port_set_write_time_us(uint32_t block_us);
+// Host only: the staged bytes of the image and their size, up to the last written byte. NULL if none.
+const uint8_t *psa_fwu_port_staged(psa_image_id_t image_id, size_t *size);
+// Host only: the bytes programmed with psa_fwu_write() since the reset
+uint64_t psa_fwu_port_bytes_written(void);
+// Host only: true once psa_fwu_request_reboot() was called
+int psa_fwu_port_reboot_requested(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PSA_UPDATE_H
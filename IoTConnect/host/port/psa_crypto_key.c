@@ -0,0 +1,36 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include "psa/crypto.h"
+
+psa_status_t psa_generate_key(const psa_key_attributes_t *attributes, psa_key_id_t *key) {
+    (void) attributes;
+    (void) key;
+    return PSA_ERROR_NOT_SUPPORTED;
+}
+
+psa_status_t psa_destroy_key(psa_key_id_t key) {
+    (void) key;
+    return PSA_ERROR_INVALID_HANDLE;
+}
+
+psa_status_t psa_export_public_key(psa_key_id_t key, uint8_t *data, size_t data_size, size_t *data_length) {
+    (void) key;
+    (void) data;
+    (void) data_size;
+    *data_length = 0;
+    return PSA_ERROR_INVALID_HANDLE;
+}
+
+psa_status_t psa_sign_hash(psa_key_id_t key, psa_algorithm_t alg, const uint8_t *hash, size_t hash_length,
+        uint8_t *signature, size_t signature_size, size_t *signature_length) {
+    (void) key;
+    (void) alg;
+    (void) hash;
+    (void) hash_length;
+    (void) signature;
+    (void) signature_size;
+    *signature_length = 0;
+    return PSA_ERROR_NOT_SUPPORTED;
+}
@@ -0,0 +1,201 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include "psa/update.h"
+
+#define SLOT_COUNT 2
+
+typedef struct staging_slot {
+    psa_image_id_t image_id;
+    int used;
+    uint8_t state;          // in RAM on the secure side, lost at a reboot
+    size_t size;            // up to the last written byte
+    uint8_t flash[PSA_FWU_PORT_SLOT_SIZE];
+} staging_slot;
+
+static staging_slot slots[SLOT_COUNT];
+static psa_image_id_t active_image_id;
+static psa_image_version_t active_version;
+static uint32_t write_time_us;
+static uint64_t bytes_written;
+static int reboot_requested;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static staging_slot *find(psa_image_id_t image_id, int create) {
+    for (int i = 0; i < SLOT_COUNT; i++) {
+        if (slots[i].used && slots[i].image_id == image_id) {
+            return &slots[i];
+        }
+    }
+    for (int i = 0; create && i < SLOT_COUNT; i++) {
+        if (!slots[i].used) {
+            slots[i].used = 1;
+            slots[i].image_id = image_id;
+            slots[i].state = PSA_IMAGE_UNDEFINED;
+            slots[i].size = 0;
+            memset(slots[i].flash, 0xFF, sizeof(slots[i].flash));
+            return &slots[i];
+        }
+    }
+    return NULL;
+}
+
+static void erase(staging_slot *slot) {
+    memset(slot->flash, 0xFF, sizeof(slot->flash));
+    slot->size = 0;
+}
+
+static int is_erased(const uint8_t *data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        if (0xFF != data[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+psa_status_t psa_fwu_write(psa_image_id_t image_id, size_t block_offset, const void *block, size_t block_size) {
+    if (NULL == block || block_size > PSA_FWU_MAX_BLOCK_SIZE || block_offset + block_size > PSA_FWU_PORT_SLOT_SIZE
+            || image_id == active_image_id) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+    // the secure call runs without the caller's lock on the device, so the time is spent outside of it here
+    if (write_time_us) {
+        const uint64_t ns = (uint64_t) write_time_us * 1000 * block_size / PSA_FWU_MAX_BLOCK_SIZE;
+        const struct timespec ts = {(time_t) (ns / 1000000000ULL), (long) (ns % 1000000000ULL)};
+        nanosleep(&ts, NULL);
+    }
+    psa_status_t status = PSA_SUCCESS;
+    pthread_mutex_lock(&lock);
+    staging_slot *slot = find(image_id, 1);
+    if (NULL == slot) {
+        status = PSA_ERROR_INSUFFICIENT_STORAGE;
+    } else {
+        if (PSA_IMAGE_UNDEFINED == slot->state) {
+            erase(slot); // a new update starts with an erased staging area
+        }
+        // the flash is programmed by units. A unit that is written already fails.
+        const size_t first = block_offset - block_offset % PSA_FWU_PORT_PROG_UNIT;
+        const size_t last = (block_offset + block_size + PSA_FWU_PORT_PROG_UNIT - 1) / PSA_FWU_PORT_PROG_UNIT
+                * PSA_FWU_PORT_PROG_UNIT;
+        if (!is_erased(&slot->flash[first], last - first)) {
+            status = PSA_ERROR_STORAGE_FAILURE;
+        } else {
+            memcpy(&slot->flash[block_offset], block, block_size);
+            if (block_offset + block_size > slot->size) {
+                slot->size = block_offset + block_size;
+            }
+            slot->state = PSA_IMAGE_CANDIDATE;
+            bytes_written += block_size;
+        }
+    }
+    pthread_mutex_unlock(&lock);
+    return status;
+}
+
+psa_status_t psa_fwu_install(psa_image_id_t image_id, psa_image_id_t *dependency_uuid,
+        psa_image_version_t *dependency_version) {
+    (void) dependency_uuid;
+    (void) dependency_version;
+    psa_status_t status = PSA_SUCCESS_REBOOT;
+    pthread_mutex_lock(&lock);
+    staging_slot *slot = find(image_id, 0);
+    if (NULL == slot || PSA_IMAGE_CANDIDATE != slot->state) {
+        status = PSA_ERROR_INVALID_ARGUMENT;
+    } else {
+        slot->state = PSA_IMAGE_REBOOT_NEEDED;
+    }
+    pthread_mutex_unlock(&lock);
+    return status;
+}
+
+psa_status_t psa_fwu_abort(psa_image_id_t image_id) {
+    psa_status_t status = PSA_SUCCESS;
+    pthread_mutex_lock(&lock);
+    staging_slot *slot = find(image_id, 0);
+    if (NULL == slot || PSA_IMAGE_UNDEFINED == slot->state) {
+        status = PSA_ERROR_INVALID_ARGUMENT; // no update of this image in progress
+    } else {
+        erase(slot);
+        slot->state = PSA_IMAGE_UNDEFINED;
+    }
+    pthread_mutex_unlock(&lock);
+    return status;
+}
+
+psa_status_t psa_fwu_query(psa_image_id_t image_id, psa_image_info_t *info) {
+    memset(info, 0, sizeof(*info));
+    pthread_mutex_lock(&lock);
+    if (image_id == active_image_id) {
+        info->version = active_version;
+        info->state = PSA_IMAGE_INSTALLED;
+    } else {
+        const staging_slot *slot = find(image_id, 0);
+        if (slot && PSA_IMAGE_UNDEFINED != slot->state) {
+            // The digest stays zero. What it covers is up to the secure side, and the driver does not use it.
+            info->state = slot->state;
+        }
+    }
+    pthread_mutex_unlock(&lock);
+    return PSA_SUCCESS;
+}
+
+psa_status_t psa_fwu_request_reboot(void) {
+    reboot_requested = 1;
+    return PSA_SUCCESS;
+}
+
+psa_status_t psa_fwu_accept(psa_image_id_t image_id) {
+    (void) image_id;
+    return PSA_SUCCESS;
+}
+
+void psa_fwu_port_reset(void) {
+    pthread_mutex_lock(&lock);
+    for (int i = 0; i < SLOT_COUNT; i++) {
+        slots[i].used = 0;
+    }
+    bytes_written = 0;
+    reboot_requested = 0;
+    pthread_mutex_unlock(&lock);
+}
+
+void psa_fwu_port_reboot(void) {
+    pthread_mutex_lock(&lock);
+    for (int i = 0; i < SLOT_COUNT; i++) {
+        slots[i].state = PSA_IMAGE_UNDEFINED;
+    }
+    reboot_requested = 0;
+    pthread_mutex_unlock(&lock);
+}
+
+void psa_fwu_port_set_active(psa_image_id_t image_id, const psa_image_version_t *version) {
+    pthread_mutex_lock(&lock);
+    active_image_id = image_id;
+    active_version = *version;
+    pthread_mutex_unlock(&lock);
+}
+
+void psa_fwu_port_set_write_time_us(uint32_t block_us) {
+    write_time_us = block_us;
+}
+
+const uint8_t *psa_fwu_port_staged(psa_image_id_t image_id, size_t *size) {
+    pthread_mutex_lock(&lock);
+    const staging_slot *slot = find(image_id, 0);
+    *size = slot ? slot->size : 0;
+    pthread_mutex_unlock(&lock);
+    return slot ? slot->flash : NULL;
+}
+
+uint64_t psa_fwu_port_bytes_written(void) {
+    return bytes_written;
+}
+
+int psa_fwu_port_reboot_requested(void) {
+    return reboot_requested;
+}
@@ -0,0 +1,113 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <pthread.h>
+#include <string.h>
+#include "psa/internal_trusted_storage.h"
+
+typedef struct its_asset {
+    psa_storage_uid_t uid;
+    psa_storage_create_flags_t flags;
+    size_t size;
+    uint8_t data[ITS_MAX_ASSET_SIZE];
+    int used;
+} its_asset;
+
+static its_asset assets[ITS_NUM_ASSETS];
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static its_asset *find(psa_storage_uid_t uid) {
+    for (int i = 0; i < ITS_NUM_ASSETS; i++) {
+        if (assets[i].used && assets[i].uid == uid) {
+            return &assets[i];
+        }
+    }
+    return NULL;
+}
+
+psa_status_t psa_its_set(psa_storage_uid_t uid, size_t data_length, const void *p_data,
+        psa_storage_create_flags_t create_flags) {
+    if (0 == uid || (data_length && NULL == p_data)) {
+        return PSA_ERROR_INVALID_ARGUMENT;
+    }
+    if (data_length > ITS_MAX_ASSET_SIZE) {
+        return PSA_ERROR_INSUFFICIENT_STORAGE;
+    }
+    psa_status_t status = PSA_SUCCESS;
+    pthread_mutex_lock(&lock);
+    its_asset *asset = find(uid);
+    if (asset && (asset->flags & PSA_STORAGE_FLAG_WRITE_ONCE)) {
+        status = PSA_ERROR_NOT_PERMITTED;
+    } else if (NULL == asset) {
+        for (int i = 0; i < ITS_NUM_ASSETS && NULL == asset; i++) {
+            if (!assets[i].used) {
+                asset = &assets[i];
+            }
+        }
+        if (NULL == asset) {
+            status = PSA_ERROR_INSUFFICIENT_STORAGE;
+        }
+    }
+    if (PSA_SUCCESS == status) {
+        asset->uid = uid;
+        asset->flags = create_flags;
+        asset->size = data_length;
+        memcpy(asset->data, p_data, data_length);
+        asset->used = 1;
+    }
+    pthread_mutex_unlock(&lock);
+    return status;
+}
+
+psa_status_t psa_its_get(psa_storage_uid_t uid, size_t data_offset, size_t data_size, void *p_data,
+        size_t *p_data_length) {
+    psa_status_t status = PSA_SUCCESS;
+    pthread_mutex_lock(&lock);
+    const its_asset *asset = find(uid);
+    if (NULL == asset) {
+        status = PSA_ERROR_DOES_NOT_EXIST;
+    } else if (data_offset > asset->size) {
+        status = PSA_ERROR_INVALID_ARGUMENT;
+    } else {
+        const size_t length = (asset->size - data_offset < data_size) ? asset->size - data_offset : data_size;
+        memcpy(p_data, &asset->data[data_offset], length);
+        *p_data_length = length;
+    }
+    pthread_mutex_unlock(&lock);
+    return status;
+}
+
+psa_status_t psa_its_get_info(psa_storage_uid_t uid, struct psa_storage_info_t *p_info) {
+    psa_status_t status = PSA_ERROR_DOES_NOT_EXIST;
+    pthread_mutex_lock(&lock);
+    const its_asset *asset = find(uid);
+    if (asset) {
+        p_info->capacity = asset->size;
+        p_info->size = asset->size;
+        p_info->flags = asset->flags;
+        status = PSA_SUCCESS;
+    }
+    pthread_mutex_unlock(&lock);
+    return status;
+}
+
+psa_status_t psa_its_remove(psa_storage_uid_t uid) {
+    psa_status_t status = PSA_ERROR_DOES_NOT_EXIST;
+    pthread_mutex_lock(&lock);
+    its_asset *asset = find(uid);
+    if (asset && (asset->flags & PSA_STORAGE_FLAG_WRITE_ONCE)) {
+        status = PSA_ERROR_NOT_PERMITTED;
+    } else if (asset) {
+        asset->used = 0;
+        status = PSA_SUCCESS;
+    }
+    pthread_mutex_unlock(&lock);
+    return status;
+}
+
+void psa_its_port_reset(void) {
+    pthread_mutex_lock(&lock);
+    memset(assets, 0, sizeof(assets));
+    pthread_mutex_unlock(&lock);
+}
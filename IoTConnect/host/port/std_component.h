@@ -0,0 +1,34 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef STD_COMPONENT_H
+#define STD_COMPONENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The sensor component of the project, for the host build: a fixed temperature and the button counter
+
+#include <stdint.h>
+#include "nx_azure_iot_adu_agent.h"
+
+#define STD_COMPONENT_HOST_TEMPERATURE  25.0
+
+typedef struct {
+    const UCHAR *component_name;
+    UINT component_name_length;
+    double Temperature;
+    uint32_t ButtonCounter;
+} STD_COMPONENT;
+
+UINT std_component_init(STD_COMPONENT *handle, UCHAR *component_name, UINT component_name_length);
+UINT std_component_read_sensor_values(STD_COMPONENT *handle);
+void std_component_on_button_pushed(STD_COMPONENT *handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STD_COMPONENT_H
@@ -0,0 +1,13 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef SW_AUTH_DRIVER_H
+#define SW_AUTH_DRIVER_H
+
+// The software auth driver of the SDK, for the host build. The app includes it, but authenticates with a
+// symmetric key or with the PSA auth driver.
+
+#include "iotc_auth_driver.h"
+
+#endif // SW_AUTH_DRIVER_H
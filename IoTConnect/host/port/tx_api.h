@@ -0,0 +1,183 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef TX_API_H
+#define TX_API_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The subset of the ThreadX API that the app modules use, on POSIX threads, for the host build.
+// Each object is a pthread mutex and condition; timeouts are in ticks of TX_TIMER_TICKS_PER_SECOND.
+// tx_interrupt_control() takes one process wide lock, so "interrupt" code that runs on another thread, like
+// a timer or a test thread calling an ISR, is excluded as it is on the device.
+
+#include <pthread.h>
+#include <stdint.h>
+
+typedef void VOID;
+typedef char CHAR;
+typedef unsigned char UCHAR;
+typedef unsigned short USHORT;
+typedef int INT;
+typedef unsigned int UINT;
+typedef long LONG;
+typedef unsigned long ULONG;
+typedef unsigned long long ULONG64;
+typedef unsigned long ALIGN_TYPE;
+
+#ifndef TX_TIMER_TICKS_PER_SECOND
+#define TX_TIMER_TICKS_PER_SECOND   100
+#endif
+
+#define TX_NO_WAIT                  0
+#define TX_WAIT_FOREVER             0xFFFFFFFFUL
+#define TX_AND                      2
+#define TX_AND_CLEAR                3
+#define TX_OR                       0
+#define TX_OR_CLEAR                 1
+#define TX_1_ULONG                  1
+#define TX_2_ULONG                  2
+#define TX_4_ULONG                  4
+#define TX_8_ULONG                  8
+#define TX_16_ULONG                 16
+#define TX_NO_TIME_SLICE            0
+#define TX_AUTO_START               1
+#define TX_DONT_START               0
+#define TX_AUTO_ACTIVATE            1
+#define TX_NO_ACTIVATE              0
+#define TX_INHERIT                  1
+#define TX_NO_INHERIT               0
+#define TX_INT_DISABLE              1
+#define TX_INT_ENABLE               0
+#define TX_NULL                     ((void *) 0)
+
+#define TX_SUCCESS                  0x00
+#define TX_DELETED                  0x01
+#define TX_POOL_ERROR               0x02
+#define TX_QUEUE_EMPTY              0x0A
+#define TX_QUEUE_FULL               0x0B
+#define TX_SEMAPHORE_ERROR          0x0C
+#define TX_NO_EVENTS                0x07
+#define TX_NO_INSTANCE              0x0D
+#define TX_THREAD_ERROR             0x0E
+#define TX_WAIT_ABORTED             0x1A
+#define TX_NOT_AVAILABLE            0x1D
+
+typedef struct TX_MUTEX_STRUCT {
+    pthread_mutex_t lock;
+    CHAR *name;
+} TX_MUTEX;
+
+typedef struct TX_SEMAPHORE_STRUCT {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    ULONG count;
+    CHAR *name;
+} TX_SEMAPHORE;
+
+typedef struct TX_QUEUE_STRUCT {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    ULONG *start;
+    UINT message_words;
+    ULONG capacity;
+    ULONG enqueued;
+    ULONG read;
+    ULONG write;
+    CHAR *name;
+} TX_QUEUE;
+
+typedef struct TX_EVENT_FLAGS_GROUP_STRUCT {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    ULONG flags;
+    CHAR *name;
+} TX_EVENT_FLAGS_GROUP;
+
+typedef struct TX_THREAD_STRUCT {
+    pthread_t thread;
+    VOID (*entry)(ULONG);
+    ULONG input;
+    CHAR *name;
+    VOID *tx_thread_stack_start;
+    VOID *tx_thread_stack_end;
+    ULONG tx_thread_stack_size;
+    UINT tx_thread_priority;
+} TX_THREAD;
+
+// The fields of the ThreadX control block that the health sampler walks. There are no byte pools on the host,
+// malloc() is the one of the C library, so the created pool list is empty.
+typedef struct TX_BYTE_POOL_STRUCT {
+    CHAR *tx_byte_pool_name;
+    ULONG tx_byte_pool_available;
+    ULONG tx_byte_pool_fragments;
+    UCHAR *tx_byte_pool_list;
+    UCHAR *tx_byte_pool_start;
+    ULONG tx_byte_pool_size;
+    TX_THREAD *tx_byte_pool_owner;
+    struct TX_BYTE_POOL_STRUCT *tx_byte_pool_created_next;
+} TX_BYTE_POOL;
+
+typedef struct TX_TIMER_STRUCT {
+    pthread_t thread;
+    VOID (*expiration)(ULONG);
+    ULONG input;
+    ULONG initial_ticks;
+    ULONG reschedule_ticks;
+    volatile int active;
+    CHAR *name;
+} TX_TIMER;
+
+UINT tx_mutex_create(TX_MUTEX *mutex_ptr, CHAR *name_ptr, UINT inherit);
+UINT tx_mutex_delete(TX_MUTEX *mutex_ptr);
+UINT tx_mutex_get(TX_MUTEX *mutex_ptr, ULONG wait_option);
+UINT tx_mutex_put(TX_MUTEX *mutex_ptr);
+
+UINT tx_semaphore_create(TX_SEMAPHORE *semaphore_ptr, CHAR *name_ptr, ULONG initial_count);
+UINT tx_semaphore_delete(TX_SEMAPHORE *semaphore_ptr);
+UINT tx_semaphore_get(TX_SEMAPHORE *semaphore_ptr, ULONG wait_option);
+UINT tx_semaphore_put(TX_SEMAPHORE *semaphore_ptr);
+UINT tx_semaphore_ceiling_put(TX_SEMAPHORE *semaphore_ptr, ULONG ceiling);
+
+UINT tx_queue_create(TX_QUEUE *queue_ptr, CHAR *name_ptr, UINT message_size, VOID *queue_start,
+        ULONG queue_size);
+UINT tx_queue_delete(TX_QUEUE *queue_ptr);
+UINT tx_queue_send(TX_QUEUE *queue_ptr, VOID *source_ptr, ULONG wait_option);
+UINT tx_queue_receive(TX_QUEUE *queue_ptr, VOID *destination_ptr, ULONG wait_option);
+
+UINT tx_event_flags_create(TX_EVENT_FLAGS_GROUP *group_ptr, CHAR *name_ptr);
+UINT tx_event_flags_delete(TX_EVENT_FLAGS_GROUP *group_ptr);
+UINT tx_event_flags_set(TX_EVENT_FLAGS_GROUP *group_ptr, ULONG flags_to_set, UINT set_option);
+UINT tx_event_flags_get(TX_EVENT_FLAGS_GROUP *group_ptr, ULONG requested_flags, UINT get_option,
+        ULONG *actual_flags_ptr, ULONG wait_option);
+
+// The stack and the priorities are ignored. The threads always start.
+UINT tx_thread_create(TX_THREAD *thread_ptr, CHAR *name_ptr, VOID (*entry_function)(ULONG), ULONG entry_input,
+        VOID *stack_start, ULONG stack_size, UINT priority, UINT preempt_threshold, ULONG time_slice,
+        UINT auto_start);
+UINT tx_thread_sleep(ULONG timer_ticks);
+// NULL on a thread that was not created with tx_thread_create(), like the one of main()
+TX_THREAD *tx_thread_identify(void);
+// Answers the name and the priority given to tx_thread_create(). The threads are not listed: the next is NULL.
+UINT tx_thread_info_get(TX_THREAD *thread_ptr, CHAR **name, UINT *state, ULONG *run_count, UINT *priority,
+        UINT *preemption_threshold, ULONG *time_slice, TX_THREAD **next_thread, TX_THREAD **next_suspended_thread);
+
+UINT tx_byte_pool_info_get(TX_BYTE_POOL *pool_ptr, CHAR **name, ULONG *available_bytes, ULONG *fragments,
+        TX_THREAD **first_suspended, ULONG *suspended_count, TX_BYTE_POOL **next_pool);
+
+UINT tx_timer_create(TX_TIMER *timer_ptr, CHAR *name_ptr, VOID (*expiration_function)(ULONG), ULONG expiration_input,
+        ULONG initial_ticks, ULONG reschedule_ticks, UINT auto_activate);
+UINT tx_timer_activate(TX_TIMER *timer_ptr);
+UINT tx_timer_deactivate(TX_TIMER *timer_ptr);
+
+ULONG tx_time_get(void);
+UINT tx_interrupt_control(UINT new_posture);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TX_API_H
@@ -0,0 +1,402 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "tx_api.h"
+
+TX_BYTE_POOL *_tx_byte_pool_created_ptr = NULL;
+ULONG _tx_byte_pool_created_count = 0;
+
+static pthread_mutex_t interrupt_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread UINT interrupt_posture = TX_INT_ENABLE;
+static __thread TX_THREAD *current_thread;
+
+static void init_lock(pthread_mutex_t *lock, pthread_cond_t *changed) {
+    pthread_mutex_init(lock, NULL);
+    if (changed) {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(changed, &attr);
+        pthread_condattr_destroy(&attr);
+    }
+}
+
+static struct timespec deadline(ULONG wait_option) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const uint64_t ns = (uint64_t) wait_option * (1000000000ULL / TX_TIMER_TICKS_PER_SECOND) + (uint64_t) ts.tv_nsec;
+    ts.tv_sec += (time_t) (ns / 1000000000ULL);
+    ts.tv_nsec = (long) (ns % 1000000000ULL);
+    return ts;
+}
+
+// Waits on the condition with the lock held. Returns false if the wait option ran out.
+static int wait_changed(pthread_cond_t *changed, pthread_mutex_t *lock, ULONG wait_option,
+        const struct timespec *until) {
+    if (TX_NO_WAIT == wait_option) {
+        return 0;
+    }
+    if (TX_WAIT_FOREVER == wait_option) {
+        pthread_cond_wait(changed, lock);
+        return 1;
+    }
+    return ETIMEDOUT != pthread_cond_timedwait(changed, lock, until);
+}
+
+UINT tx_mutex_create(TX_MUTEX *mutex_ptr, CHAR *name_ptr, UINT inherit) {
+    (void) inherit;
+    // ThreadX mutexes can be taken again by their owner
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mutex_ptr->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    mutex_ptr->name = name_ptr;
+    return TX_SUCCESS;
+}
+
+UINT tx_mutex_delete(TX_MUTEX *mutex_ptr) {
+    pthread_mutex_destroy(&mutex_ptr->lock);
+    return TX_SUCCESS;
+}
+
+UINT tx_mutex_get(TX_MUTEX *mutex_ptr, ULONG wait_option) {
+    if (TX_WAIT_FOREVER == wait_option) {
+        return pthread_mutex_lock(&mutex_ptr->lock) ? TX_NOT_AVAILABLE : TX_SUCCESS;
+    }
+    if (TX_NO_WAIT == wait_option) {
+        return pthread_mutex_trylock(&mutex_ptr->lock) ? TX_NOT_AVAILABLE : TX_SUCCESS;
+    }
+    struct timespec until = deadline(wait_option);
+    // pthread_mutex_timedlock() only takes the realtime clock, so poll instead
+    while (pthread_mutex_trylock(&mutex_ptr->lock)) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec > until.tv_sec || (now.tv_sec == until.tv_sec && now.tv_nsec >= until.tv_nsec)) {
+            return TX_NOT_AVAILABLE;
+        }
+        tx_thread_sleep(0);
+    }
+    return TX_SUCCESS;
+}
+
+UINT tx_mutex_put(TX_MUTEX *mutex_ptr) {
+    return pthread_mutex_unlock(&mutex_ptr->lock) ? TX_NOT_AVAILABLE : TX_SUCCESS;
+}
+
+UINT tx_semaphore_create(TX_SEMAPHORE *semaphore_ptr, CHAR *name_ptr, ULONG initial_count) {
+    init_lock(&semaphore_ptr->lock, &semaphore_ptr->changed);
+    semaphore_ptr->count = initial_count;
+    semaphore_ptr->name = name_ptr;
+    return TX_SUCCESS;
+}
+
+UINT tx_semaphore_delete(TX_SEMAPHORE *semaphore_ptr) {
+    pthread_cond_destroy(&semaphore_ptr->changed);
+    pthread_mutex_destroy(&semaphore_ptr->lock);
+    return TX_SUCCESS;
+}
+
+UINT tx_semaphore_get(TX_SEMAPHORE *semaphore_ptr, ULONG wait_option) {
+    const struct timespec until = deadline(wait_option);
+    UINT status = TX_SUCCESS;
+    pthread_mutex_lock(&semaphore_ptr->lock);
+    while (0 == semaphore_ptr->count) {
+        if (!wait_changed(&semaphore_ptr->changed, &semaphore_ptr->lock, wait_option, &until)) {
+            status = TX_NO_INSTANCE;
+            break;
+        }
+    }
+    if (TX_SUCCESS == status) {
+        semaphore_ptr->count--;
+    }
+    pthread_mutex_unlock(&semaphore_ptr->lock);
+    return status;
+}
+
+UINT tx_semaphore_put(TX_SEMAPHORE *semaphore_ptr) {
+    pthread_mutex_lock(&semaphore_ptr->lock);
+    semaphore_ptr->count++;
+    pthread_cond_broadcast(&semaphore_ptr->changed);
+    pthread_mutex_unlock(&semaphore_ptr->lock);
+    return TX_SUCCESS;
+}
+
+UINT tx_semaphore_ceiling_put(TX_SEMAPHORE *semaphore_ptr, ULONG ceiling) {
+    UINT status = TX_SUCCESS;
+    pthread_mutex_lock(&semaphore_ptr->lock);
+    if (semaphore_ptr->count >= ceiling) {
+        status = 0x21; // TX_CEILING_EXCEEDED
+    } else {
+        semaphore_ptr->count++;
+        pthread_cond_broadcast(&semaphore_ptr->changed);
+    }
+    pthread_mutex_unlock(&semaphore_ptr->lock);
+    return status;
+}
+
+UINT tx_queue_create(TX_QUEUE *queue_ptr, CHAR *name_ptr, UINT message_size, VOID *queue_start,
+        ULONG queue_size) {
+    init_lock(&queue_ptr->lock, &queue_ptr->changed);
+    queue_ptr->start = (ULONG *) queue_start;
+    queue_ptr->message_words = message_size;
+    queue_ptr->capacity = queue_size / (message_size * sizeof(ULONG));
+    queue_ptr->enqueued = 0;
+    queue_ptr->read = 0;
+    queue_ptr->write = 0;
+    queue_ptr->name = name_ptr;
+    return queue_ptr->capacity ? TX_SUCCESS : 0x05; // TX_SIZE_ERROR
+}
+
+UINT tx_queue_delete(TX_QUEUE *queue_ptr) {
+    pthread_cond_destroy(&queue_ptr->changed);
+    pthread_mutex_destroy(&queue_ptr->lock);
+    return TX_SUCCESS;
+}
+
+UINT tx_queue_send(TX_QUEUE *queue_ptr, VOID *source_ptr, ULONG wait_option) {
+    const struct timespec until = deadline(wait_option);
+    UINT status = TX_SUCCESS;
+    pthread_mutex_lock(&queue_ptr->lock);
+    while (queue_ptr->enqueued == queue_ptr->capacity) {
+        if (!wait_changed(&queue_ptr->changed, &queue_ptr->lock, wait_option, &until)) {
+            status = TX_QUEUE_FULL;
+            break;
+        }
+    }
+    if (TX_SUCCESS == status) {
+        memcpy(&queue_ptr->start[queue_ptr->write * queue_ptr->message_words], source_ptr,
+                queue_ptr->message_words * sizeof(ULONG));
+        queue_ptr->write = (queue_ptr->write + 1) % queue_ptr->capacity;
+        queue_ptr->enqueued++;
+        pthread_cond_broadcast(&queue_ptr->changed);
+    }
+    pthread_mutex_unlock(&queue_ptr->lock);
+    return status;
+}
+
+UINT tx_queue_receive(TX_QUEUE *queue_ptr, VOID *destination_ptr, ULONG wait_option) {
+    const struct timespec until = deadline(wait_option);
+    UINT status = TX_SUCCESS;
+    pthread_mutex_lock(&queue_ptr->lock);
+    while (0 == queue_ptr->enqueued) {
+        if (!wait_changed(&queue_ptr->changed, &queue_ptr->lock, wait_option, &until)) {
+            status = TX_QUEUE_EMPTY;
+            break;
+        }
+    }
+    if (TX_SUCCESS == status) {
+        memcpy(destination_ptr, &queue_ptr->start[queue_ptr->read * queue_ptr->message_words],
+                queue_ptr->message_words * sizeof(ULONG));
+        queue_ptr->read = (queue_ptr->read + 1) % queue_ptr->capacity;
+        queue_ptr->enqueued--;
+        pthread_cond_broadcast(&queue_ptr->changed);
+    }
+    pthread_mutex_unlock(&queue_ptr->lock);
+    return status;
+}
+
+UINT tx_event_flags_create(TX_EVENT_FLAGS_GROUP *group_ptr, CHAR *name_ptr) {
+    init_lock(&group_ptr->lock, &group_ptr->changed);
+    group_ptr->flags = 0;
+    group_ptr->name = name_ptr;
+    return TX_SUCCESS;
+}
+
+UINT tx_event_flags_delete(TX_EVENT_FLAGS_GROUP *group_ptr) {
+    pthread_cond_destroy(&group_ptr->changed);
+    pthread_mutex_destroy(&group_ptr->lock);
+    return TX_SUCCESS;
+}
+
+UINT tx_event_flags_set(TX_EVENT_FLAGS_GROUP *group_ptr, ULONG flags_to_set, UINT set_option) {
+    pthread_mutex_lock(&group_ptr->lock);
+    if (TX_OR == set_option) {
+        group_ptr->flags |= flags_to_set;
+    } else {
+        group_ptr->flags &= flags_to_set;
+    }
+    pthread_cond_broadcast(&group_ptr->changed);
+    pthread_mutex_unlock(&group_ptr->lock);
+    return TX_SUCCESS;
+}
+
+UINT tx_event_flags_get(TX_EVENT_FLAGS_GROUP *group_ptr, ULONG requested_flags, UINT get_option,
+        ULONG *actual_flags_ptr, ULONG wait_option) {
+    const struct timespec until = deadline(wait_option);
+    const int all = (TX_AND == get_option || TX_AND_CLEAR == get_option);
+    UINT status = TX_SUCCESS;
+    pthread_mutex_lock(&group_ptr->lock);
+    for (;;) {
+        const ULONG matched = group_ptr->flags & requested_flags;
+        if (all ? matched == requested_flags : 0 != matched) {
+            break;
+        }
+        if (!wait_changed(&group_ptr->changed, &group_ptr->lock, wait_option, &until)) {
+            status = TX_NO_EVENTS;
+            break;
+        }
+    }
+    *actual_flags_ptr = group_ptr->flags;
+    if (TX_SUCCESS == status && (TX_AND_CLEAR == get_option || TX_OR_CLEAR == get_option)) {
+        group_ptr->flags &= ~requested_flags;
+    }
+    pthread_mutex_unlock(&group_ptr->lock);
+    return status;
+}
+
+static void *thread_start(void *arg) {
+    TX_THREAD *thread_ptr = (TX_THREAD *) arg;
+    current_thread = thread_ptr;
+    thread_ptr->entry(thread_ptr->input);
+    return NULL;
+}
+
+UINT tx_thread_create(TX_THREAD *thread_ptr, CHAR *name_ptr, VOID (*entry_function)(ULONG), ULONG entry_input,
+        VOID *stack_start, ULONG stack_size, UINT priority, UINT preempt_threshold, ULONG time_slice,
+        UINT auto_start) {
+    (void) preempt_threshold;
+    (void) time_slice;
+    (void) auto_start;
+    thread_ptr->entry = entry_function;
+    thread_ptr->input = entry_input;
+    thread_ptr->name = name_ptr;
+    thread_ptr->tx_thread_priority = priority;
+    thread_ptr->tx_thread_stack_start = stack_start;
+    thread_ptr->tx_thread_stack_size = stack_size;
+    thread_ptr->tx_thread_stack_end = (UCHAR *) stack_start + stack_size - 1;
+    if (pthread_create(&thread_ptr->thread, NULL, thread_start, thread_ptr)) {
+        return TX_THREAD_ERROR;
+    }
+    pthread_detach(thread_ptr->thread);
+    return TX_SUCCESS;
+}
+
+UINT tx_thread_sleep(ULONG timer_ticks) {
+    if (0 == timer_ticks) {
+        sched_yield();
+        return TX_SUCCESS;
+    }
+    const struct timespec until = deadline(timer_ticks);
+    while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL)) {
+    }
+    return TX_SUCCESS;
+}
+
+TX_THREAD *tx_thread_identify(void) {
+    return current_thread;
+}
+
+UINT tx_thread_info_get(TX_THREAD *thread_ptr, CHAR **name, UINT *state, ULONG *run_count, UINT *priority,
+        UINT *preemption_threshold, ULONG *time_slice, TX_THREAD **next_thread, TX_THREAD **next_suspended_thread) {
+    (void) state;
+    (void) run_count;
+    (void) time_slice;
+    (void) next_suspended_thread;
+    if (NULL == thread_ptr) {
+        return TX_THREAD_ERROR;
+    }
+    if (name) {
+        *name = thread_ptr->name;
+    }
+    if (priority) {
+        *priority = thread_ptr->tx_thread_priority;
+    }
+    if (preemption_threshold) {
+        *preemption_threshold = thread_ptr->tx_thread_priority;
+    }
+    if (next_thread) {
+        *next_thread = NULL;
+    }
+    return TX_SUCCESS;
+}
+
+UINT tx_byte_pool_info_get(TX_BYTE_POOL *pool_ptr, CHAR **name, ULONG *available_bytes, ULONG *fragments,
+        TX_THREAD **first_suspended, ULONG *suspended_count, TX_BYTE_POOL **next_pool) {
+    (void) first_suspended;
+    (void) suspended_count;
+    (void) next_pool;
+    if (NULL == pool_ptr) {
+        return TX_POOL_ERROR;
+    }
+    if (name) {
+        *name = pool_ptr->tx_byte_pool_name;
+    }
+    if (available_bytes) {
+        *available_bytes = pool_ptr->tx_byte_pool_available;
+    }
+    if (fragments) {
+        *fragments = pool_ptr->tx_byte_pool_fragments;
+    }
+    return TX_SUCCESS;
+}
+
+static void *timer_thread(void *arg) {
+    TX_TIMER *timer_ptr = (TX_TIMER *) arg;
+    tx_thread_sleep(timer_ptr->initial_ticks);
+    for (;;) {
+        if (timer_ptr->active) {
+            // like the ThreadX timer thread, which runs above all application threads
+            const UINT posture = tx_interrupt_control(TX_INT_DISABLE);
+            timer_ptr->expiration(timer_ptr->input);
+            tx_interrupt_control(posture);
+        }
+        if (0 == timer_ptr->reschedule_ticks) {
+            timer_ptr->active = 0;
+            return NULL;
+        }
+        tx_thread_sleep(timer_ptr->reschedule_ticks);
+    }
+}
+
+UINT tx_timer_create(TX_TIMER *timer_ptr, CHAR *name_ptr, VOID (*expiration_function)(ULONG), ULONG expiration_input,
+        ULONG initial_ticks, ULONG reschedule_ticks, UINT auto_activate) {
+    timer_ptr->expiration = expiration_function;
+    timer_ptr->input = expiration_input;
+    timer_ptr->initial_ticks = initial_ticks;
+    timer_ptr->reschedule_ticks = reschedule_ticks;
+    timer_ptr->active = 0;
+    timer_ptr->name = name_ptr;
+    return (TX_AUTO_ACTIVATE == auto_activate) ? tx_timer_activate(timer_ptr) : TX_SUCCESS;
+}
+
+UINT tx_timer_activate(TX_TIMER *timer_ptr) {
+    if (timer_ptr->active) {
+        return 0x17; // TX_ACTIVATE_ERROR
+    }
+    timer_ptr->active = 1;
+    if (pthread_create(&timer_ptr->thread, NULL, timer_thread, timer_ptr)) {
+        timer_ptr->active = 0;
+        return TX_THREAD_ERROR;
+    }
+    pthread_detach(timer_ptr->thread);
+    return TX_SUCCESS;
+}
+
+UINT tx_timer_deactivate(TX_TIMER *timer_ptr) {
+    timer_ptr->active = 0;
+    return TX_SUCCESS;
+}
+
+ULONG tx_time_get(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ULONG) ((uint64_t) ts.tv_sec * TX_TIMER_TICKS_PER_SECOND
+            + (uint64_t) ts.tv_nsec / (1000000000ULL / TX_TIMER_TICKS_PER_SECOND));
+}
+
+UINT tx_interrupt_control(UINT new_posture) {
+    const UINT old_posture = interrupt_posture;
+    if (TX_INT_DISABLE == new_posture && TX_INT_ENABLE == old_posture) {
+        pthread_mutex_lock(&interrupt_lock);
+    } else if (TX_INT_ENABLE == new_posture && TX_INT_DISABLE == old_posture) {
+        pthread_mutex_unlock(&interrupt_lock);
+    }
+    interrupt_posture = new_posture;
+    return old_posture;
+}
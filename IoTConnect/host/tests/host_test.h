@@ -0,0 +1,37 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Checks for the host tests. A failed check prints its location and ends the test with a failure.
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        exit(EXIT_FAILURE); \
+    } \
+} while (0)
+
+#define CHECK_EQUAL(expected, actual) do { \
+    const long long expected_ = (long long) (expected); \
+    const long long actual_ = (long long) (actual); \
+    if (expected_ != actual_) { \
+        fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, actual_, expected_); \
+        exit(EXIT_FAILURE); \
+    } \
+} while (0)
+
+// Monotonic nanoseconds, for the benchmarks
+static inline uint64_t host_test_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+#endif // HOST_TEST_H
@@ -0,0 +1,86 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef HOST_TEST_CERT_H
+#define HOST_TEST_CERT_H
+
+// Self-signed P-256 certificates for the host tests.
+// Made with: openssl req -x509 -new -key <P-256 key> -subj "/O=Avnet/CN=<CN>" -days 3650 -outform DER
+// The keys are not kept, as nothing on the host signs with them.
+
+// The device certificate, with the subject O=Avnet, CN=rot-sample-host-device
+#define HOST_TEST_DEVICE_CN "rot-sample-host-device"
+
+static const unsigned char host_test_device_cert[] = {
+    0x30, 0x82, 0x01, 0xb6, 0x30, 0x82, 0x01, 0x5d, 0xa0, 0x03, 0x02, 0x01, 0x02, 0x02, 0x14, 0x60,
+    0x6a, 0x6e, 0x7b, 0x53, 0xf1, 0xed, 0x12, 0xfe, 0x76, 0x0e, 0x8d, 0xd2, 0xf7, 0xc2, 0xb6, 0xe7,
+    0x5d, 0x4c, 0x79, 0x30, 0x0a, 0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x04, 0x03, 0x02, 0x30,
+    0x31, 0x31, 0x0e, 0x30, 0x0c, 0x06, 0x03, 0x55, 0x04, 0x0a, 0x0c, 0x05, 0x41, 0x76, 0x6e, 0x65,
+    0x74, 0x31, 0x1f, 0x30, 0x1d, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0c, 0x16, 0x72, 0x6f, 0x74, 0x2d,
+    0x73, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x2d, 0x68, 0x6f, 0x73, 0x74, 0x2d, 0x64, 0x65, 0x76, 0x69,
+    0x63, 0x65, 0x30, 0x1e, 0x17, 0x0d, 0x32, 0x36, 0x31, 0x30, 0x31, 0x37, 0x30, 0x38, 0x35, 0x39,
+    0x34, 0x33, 0x5a, 0x17, 0x0d, 0x33, 0x36, 0x31, 0x30, 0x31, 0x34, 0x30, 0x38, 0x35, 0x39, 0x34,
+    0x33, 0x5a, 0x30, 0x31, 0x31, 0x0e, 0x30, 0x0c, 0x06, 0x03, 0x55, 0x04, 0x0a, 0x0c, 0x05, 0x41,
+    0x76, 0x6e, 0x65, 0x74, 0x31, 0x1f, 0x30, 0x1d, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0c, 0x16, 0x72,
+    0x6f, 0x74, 0x2d, 0x73, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x2d, 0x68, 0x6f, 0x73, 0x74, 0x2d, 0x64,
+    0x65, 0x76, 0x69, 0x63, 0x65, 0x30, 0x59, 0x30, 0x13, 0x06, 0x07, 0x2a, 0x86, 0x48, 0xce, 0x3d,
+    0x02, 0x01, 0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x03, 0x01, 0x07, 0x03, 0x42, 0x00, 0x04,
+    0x8f, 0x9f, 0xb8, 0xa5, 0x04, 0x70, 0xac, 0xc2, 0xc5, 0xc7, 0xdc, 0x71, 0x11, 0xaf, 0x7c, 0x60,
+    0x12, 0x40, 0xf2, 0x66, 0x49, 0x25, 0x9e, 0x9a, 0xab, 0xb3, 0xf2, 0x20, 0xf2, 0xcb, 0xdf, 0xea,
+    0x84, 0x99, 0xd4, 0xc4, 0xf3, 0x70, 0xbd, 0x64, 0x1a, 0xe0, 0xef, 0xb4, 0x24, 0xbd, 0x18, 0xaf,
+    0x25, 0x1a, 0x63, 0x10, 0x40, 0x38, 0xbd, 0x7e, 0xe9, 0x41, 0xeb, 0x44, 0x70, 0x05, 0x7a, 0x38,
+    0xa3, 0x53, 0x30, 0x51, 0x30, 0x1d, 0x06, 0x03, 0x55, 0x1d, 0x0e, 0x04, 0x16, 0x04, 0x14, 0xef,
+    0xfa, 0xa2, 0x2e, 0xc3, 0xcf, 0x68, 0x60, 0xed, 0x6f, 0xa9, 0xc3, 0x1f, 0xff, 0x70, 0x6a, 0xf2,
+    0x09, 0x5a, 0xd0, 0x30, 0x1f, 0x06, 0x03, 0x55, 0x1d, 0x23, 0x04, 0x18, 0x30, 0x16, 0x80, 0x14,
+    0xef, 0xfa, 0xa2, 0x2e, 0xc3, 0xcf, 0x68, 0x60, 0xed, 0x6f, 0xa9, 0xc3, 0x1f, 0xff, 0x70, 0x6a,
+    0xf2, 0x09, 0x5a, 0xd0, 0x30, 0x0f, 0x06, 0x03, 0x55, 0x1d, 0x13, 0x01, 0x01, 0xff, 0x04, 0x05,
+    0x30, 0x03, 0x01, 0x01, 0xff, 0x30, 0x0a, 0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x04, 0x03,
+    0x02, 0x03, 0x47, 0x00, 0x30, 0x44, 0x02, 0x20, 0x1e, 0xe8, 0x40, 0x9b, 0x02, 0xd0, 0xf8, 0xd4,
+    0x19, 0x7e, 0x7e, 0x08, 0x48, 0x81, 0xe8, 0x36, 0xdc, 0x12, 0xae, 0xd0, 0x63, 0x30, 0x31, 0xad,
+    0x3d, 0xba, 0x86, 0x63, 0x42, 0xee, 0xd2, 0xa4, 0x02, 0x20, 0x2b, 0xae, 0xec, 0x26, 0xdb, 0xb8,
+    0x6f, 0xfb, 0x32, 0x07, 0x08, 0xec, 0xf3, 0x6a, 0x28, 0xdc, 0x34, 0x36, 0x0c, 0x50, 0x64, 0x49,
+    0xd0, 0x2b, 0xc4, 0x48, 0x2d, 0x98, 0x52, 0x2c, 0x0c, 0xd3
+};
+
+// Offsets into host_test_device_cert, from openssl asn1parse
+#define HOST_TEST_DEVICE_CERT_NOT_BEFORE    102     // 13 bytes, "261017085943Z"
+#define HOST_TEST_DEVICE_CERT_NOT_AFTER     117     // 13 bytes, "361014085943Z"
+#define HOST_TEST_DEVICE_CERT_PUBLIC_KEY    207     // the 65 byte uncompressed point
+
+// Another one, with CN=rot-sample-host-operational, as the certificate that IoTConnect issues for a CSR
+#define HOST_TEST_OPERATIONAL_CN "rot-sample-host-operational"
+
+static const unsigned char host_test_operational_cert[] = {
+    0x30, 0x82, 0x01, 0xc0, 0x30, 0x82, 0x01, 0x67, 0xa0, 0x03, 0x02, 0x01, 0x02, 0x02, 0x14, 0x19,
+    0x15, 0xda, 0x4e, 0xd6, 0x0f, 0xd6, 0x82, 0x4f, 0x46, 0x27, 0xea, 0xea, 0xa3, 0x5c, 0x77, 0xd7,
+    0xe7, 0x0f, 0x3c, 0x30, 0x0a, 0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x04, 0x03, 0x02, 0x30,
+    0x36, 0x31, 0x0e, 0x30, 0x0c, 0x06, 0x03, 0x55, 0x04, 0x0a, 0x0c, 0x05, 0x41, 0x76, 0x6e, 0x65,
+    0x74, 0x31, 0x24, 0x30, 0x22, 0x06, 0x03, 0x55, 0x04, 0x03, 0x0c, 0x1b, 0x72, 0x6f, 0x74, 0x2d,
+    0x73, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x2d, 0x68, 0x6f, 0x73, 0x74, 0x2d, 0x6f, 0x70, 0x65, 0x72,
+    0x61, 0x74, 0x69, 0x6f, 0x6e, 0x61, 0x6c, 0x30, 0x1e, 0x17, 0x0d, 0x32, 0x36, 0x31, 0x30, 0x31,
+    0x37, 0x30, 0x39, 0x30, 0x34, 0x33, 0x39, 0x5a, 0x17, 0x0d, 0x33, 0x36, 0x31, 0x30, 0x31, 0x34,
+    0x30, 0x39, 0x30, 0x34, 0x33, 0x39, 0x5a, 0x30, 0x36, 0x31, 0x0e, 0x30, 0x0c, 0x06, 0x03, 0x55,
+    0x04, 0x0a, 0x0c, 0x05, 0x41, 0x76, 0x6e, 0x65, 0x74, 0x31, 0x24, 0x30, 0x22, 0x06, 0x03, 0x55,
+    0x04, 0x03, 0x0c, 0x1b, 0x72, 0x6f, 0x74, 0x2d, 0x73, 0x61, 0x6d, 0x70, 0x6c, 0x65, 0x2d, 0x68,
+    0x6f, 0x73, 0x74, 0x2d, 0x6f, 0x70, 0x65, 0x72, 0x61, 0x74, 0x69, 0x6f, 0x6e, 0x61, 0x6c, 0x30,
+    0x59, 0x30, 0x13, 0x06, 0x07, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x02, 0x01, 0x06, 0x08, 0x2a, 0x86,
+    0x48, 0xce, 0x3d, 0x03, 0x01, 0x07, 0x03, 0x42, 0x00, 0x04, 0x24, 0x63, 0xeb, 0xcb, 0xf6, 0x96,
+    0x06, 0x2c, 0x6c, 0xa2, 0x6d, 0xa2, 0x93, 0x7c, 0x75, 0x91, 0x76, 0xc2, 0xe4, 0x74, 0x2b, 0xce,
+    0x13, 0x32, 0x1e, 0x0d, 0x0b, 0x44, 0x4f, 0x42, 0xe3, 0xd3, 0x05, 0xa2, 0xf4, 0x42, 0x80, 0x75,
+    0x3c, 0xc6, 0x14, 0xdc, 0x89, 0xae, 0x3c, 0xba, 0x1b, 0x52, 0xb1, 0x22, 0x2e, 0x09, 0x22, 0xae,
+    0xbd, 0xd5, 0x1f, 0x78, 0xaf, 0xf2, 0x86, 0x31, 0x9c, 0xad, 0xa3, 0x53, 0x30, 0x51, 0x30, 0x1d,
+    0x06, 0x03, 0x55, 0x1d, 0x0e, 0x04, 0x16, 0x04, 0x14, 0xc7, 0x17, 0x7c, 0xeb, 0x27, 0xb6, 0xad,
+    0x6a, 0x82, 0x11, 0x3c, 0x1c, 0x0f, 0x73, 0xd6, 0x3e, 0x5b, 0xb0, 0x76, 0x7d, 0x30, 0x1f, 0x06,
+    0x03, 0x55, 0x1d, 0x23, 0x04, 0x18, 0x30, 0x16, 0x80, 0x14, 0xc7, 0x17, 0x7c, 0xeb, 0x27, 0xb6,
+    0xad, 0x6a, 0x82, 0x11, 0x3c, 0x1c, 0x0f, 0x73, 0xd6, 0x3e, 0x5b, 0xb0, 0x76, 0x7d, 0x30, 0x0f,
+    0x06, 0x03, 0x55, 0x1d, 0x13, 0x01, 0x01, 0xff, 0x04, 0x05, 0x30, 0x03, 0x01, 0x01, 0xff, 0x30,
+    0x0a, 0x06, 0x08, 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x04, 0x03, 0x02, 0x03, 0x47, 0x00, 0x30, 0x44,
+    0x02, 0x20, 0x79, 0x2c, 0xc0, 0xaf, 0x0f, 0x67, 0xa6, 0x90, 0x8c, 0xd0, 0x11, 0x33, 0xed, 0x26,
+    0x05, 0xef, 0xa9, 0xe3, 0xeb, 0x38, 0xfe, 0xb4, 0xcb, 0xb6, 0x64, 0x3a, 0xcd, 0xed, 0x8e, 0x0f,
+    0xd3, 0x29, 0x02, 0x20, 0x6e, 0xd0, 0x4c, 0x8d, 0x16, 0xf9, 0x58, 0x21, 0x4e, 0x82, 0x42, 0xdc,
+    0x71, 0x11, 0xf8, 0x8e, 0x09, 0x5e, 0x2a, 0xef, 0x30, 0x41, 0x03, 0x3f, 0x79, 0x5c, 0x62, 0x36,
+    0x47, 0x4f, 0x54, 0x5f
+};
+
+#endif // HOST_TEST_CERT_H
@@ -0,0 +1,192 @@
+//
+// Copyright: Avnet 2023
+//
+
+// Runs the PSA firmware driver of NetXDuo/App on the PSA update port, whose psa_fwu_write() takes a set time.
+// Downloads an image through the driver as the OTA download does, one TCP segment per write request, with the
+// network delivering the next segment only once the previous write returned, like a receive window that is
+// not drained while the driver is busy. Compares the end to end time of the writer thread with two buffers
+// against the driver built with one buffer, which programs each block before the write returns like the
+// driver did before the writer thread. Also checks that an image that does not match the digest of the update
+// is rejected with its last write, and cannot be installed.
+//
+// Usage: test_adu_driver [image KB]
+
+#include <string.h>
+#include "host_test.h"
+#include "nx_azure_iot_adu_agent_psa_driver.h"
+#include "delta_patch.h"
+#include "psa/crypto.h"
+
+#define DEFAULT_IMAGE_KB    128
+#define SEGMENT_SIZE        1460    // the TCP MSS, as NetX delivers the body of the HTTP response
+#define ACTIVE_IMAGE_ID     0x0101
+#define DOWNLOAD_IMAGE_ID   0x0102
+
+// the same driver, built with ADU_PSA_DRIVER_WRITE_BLOCK_COUNT 1
+void nx_azure_iot_adu_agent_psa_driver_serial(NX_AZURE_IOT_ADU_AGENT_DRIVER *driver_req_ptr,
+        nx_azure_iot_adu_agent_psa_driver_context_t *ctx);
+
+typedef void (*psa_driver)(NX_AZURE_IOT_ADU_AGENT_DRIVER *driver_req_ptr,
+        nx_azure_iot_adu_agent_psa_driver_context_t *ctx);
+
+static uint8_t *image;
+static size_t image_size;
+static char image_sha256[48];
+
+static void sleep_us(uint64_t us) {
+    const struct timespec ts = {(time_t) (us / 1000000), (long) (us % 1000000) * 1000L};
+    nanosleep(&ts, NULL);
+}
+
+static void base64_encode(const uint8_t *data, size_t size, char *out) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t o = 0;
+    for (size_t i = 0; i < size; i += 3) {
+        const uint32_t v = ((uint32_t) data[i] << 16) | (i + 1 < size ? (uint32_t) data[i + 1] << 8 : 0)
+                | (i + 2 < size ? data[i + 2] : 0);
+        out[o++] = alphabet[(v >> 18) & 63];
+        out[o++] = alphabet[(v >> 12) & 63];
+        out[o++] = (i + 1 < size) ? alphabet[(v >> 6) & 63] : '=';
+        out[o++] = (i + 2 < size) ? alphabet[v & 63] : '=';
+    }
+    out[o] = 0;
+}
+
+static void make_image(size_t size) {
+    image_size = size;
+    image = (uint8_t *) malloc(size);
+    CHECK(image != NULL);
+    uint32_t x = 2463534242u;
+    for (size_t i = 0; i < size; i++) { // does not compress, and does not start like a delta
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        image[i] = (uint8_t) x;
+    }
+    uint8_t digest[32];
+    size_t length;
+    CHECK_EQUAL(PSA_SUCCESS, psa_hash_compute(PSA_ALG_SHA_256, image, size, digest, sizeof(digest), &length));
+    base64_encode(digest, sizeof(digest), image_sha256);
+}
+
+static UINT request(psa_driver driver, nx_azure_iot_adu_agent_psa_driver_context_t *ctx, UINT command,
+        const uint8_t *data, UINT offset, UINT size) {
+    NX_AZURE_IOT_ADU_AGENT_DRIVER req;
+    memset(&req, 0, sizeof(req));
+    req.nx_azure_iot_adu_agent_driver_command = command;
+    req.nx_azure_iot_adu_agent_driver_firmware_size = (UINT) image_size;
+    req.nx_azure_iot_adu_agent_driver_firmware_sha256 = (const UCHAR *) image_sha256;
+    req.nx_azure_iot_adu_agent_driver_firmware_sha256_length = (UINT) strlen(image_sha256);
+    req.nx_azure_iot_adu_agent_driver_firmware_data_offset = offset;
+    req.nx_azure_iot_adu_agent_driver_firmware_data_ptr = (UCHAR *) data;
+    req.nx_azure_iot_adu_agent_driver_firmware_data_size = size;
+    driver(&req, ctx);
+    return req.nx_azure_iot_adu_agent_driver_status;
+}
+
+static void init_context(nx_azure_iot_adu_agent_psa_driver_context_t *ctx) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->active_image_id = ACTIVE_IMAGE_ID;
+    ctx->download_image_id = DOWNLOAD_IMAGE_ID;
+}
+
+static void check_staged(void) {
+    size_t staged_size;
+    const uint8_t *staged = psa_fwu_port_staged(DOWNLOAD_IMAGE_ID, &staged_size);
+    CHECK(staged != NULL);
+    // the last block is padded to the programming unit
+    CHECK(staged_size >= image_size && staged_size < image_size + FLASH0_PROG_UNIT);
+    CHECK(0 == memcmp(staged, image, image_size));
+}
+
+// Returns the time from the preprocess request to the install in seconds
+static double download(psa_driver driver, uint32_t segment_us) {
+    nx_azure_iot_adu_agent_psa_driver_context_t ctx;
+    init_context(&ctx);
+    const uint64_t start = host_test_ns();
+    CHECK_EQUAL(NX_AZURE_IOT_SUCCESS, request(driver, &ctx, NX_AZURE_IOT_ADU_AGENT_DRIVER_PREPROCESS, NULL, 0, 0));
+    for (size_t offset = 0; offset < image_size; offset += SEGMENT_SIZE) {
+        sleep_us(segment_us);
+        const UINT size = (UINT) (image_size - offset < SEGMENT_SIZE ? image_size - offset : SEGMENT_SIZE);
+        CHECK_EQUAL(NX_AZURE_IOT_SUCCESS, request(driver, &ctx, NX_AZURE_IOT_ADU_AGENT_DRIVER_WRITE,
+                &image[offset], (UINT) offset, size));
+    }
+    CHECK_EQUAL(NX_AZURE_IOT_SUCCESS, request(driver, &ctx, NX_AZURE_IOT_ADU_AGENT_DRIVER_INSTALL, NULL, 0, 0));
+    const double seconds = (double) (host_test_ns() - start) / 1e9;
+    check_staged();
+    return seconds;
+}
+
+// A byte that was corrupted on the way fails the last write, which drops the staged image, and the install
+static void test_corrupted_download(void) {
+    nx_azure_iot_adu_agent_psa_driver_context_t ctx;
+    init_context(&ctx);
+    psa_fwu_port_set_write_time_us(0);
+    CHECK_EQUAL(NX_AZURE_IOT_SUCCESS, request(nx_azure_iot_adu_agent_psa_driver, &ctx,
+            NX_AZURE_IOT_ADU_AGENT_DRIVER_PREPROCESS, NULL, 0, 0));
+    const size_t corrupted = image_size / 2;
+    image[corrupted] ^= 0x10;
+    CHECK_EQUAL(NX_AZURE_IOT_SUCCESS, request(nx_azure_iot_adu_agent_psa_driver, &ctx,
+            NX_AZURE_IOT_ADU_AGENT_DRIVER_WRITE, image, 0, (UINT) (image_size - 1)));
+    CHECK_EQUAL(NX_AZURE_IOT_FAILURE, request(nx_azure_iot_adu_agent_psa_driver, &ctx,
+            NX_AZURE_IOT_ADU_AGENT_DRIVER_WRITE, &image[image_size - 1], (UINT) (image_size - 1), 1));
+    image[corrupted] ^= 0x10;
+    psa_image_info_t info;
+    CHECK_EQUAL(PSA_SUCCESS, psa_fwu_query(DOWNLOAD_IMAGE_ID, &info));
+    CHECK_EQUAL(PSA_IMAGE_UNDEFINED, info.state);
+    CHECK_EQUAL(NX_AZURE_IOT_FAILURE, request(nx_azure_iot_adu_agent_psa_driver, &ctx,
+            NX_AZURE_IOT_ADU_AGENT_DRIVER_INSTALL, NULL, 0, 0));
+}
+
+// The driver is built without ADU_PSA_DRIVER_DELTA, so it refuses a delta instead of staging it as an image
+static void test_delta_refused(void) {
+    nx_azure_iot_adu_agent_psa_driver_context_t ctx;
+    init_context(&ctx);
+    const uint32_t magic = DELTA_PATCH_MAGIC;
+    memcpy(image, &magic, sizeof(magic)); // little endian, as in the delta header
+    CHECK_EQUAL(NX_AZURE_IOT_SUCCESS, request(nx_azure_iot_adu_agent_psa_driver, &ctx,
+            NX_AZURE_IOT_ADU_AGENT_DRIVER_PREPROCESS, NULL, 0, 0));
+    CHECK_EQUAL(NX_AZURE_IOT_FAILURE, request(nx_azure_iot_adu_agent_psa_driver, &ctx,
+            NX_AZURE_IOT_ADU_AGENT_DRIVER_WRITE, image, 0, SEGMENT_SIZE));
+    free(image);
+}
+
+typedef struct scenario {
+    const char *name;
+    uint32_t network_kbps;      // KB/s
+    uint32_t block_write_us;    // per PSA_FWU_MAX_BLOCK_SIZE bytes
+} scenario;
+
+int main(int argc, char *argv[]) {
+    const size_t image_kb = argc > 1 ? (size_t) strtoul(argv[1], NULL, 10) : DEFAULT_IMAGE_KB;
+    make_image(image_kb * 1024);
+    test_delta_refused();
+    make_image(image_kb * 1024);
+    const psa_image_version_t version = {1, 1, 0, 0};
+    psa_fwu_port_set_active(ACTIVE_IMAGE_ID, &version);
+    test_corrupted_download();
+
+    const scenario scenarios[] = {
+        // the flash and the secure call at about 4 ms per KB, against networks of three speeds
+        {"fast network", 1000, 4000},
+        {"network as fast as the flash", 250, 4000},
+        {"slow network", 50, 4000},
+    };
+    printf("image %zu KB, write block %d B\n", image_kb, PSA_FWU_MAX_BLOCK_SIZE);
+    printf("%-30s %8s %10s %10s %10s %8s\n", "scenario", "net KB/s", "flash KB/s", "serial s", "overlap s",
+            "speedup");
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        const scenario *s = &scenarios[i];
+        const uint32_t segment_us = (uint32_t) ((uint64_t) SEGMENT_SIZE * 1000000 / (s->network_kbps * 1024));
+        psa_fwu_port_set_write_time_us(s->block_write_us);
+        const double serial = download(nx_azure_iot_adu_agent_psa_driver_serial, segment_us);
+        const double overlapped = download(nx_azure_iot_adu_agent_psa_driver, segment_us);
+        printf("%-30s %8u %10.0f %10.2f %10.2f %7.2fx\n", s->name, s->network_kbps,
+                PSA_FWU_MAX_BLOCK_SIZE * 1e6 / 1024 / s->block_write_us, serial, overlapped, serial / overlapped);
+        // the download and the flash overlap, so the time is that of the slower of the two, not of their sum
+        CHECK(overlapped < serial);
+    }
+    free(image);
+    return 0;
+}
@@ -0,0 +1,188 @@
+//
+// Copyright: Avnet 2023
+//
+
+// Checks the PSA auth driver on the host stand-ins of the SDK interface, the device identity and ITS.
+// The certificates are parsed once, when the driver is created: the CN lookups answer the same string each time,
+// and the auth profiler counts one certificate parse for each. An operational certificate of the cert store is
+// the one of the connection, and the device identity stays the bootstrap identity. A certificate that does not
+// parse has no CN. There are no keys on the host, so a CSR fails at the key generation.
+// Then times the CN lookup against parsing the certificate on each call, as the "auth-bench-cn" command does on
+// the device.
+//
+// Usage: test_auth_driver [benchmark iterations]
+
+#include <string.h>
+#include "host_test.h"
+#include "host_test_cert.h"
+#include "auth_profiler.h"
+#include "cert_store.h"
+#include "device_identity.h"
+#include "psa/internal_trusted_storage.h"
+#include "stm32_psa_auth_driver.h"
+
+#define DEFAULT_ITERATIONS  10000u
+#define DEVICE_KEY_ID       0x100u
+#define OPERATIONAL_KEY_ID  0x300u // the key ID of slot 0 in the driver
+
+typedef struct driver {
+    IotcAuthInterface auth;
+    IotcDdimInterface ddim;
+    IotcAuthInterfaceContext context;
+} driver;
+
+static void create(driver *d) {
+    struct stm32_psa_driver_parameters parameters = {0};
+    memset(d, 0, sizeof(*d));
+    CHECK_EQUAL(0, stm32_psa_create_auth_driver(&d->auth, &d->ddim, &d->context, &parameters));
+}
+
+static uint32_t parses(void) {
+    return auth_profiler_get(AUTH_PROFILE_X509_INITIALIZE)->calls;
+}
+
+static void test_parser(void) {
+    NX_SECURE_X509_CERT cert;
+    CHECK_EQUAL(NX_SECURE_TLS_SUCCESS, nx_secure_x509_certificate_initialize(&cert, (UCHAR *) host_test_device_cert,
+            sizeof(host_test_device_cert), NX_NULL, 0, NX_NULL, 0, NX_SECURE_X509_KEY_TYPE_NONE));
+    const NX_SECURE_X509_DISTINGUISHED_NAME *name = &cert.nx_secure_x509_distinguished_name;
+    CHECK_EQUAL(strlen(HOST_TEST_DEVICE_CN), name->nx_secure_x509_common_name_length);
+    CHECK(0 == memcmp(HOST_TEST_DEVICE_CN, name->nx_secure_x509_common_name, strlen(HOST_TEST_DEVICE_CN)));
+    CHECK(cert.nx_secure_x509_not_before == &host_test_device_cert[HOST_TEST_DEVICE_CERT_NOT_BEFORE]);
+    CHECK_EQUAL(13, cert.nx_secure_x509_not_before_length);
+    CHECK(cert.nx_secure_x509_not_after == &host_test_device_cert[HOST_TEST_DEVICE_CERT_NOT_AFTER]);
+    CHECK_EQUAL(13, cert.nx_secure_x509_not_after_length);
+    const NX_SECURE_EC_PUBLIC_KEY *key = &cert.nx_secure_x509_public_key.ec_public_key;
+    CHECK(key->nx_secure_ec_public_key == &host_test_device_cert[HOST_TEST_DEVICE_CERT_PUBLIC_KEY]);
+    CHECK_EQUAL(65, key->nx_secure_ec_public_key_length);
+    CHECK_EQUAL(0x04, key->nx_secure_ec_public_key[0]);
+
+    // a certificate cut anywhere does not parse
+    for (USHORT length = 1; length < sizeof(host_test_device_cert); length++) {
+        CHECK_EQUAL(NX_SECURE_X509_INVALID_CERTIFICATE, nx_secure_x509_certificate_initialize(&cert,
+                (UCHAR *) host_test_device_cert, length, NX_NULL, 0, NX_NULL, 0, NX_SECURE_X509_KEY_TYPE_NONE));
+    }
+}
+
+static void test_device_identity(void) {
+    device_identity_host_set(host_test_device_cert, sizeof(host_test_device_cert), DEVICE_KEY_ID);
+    auth_profiler_reset();
+    const unsigned int retrievals = device_identity_host_retrievals();
+    driver d;
+    create(&d);
+    CHECK_EQUAL(retrievals + 1, device_identity_host_retrievals());
+    CHECK_EQUAL(1, parses());
+
+    uint8_t *cert;
+    size_t cert_size;
+    CHECK_EQUAL(0, d.auth.get_cert(d.context, &cert, &cert_size));
+    CHECK(cert == host_test_device_cert);
+    CHECK_EQUAL(sizeof(host_test_device_cert), cert_size);
+    CHECK_EQUAL(0, d.ddim.get_bootstrap_cert(d.context, &cert, &cert_size));
+    CHECK(cert == host_test_device_cert);
+
+    uint8_t *key;
+    size_t key_size;
+    CHECK_EQUAL(0, d.auth.get_private_key(d.context, &key, &key_size));
+    CHECK_EQUAL(sizeof(uint32_t), key_size);
+    CHECK_EQUAL(DEVICE_KEY_ID, *(uint32_t *) key);
+    CHECK_EQUAL(NX_SECURE_X509_KEY_TYPE_HARDWARE, d.auth.get_azrtos_private_key_type(d.context));
+
+    // without an operational certificate, both are the device identity
+    const char *cn = d.ddim.extract_bootstrap_cn(d.context);
+    CHECK(cn != NULL);
+    CHECK(0 == strcmp(HOST_TEST_DEVICE_CN, cn));
+    for (int i = 0; i < 100; i++) {
+        CHECK(cn == d.ddim.extract_bootstrap_cn(d.context));
+        CHECK(cn == d.ddim.extract_operational_cn(d.context));
+    }
+    CHECK_EQUAL(1, parses());
+    CHECK_EQUAL(retrievals + 1, device_identity_host_retrievals());
+    CHECK_EQUAL(201, auth_profiler_get(AUTH_PROFILE_EXTRACT_CN)->calls);
+
+    // no keys on the host: the CSR fails to generate one, and there is no CSR for a certificate
+    uint8_t *csr;
+    size_t csr_size;
+    CHECK_EQUAL(-2, d.ddim.generate_csr(d.context, HOST_TEST_OPERATIONAL_CN, &csr, &csr_size));
+    CHECK_EQUAL(-2, d.ddim.store_operational_cert(d.context, (uint8_t *) host_test_operational_cert,
+            sizeof(host_test_operational_cert)));
+    CHECK_EQUAL(0, stm32_psa_release_auth_driver(d.context));
+}
+
+static void test_operational_cert(void) {
+    // as if a previous run received the certificate for its CSR
+    cert_store_storage storage;
+    cert_store store;
+    cert_store_its_storage_init(&storage);
+    CHECK_EQUAL(0, cert_store_init(&store, &storage));
+    const int slot = cert_store_staging_slot(&store);
+    CHECK_EQUAL(0, slot);
+    CHECK_EQUAL(0, cert_store_stage_key(&store, slot, OPERATIONAL_KEY_ID));
+    CHECK_EQUAL(0, cert_store_commit(&store, slot, host_test_operational_cert, sizeof(host_test_operational_cert)));
+
+    device_identity_host_set(host_test_device_cert, sizeof(host_test_device_cert), DEVICE_KEY_ID);
+    auth_profiler_reset();
+    driver d;
+    create(&d);
+    CHECK_EQUAL(2, parses());
+
+    uint8_t *cert;
+    size_t cert_size;
+    CHECK_EQUAL(0, d.auth.get_cert(d.context, &cert, &cert_size));
+    CHECK_EQUAL(sizeof(host_test_operational_cert), cert_size);
+    CHECK(0 == memcmp(host_test_operational_cert, cert, cert_size));
+    uint8_t *key;
+    size_t key_size;
+    CHECK_EQUAL(0, d.auth.get_private_key(d.context, &key, &key_size));
+    CHECK_EQUAL(OPERATIONAL_KEY_ID, *(uint32_t *) key);
+
+    const char *operational_cn = d.ddim.extract_operational_cn(d.context);
+    const char *bootstrap_cn = d.ddim.extract_bootstrap_cn(d.context);
+    CHECK(operational_cn != NULL && bootstrap_cn != NULL);
+    CHECK(0 == strcmp(HOST_TEST_OPERATIONAL_CN, operational_cn));
+    CHECK(0 == strcmp(HOST_TEST_DEVICE_CN, bootstrap_cn));
+    CHECK(operational_cn == d.ddim.extract_operational_cn(d.context));
+    CHECK_EQUAL(2, parses());
+    CHECK_EQUAL(0, stm32_psa_release_auth_driver(d.context));
+
+    // back to the device identity for the rest
+    psa_its_port_reset();
+}
+
+static void test_invalid_cert(void) {
+    device_identity_host_set(host_test_device_cert, sizeof(host_test_device_cert) - 1, DEVICE_KEY_ID);
+    driver d;
+    create(&d);
+    CHECK(NULL == d.ddim.extract_bootstrap_cn(d.context));
+    CHECK(NULL == d.ddim.extract_operational_cn(d.context));
+    CHECK_EQUAL(-1, stm32_psa_benchmark_extract_cn(d.context, 0));
+    CHECK_EQUAL(-2, stm32_psa_benchmark_extract_cn(d.context, 1));
+    CHECK_EQUAL(0, stm32_psa_release_auth_driver(d.context));
+}
+
+static void test_benchmark(unsigned int iterations) {
+    device_identity_host_set(host_test_device_cert, sizeof(host_test_device_cert), DEVICE_KEY_ID);
+    driver d;
+    create(&d);
+    const char *cn = d.ddim.extract_bootstrap_cn(d.context);
+    CHECK(cn != NULL);
+    auth_profiler_reset();
+    CHECK_EQUAL(0, stm32_psa_benchmark_extract_cn(d.context, iterations));
+    CHECK_EQUAL(iterations, parses());
+    // the benchmark parses on the side: the view of the driver is the one from before
+    CHECK(cn == d.ddim.extract_bootstrap_cn(d.context));
+    CHECK(0 == strcmp(HOST_TEST_DEVICE_CN, cn));
+    auth_profiler_print();
+    CHECK_EQUAL(0, stm32_psa_release_auth_driver(d.context));
+}
+
+int main(int argc, char *argv[]) {
+    const unsigned int iterations = (unsigned int) (argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_ITERATIONS);
+    CHECK(iterations > 0);
+    test_parser();
+    test_device_identity();
+    test_operational_cert();
+    test_invalid_cert();
+    test_benchmark(iterations);
+    return 0;
+}
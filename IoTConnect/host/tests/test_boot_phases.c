@@ -0,0 +1,149 @@
+//
+// Copyright: Avnet 2023
+//
+
+// Runs the concurrent startup with boot_phases.c: a network thread that gets the IP address, creates the DNS
+// client and syncs the time like NetXDuo/App/app_netxduo.c, a lookup thread that resolves the discovery host,
+// and the app thread that initializes what does not need the network and then waits for both before it
+// connects, like app_startup() in iotconnect_app.c. The network steps are sleeps of fixed length. The DNS client
+// serves one query at a time, so the two lookups are serialized. Checks the times that boot_phases_print()
+// reports against the dependencies of the steps, and compares the first publish with the sum of the steps,
+// which is what the previous sequential startup took.
+
+#include <string.h>
+#include <unistd.h>
+#include "host_test.h"
+#include "app_platform.h"
+#include "boot_phases.h"
+
+#define DHCP_MS             120
+#define SNTP_LOOKUP_MS      60
+#define SNTP_SYNC_MS        250
+#define DISCOVERY_LOOKUP_MS 60
+#define APP_INIT_MS         180
+#define CONNECT_MS          150
+#define PUBLISH_MS          10
+#define TOLERANCE_MS        40  // scheduling and the timer tick of the host port
+
+static TX_MUTEX dns_client;
+static TX_THREAD network_thread;
+static TX_THREAD lookup_thread;
+static volatile bool lookup_done = false;
+
+static void dns_lookup(uint32_t ms) {
+    CHECK_EQUAL(TX_SUCCESS, tx_mutex_get(&dns_client, TX_WAIT_FOREVER));
+    app_platform_sleep_ms(ms);
+    tx_mutex_put(&dns_client);
+}
+
+static void network_entry(ULONG input) {
+    (void) input;
+    app_platform_sleep_ms(DHCP_MS);
+    boot_phases_mark(BOOT_PHASE_IP_ADDRESS);
+    boot_phases_mark(BOOT_PHASE_DNS_READY);
+    dns_lookup(SNTP_LOOKUP_MS);
+    app_platform_sleep_ms(SNTP_SYNC_MS);
+    boot_phases_mark(BOOT_PHASE_TIME_SYNCED);
+}
+
+static void lookup_entry(ULONG input) {
+    (void) input;
+    CHECK_EQUAL(TX_SUCCESS, boot_phases_wait(BOOT_PHASE_BIT(BOOT_PHASE_DNS_READY), TX_WAIT_FOREVER));
+    // the network thread runs at a higher priority and queries first
+    app_platform_sleep_ms(5);
+    dns_lookup(DISCOVERY_LOOKUP_MS);
+    boot_phases_mark(BOOT_PHASE_DISCOVERY_LOOKUP);
+    lookup_done = true;
+}
+
+// The times of boot_phases_print()
+static void read_phases(uint32_t phase_ms[BOOT_PHASE_COUNT]) {
+    static const char *const names[BOOT_PHASE_COUNT] = {"IP address", "DNS ready", "Discovery host lookup",
+            "Time synced", "App ready", "Connected", "First publish"};
+    FILE *output = tmpfile();
+    CHECK(output != NULL);
+    fflush(stdout);
+    const int saved = dup(STDOUT_FILENO);
+    CHECK(saved >= 0 && dup2(fileno(output), STDOUT_FILENO) >= 0);
+    boot_phases_print();
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+
+    char line[128];
+    rewind(output);
+    memset(phase_ms, 0xFF, BOOT_PHASE_COUNT * sizeof(uint32_t));
+    while (fgets(line, sizeof(line), output)) {
+        fputs(line, stdout);
+        for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+            const char *name = strstr(line, names[i]);
+            unsigned long ms;
+            if (name && 1 == sscanf(name + strlen(names[i]), " %lu ms", &ms)) {
+                phase_ms[i] = (uint32_t) ms;
+            }
+        }
+    }
+    fclose(output);
+}
+
+static void check_between(uint32_t ms, uint32_t first, uint32_t last) {
+    if (ms < first || ms > last + TOLERANCE_MS) {
+        fprintf(stderr, "%u ms is not between %u and %u ms\n", ms, first, last);
+        CHECK(false);
+    }
+}
+
+int main(void) {
+    CHECK_EQUAL(TX_SUCCESS, boot_phases_init());
+    CHECK_EQUAL(TX_SUCCESS, tx_mutex_create(&dns_client, "DNS Client", TX_NO_INHERIT));
+    CHECK(!boot_phases_reached(BOOT_PHASE_IP_ADDRESS));
+    CHECK_EQUAL(TX_SUCCESS, tx_thread_create(&network_thread, "Network", network_entry, 0, NULL, 0, 10, 10,
+            TX_NO_TIME_SLICE, TX_AUTO_START));
+    CHECK_EQUAL(TX_SUCCESS, tx_thread_create(&lookup_thread, "Lookup", lookup_entry, 0, NULL, 0, 20, 20,
+            TX_NO_TIME_SLICE, TX_AUTO_START));
+
+    // the app thread
+    app_platform_sleep_ms(APP_INIT_MS);
+    boot_phases_mark(BOOT_PHASE_APP_READY);
+    const ULONG network_phases = BOOT_PHASE_BIT(BOOT_PHASE_TIME_SYNCED) | BOOT_PHASE_BIT(BOOT_PHASE_DISCOVERY_LOOKUP);
+    // a wait that times out before the phases are reached
+    CHECK(TX_SUCCESS != boot_phases_wait(network_phases, 1));
+    CHECK_EQUAL(TX_SUCCESS, boot_phases_wait(network_phases, 10 * TX_TIMER_TICKS_PER_SECOND));
+    CHECK(boot_phases_reached(BOOT_PHASE_TIME_SYNCED) && boot_phases_reached(BOOT_PHASE_DISCOVERY_LOOKUP));
+    app_platform_sleep_ms(CONNECT_MS);
+    boot_phases_mark(BOOT_PHASE_CONNECTED);
+    app_platform_sleep_ms(PUBLISH_MS);
+    boot_phases_mark(BOOT_PHASE_FIRST_PUBLISH);
+    // a reconnect does not move the phases
+    app_platform_sleep_ms(50);
+    boot_phases_mark(BOOT_PHASE_CONNECTED);
+    boot_phases_mark(BOOT_PHASE_FIRST_PUBLISH);
+    while (!lookup_done) {
+        app_platform_sleep_ms(1);
+    }
+
+    uint32_t ms[BOOT_PHASE_COUNT];
+    read_phases(ms);
+    const uint32_t ip = DHCP_MS;
+    const uint32_t synced = ip + SNTP_LOOKUP_MS + SNTP_SYNC_MS;
+    const uint32_t looked_up = ip + SNTP_LOOKUP_MS + DISCOVERY_LOOKUP_MS;
+    check_between(ms[BOOT_PHASE_IP_ADDRESS], ip, ip);
+    check_between(ms[BOOT_PHASE_DNS_READY], ms[BOOT_PHASE_IP_ADDRESS], ip);
+    check_between(ms[BOOT_PHASE_TIME_SYNCED], synced, synced);
+    // the discovery lookup waits for the DNS client
+    check_between(ms[BOOT_PHASE_DISCOVERY_LOOKUP], looked_up, looked_up);
+    check_between(ms[BOOT_PHASE_APP_READY], APP_INIT_MS, APP_INIT_MS);
+    // the connect starts once the time is synced and the discovery host is resolved, and not before
+    const uint32_t ready = ms[BOOT_PHASE_TIME_SYNCED] > ms[BOOT_PHASE_DISCOVERY_LOOKUP] ?
+            ms[BOOT_PHASE_TIME_SYNCED] : ms[BOOT_PHASE_DISCOVERY_LOOKUP];
+    check_between(ms[BOOT_PHASE_CONNECTED], ready + CONNECT_MS, ready + CONNECT_MS);
+    check_between(ms[BOOT_PHASE_FIRST_PUBLISH], ms[BOOT_PHASE_CONNECTED] + PUBLISH_MS,
+            ms[BOOT_PHASE_CONNECTED] + PUBLISH_MS);
+
+    const uint32_t sequential = DHCP_MS + SNTP_LOOKUP_MS + SNTP_SYNC_MS + APP_INIT_MS + DISCOVERY_LOOKUP_MS
+            + CONNECT_MS + PUBLISH_MS;
+    printf("First publish after %u ms, %u ms with the sequential startup\n", ms[BOOT_PHASE_FIRST_PUBLISH],
+            sequential);
+    CHECK(ms[BOOT_PHASE_FIRST_PUBLISH] + APP_INIT_MS / 2 < sequential);
+    return 0;
+}
@@ -0,0 +1,469 @@
+//
+// Copyright: Avnet 2023
+//
+
+// Checks cert_store.c on the file storage of cert_store_file.c, which stands in for ITS: a certificate that is
+// staged and committed is active after a reload, a power loss between the certificate and the table write
+// keeps the old certificate, a certificate that fails to load falls back to the newest other one, and new keys
+// are staged in the oldest slot. Then decodes the output of csr_writer.c as a PKCS#10 request, with signature
+// values that need a leading zero in DER and ones that need leading zeros stripped.
+//
+// Usage: test_cert_store [work directory]
+
+#include <string.h>
+#include "host_test.h"
+#include "cert_store.h"
+#include "csr_writer.h"
+
+#define KEY_ID(slot) (0x300u + (slot))
+
+static const char *directory = ".";
+
+// Storage that passes on to the file storage, and fails a write of the table when asked, like a power loss
+// after the certificate was written
+typedef struct crashing_storage {
+    cert_store_storage file;
+    cert_store_storage storage;
+    bool fail_table_write;
+} crashing_storage;
+
+static int crashing_read(void *context, uint32_t item, uint8_t *data, uint32_t size, uint32_t *actual_size) {
+    crashing_storage *c = (crashing_storage *) context;
+    return c->file.read(c->file.context, item, data, size, actual_size);
+}
+
+static int crashing_write(void *context, uint32_t item, const uint8_t *data, uint32_t size) {
+    crashing_storage *c = (crashing_storage *) context;
+    if (c->fail_table_write && CERT_STORE_ITEM_TABLE == item) {
+        return CERT_STORE_ERROR_STORAGE;
+    }
+    return c->file.write(c->file.context, item, data, size);
+}
+
+static void open_storage(crashing_storage *c) {
+    memset(c, 0, sizeof(*c));
+    CHECK_EQUAL(0, cert_store_file_storage_init(&c->file, directory));
+    c->storage.context = c;
+    c->storage.read = crashing_read;
+    c->storage.write = crashing_write;
+}
+
+static void item_path(char *path, size_t size, uint32_t item) {
+    snprintf(path, size, "%s/cert-store-%lu", directory, (unsigned long) item);
+}
+
+static void remove_items(void) {
+    char path[512];
+    for (uint32_t item = 0; item <= CERT_STORE_ITEM_CERT(CERT_STORE_SLOT_COUNT - 1); item++) {
+        item_path(path, sizeof(path), item);
+        remove(path);
+    }
+}
+
+// Replaces the item with the first size bytes of the data
+static void write_item(uint32_t item, const void *data, size_t size) {
+    char path[512];
+    item_path(path, sizeof(path), item);
+    FILE *file = fopen(path, "wb");
+    CHECK(NULL != file);
+    CHECK_EQUAL(size, fwrite(data, 1, size, file));
+    CHECK_EQUAL(0, fclose(file));
+}
+
+// A certificate stand-in, filled with its tag
+static void make_cert(uint8_t *cert, uint32_t size, uint8_t tag) {
+    memset(cert, tag, size);
+}
+
+static void check_active(const cert_store *store, int slot, const uint8_t *cert, uint32_t cert_size) {
+    const uint8_t *active_cert = NULL;
+    uint32_t active_size = 0;
+    uint32_t key_id = 0;
+    CHECK_EQUAL(slot, store->active);
+    CHECK(cert_store_active(store, &active_cert, &active_size, &key_id));
+    CHECK_EQUAL(cert_size, active_size);
+    CHECK(0 == memcmp(cert, active_cert, cert_size));
+    CHECK_EQUAL(KEY_ID(slot), key_id);
+}
+
+// Stages a key in the slot that the store picks, and commits the certificate for it
+static int rotate(cert_store *store, const uint8_t *cert, uint32_t cert_size) {
+    const int slot = cert_store_staging_slot(store);
+    CHECK(slot >= 0 && slot < CERT_STORE_SLOT_COUNT);
+    CHECK(slot != store->active);
+    CHECK_EQUAL(0, cert_store_stage_key(store, slot, KEY_ID(slot)));
+    CHECK_EQUAL(CERT_STORE_SLOT_KEY_STAGED, store->slots[slot].state);
+    CHECK_EQUAL(0, cert_store_commit(store, slot, cert, cert_size));
+    return slot;
+}
+
+static void test_commit_reload(void) {
+    static cert_store store;
+    crashing_storage storage;
+    uint8_t first[300];
+    uint8_t second[CERT_STORE_MAX_CERT_SIZE];
+    make_cert(first, sizeof(first), 0xA1);
+    make_cert(second, sizeof(second), 0xB2);
+    remove_items();
+    open_storage(&storage);
+
+    CHECK_EQUAL(0, cert_store_init(&store, &storage.storage));
+    CHECK_EQUAL(CERT_STORE_NONE, store.active);
+    CHECK(!cert_store_active(&store, NULL, NULL, NULL));
+
+    // a staged key is not active, also not after a reload
+    CHECK_EQUAL(0, cert_store_stage_key(&store, 0, KEY_ID(0)));
+    CHECK_EQUAL(0, cert_store_init(&store, &storage.storage));
+    CHECK_EQUAL(CERT_STORE_NONE, store.active);
+    CHECK_EQUAL(CERT_STORE_SLOT_KEY_STAGED, store.slots[0].state);
+    CHECK_EQUAL(0, cert_store_commit(&store, 0, first, sizeof(first)));
+    check_active(&store, 0, first, sizeof(first));
+    CHECK_EQUAL(1, store.generation);
+
+    CHECK_EQUAL(0, cert_store_init(&store, &storage.storage));
+    check_active(&store, 0, first, sizeof(first));
+    CHECK_EQUAL(1, store.slots[0].generation);
+
+    // the next certificate goes to the other slot, and the previous one stays intact
+    CHECK_EQUAL(1, rotate(&store, second, sizeof(second)));
+    check_active(&store, 1, second, sizeof(second));
+    CHECK_EQUAL(0, cert_store_init(&store, &storage.storage));
+    check_active(&store, 1, second, sizeof(second));
+    CHECK_EQUAL(2, store.generation);
+    CHECK_EQUAL(CERT_STORE_SLOT_READY, store.slots[0].state);
+    CHECK(0 == memcmp(first, store.slots[0].cert, sizeof(first)));
+
+    // the active slot cannot be staged or committed, nor a slot without a staged key
+    CHECK_EQUAL(CERT_STORE_ERROR_STATE, cert_store_stage_key(&store, 1, KEY_ID(1)));
+    CHECK_EQUAL(CERT_STORE_ERROR_STATE, cert_store_commit(&store, 1, first, sizeof(first)));
+    CHECK_EQUAL(CERT_STORE_ERROR_STATE, cert_store_commit(&store, 0, first, sizeof(first)));
+    CHECK_EQUAL(CERT_STORE_ERROR_STATE, cert_store_stage_key(&store, CERT_STORE_SLOT_COUNT, KEY_ID(0)));
+    CHECK_EQUAL(0, cert_store_stage_key(&store, 0, KEY_ID(0)));
+    CHECK_EQUAL(CERT_STORE_ERROR_SIZE, cert_store_commit(&store, 0, first, 0));
+    CHECK_EQUAL(CERT_STORE_ERROR_SIZE, cert_store_commit(&store, 0, second, CERT_STORE_MAX_CERT_SIZE + 1));
+    check_active(&store, 1, second, sizeof(second));
+    cert_store_file_storage_close(&storage.file);
+}
+
+static void test_crash_before_table_write(void) {
+    static cert_store store;
+    crashing_storage storage;
+    uint8_t old_cert[200];
+    uint8_t new_cert[250];
+    make_cert(old_cert, sizeof(old_cert), 0x01);
+    make_cert(new_cert, sizeof(new_cert), 0x02);
+    remove_items();
+    open_storage(&storage);
+    CHECK_EQUAL(0, cert_store_init(&store, &storage.storage));
+    CHECK_EQUAL(0, rotate(&store, old_cert, sizeof(old_cert)));
+
+    // the certificate of the new slot is written, then the power fails before the table is
+    CHECK_EQUAL(0, cert_store_stage_key(&store, 1, KEY_ID(1)));
+    storage.fail_table_write = true;
+    CHECK_EQUAL(CERT_STORE_ERROR_STORAGE, cert_store_commit(&store, 1, new_cert, sizeof(new_cert)));
+    storage.fail_table_write = false;
+    check_active(&store, 0, old_cert, sizeof(old_cert));
+    CHECK_EQUAL(CERT_STORE_SLOT_KEY_STAGED, store.slots[1].state);
+    CHECK_EQUAL(1, store.generation);
+
+    // after the restart, the old certificate is still the active one, and the new key still waits for its own
+    CHECK_EQUAL(0, cert_store_init(&store, &storage.storage));
+    check_active(&store, 0, old_cert, sizeof(old_cert));
+    CHECK_EQUAL(CERT_STORE_SLOT_KEY_STAGED, store.slots[1].state);
+    CHECK_EQUAL(0, store.slots[1].cert_size);
+    CHECK_EQUAL(1, store.generation);
+
+    // and the commit can be done again
+    CHECK_EQUAL(0, cert_store_commit(&store, 1, new_cert, sizeof(new_cert)));
+    CHECK_EQUAL(0, cert_store_init(&store, &storage.storage));
+    check_active(&store, 1, new_cert, sizeof(new_cert));
+    cert_store_file_storage_close(&storage.file);
+}
+
+static void test_load_fallback(void) {
+    static cert_store store;
+    crashing_storage storage;
+    uint8_t certs[3][100];
+    for (int i = 0; i < 3; i++) {
+        make_cert(certs[i], sizeof(certs[i]), (uint8_t) (0x10 + i));
+    }
+    remove_items();
+    open_storage(&storage);
+    CHECK_EQUAL(0, cert_store_init(&store, &storage.storage));
+    // generation 1 in slot 0, 2 in slot 1, then 3 in slot 0 again
+    CHECK_EQUAL(0, rotate(&store, certs[0], sizeof(certs[0])));
+    CHECK_EQUAL(1, rotate(&store, certs[1], sizeof(certs[1])));
+    CHECK_EQUAL(0, rotate(&store, certs[2], sizeof(certs[2])));
+    CHECK_EQUAL(0, cert_store_init(&store, &storage.storage));
+    check_active(&store, 0, certs[2], sizeof(certs[2]));
+
+    // a table without an active slot picks the newest certificate
+    uint8_t table[256];
+    uint32_t table_size = 0;
+    CHECK_EQUAL(0, storage.file.read(storage.file.context, CERT_STORE_ITEM_TABLE, table, sizeof(table), &table_size));
+    uint8_t no_active[256];
+    memcpy(no_active, table, table_size);
+    memset(&no_active[8], 0xFF, 4);
+    write_item(CERT_STORE_ITEM_TABLE, no_active, table_size);
+    CHECK_EQUAL(0, cert_store_init(&store, &storage.storage));
+    check_active(&store, 0, certs[2], sizeof(certs[2]));
+    write_item(CERT_STORE_ITEM_TABLE, table, table_size);
+
+    // the active certificate is cut short: the other one, which is the newest left, is used
+    write_item(CERT_STORE_ITEM_CERT(0), certs[2], sizeof(certs[2]) - 1);
+    CHECK_EQUAL(0, cert_store_init(&store, &storage.storage));
+    check_active(&store, 1, certs[1], sizeof(certs[1]));
+    CHECK_EQUAL(CERT_STORE_SLOT_EMPTY, store.slots[0].state);
+    // and the slot that failed is the one for the next key
+    CHECK_EQUAL(0, cert_store_staging_slot(&store));
+
+    // without any certificate that loads, no slot is active, and the device identity is used
+    write_item(CERT_STORE_ITEM_CERT(1), certs[1], 0);
+    CHECK_EQUAL(0, cert_store_init(&store, &storage.storage));
+    CHECK_EQUAL(CERT_STORE_NONE, store.active);
+    CHECK(!cert_store_active(&store, NULL, NULL, NULL));
+
+    // nor with a table that is damaged
+    write_item(CERT_STORE_ITEM_TABLE, table, table_size - 1);
+    CHECK_EQUAL(0, cert_store_init(&store, &storage.storage));
+    CHECK_EQUAL(CERT_STORE_NONE, store.active);
+    CHECK_EQUAL(0, store.generation);
+    cert_store_file_storage_close(&storage.file);
+}
+
+static void set_slot(cert_store *store, int slot, cert_store_slot_state state, uint32_t generation) {
+    store->slots[slot].state = (uint8_t) state;
+    store->slots[slot].generation = generation;
+}
+
+static void test_staging_slot(void) {
+    static cert_store store;
+    memset(&store, 0, sizeof(store));
+    store.active = CERT_STORE_NONE;
+    CHECK_EQUAL(0, cert_store_staging_slot(&store));
+
+    // an empty slot first
+    set_slot(&store, 0, CERT_STORE_SLOT_READY, 4);
+    CHECK_EQUAL(1, cert_store_staging_slot(&store));
+    store.active = 0;
+    CHECK_EQUAL(1, cert_store_staging_slot(&store));
+
+    // then the oldest one that is not active
+    set_slot(&store, 1, CERT_STORE_SLOT_READY, 3);
+    CHECK_EQUAL(1, cert_store_staging_slot(&store));
+    store.active = 1;
+    CHECK_EQUAL(0, cert_store_staging_slot(&store));
+    store.active = CERT_STORE_NONE;
+    CHECK_EQUAL(1, cert_store_staging_slot(&store));
+    set_slot(&store, 1, CERT_STORE_SLOT_READY, 5);
+    CHECK_EQUAL(0, cert_store_staging_slot(&store));
+    // a key that waits for its certificate counts with the generation that the slot had
+    set_slot(&store, 1, CERT_STORE_SLOT_KEY_STAGED, 0);
+    CHECK_EQUAL(1, cert_store_staging_slot(&store));
+}
+
+// A DER element: the tag and the content
+typedef struct der {
+    uint8_t tag;
+    const uint8_t *content;
+    size_t length;
+    size_t size;        // of the whole element
+} der;
+
+// Reads the element at the start of the data, which must use the shortest length encoding
+static der der_read(const uint8_t *data, size_t size) {
+    der element = {0};
+    CHECK(size >= 2);
+    element.tag = data[0];
+    size_t header = 2;
+    if (data[1] < 0x80) {
+        element.length = data[1];
+    } else {
+        const size_t bytes = data[1] & 0x7F;
+        CHECK(bytes >= 1 && bytes <= 2 && size >= 2 + bytes);
+        CHECK(0 != data[2]);
+        for (size_t i = 0; i < bytes; i++) {
+            element.length = (element.length << 8) | data[2 + i];
+        }
+        CHECK(element.length >= (1 == bytes ? 0x80u : 0x100u));
+        header += bytes;
+    }
+    CHECK(size >= header + element.length);
+    element.content = &data[header];
+    element.size = header + element.length;
+    return element;
+}
+
+// Reads the next element of a constructed element, and moves past it
+static der der_next(der *parent, uint8_t tag) {
+    der element = der_read(parent->content, parent->length);
+    CHECK_EQUAL(tag, element.tag);
+    parent->content += element.size;
+    parent->length -= element.size;
+    return element;
+}
+
+static void check_bytes(const der *element, const uint8_t *expected, size_t size) {
+    CHECK_EQUAL(size, element->length);
+    CHECK(0 == memcmp(expected, element->content, size));
+}
+
+// Checks a DER INTEGER against a 32 byte unsigned big endian value
+static void check_integer(const der *element, const uint8_t *value) {
+    CHECK(element->length >= 1);
+    CHECK(0 == (element->content[0] & 0x80)); // positive
+    if (element->length > 1) {
+        // minimal: no leading zero, unless the next byte has its high bit set
+        CHECK(0 != element->content[0] || 0 != (element->content[1] & 0x80));
+    }
+    uint8_t decoded[33] = {0};
+    CHECK(element->length <= sizeof(decoded));
+    memcpy(&decoded[sizeof(decoded) - element->length], element->content, element->length);
+    CHECK_EQUAL(0, decoded[0]);
+    CHECK(0 == memcmp(value, &decoded[1], 32));
+}
+
+typedef struct fake_signer {
+    uint8_t signature[CSR_WRITER_SIGNATURE_SIZE];
+    uint8_t signed_data[512];
+    size_t signed_size;
+    bool fail;
+} fake_signer;
+
+static int fake_sign(void *context, const uint8_t *data, size_t size, uint8_t signature[CSR_WRITER_SIGNATURE_SIZE]) {
+    fake_signer *signer = (fake_signer *) context;
+    CHECK(size <= sizeof(signer->signed_data));
+    memcpy(signer->signed_data, data, size);
+    signer->signed_size = size;
+    memcpy(signature, signer->signature, CSR_WRITER_SIGNATURE_SIZE);
+    return signer->fail ? -1 : 0;
+}
+
+static const uint8_t OID_COMMON_NAME[] = {0x55, 0x04, 0x03};
+static const uint8_t OID_EC_PUBLIC_KEY[] = {0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x02, 0x01};
+static const uint8_t OID_PRIME256V1[] = {0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x03, 0x01, 0x07};
+static const uint8_t OID_ECDSA_WITH_SHA256[] = {0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02};
+
+// Builds a CSR with the given r and s, and decodes it
+static void check_csr(const char *cn, uint8_t r_first, uint8_t r_second, uint8_t s_first, uint8_t s_second) {
+    uint8_t public_key[CSR_WRITER_PUBLIC_KEY_SIZE];
+    public_key[0] = 0x04;
+    for (int i = 1; i < CSR_WRITER_PUBLIC_KEY_SIZE; i++) {
+        public_key[i] = (uint8_t) (i * 7);
+    }
+    fake_signer signer;
+    memset(&signer, 0, sizeof(signer));
+    for (int i = 0; i < 32; i++) {
+        signer.signature[i] = (uint8_t) (0x40 + i);
+        signer.signature[32 + i] = (uint8_t) (0x60 + i);
+    }
+    signer.signature[0] = r_first;
+    signer.signature[1] = r_second;
+    signer.signature[32] = s_first;
+    signer.signature[33] = s_second;
+
+    uint8_t csr[600];
+    const int length = csr_writer_build(csr, sizeof(csr), cn, public_key, fake_sign, &signer);
+    CHECK(length > 0);
+
+    // CertificationRequest ::= SEQUENCE { certificationRequestInfo, signatureAlgorithm, signature }
+    der request = der_read(csr, (size_t) length);
+    CHECK_EQUAL(0x30, request.tag);
+    CHECK_EQUAL(length, request.size);
+    der info = der_next(&request, 0x30);
+    // the signature is over the DER of the info
+    CHECK_EQUAL(info.size, signer.signed_size);
+    CHECK(0 == memcmp(info.content - (info.size - info.length), signer.signed_data, info.size));
+
+    // CertificationRequestInfo ::= SEQUENCE { version, subject, subjectPKInfo, [0] attributes }
+    const uint8_t version_0[] = {0x00};
+    der version = der_next(&info, 0x02);
+    check_bytes(&version, version_0, sizeof(version_0));
+    der subject = der_next(&info, 0x30);
+    der rdn = der_next(&subject, 0x31);
+    CHECK_EQUAL(0, subject.length);
+    der attribute = der_next(&rdn, 0x30);
+    CHECK_EQUAL(0, rdn.length);
+    der type = der_next(&attribute, 0x06);
+    check_bytes(&type, OID_COMMON_NAME, sizeof(OID_COMMON_NAME));
+    der value = der_next(&attribute, 0x0C);
+    check_bytes(&value, (const uint8_t *) cn, strlen(cn));
+    CHECK_EQUAL(0, attribute.length);
+
+    der key_info = der_next(&info, 0x30);
+    der algorithm = der_next(&key_info, 0x30);
+    der algorithm_oid = der_next(&algorithm, 0x06);
+    check_bytes(&algorithm_oid, OID_EC_PUBLIC_KEY, sizeof(OID_EC_PUBLIC_KEY));
+    der curve = der_next(&algorithm, 0x06);
+    check_bytes(&curve, OID_PRIME256V1, sizeof(OID_PRIME256V1));
+    CHECK_EQUAL(0, algorithm.length);
+    der key = der_next(&key_info, 0x03);
+    CHECK_EQUAL(1 + CSR_WRITER_PUBLIC_KEY_SIZE, key.length);
+    CHECK_EQUAL(0, key.content[0]); // no unused bits
+    CHECK(0 == memcmp(public_key, &key.content[1], CSR_WRITER_PUBLIC_KEY_SIZE));
+    CHECK_EQUAL(0, key_info.length);
+    der attributes = der_next(&info, 0xA0);
+    CHECK_EQUAL(0, attributes.length);
+    CHECK_EQUAL(0, info.length);
+
+    der signature_algorithm = der_next(&request, 0x30);
+    der signature_oid = der_next(&signature_algorithm, 0x06);
+    check_bytes(&signature_oid, OID_ECDSA_WITH_SHA256, sizeof(OID_ECDSA_WITH_SHA256));
+    CHECK_EQUAL(0, signature_algorithm.length); // no parameters for ECDSA
+
+    // Ecdsa-Sig-Value ::= SEQUENCE { r INTEGER, s INTEGER }, in a BIT STRING
+    der signature = der_next(&request, 0x03);
+    CHECK_EQUAL(0, request.length);
+    CHECK_EQUAL(0, signature.content[0]);
+    signature.content++;
+    signature.length--;
+    der ecdsa_value = der_next(&signature, 0x30);
+    CHECK_EQUAL(0, signature.length);
+    der r = der_next(&ecdsa_value, 0x02);
+    check_integer(&r, &signer.signature[0]);
+    der s = der_next(&ecdsa_value, 0x02);
+    check_integer(&s, &signer.signature[32]);
+    CHECK_EQUAL(0, ecdsa_value.length);
+
+    // every smaller buffer is refused, and nothing is written past its end
+    for (size_t size = 0; size < (size_t) length; size++) {
+        uint8_t small[sizeof(csr) + 1];
+        memset(small, 0xEE, sizeof(small));
+        CHECK_EQUAL(CSR_WRITER_ERROR_SIZE, csr_writer_build(small, size, cn, public_key, fake_sign, &signer));
+        for (size_t i = size; i < sizeof(small); i++) {
+            CHECK_EQUAL(0xEE, small[i]);
+        }
+    }
+    signer.fail = true;
+    CHECK_EQUAL(CSR_WRITER_ERROR_SIGN, csr_writer_build(csr, sizeof(csr), cn, public_key, fake_sign, &signer));
+}
+
+static void test_csr(void) {
+    char long_cn[121];
+    memset(long_cn, 'd', sizeof(long_cn) - 1);
+    long_cn[sizeof(long_cn) - 1] = 0;
+
+    // r and s with the high bit set need a leading zero
+    check_csr("device-1", 0x80, 0x00, 0xFF, 0xFF);
+    // without it, they are written as they are
+    check_csr("device-1", 0x7F, 0xFF, 0x01, 0x00);
+    // leading zeros are stripped, down to where the high bit is set, or not
+    check_csr("device-1", 0x00, 0x80, 0x00, 0x7F);
+    check_csr("device-1", 0x00, 0x00, 0x00, 0x00);
+    // a CN that takes the lengths past 127 and 255 bytes
+    check_csr(long_cn, 0x80, 0x01, 0x80, 0x01);
+    check_csr("", 0x12, 0x34, 0xC0, 0xDE);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        directory = argv[1];
+    }
+    test_commit_reload();
+    test_crash_before_table_write();
+    test_load_fallback();
+    remove_items();
+    test_staging_slot();
+    test_csr();
+    return 0;
+}
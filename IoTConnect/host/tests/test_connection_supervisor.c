@@ -0,0 +1,180 @@
+//
+// Copyright: Avnet 2023
+//
+
+// Checks the reconnect delays of connection_supervisor.c with the policy of iotconnect_app_config.h, then
+// simulates a fleet of devices that lose the connection to the broker at the same time, comparing the fixed
+// reconnect delay that the app used before with the supervisor. The broker comes back after the outage and
+// accepts a limited number of connections per second. Prints the attempts over time.
+//
+// Usage: test_connection_supervisor [devices] [outage seconds] [broker accepts per second]
+
+#include <string.h>
+#include "host_test.h"
+#include "connection_supervisor.h"
+
+#define MIN_DELAY_MS            2000    // APP_RECONNECT_MIN_DELAY_MS
+#define MAX_DELAY_MS            300000  // APP_RECONNECT_MAX_DELAY_MS
+#define NETWORK_MAX_DELAY_MS    30000   // APP_RECONNECT_NETWORK_MAX_DELAY_MS
+#define STABLE_MS               60000   // APP_RECONNECT_STABLE_MS
+#define FIXED_DELAY_MS          10000   // the previous APP_RECONNECT_DELAY_MS
+#define CONNECT_TIME_MS         1000    // time a connection attempt takes
+#define BUCKET_MS               10000
+#define MAX_BUCKETS             512
+
+static const connection_backoff_policy policy = {MIN_DELAY_MS, MAX_DELAY_MS, NETWORK_MAX_DELAY_MS, STABLE_MS};
+
+static void test_delays(void) {
+    connection_supervisor supervisor;
+    connection_supervisor_init(&supervisor, &policy, connection_supervisor_seed("device", 1));
+    uint32_t delay = MIN_DELAY_MS;
+    for (int i = 0; i < 20; i++) {
+        // each delay is between half of the full delay and the full delay, which doubles up to the cap
+        const uint32_t d = connection_supervisor_on_failure(&supervisor, CONNECTION_STAGE_CLOUD);
+        CHECK(d >= delay / 2 && d <= delay);
+        delay = delay * 2 > MAX_DELAY_MS ? MAX_DELAY_MS : delay * 2;
+    }
+    // a network stage failure has its own, lower cap
+    for (int i = 0; i < 5; i++) {
+        CHECK(connection_supervisor_on_failure(&supervisor, CONNECTION_STAGE_NETWORK) <= NETWORK_MAX_DELAY_MS);
+    }
+
+    // a connection that did not last keeps backing off
+    connection_supervisor_on_connected(&supervisor, 1000);
+    CHECK(connection_supervisor_on_disconnected(&supervisor, 1000 + STABLE_MS - 1) >= MAX_DELAY_MS / 2);
+
+    // a stable connection resets the backoff, and the first attempt is spread over the minimum delay
+    connection_supervisor_on_connected(&supervisor, 100000);
+    CHECK(connection_supervisor_on_disconnected(&supervisor, 100000 + STABLE_MS) <= MIN_DELAY_MS);
+    const uint32_t d = connection_supervisor_on_failure(&supervisor, CONNECTION_STAGE_CLOUD);
+    CHECK(d >= MIN_DELAY_MS && d <= 2 * MIN_DELAY_MS);
+
+    // the time of the connection wraps around
+    connection_supervisor_on_connected(&supervisor, UINT32_MAX - 10);
+    CHECK(connection_supervisor_on_disconnected(&supervisor, STABLE_MS) <= MIN_DELAY_MS);
+
+    // devices with different IDs get different delays
+    connection_supervisor a;
+    connection_supervisor b;
+    connection_supervisor_init(&a, &policy, connection_supervisor_seed("device-1", 0));
+    connection_supervisor_init(&b, &policy, connection_supervisor_seed("device-2", 0));
+    int same = 0;
+    for (int i = 0; i < 10; i++) {
+        same += connection_supervisor_on_failure(&a, CONNECTION_STAGE_CLOUD)
+                == connection_supervisor_on_failure(&b, CONNECTION_STAGE_CLOUD);
+    }
+    CHECK(same < 10);
+
+    // a zero seed still gives random delays
+    connection_supervisor_init(&a, &policy, 0);
+    CHECK(connection_supervisor_on_failure(&a, CONNECTION_STAGE_CLOUD)
+            != connection_supervisor_on_failure(&a, CONNECTION_STAGE_CLOUD) / 2);
+}
+
+typedef struct fleet_result {
+    uint32_t attempts[MAX_BUCKETS];
+    uint32_t total_attempts;
+    uint32_t buckets;
+    uint32_t peak_after_outage;
+    uint32_t done_ms;
+} fleet_result;
+
+// All devices lose the connection at time 0, with the supervisor or with the fixed delay
+static void simulate(bool backoff, uint32_t devices, uint32_t outage_ms, uint32_t accepts_per_s,
+        fleet_result *result) {
+    connection_supervisor *supervisors = (connection_supervisor *) calloc(devices, sizeof(connection_supervisor));
+    uint32_t *next_ms = (uint32_t *) calloc(devices, sizeof(uint32_t));
+    bool *connected = (bool *) calloc(devices, sizeof(bool));
+    CHECK(supervisors && next_ms && connected);
+    memset(result, 0, sizeof(*result));
+    for (uint32_t i = 0; i < devices; i++) {
+        char id[32];
+        snprintf(id, sizeof(id), "device-%u", i);
+        connection_supervisor_init(&supervisors[i], &policy, connection_supervisor_seed(id, i * 7919));
+        connection_supervisor_on_connected(&supervisors[i], 0);
+        next_ms[i] = backoff ? connection_supervisor_on_disconnected(&supervisors[i], 0) : FIXED_DELAY_MS;
+    }
+    uint32_t second = UINT32_MAX;
+    uint32_t accepted_in_second = 0;
+    for (uint32_t remaining = devices; remaining > 0;) {
+        uint32_t device = 0;
+        uint32_t time_ms = UINT32_MAX;
+        for (uint32_t i = 0; i < devices; i++) {
+            if (!connected[i] && next_ms[i] < time_ms) {
+                time_ms = next_ms[i];
+                device = i;
+            }
+        }
+        const uint32_t bucket = time_ms / BUCKET_MS;
+        CHECK(bucket < MAX_BUCKETS);
+        result->attempts[bucket]++;
+        result->total_attempts++;
+        if (bucket + 1 > result->buckets) {
+            result->buckets = bucket + 1;
+        }
+        if (time_ms / 1000 != second) {
+            second = time_ms / 1000;
+            accepted_in_second = 0;
+        }
+        if (time_ms >= outage_ms && accepted_in_second < accepts_per_s) {
+            accepted_in_second++;
+            connected[device] = true;
+            remaining--;
+            if (time_ms + CONNECT_TIME_MS > result->done_ms) {
+                result->done_ms = time_ms + CONNECT_TIME_MS;
+            }
+        } else {
+            next_ms[device] = time_ms + CONNECT_TIME_MS + (backoff ?
+                    connection_supervisor_on_failure(&supervisors[device], CONNECTION_STAGE_CLOUD) : FIXED_DELAY_MS);
+        }
+    }
+    for (uint32_t bucket = outage_ms / BUCKET_MS; bucket < result->buckets; bucket++) {
+        if (result->attempts[bucket] > result->peak_after_outage) {
+            result->peak_after_outage = result->attempts[bucket];
+        }
+    }
+    free(connected);
+    free(next_ms);
+    free(supervisors);
+}
+
+static void print_curve(const char *name, const fleet_result *result, uint32_t devices) {
+    uint32_t peak = 1;
+    for (uint32_t bucket = 0; bucket < result->buckets; bucket++) {
+        if (result->attempts[bucket] > peak) {
+            peak = result->attempts[bucket];
+        }
+    }
+    printf("%s: all %u devices connected after %u s, %u attempts in total, peak %u attempts per %d s after "
+            "the outage\n", name, devices, result->done_ms / 1000, result->total_attempts,
+            result->peak_after_outage, BUCKET_MS / 1000);
+    for (uint32_t bucket = 0; bucket < result->buckets; bucket++) {
+        const uint32_t count = result->attempts[bucket];
+        printf("%6u s %6u ", bucket * BUCKET_MS / 1000, count);
+        for (uint32_t i = 0; i < 60 * count / peak; i++) {
+            putchar('#');
+        }
+        putchar('\n');
+    }
+    putchar('\n');
+}
+
+int main(int argc, char *argv[]) {
+    const uint32_t devices = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 10) : 1000;
+    const uint32_t outage_ms = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 10) * 1000 : 120000;
+    const uint32_t accepts_per_s = argc > 3 ? (uint32_t) strtoul(argv[3], NULL, 10) : 20;
+    test_delays();
+
+    printf("%u devices, %u s broker outage, broker accepts %u connections per second\n\n", devices,
+            outage_ms / 1000, accepts_per_s);
+    static fleet_result fixed;
+    static fleet_result backoff;
+    simulate(false, devices, outage_ms, accepts_per_s, &fixed);
+    simulate(true, devices, outage_ms, accepts_per_s, &backoff);
+    print_curve("Fixed 10 s delay", &fixed, devices);
+    print_curve("Jittered backoff", &backoff, devices);
+    // the backoff spreads the load on the broker once it is back, with fewer attempts overall
+    CHECK(backoff.peak_after_outage < fixed.peak_after_outage);
+    CHECK(backoff.total_attempts < fixed.total_attempts);
+    return 0;
+}
@@ -0,0 +1,224 @@
+//
+// Copyright: Avnet 2023
+//
+
+// Generates deltas with scripts/delta-generate.py and applies them with delta_patch.c, fed in chunks of
+// every size up to a limit and in random chunks, and compares the result with the new image. Also checks
+// that a delta against another source image, and a truncated or corrupted delta, are rejected, and
+// reports the apply throughput of the C decoder on the host.
+//
+// Usage: test_delta_patch [work directory]
+
+#include <string.h>
+#include "host_test.h"
+#include "delta_patch.h"
+#include "psa/crypto.h"
+
+#define IMAGE_SIZE      (48 * 1024)
+#define MAX_EVEN_CHUNK  80  // chunk sizes tried one by one, past the header and the op fields
+#define BENCH_RUNS      20
+
+typedef struct buffer {
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+} buffer;
+
+// The context of the writer and of the source check
+typedef struct patch_context {
+    const buffer *source;
+    buffer *result;
+} patch_context;
+
+static const char *work_directory = ".";
+static uint32_t seed = 2463534242u;
+
+static uint32_t next_random(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static int buffer_write(void *context, const uint8_t *data, size_t size) {
+    buffer *b = ((patch_context *) context)->result;
+    if (b->size + size > b->capacity) {
+        return -100;
+    }
+    memcpy(&b->data[b->size], data, size);
+    b->size += size;
+    return 0;
+}
+
+static int check_source(void *context, const uint8_t *digest, uint32_t source_size) {
+    const buffer *source = ((const patch_context *) context)->source;
+    if (source_size > source->size) {
+        return -1;
+    }
+    return PSA_SUCCESS == psa_hash_compare(PSA_ALG_SHA_256, source->data, source_size, digest,
+            DELTA_PATCH_DIGEST_SIZE) ? 0 : -1;
+}
+
+static void write_file(const char *name, const buffer *b) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", work_directory, name);
+    FILE *f = fopen(path, "wb");
+    CHECK(f != NULL);
+    CHECK_EQUAL(b->size, fwrite(b->data, 1, b->size, f));
+    fclose(f);
+}
+
+static buffer read_file(const char *name) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", work_directory, name);
+    FILE *f = fopen(path, "rb");
+    CHECK(f != NULL);
+    fseek(f, 0, SEEK_END);
+    buffer b = {NULL, (size_t) ftell(f), 0};
+    fseek(f, 0, SEEK_SET);
+    b.capacity = b.size;
+    b.data = (uint8_t *) malloc(b.size ? b.size : 1);
+    CHECK(b.data != NULL);
+    CHECK_EQUAL(b.size, fread(b.data, 1, b.size, f));
+    fclose(f);
+    return b;
+}
+
+// Runs the generator of the repository on the two images
+static buffer generate(const buffer *source, const buffer *target) {
+    write_file("delta-old.bin", source);
+    write_file("delta-new.bin", target);
+    char command[2048];
+    snprintf(command, sizeof(command), "\"%s\" \"%s\" \"%s/delta-old.bin\" \"%s/delta-new.bin\" \"%s/delta.bin\""
+            " > /dev/null", PYTHON_EXECUTABLE, DELTA_GENERATE_SCRIPT, work_directory, work_directory,
+            work_directory);
+    CHECK_EQUAL(0, system(command));
+    return read_file("delta.bin");
+}
+
+// Applies the delta in chunks of the given size, or of random sizes up to 4 KB for 0.
+// Returns the result of the last feed.
+static int apply(const buffer *source, const buffer *delta, size_t chunk, buffer *result) {
+    delta_patch patch;
+    patch_context context = {source, result};
+    result->size = 0;
+    delta_patch_init(&patch, source->data, (uint32_t) source->size, buffer_write, check_source, &context);
+    for (size_t offset = 0; offset < delta->size;) {
+        size_t size = chunk ? chunk : 1 + next_random() % 4096;
+        if (size > delta->size - offset) {
+            size = delta->size - offset;
+        }
+        const int status = delta_patch_feed(&patch, &delta->data[offset], size);
+        if (status) {
+            return status;
+        }
+        offset += size;
+    }
+    return delta_patch_done(&patch) ? 0 : DELTA_PATCH_ERROR_FORMAT;
+}
+
+static buffer make_buffer(size_t capacity) {
+    buffer b = {(uint8_t *) malloc(capacity), 0, capacity};
+    CHECK(b.data != NULL);
+    return b;
+}
+
+// Something like code: short repeated instruction patterns with varying operands
+static void make_old_image(buffer *image) {
+    image->size = IMAGE_SIZE;
+    for (size_t i = 0; i < image->size; i += 4) {
+        const uint32_t word = (next_random() % 16) << 24 | (uint32_t) (i & 0xFFFF) | (next_random() % 4) << 20;
+        memcpy(&image->data[i], &word, 4);
+    }
+}
+
+// The old image with a block inserted, a function moved by a few bytes with its addresses changed,
+// a block removed and a new tail
+static void make_new_image(const buffer *old, buffer *image) {
+    size_t o = 0;
+    memcpy(image->data, old->data, 8192);
+    o = 8192;
+    for (int i = 0; i < 700; i++) {
+        image->data[o++] = (uint8_t) next_random();
+    }
+    memcpy(&image->data[o], &old->data[8192], 16384);
+    for (size_t i = 0; i < 16384; i += 64) {
+        image->data[o + i] = (uint8_t) (image->data[o + i] + 4); // relocated address bytes
+    }
+    o += 16384;
+    memcpy(&image->data[o], &old->data[8192 + 16384 + 2048], IMAGE_SIZE - (8192 + 16384 + 2048));
+    o += IMAGE_SIZE - (8192 + 16384 + 2048);
+    for (int i = 0; i < 1500; i++) {
+        image->data[o++] = (uint8_t) next_random();
+    }
+    image->size = o;
+}
+
+static void check_applies(const char *name, const buffer *source, const buffer *target) {
+    buffer delta = generate(source, target);
+    CHECK(delta_patch_is_delta(delta.data, delta.size));
+    buffer result = make_buffer(target->size + 1);
+    for (size_t chunk = 1; chunk <= MAX_EVEN_CHUNK; chunk++) {
+        CHECK_EQUAL(0, apply(source, &delta, chunk, &result));
+        CHECK_EQUAL(target->size, result.size);
+        CHECK(0 == memcmp(result.data, target->data, target->size));
+    }
+    for (int run = 0; run < 20; run++) {
+        CHECK_EQUAL(0, apply(source, &delta, 0, &result));
+        CHECK_EQUAL(target->size, result.size);
+        CHECK(0 == memcmp(result.data, target->data, target->size));
+    }
+    const uint64_t start = host_test_ns();
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        CHECK_EQUAL(0, apply(source, &delta, 1460, &result));
+    }
+    const double seconds = (double) (host_test_ns() - start) / 1e9 / BENCH_RUNS;
+    printf("%-12s image %6zu B, delta %6zu B (%5.1f%%), applied at %7.1f MB/s\n", name, target->size, delta.size,
+            100.0 * (double) delta.size / (double) target->size, (double) target->size / seconds / 1e6);
+    free(result.data);
+    free(delta.data);
+}
+
+static void check_rejected(const buffer *source, const buffer *target) {
+    buffer delta = generate(source, target);
+    buffer result = make_buffer(target->size + 1);
+    // against another source image
+    buffer other = make_buffer(source->size);
+    memcpy(other.data, source->data, source->size);
+    other.size = source->size;
+    other.data[100] ^= 1;
+    CHECK_EQUAL(DELTA_PATCH_ERROR_SOURCE, apply(&other, &delta, 1460, &result));
+    // truncated
+    buffer truncated = delta;
+    truncated.size = delta.size - 1;
+    CHECK(0 != apply(source, &truncated, 1460, &result));
+    // an unknown op right after the header
+    delta.data[DELTA_PATCH_HEADER_SIZE] = 0x7F;
+    CHECK_EQUAL(DELTA_PATCH_ERROR_FORMAT, apply(source, &delta, 1460, &result));
+    free(other.data);
+    free(result.data);
+    free(delta.data);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        work_directory = argv[1];
+    }
+    buffer old_image = make_buffer(IMAGE_SIZE);
+    buffer new_image = make_buffer(IMAGE_SIZE + 4096);
+    make_old_image(&old_image);
+    make_new_image(&old_image, &new_image);
+    check_applies("changed", &old_image, &new_image);
+    check_applies("same", &old_image, &old_image);
+    buffer unrelated = make_buffer(IMAGE_SIZE);
+    unrelated.size = IMAGE_SIZE;
+    for (size_t i = 0; i < unrelated.size; i++) {
+        unrelated.data[i] = (uint8_t) next_random();
+    }
+    check_applies("unrelated", &old_image, &unrelated);
+    check_rejected(&old_image, &new_image);
+    free(unrelated.data);
+    free(new_image.data);
+    free(old_image.data);
+    return 0;
+}
@@ -0,0 +1,335 @@
+//
+// Copyright: Avnet 2023
+//
+
+// Runs dns_cache.c with the NetX resolver of dns_cache_nx.c and the file storage against a stub DNS server on
+// localhost, which answers with a set TTL and delay, and can be taken down to model an outage. The clock of the
+// cache is wrapped (-Wl,--wrap=time), so that answers expire without waiting. Checks fresh, stale and expired
+// answers, the background refresh, persistence across a restart, eviction and the TTL of a CNAME chain.
+// nx_dns_host_by_name_get() is routed through the cache with DNS_CACHE_WRAP_NETX and the --wrap linker option
+// that the project uses, and the time of a connect's lookups is compared with and without the cache.
+//
+// Usage: test_dns_cache [work directory]
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "host_test.h"
+#include "app_platform.h"
+#include "dns_cache.h"
+
+#define MAX_STALE_S     3600
+#define DELAY_MS        50      // the time the resolver takes for an answer
+#define TIMEOUT_MS      300
+
+static const char *const connect_hosts[] = {"discovery.iotconnect.io",
+        "poc-iotconnect-iothub-030-eu2.azure-devices.net", "iotconnect.blob.core.windows.net"};
+
+typedef struct stub_server {
+    int fd;
+    UINT port;
+    volatile uint32_t ttl_s;
+    volatile uint32_t delay_ms;
+    volatile uint32_t address_offset;   // changes the addresses of all hosts
+    volatile bool down;
+    volatile bool cname;                // answers with a CNAME of TTL 60 in front of the address
+    volatile uint32_t queries;
+} stub_server;
+
+static stub_server server;
+static time_t fake_now = 1700000000;
+static char storage_path[512];
+
+time_t __wrap_time(time_t *t) {
+    if (t) {
+        *t = fake_now;
+    }
+    return fake_now;
+}
+
+static uint32_t host_address(const uint8_t *name, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ name[i]) * 16777619u;
+    }
+    return IP_ADDRESS(10, 0, 0, 0) | ((hash + server.address_offset) & 0xFFFFFF);
+}
+
+static uint8_t *put_u16(uint8_t *p, uint16_t value) {
+    p[0] = (uint8_t) (value >> 8);
+    p[1] = (uint8_t) value;
+    return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t value) {
+    return put_u16(put_u16(p, (uint16_t) (value >> 16)), (uint16_t) value);
+}
+
+// Answers A queries of any name, with an address derived from the name
+static void *server_entry(void *arg) {
+    (void) arg;
+    for (;;) {
+        uint8_t message[512];
+        struct sockaddr_in from;
+        socklen_t from_length = sizeof(from);
+        const ssize_t length = recvfrom(server.fd, message, sizeof(message), 0, (struct sockaddr *) &from,
+                &from_length);
+        if (length < 17) {
+            continue;
+        }
+        server.queries++;
+        if (server.down) {
+            continue;
+        }
+        app_platform_sleep_ms(server.delay_ms);
+        size_t question_end = 12;
+        while (question_end < (size_t) length && message[question_end]) {
+            question_end += 1 + message[question_end];
+        }
+        question_end += 5;
+        if (question_end > (size_t) length || question_end + 32 > sizeof(message)) {
+            continue;
+        }
+        const uint32_t address = host_address(&message[12], question_end - 5 - 12);
+        message[2] = 0x81; // response, recursion desired
+        message[3] = 0x80; // recursion available, no error
+        uint8_t *p = &message[question_end];
+        if (server.cname) {
+            message[7] = 2;
+            // the alias points back to the question name, which is good enough for the resolver
+            p = put_u16(p, 0xC00C);
+            p = put_u16(p, 5);
+            p = put_u16(p, 1);
+            p = put_u32(p, 60);
+            p = put_u16(p, 2);
+            p = put_u16(p, 0xC00C);
+        } else {
+            message[7] = 1;
+        }
+        p = put_u16(p, 0xC00C);
+        p = put_u16(p, 1);
+        p = put_u16(p, 1);
+        p = put_u32(p, server.ttl_s);
+        p = put_u16(p, 4);
+        p = put_u32(p, address);
+        sendto(server.fd, message, (size_t) (p - message), 0, (struct sockaddr *) &from, from_length);
+    }
+    return NULL;
+}
+
+static void start_server(void) {
+    server.fd = socket(AF_INET, SOCK_DGRAM, 0);
+    CHECK(server.fd >= 0);
+    struct sockaddr_in address = {0};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(0 == bind(server.fd, (struct sockaddr *) &address, sizeof(address)));
+    socklen_t length = sizeof(address);
+    CHECK(0 == getsockname(server.fd, (struct sockaddr *) &address, &length));
+    server.port = ntohs(address.sin_port);
+    server.ttl_s = 300;
+    server.delay_ms = DELAY_MS;
+    pthread_t thread;
+    CHECK(0 == pthread_create(&thread, NULL, server_entry, NULL));
+    pthread_detach(thread);
+}
+
+static uint32_t expected_address(const char *host) {
+    uint8_t name[DNS_CACHE_MAX_HOST_LENGTH + 2];
+    size_t length = 0;
+    for (const char *label = host; *label;) {
+        const char *dot = strchr(label, '.');
+        const size_t label_length = dot ? (size_t) (dot - label) : strlen(label);
+        name[length++] = (uint8_t) label_length;
+        memcpy(&name[length], label, label_length);
+        length += label_length;
+        label += label_length + (dot ? 1 : 0);
+    }
+    return host_address(name, length);
+}
+
+static dns_cache_stats get_stats(dns_cache *cache) {
+    tx_mutex_get(&cache->mutex, TX_WAIT_FOREVER);
+    const dns_cache_stats stats = cache->stats;
+    tx_mutex_put(&cache->mutex);
+    return stats;
+}
+
+// Waits for the refresh thread to finish the refreshes it was asked for
+static void wait_refreshed(dns_cache *cache, uint32_t refreshes, uint32_t failures) {
+    for (int i = 0; i < 2 * TIMEOUT_MS; i++) {
+        const dns_cache_stats stats = get_stats(cache);
+        if (stats.refreshes >= refreshes && stats.refresh_failures >= failures) {
+            CHECK_EQUAL(refreshes, stats.refreshes);
+            CHECK_EQUAL(failures, stats.refresh_failures);
+            return;
+        }
+        app_platform_sleep_ms(5);
+    }
+    CHECK(false); // the refresh did not happen
+}
+
+static void open_cache(dns_cache *cache, dns_cache_storage *storage, dns_cache_nx_resolver *resolver) {
+    CHECK_EQUAL(0, dns_cache_file_storage_init(storage, storage_path));
+    CHECK_EQUAL(0, dns_cache_init(cache, storage, dns_cache_nx_resolve, resolver, MAX_STALE_S));
+    CHECK_EQUAL(TX_SUCCESS, dns_cache_start_refresh(cache, NULL, 0, 12));
+}
+
+static void test_cache(dns_cache_nx_resolver *resolver) {
+    static dns_cache cache;
+    static dns_cache_storage storage;
+    const char *host = connect_hosts[0];
+    const uint32_t address = expected_address(host);
+    uint32_t found = 0;
+    open_cache(&cache, &storage, resolver);
+
+    // a miss waits for the resolver, and a hit does not
+    server.ttl_s = 5; // below DNS_CACHE_MIN_TTL_S
+    uint32_t queries = server.queries;
+    CHECK_EQUAL(0, dns_cache_lookup(&cache, host, &found));
+    CHECK_EQUAL(address, found);
+    CHECK_EQUAL(queries + 1, server.queries);
+    fake_now += DNS_CACHE_MIN_TTL_S - 1;
+    CHECK_EQUAL(0, dns_cache_lookup(&cache, host, &found));
+    CHECK_EQUAL(queries + 1, server.queries);
+    CHECK_EQUAL(1, get_stats(&cache).hits);
+
+    // an expired answer is served right away and refreshed in the background, with the new address
+    server.address_offset = 1;
+    fake_now += 2;
+    CHECK_EQUAL(0, dns_cache_lookup(&cache, host, &found));
+    CHECK_EQUAL(address, found);
+    CHECK_EQUAL(1, get_stats(&cache).stale_hits);
+    wait_refreshed(&cache, 1, 0);
+    CHECK_EQUAL(0, dns_cache_lookup(&cache, host, &found));
+    CHECK_EQUAL(expected_address(host), found);
+    server.address_offset = 0;
+
+    // during an outage, the stale answer stays in use
+    server.ttl_s = 300;
+    server.down = true;
+    fake_now += 600;
+    CHECK_EQUAL(0, dns_cache_lookup(&cache, host, &found));
+    wait_refreshed(&cache, 1, 1);
+    CHECK_EQUAL(0, dns_cache_lookup(&cache, host, &found));
+    CHECK(0 != found);
+    // until it is older than the max stale time, or if it was never resolved
+    CHECK_EQUAL(DNS_CACHE_ERROR_RESOLVE, dns_cache_lookup(&cache, connect_hosts[1], &found));
+    fake_now += MAX_STALE_S + 60;
+    CHECK_EQUAL(DNS_CACHE_ERROR_RESOLVE, dns_cache_lookup(&cache, host, &found));
+    server.down = false;
+    wait_refreshed(&cache, 1, 2);
+
+    // names that do not fit
+    char long_name[DNS_CACHE_MAX_HOST_LENGTH + 1];
+    memset(long_name, 'a', sizeof(long_name) - 1);
+    long_name[sizeof(long_name) - 1] = 0;
+    CHECK_EQUAL(DNS_CACHE_ERROR_NAME, dns_cache_lookup(&cache, long_name, &found));
+
+    // the lowest TTL of a CNAME chain is kept
+    server.cname = true;
+    server.ttl_s = 3600;
+    CHECK_EQUAL(0, dns_cache_lookup(&cache, "alias.iotconnect.io", &found));
+    CHECK_EQUAL(expected_address("alias.iotconnect.io"), found);
+    server.cname = false;
+    fake_now += 61;
+    CHECK_EQUAL(0, dns_cache_lookup(&cache, "alias.iotconnect.io", &found));
+    wait_refreshed(&cache, 2, 2);
+
+    // the least recently used entry is evicted
+    for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "host%d.iotconnect.io", i);
+        CHECK_EQUAL(0, dns_cache_lookup(&cache, name, &found));
+    }
+    queries = server.queries;
+    CHECK_EQUAL(0, dns_cache_lookup(&cache, "host1.iotconnect.io", &found));
+    CHECK_EQUAL(0, dns_cache_lookup(&cache, "alias.iotconnect.io", &found)); // evicted
+    CHECK_EQUAL(queries + 1, server.queries);
+    dns_cache_print(&cache);
+    dns_cache_file_storage_close(&storage);
+
+    // after a restart, the answers are served from the storage without a query
+    static dns_cache restarted;
+    static dns_cache_storage restarted_storage;
+    open_cache(&restarted, &restarted_storage, resolver);
+    queries = server.queries;
+    CHECK_EQUAL(0, dns_cache_lookup(&restarted, "host1.iotconnect.io", &found));
+    CHECK_EQUAL(expected_address("host1.iotconnect.io"), found);
+    CHECK_EQUAL(queries, server.queries);
+    CHECK_EQUAL(1, get_stats(&restarted).hits);
+    dns_cache_file_storage_close(&restarted_storage);
+}
+
+// Looks up the hosts of a connect with nx_dns_host_by_name_get(), like the SDK does. Returns the time in ms.
+static uint32_t connect_lookups(NX_DNS *dns) {
+    const uint64_t start = host_test_ns();
+    for (size_t i = 0; i < sizeof(connect_hosts) / sizeof(connect_hosts[0]); i++) {
+        ULONG address = 0;
+        CHECK_EQUAL(NX_SUCCESS, nx_dns_host_by_name_get(dns, (UCHAR *) connect_hosts[i], &address,
+                TIMEOUT_MS * NX_IP_PERIODIC_RATE / 1000));
+        CHECK_EQUAL(expected_address(connect_hosts[i]), address);
+    }
+    return (uint32_t) ((host_test_ns() - start) / 1000000);
+}
+
+static void test_routed_lookups(NX_DNS *dns, dns_cache_nx_resolver *resolver) {
+    static dns_cache cache;
+    static dns_cache_storage storage;
+    remove(storage_path);
+    open_cache(&cache, &storage, resolver);
+    server.ttl_s = 300;
+
+    // without the cache, every connect waits for the DNS server
+    const ULONG lookups = dns->lookups;
+    const uint32_t uncached_ms = connect_lookups(dns);
+    CHECK_EQUAL(lookups + 3, dns->lookups);
+
+    dns_cache_nx_route_lookups(&cache);
+    const uint32_t first_ms = connect_lookups(dns); // fills the cache
+    uint32_t queries = server.queries;
+    const uint32_t cached_ms = connect_lookups(dns);
+    CHECK_EQUAL(queries, server.queries);
+    // expired answers do not hold up the connect either
+    fake_now += 600;
+    const uint32_t stale_ms = connect_lookups(dns);
+    wait_refreshed(&cache, 3, 0);
+    // none of these went to the NetX lookup
+    CHECK_EQUAL(lookups + 3, dns->lookups);
+
+    // a host that the cache can not resolve falls back to the NetX lookup
+    server.down = true;
+    ULONG address;
+    CHECK(NX_SUCCESS != nx_dns_host_by_name_get(dns, (UCHAR *) "new.iotconnect.io", &address,
+            TIMEOUT_MS * NX_IP_PERIODIC_RATE / 1000));
+    CHECK_EQUAL(lookups + 4, dns->lookups);
+    server.down = false;
+    dns_cache_nx_route_lookups(NULL);
+    dns_cache_file_storage_close(&storage);
+
+    printf("Lookups of a connect with a %d ms resolver: %u ms without the cache, %u ms on the first connect, "
+            "%u ms cached, %u ms expired\n", DELAY_MS, uncached_ms, first_ms, cached_ms, stale_ms);
+    CHECK(uncached_ms >= 3 * DELAY_MS);
+    CHECK(cached_ms < DELAY_MS && stale_ms < DELAY_MS);
+}
+
+int main(int argc, char *argv[]) {
+    snprintf(storage_path, sizeof(storage_path), "%s/dns-cache.bin", argc > 1 ? argv[1] : ".");
+    remove(storage_path);
+    start_server();
+    static NX_IP ip;
+    static NX_PACKET_POOL pool;
+    static NX_DNS dns;
+    ip.host_udp_port_override = server.port;
+    CHECK_EQUAL(NX_SUCCESS, nx_dns_create(&dns, &ip, (UCHAR *) "DNS Client"));
+    CHECK_EQUAL(NX_SUCCESS, nx_dns_server_add(&dns, IP_ADDRESS(127, 0, 0, 1)));
+    dns_cache_nx_resolver resolver = {&ip, &pool, &dns, TIMEOUT_MS * NX_IP_PERIODIC_RATE / 1000};
+
+    test_cache(&resolver);
+    test_routed_lookups(&dns, &resolver);
+    remove(storage_path);
+    return 0;
+}
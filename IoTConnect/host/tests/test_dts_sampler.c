@@ -0,0 +1,254 @@
+//
+// Copyright: Avnet 2023
+//
+
+// Checks dts_sampler.c with the fake sensor of dts_sampler_fake.c. The statistics of the window are compared
+// with a reference over the last DTS_SAMPLER_WINDOW readings, before and after the window wraps. The rate
+// timer runs against a busy sensor, to count the missed triggers, and the deadband change detection must
+// signal once per reported value. Then a thread produces readings as fast as it can, like an interrupt at a
+// rate no timer gets to, while the test reads the statistics, and every snapshot must be consistent.
+//
+// Usage: test_dts_sampler [high rate readings]
+
+#include <string.h>
+#include "host_test.h"
+#include "dts_sampler.h"
+
+#define DEFAULT_READINGS    2000000UL
+#define TIMER_RATE_HZ       TX_TIMER_TICKS_PER_SECOND  // the highest rate of the timer
+#define TIMER_RUN_TICKS     (TX_TIMER_TICKS_PER_SECOND / 2)
+
+// A pseudo random spread of values around zero
+static int32_t scattered(void *context, uint32_t index) {
+    (void) context;
+    return (int32_t) ((index * 37u) % 101u) * 10 - 500;
+}
+
+// Holds the level the context points to
+static int32_t level(void *context, uint32_t index) {
+    (void) index;
+    return *(const int32_t *) context;
+}
+
+// A triangle between 20 and 30 degrees, in steps of 1 milli degree
+static int32_t triangle(void *context, uint32_t index) {
+    (void) context;
+    const uint32_t phase = index % 20000u;
+    return 20000 + (int32_t) (phase < 10000u ? phase : 20000u - phase);
+}
+
+// Starts the sampler on the fake. The rate timer is stopped unless the test runs it, so that the test decides
+// when readings arrive.
+static void start(dts_sampler *sampler, dts_sampler_hw *hw, dts_sampler_fake *fake, uint32_t rate_hz,
+        int32_t deadband, bool run_timer) {
+    CHECK_EQUAL(0, dts_sampler_start(sampler, hw, rate_hz, deadband));
+    if (!run_timer) {
+        tx_timer_deactivate(&sampler->timer);
+    }
+    CHECK(fake->sampler == sampler);
+}
+
+static void test_window(void) {
+    static dts_sampler sampler;
+    static dts_sampler_fake fake;
+    dts_sampler_hw hw;
+    memset(&fake, 0, sizeof(fake));
+    fake.waveform = scattered;
+    dts_sampler_fake_hw_init(&hw, &fake);
+    start(&sampler, &hw, &fake, TIMER_RATE_HZ, 0, false);
+
+    dts_sampler_stats stats;
+    dts_sampler_get_stats(&sampler, &stats);
+    CHECK_EQUAL(0, stats.count);
+    CHECK_EQUAL(0, stats.min);
+    CHECK_EQUAL(0, stats.max);
+    CHECK_EQUAL(0, stats.mean);
+    CHECK_EQUAL(0, stats.last);
+
+    for (uint32_t readings = 1; readings <= 3 * DTS_SAMPLER_WINDOW + 5; readings++) {
+        dts_sampler_fake_step(&fake, 1);
+        const uint32_t count = readings < DTS_SAMPLER_WINDOW ? readings : DTS_SAMPLER_WINDOW;
+        int64_t sum = 0;
+        int32_t min = INT32_MAX;
+        int32_t max = INT32_MIN;
+        for (uint32_t i = readings - count; i < readings; i++) {
+            const int32_t value = scattered(NULL, i);
+            sum += value;
+            min = value < min ? value : min;
+            max = value > max ? value : max;
+        }
+        dts_sampler_get_stats(&sampler, &stats);
+        CHECK_EQUAL(count, stats.count);
+        CHECK_EQUAL(readings, stats.readings);
+        CHECK_EQUAL(min, stats.min);
+        CHECK_EQUAL(max, stats.max);
+        CHECK_EQUAL(sum / (int64_t) count, stats.mean);
+        CHECK_EQUAL(scattered(NULL, readings - 1), stats.last);
+        CHECK_EQUAL(0, stats.missed_triggers);
+    }
+}
+
+static void set_busy(dts_sampler_fake *fake, bool busy) {
+    const UINT posture = tx_interrupt_control(TX_INT_DISABLE);
+    fake->busy = busy;
+    tx_interrupt_control(posture);
+}
+
+static void test_missed_triggers(void) {
+    static dts_sampler sampler;
+    static dts_sampler_fake fake;
+    static int32_t value = 25000;
+    dts_sampler_hw hw;
+    memset(&fake, 0, sizeof(fake));
+    fake.waveform = level;
+    fake.waveform_context = &value;
+    fake.busy = true;
+    dts_sampler_fake_hw_init(&hw, &fake);
+    start(&sampler, &hw, &fake, TIMER_RATE_HZ, 0, true);
+
+    // every trigger of the timer fails while the sensor is busy
+    tx_thread_sleep(TIMER_RUN_TICKS);
+    dts_sampler_stats busy;
+    dts_sampler_get_stats(&sampler, &busy);
+    CHECK_EQUAL(0, busy.readings);
+    CHECK_EQUAL(0, busy.count);
+    CHECK(busy.missed_triggers >= TIMER_RUN_TICKS / 2);
+    CHECK(busy.missed_triggers <= TIMER_RUN_TICKS + 1);
+
+    // and none once it is done
+    set_busy(&fake, false);
+    dts_sampler_stats ready;
+    dts_sampler_get_stats(&sampler, &ready);
+    tx_thread_sleep(TIMER_RUN_TICKS);
+    dts_sampler_stats stats;
+    dts_sampler_get_stats(&sampler, &stats);
+    tx_timer_deactivate(&sampler.timer);
+    CHECK_EQUAL(ready.missed_triggers, stats.missed_triggers);
+    CHECK(stats.readings - ready.readings >= TIMER_RUN_TICKS / 2);
+    CHECK_EQUAL(value, stats.last);
+    CHECK_EQUAL(value, stats.mean);
+    printf("Timer at %d Hz: %u missed triggers in %d ticks while busy, then %u readings\n", TIMER_RATE_HZ,
+            (unsigned) busy.missed_triggers, TIMER_RUN_TICKS, (unsigned) (stats.readings - ready.readings));
+}
+
+// Steps the fake and returns true if the change was signaled
+static bool step_signals(dts_sampler *sampler, dts_sampler_fake *fake, uint32_t count) {
+    dts_sampler_fake_step(fake, count);
+    return dts_sampler_wait_change(sampler, TX_NO_WAIT);
+}
+
+static void test_deadband(void) {
+    static dts_sampler sampler;
+    static dts_sampler_fake fake;
+    static int32_t value = 25000;
+    const int32_t deadband = 500;
+    dts_sampler_hw hw;
+    memset(&fake, 0, sizeof(fake));
+    fake.waveform = level;
+    fake.waveform_context = &value;
+    dts_sampler_fake_hw_init(&hw, &fake);
+    start(&sampler, &hw, &fake, TIMER_RATE_HZ, deadband, false);
+
+    // nothing is signaled until a value was reported
+    CHECK(!step_signals(&sampler, &fake, DTS_SAMPLER_WINDOW));
+    CHECK(dts_sampler_exceeds_deadband(&sampler, value));
+    dts_sampler_set_reported(&sampler, value);
+    CHECK(!dts_sampler_exceeds_deadband(&sampler, value + deadband - 1));
+    CHECK(dts_sampler_exceeds_deadband(&sampler, value - deadband));
+
+    // a step of twice the deadband moves the mean of the full window by the deadband after half a window
+    value = 26000;
+    CHECK(!step_signals(&sampler, &fake, DTS_SAMPLER_WINDOW / 2 - 1));
+    CHECK(step_signals(&sampler, &fake, 1));
+    // once, however long the value stays away
+    CHECK(!step_signals(&sampler, &fake, 3 * DTS_SAMPLER_WINDOW));
+    value = 24000;
+    CHECK(!step_signals(&sampler, &fake, 3 * DTS_SAMPLER_WINDOW));
+
+    // reporting re-arms it, against the new value
+    dts_sampler_set_reported(&sampler, value);
+    CHECK(!step_signals(&sampler, &fake, DTS_SAMPLER_WINDOW));
+    value = 23000;
+    CHECK(!step_signals(&sampler, &fake, DTS_SAMPLER_WINDOW / 2 - 1));
+    CHECK(step_signals(&sampler, &fake, 1));
+    CHECK(!step_signals(&sampler, &fake, DTS_SAMPLER_WINDOW));
+
+    // a change that was signaled but not yet waited for is dropped by the report
+    dts_sampler_set_reported(&sampler, 25000);
+    dts_sampler_fake_step(&fake, 1);
+    dts_sampler_set_reported(&sampler, value);
+    CHECK(!step_signals(&sampler, &fake, DTS_SAMPLER_WINDOW));
+
+    // a deadband of 0 disables it
+    static dts_sampler disabled;
+    static dts_sampler_fake disabled_fake;
+    memset(&disabled_fake, 0, sizeof(disabled_fake));
+    disabled_fake.waveform = triangle;
+    dts_sampler_fake_hw_init(&hw, &disabled_fake);
+    start(&disabled, &hw, &disabled_fake, TIMER_RATE_HZ, 0, false);
+    dts_sampler_set_reported(&disabled, 0);
+    CHECK(!step_signals(&disabled, &disabled_fake, 100));
+}
+
+static dts_sampler high_rate_sampler;
+static dts_sampler_fake high_rate_fake;
+static uint32_t high_rate_readings;
+static TX_SEMAPHORE high_rate_done;
+
+static void interrupt_entry(ULONG input) {
+    (void) input;
+    dts_sampler_fake_step(&high_rate_fake, high_rate_readings);
+    tx_semaphore_put(&high_rate_done);
+}
+
+static void test_high_rate(uint32_t readings) {
+    static TX_THREAD interrupt;
+    dts_sampler_hw hw;
+    memset(&high_rate_fake, 0, sizeof(high_rate_fake));
+    high_rate_fake.waveform = triangle;
+    dts_sampler_fake_hw_init(&hw, &high_rate_fake);
+    start(&high_rate_sampler, &hw, &high_rate_fake, TIMER_RATE_HZ, 0, false);
+    high_rate_readings = readings;
+    CHECK_EQUAL(TX_SUCCESS, tx_semaphore_create(&high_rate_done, "Done", 0));
+
+    const uint64_t start_ns = host_test_ns();
+    CHECK_EQUAL(TX_SUCCESS, tx_thread_create(&interrupt, "DTS IRQ", interrupt_entry, 0, NULL, 0, 1, 1,
+            TX_NO_TIME_SLICE, TX_AUTO_START));
+    uint32_t snapshots = 0;
+    uint32_t previous = 0;
+    dts_sampler_stats stats;
+    do {
+        dts_sampler_get_stats(&high_rate_sampler, &stats);
+        CHECK(stats.readings >= previous);
+        previous = stats.readings;
+        if (0 == stats.readings) {
+            continue;
+        }
+        // a snapshot holds the last readings, up to the one that was counted last
+        const uint32_t count = stats.readings < DTS_SAMPLER_WINDOW ? stats.readings : DTS_SAMPLER_WINDOW;
+        CHECK_EQUAL(count, stats.count);
+        CHECK_EQUAL(triangle(NULL, stats.readings - 1), stats.last);
+        CHECK(stats.min <= stats.mean && stats.mean <= stats.max);
+        CHECK(stats.max - stats.min <= (int32_t) count - 1);
+        snapshots++;
+    } while (TX_SUCCESS != tx_semaphore_get(&high_rate_done, TX_NO_WAIT));
+    const double seconds = (double) (host_test_ns() - start_ns) / 1e9;
+
+    dts_sampler_get_stats(&high_rate_sampler, &stats);
+    CHECK_EQUAL(readings, stats.readings);
+    CHECK_EQUAL(0, stats.missed_triggers);
+    CHECK_EQUAL(triangle(NULL, readings - 1), stats.last);
+    printf("High rate: %u readings at %.0f/s, %u consistent snapshots\n", (unsigned) readings,
+            (double) readings / seconds, (unsigned) snapshots);
+    tx_semaphore_delete(&high_rate_done);
+}
+
+int main(int argc, char *argv[]) {
+    const uint32_t readings = (uint32_t) (argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_READINGS);
+    CHECK(readings > 0);
+    test_window();
+    test_missed_triggers();
+    test_deadband();
+    test_high_rate(readings);
+    return 0;
+}
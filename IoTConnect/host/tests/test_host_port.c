@@ -0,0 +1,186 @@
+//
+// Copyright: Avnet 2023
+//
+
+// Checks the POSIX stand-ins of the host build against the ThreadX, PSA ITS and platform behavior that the
+// modules rely on, and runs the command dispatcher, which uses most of them, end to end.
+
+#include <string.h>
+#include "host_test.h"
+#include "app_platform.h"
+#include "command_dispatcher.h"
+#include "psa/internal_trusted_storage.h"
+#include "tx_api.h"
+
+static TX_QUEUE queue;
+static ULONG queue_storage[4 * TX_2_ULONG];
+static TX_SEMAPHORE done;
+static volatile ULONG timer_count;
+static volatile int in_critical_section;
+static volatile int timer_saw_critical_section;
+
+static void producer_entry(ULONG input) {
+    for (ULONG i = 0; i < input; i++) {
+        ULONG message[2] = {i, ~i};
+        CHECK_EQUAL(TX_SUCCESS, tx_queue_send(&queue, message, TX_WAIT_FOREVER));
+    }
+    tx_semaphore_put(&done);
+}
+
+static void timer_expired(ULONG input) {
+    (void) input;
+    if (in_critical_section) {
+        timer_saw_critical_section = 1;
+    }
+    timer_count++;
+}
+
+static void test_platform(void) {
+    const uint32_t start_ms = app_platform_time_ms();
+    const uint32_t start_cycles = app_platform_cycles();
+    app_platform_sleep_ms(50);
+    const uint32_t elapsed_ms = app_platform_time_ms() - start_ms;
+    CHECK(elapsed_ms >= 50 && elapsed_ms < 1000);
+    const uint32_t elapsed_us = (app_platform_cycles() - start_cycles) / app_platform_cycles_per_us();
+    CHECK(elapsed_us >= 50000);
+
+    const ULONG ticks = tx_time_get();
+    tx_thread_sleep(TX_TIMER_TICKS_PER_SECOND / 10);
+    CHECK(tx_time_get() - ticks >= TX_TIMER_TICKS_PER_SECOND / 10);
+}
+
+static void test_queue(void) {
+    static TX_THREAD producer;
+    const ULONG count = 10000;
+    CHECK_EQUAL(TX_SUCCESS, tx_queue_create(&queue, "Test", TX_2_ULONG, queue_storage, sizeof(queue_storage)));
+    CHECK_EQUAL(TX_SUCCESS, tx_semaphore_create(&done, "Done", 0));
+    ULONG message[2];
+    CHECK_EQUAL(TX_QUEUE_EMPTY, tx_queue_receive(&queue, message, TX_NO_WAIT));
+    CHECK_EQUAL(TX_QUEUE_EMPTY, tx_queue_receive(&queue, message, 2));
+
+    // a full queue blocks the producer, and the order is kept
+    CHECK_EQUAL(TX_SUCCESS, tx_thread_create(&producer, "Producer", producer_entry, count, NULL, 0, 1, 1,
+            TX_NO_TIME_SLICE, TX_AUTO_START));
+    for (ULONG i = 0; i < count; i++) {
+        CHECK_EQUAL(TX_SUCCESS, tx_queue_receive(&queue, message, TX_WAIT_FOREVER));
+        CHECK_EQUAL(i, message[0]);
+        CHECK_EQUAL(~i, message[1]);
+    }
+    CHECK_EQUAL(TX_SUCCESS, tx_semaphore_get(&done, TX_WAIT_FOREVER));
+
+    for (int i = 0; i < 4; i++) {
+        CHECK_EQUAL(TX_SUCCESS, tx_queue_send(&queue, message, TX_NO_WAIT));
+    }
+    CHECK_EQUAL(TX_QUEUE_FULL, tx_queue_send(&queue, message, TX_NO_WAIT));
+}
+
+static void test_semaphore_and_flags(void) {
+    TX_SEMAPHORE semaphore;
+    CHECK_EQUAL(TX_SUCCESS, tx_semaphore_create(&semaphore, "Test", 0));
+    CHECK_EQUAL(TX_SUCCESS, tx_semaphore_ceiling_put(&semaphore, 1));
+    CHECK(TX_SUCCESS != tx_semaphore_ceiling_put(&semaphore, 1));
+    CHECK_EQUAL(TX_SUCCESS, tx_semaphore_get(&semaphore, TX_NO_WAIT));
+    const ULONG before = tx_time_get();
+    CHECK_EQUAL(TX_NO_INSTANCE, tx_semaphore_get(&semaphore, 5));
+    CHECK(tx_time_get() - before >= 4);
+
+    TX_EVENT_FLAGS_GROUP flags;
+    ULONG actual;
+    CHECK_EQUAL(TX_SUCCESS, tx_event_flags_create(&flags, "Test"));
+    CHECK_EQUAL(TX_SUCCESS, tx_event_flags_set(&flags, 0x1, TX_OR));
+    CHECK_EQUAL(TX_SUCCESS, tx_event_flags_get(&flags, 0x3, TX_OR, &actual, TX_NO_WAIT));
+    CHECK_EQUAL(TX_NO_EVENTS, tx_event_flags_get(&flags, 0x3, TX_AND, &actual, 2));
+    CHECK_EQUAL(TX_SUCCESS, tx_event_flags_set(&flags, 0x2, TX_OR));
+    CHECK_EQUAL(TX_SUCCESS, tx_event_flags_get(&flags, 0x3, TX_AND_CLEAR, &actual, TX_NO_WAIT));
+    CHECK_EQUAL(0x3, actual);
+    CHECK_EQUAL(TX_NO_EVENTS, tx_event_flags_get(&flags, 0x3, TX_OR, &actual, TX_NO_WAIT));
+}
+
+static void test_timer_and_interrupts(void) {
+    static TX_TIMER timer;
+    CHECK_EQUAL(TX_SUCCESS, tx_timer_create(&timer, "Test", timer_expired, 0, 1, 1, TX_AUTO_ACTIVATE));
+    tx_thread_sleep(TX_TIMER_TICKS_PER_SECOND / 5);
+    CHECK(timer_count >= 5);
+
+    // the timer never runs while "interrupts" are disabled, also when they are disabled twice
+    for (int i = 0; i < 20; i++) {
+        const UINT outer = tx_interrupt_control(TX_INT_DISABLE);
+        const UINT inner = tx_interrupt_control(TX_INT_DISABLE);
+        CHECK_EQUAL(TX_INT_DISABLE, inner);
+        in_critical_section = 1;
+        app_platform_sleep_ms(5);
+        in_critical_section = 0;
+        tx_interrupt_control(inner);
+        tx_interrupt_control(outer);
+        app_platform_sleep_ms(1);
+    }
+    tx_timer_deactivate(&timer);
+    CHECK(!timer_saw_critical_section);
+}
+
+static void test_its(void) {
+    static uint8_t asset[ITS_MAX_ASSET_SIZE + 1];
+    size_t length = 0;
+    psa_its_port_reset();
+    CHECK_EQUAL(PSA_ERROR_DOES_NOT_EXIST, psa_its_get(1, 0, sizeof(asset), asset, &length));
+    CHECK_EQUAL(PSA_ERROR_INSUFFICIENT_STORAGE, psa_its_set(1, sizeof(asset), asset, PSA_STORAGE_FLAG_NONE));
+    for (psa_storage_uid_t uid = 1; uid <= ITS_NUM_ASSETS; uid++) {
+        memset(asset, (int) uid, sizeof(asset));
+        CHECK_EQUAL(PSA_SUCCESS, psa_its_set(uid, ITS_MAX_ASSET_SIZE, asset, PSA_STORAGE_FLAG_NONE));
+    }
+    CHECK_EQUAL(PSA_ERROR_INSUFFICIENT_STORAGE, psa_its_set(ITS_NUM_ASSETS + 1, 1, asset, PSA_STORAGE_FLAG_NONE));
+    CHECK_EQUAL(PSA_SUCCESS, psa_its_get(2, 1, 10, asset, &length));
+    CHECK_EQUAL(10, length);
+    CHECK_EQUAL(2, asset[9]);
+    CHECK_EQUAL(PSA_SUCCESS, psa_its_remove(2));
+    CHECK_EQUAL(PSA_SUCCESS, psa_its_set(ITS_NUM_ASSETS + 1, 1, asset, PSA_STORAGE_FLAG_NONE));
+    psa_its_port_reset();
+}
+
+static int acks;
+static bool last_success;
+static char last_message[COMMAND_DISPATCHER_MESSAGE_SIZE];
+
+static void on_ack(void *event, bool success, const char *command_name, const char *message) {
+    (void) event;
+    (void) command_name;
+    acks++;
+    last_success = success;
+    strncpy(last_message, message ? message : "", sizeof(last_message) - 1);
+}
+
+static bool on_echo(int argc, const char *argv[], char *message, size_t message_size) {
+    snprintf(message, message_size, "%d %s", argc, argc > 1 ? argv[1] : "");
+    return argc > 1;
+}
+
+static void test_command_dispatcher(void) {
+    static command_dispatcher dispatcher;
+    static uint8_t stack[4096];
+    static int event;
+    CHECK_EQUAL(TX_SUCCESS, command_dispatcher_init(&dispatcher, on_ack, stack, sizeof(stack), 10));
+    CHECK(command_dispatcher_register(&dispatcher, "echo", on_echo, 0));
+
+    command_dispatcher_submit(&dispatcher, &event, "echo hello");
+    CHECK_EQUAL(1, command_dispatcher_process(&dispatcher, TX_TIMER_TICKS_PER_SECOND));
+    CHECK_EQUAL(1, acks);
+    CHECK(last_success);
+    CHECK(0 == strcmp("2 hello", last_message));
+
+    command_dispatcher_submit(&dispatcher, &event, "unknown");
+    CHECK_EQUAL(2, acks);
+    CHECK(!last_success);
+
+    command_dispatcher_benchmark(&dispatcher, 1000);
+}
+
+int main(void) {
+    test_platform();
+    test_queue();
+    test_semaphore_and_flags();
+    test_timer_and_interrupts();
+    test_its();
+    test_command_dispatcher();
+    printf("host port: OK\n");
+    return 0;
+}
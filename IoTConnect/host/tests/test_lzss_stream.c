@@ -0,0 +1,199 @@
+//
+// Copyright: Avnet 2023
+//
+
+// Compresses images with scripts/compress-image.py and decompresses them with lzss_stream.c, fed in chunks of
+// every size up to a limit, in random chunks, and split in two at every byte of the stream, so that the chunk
+// boundaries fall inside literals, back references and the header. Compares the result with the image, checks
+// that a stream with a window larger than the decoder's is rejected, and reports the decode throughput of the
+// C decoder on the host.
+//
+// Usage: test_lzss_stream [work directory]
+
+#include <string.h>
+#include "host_test.h"
+#include "lzss_stream.h"
+
+#define IMAGE_SIZE      (64 * 1024)
+#define SPLIT_SIZE      3000    // bytes of the image that is split in two at each position
+#define MAX_EVEN_CHUNK  40
+#define BENCH_RUNS      20
+
+typedef struct buffer {
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+} buffer;
+
+static const char *work_directory = ".";
+static uint32_t seed = 2463534242u;
+
+static uint32_t next_random(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static buffer make_buffer(size_t capacity) {
+    buffer b = {(uint8_t *) malloc(capacity ? capacity : 1), 0, capacity};
+    CHECK(b.data != NULL);
+    return b;
+}
+
+static int buffer_write(void *context, const uint8_t *data, size_t size) {
+    buffer *b = (buffer *) context;
+    if (b->size + size > b->capacity) {
+        return -100;
+    }
+    memcpy(&b->data[b->size], data, size);
+    b->size += size;
+    return 0;
+}
+
+static buffer read_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    CHECK(f != NULL);
+    fseek(f, 0, SEEK_END);
+    buffer b = make_buffer((size_t) ftell(f));
+    b.size = b.capacity;
+    fseek(f, 0, SEEK_SET);
+    CHECK_EQUAL(b.size, fread(b.data, 1, b.size, f));
+    fclose(f);
+    return b;
+}
+
+// Runs the compressor of the repository on the image
+static buffer compress(const buffer *image, int window_bits, int lookahead_bits) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/lzss-image.bin", work_directory);
+    FILE *f = fopen(path, "wb");
+    CHECK(f != NULL);
+    CHECK_EQUAL(image->size, fwrite(image->data, 1, image->size, f));
+    fclose(f);
+    char command[2048];
+    snprintf(command, sizeof(command), "\"%s\" \"%s\" -w %d -l %d \"%s\" \"%s/lzss-image.hsz\" > /dev/null",
+            PYTHON_EXECUTABLE, COMPRESS_IMAGE_SCRIPT, window_bits, lookahead_bits, path, work_directory);
+    CHECK_EQUAL(0, system(command));
+    snprintf(path, sizeof(path), "%s/lzss-image.hsz", work_directory);
+    return read_file(path);
+}
+
+// Feeds the stream in the given chunks: first, then chunk sized pieces, or random ones for 0
+static int decompress(const buffer *blob, size_t first, size_t chunk, buffer *result) {
+    lzss_stream stream;
+    result->size = 0;
+    lzss_stream_init(&stream, buffer_write, result);
+    for (size_t offset = 0; offset < blob->size;) {
+        size_t size = (0 == offset && first) ? first : (chunk ? chunk : 1 + next_random() % 2048);
+        if (size > blob->size - offset) {
+            size = blob->size - offset;
+        }
+        const int status = lzss_stream_feed(&stream, &blob->data[offset], size);
+        if (status) {
+            return status;
+        }
+        offset += size;
+    }
+    return lzss_stream_done(&stream) ? 0 : LZSS_STREAM_ERROR_FORMAT;
+}
+
+static void check_result(const buffer *image, const buffer *result) {
+    CHECK_EQUAL(image->size, result->size);
+    CHECK(0 == memcmp(image->data, result->data, image->size));
+}
+
+// Code-like words, repeated text and a run, which give back references of all lengths and distances
+static void make_image(buffer *image, size_t size) {
+    static const char *const words[] = {"temperature", "IoTConnect ", "firmware ", "\r\n", "0x20001", " "};
+    image->size = 0;
+    while (image->size < size) {
+        const uint32_t kind = next_random() % 8;
+        if (kind < 4) {
+            const uint32_t word = (next_random() % 16) << 24 | (uint32_t) (image->size & 0xFFFF);
+            for (int i = 0; i < 4 && image->size < size; i++) {
+                image->data[image->size++] = (uint8_t) (word >> (8 * i));
+            }
+        } else if (kind < 7) {
+            const char *word = words[next_random() % (sizeof(words) / sizeof(words[0]))];
+            for (size_t i = 0; word[i] && image->size < size; i++) {
+                image->data[image->size++] = (uint8_t) word[i];
+            }
+        } else {
+            const size_t run = 1 + next_random() % 100;
+            for (size_t i = 0; i < run && image->size < size; i++) {
+                image->data[image->size++] = 0xFF;
+            }
+        }
+    }
+}
+
+static void check_round_trip(const buffer *image, int window_bits, int lookahead_bits) {
+    buffer blob = compress(image, window_bits, lookahead_bits);
+    CHECK(lzss_stream_is_compressed(blob.data, blob.size));
+    buffer result = make_buffer(image->size);
+    for (size_t chunk = 1; chunk <= MAX_EVEN_CHUNK; chunk++) {
+        CHECK_EQUAL(0, decompress(&blob, 0, chunk, &result));
+        check_result(image, &result);
+    }
+    for (int run = 0; run < 20; run++) {
+        CHECK_EQUAL(0, decompress(&blob, 0, 0, &result));
+        check_result(image, &result);
+    }
+    const uint64_t start = host_test_ns();
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        CHECK_EQUAL(0, decompress(&blob, 0, 1460, &result));
+    }
+    const double seconds = (double) (host_test_ns() - start) / 1e9 / BENCH_RUNS;
+    printf("-w %2d -l %d: image %6zu B, compressed %6zu B (%5.1f%%), decoded at %6.1f MB/s\n", window_bits,
+            lookahead_bits, image->size, blob.size, 100.0 * (double) blob.size / (double) image->size,
+            (double) image->size / seconds / 1e6);
+    free(result.data);
+    free(blob.data);
+}
+
+// Splits the stream in two at every byte
+static void check_splits(const buffer *image, int window_bits, int lookahead_bits) {
+    buffer blob = compress(image, window_bits, lookahead_bits);
+    buffer result = make_buffer(image->size);
+    for (size_t split = 1; split < blob.size; split++) {
+        CHECK_EQUAL(0, decompress(&blob, split, blob.size, &result));
+        check_result(image, &result);
+    }
+    // a truncated stream does not complete
+    blob.size--;
+    CHECK(0 != decompress(&blob, 0, 1460, &result));
+    free(result.data);
+    free(blob.data);
+}
+
+static void check_rejected(void) {
+    // a window larger than LZSS_STREAM_MAX_WINDOW_BITS
+    const uint8_t header[LZSS_STREAM_HEADER_SIZE] = {'H', 'S', 'Z', '1', LZSS_STREAM_MAX_WINDOW_BITS + 1, 4, 0, 0,
+            16, 0, 0, 0};
+    lzss_stream stream;
+    buffer result = make_buffer(16);
+    lzss_stream_init(&stream, buffer_write, &result);
+    CHECK_EQUAL(LZSS_STREAM_ERROR_FORMAT, lzss_stream_feed(&stream, header, sizeof(header)));
+    // an image is not taken for a compressed one
+    const uint8_t image_header[] = {0x3d, 0xb8, 0xf3, 0x96, 0, 0, 0, 0}; // the MCUboot image magic
+    CHECK(!lzss_stream_is_compressed(image_header, sizeof(image_header)));
+    free(result.data);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        work_directory = argv[1];
+    }
+    buffer image = make_buffer(IMAGE_SIZE);
+    make_image(&image, IMAGE_SIZE);
+    check_round_trip(&image, 11, 4);
+    check_round_trip(&image, 8, 4);
+    check_round_trip(&image, 10, 6);
+    make_image(&image, SPLIT_SIZE);
+    check_splits(&image, 11, 4);
+    check_splits(&image, 8, 3);
+    check_rejected();
+    free(image.data);
+    return 0;
+}
@@ -0,0 +1,464 @@
+//
+// Copyright: Avnet 2023
+//
+
+// Downloads an image with ota_download() from an HTTP server on the loopback interface into the PSA firmware
+// driver of NetXDuo/App, on the PSA update port. The server drops the connection at random points of the body.
+// With a server that honors Range requests, each retry continues where the previous attempt stopped, so each
+// byte is received and programmed once. With one that ignores them, each retry starts over. A download that
+// runs out of attempts cancels the update. The driver keeps the progress in RAM and writes nothing to ITS.
+// The same downloads also run on the NetX transport of ota_download_nx.c, on the host stand-in of the Web HTTP
+// client, which checks that its TLS buffers are those of the transport and that it releases its packets.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "host_test.h"
+#include "host_test_cert.h"
+#include "nx_azure_iot_adu_agent_psa_driver.h"
+#include "ota_download.h"
+#include "ota_download_nx.h"
+#include "psa/crypto.h"
+#include "psa/internal_trusted_storage.h"
+
+#define IMAGE_SIZE          (200 * 1024 + 123)
+#define ACTIVE_IMAGE_ID     0x0101
+#define DOWNLOAD_IMAGE_ID   0x0102
+#define HEADER_MAX          1024
+#define POOL_PACKETS        8
+
+static uint8_t *image;
+static char image_sha256[48];
+static nx_azure_iot_adu_agent_psa_driver_context_t driver_context;
+
+typedef struct server {
+    int listener;
+    uint16_t port;
+    bool honor_range;
+    uint32_t drops_left;        // connections that are dropped in the body
+    uint32_t seed;
+    uint32_t requests;
+    uint32_t range_requests;
+    volatile bool stop;
+    pthread_t thread;
+} server;
+
+static uint32_t next_random(uint32_t *x) {
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    return *x;
+}
+
+static void base64_encode(const uint8_t *data, size_t size, char *out) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t o = 0;
+    for (size_t i = 0; i < size; i += 3) {
+        const uint32_t v = ((uint32_t) data[i] << 16) | (i + 1 < size ? (uint32_t) data[i + 1] << 8 : 0)
+                | (i + 2 < size ? data[i + 2] : 0);
+        out[o++] = alphabet[(v >> 18) & 63];
+        out[o++] = alphabet[(v >> 12) & 63];
+        out[o++] = (i + 1 < size) ? alphabet[(v >> 6) & 63] : '=';
+        out[o++] = (i + 2 < size) ? alphabet[v & 63] : '=';
+    }
+    out[o] = 0;
+}
+
+static void make_image(void) {
+    image = (uint8_t *) malloc(IMAGE_SIZE);
+    CHECK(image != NULL);
+    uint32_t x = 2463534242u;
+    for (size_t i = 0; i < IMAGE_SIZE; i++) { // does not compress, and does not start like a delta
+        image[i] = (uint8_t) next_random(&x);
+    }
+    uint8_t digest[32];
+    size_t length;
+    CHECK_EQUAL(PSA_SUCCESS, psa_hash_compute(PSA_ALG_SHA_256, image, IMAGE_SIZE, digest, sizeof(digest), &length));
+    base64_encode(digest, sizeof(digest), image_sha256);
+}
+
+static bool send_all(int fd, const void *data, size_t size) {
+    const uint8_t *p = (const uint8_t *) data;
+    while (size > 0) {
+        const ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= (size_t) n;
+    }
+    return true;
+}
+
+static void serve(server *s, int fd) {
+    char request[HEADER_MAX];
+    size_t length = 0;
+    while (length < sizeof(request) - 1) {
+        const ssize_t n = recv(fd, &request[length], sizeof(request) - 1 - length, 0);
+        if (n <= 0) {
+            return;
+        }
+        length += (size_t) n;
+        request[length] = 0;
+        if (strstr(request, "\r\n\r\n")) {
+            break;
+        }
+    }
+    s->requests++;
+    uint32_t first = 0;
+    const char *range = strstr(request, "\r\nRange: bytes=");
+    if (range) {
+        s->range_requests++;
+        if (s->honor_range) {
+            first = (uint32_t) strtoul(range + strlen("\r\nRange: bytes="), NULL, 10);
+        }
+    }
+    char header[HEADER_MAX];
+    int header_length;
+    if (first > 0) {
+        header_length = snprintf(header, sizeof(header), "HTTP/1.1 206 Partial Content\r\n"
+                "Content-Range: bytes %u-%u/%u\r\nContent-Length: %u\r\nConnection: close\r\n\r\n",
+                first, IMAGE_SIZE - 1, IMAGE_SIZE, IMAGE_SIZE - first);
+    } else {
+        header_length = snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\n"
+                "Content-Length: %u\r\nConnection: close\r\n\r\n", IMAGE_SIZE);
+    }
+    if (!send_all(fd, header, (size_t) header_length)) {
+        return;
+    }
+    uint32_t end = IMAGE_SIZE;
+    if (s->drops_left > 0) {
+        s->drops_left--;
+        // somewhere in the next half of what is left, at least one byte
+        end = first + 1 + next_random(&s->seed) % ((IMAGE_SIZE - first) / 2);
+    }
+    send_all(fd, &image[first], end - first);
+}
+
+static void *server_thread(void *arg) {
+    server *s = (server *) arg;
+    while (!s->stop) {
+        const int fd = accept(s->listener, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+        serve(s, fd);
+        close(fd);
+    }
+    return NULL;
+}
+
+static void server_start(server *s, bool honor_range, uint32_t drops, uint32_t seed) {
+    memset(s, 0, sizeof(*s));
+    s->honor_range = honor_range;
+    s->drops_left = drops;
+    s->seed = seed;
+    s->listener = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK(s->listener >= 0);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK_EQUAL(0, bind(s->listener, (struct sockaddr *) &address, sizeof(address)));
+    socklen_t address_length = sizeof(address);
+    CHECK_EQUAL(0, getsockname(s->listener, (struct sockaddr *) &address, &address_length));
+    s->port = ntohs(address.sin_port);
+    CHECK_EQUAL(0, listen(s->listener, 4));
+    CHECK_EQUAL(0, pthread_create(&s->thread, NULL, server_thread, s));
+}
+
+static void server_stop(server *s) {
+    s->stop = true;
+    shutdown(s->listener, SHUT_RDWR); // wakes up accept()
+    pthread_join(s->thread, NULL);
+    close(s->listener);
+}
+
+// The transport of ota_download() on a plain socket
+typedef struct socket_transport {
+    uint16_t port;
+    int fd;
+    uint8_t pending[HEADER_MAX];    // body bytes received with the headers
+    size_t pending_length;
+    size_t pending_offset;
+} socket_transport;
+
+static int socket_open(void *context, uint32_t offset, ota_download_response *response) {
+    socket_transport *t = (socket_transport *) context;
+    t->pending_length = 0;
+    t->pending_offset = 0;
+    t->fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (t->fd < 0) {
+        return -1;
+    }
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(t->port);
+    if (connect(t->fd, (struct sockaddr *) &address, sizeof(address))) {
+        return -1;
+    }
+    char request[128];
+    int length = snprintf(request, sizeof(request), "GET /image.bin HTTP/1.1\r\nHost: localhost\r\n");
+    if (offset > 0) {
+        length += snprintf(&request[length], sizeof(request) - (size_t) length, "Range: bytes=%u-\r\n", offset);
+    }
+    length += snprintf(&request[length], sizeof(request) - (size_t) length, "\r\n");
+    if (!send_all(t->fd, request, (size_t) length)) {
+        return -1;
+    }
+    char header[HEADER_MAX + 1];
+    size_t received = 0;
+    char *end = NULL;
+    while (NULL == end) {
+        if (received == HEADER_MAX) {
+            return -1;
+        }
+        const ssize_t n = recv(t->fd, &header[received], HEADER_MAX - received, 0);
+        if (n <= 0) {
+            return -1;
+        }
+        received += (size_t) n;
+        header[received] = 0;
+        end = strstr(header, "\r\n\r\n");
+    }
+    const size_t header_length = (size_t) (end + 4 - header);
+    t->pending_length = received - header_length;
+    memcpy(t->pending, &header[header_length], t->pending_length);
+    *end = 0;
+    if (0 == strncmp(header, "HTTP/1.1 206", 12)) {
+        const char *value = strstr(header, "Content-Range: ");
+        if (NULL == value) {
+            return -1;
+        }
+        value += strlen("Content-Range: ");
+        const char *line_end = strstr(value, "\r\n");
+        const uint32_t value_length = (uint32_t) (line_end ? (size_t) (line_end - value) : strlen(value));
+        return ota_download_parse_content_range(value, value_length, &response->offset, &response->file_size);
+    }
+    if (0 == strncmp(header, "HTTP/1.1 200", 12)) {
+        const char *value = strstr(header, "Content-Length: ");
+        response->offset = 0;
+        response->file_size = value ? (uint32_t) strtoul(value + strlen("Content-Length: "), NULL, 10) : 0;
+        return 0;
+    }
+    return -1;
+}
+
+static int socket_read(void *context, uint8_t *buffer, uint32_t size) {
+    socket_transport *t = (socket_transport *) context;
+    if (t->pending_offset < t->pending_length) {
+        size_t n = t->pending_length - t->pending_offset;
+        if (n > size) {
+            n = size;
+        }
+        memcpy(buffer, &t->pending[t->pending_offset], n);
+        t->pending_offset += n;
+        return (int) n;
+    }
+    const ssize_t n = recv(t->fd, buffer, size, 0);
+    return n < 0 ? -1 : (int) n;
+}
+
+static void socket_close(void *context) {
+    socket_transport *t = (socket_transport *) context;
+    if (t->fd >= 0) {
+        close(t->fd);
+        t->fd = -1;
+    }
+}
+
+// The lookups of ota_download_nx.c resolve to the loopback interface
+static ULONG lookups;
+
+UINT __wrap__nxe_dns_host_by_name_get(NX_DNS *dns_ptr, UCHAR *host_name, ULONG *host_address_ptr, ULONG wait_option) {
+    (void) dns_ptr;
+    (void) wait_option;
+    CHECK(0 == strcmp("blob.example.com", (const char *) host_name));
+    lookups++;
+    *host_address_ptr = IP_ADDRESS(127, 0, 0, 1);
+    return NX_SUCCESS;
+}
+
+static void driver(NX_AZURE_IOT_ADU_AGENT_DRIVER *driver_req_ptr) {
+    nx_azure_iot_adu_agent_psa_driver(driver_req_ptr, &driver_context);
+}
+
+static int download(server *s, unsigned int attempts, ota_download_stats *stats) {
+    socket_transport connection = {s->port, -1, {0}, 0, 0};
+    const ota_download_transport transport = {&connection, socket_open, socket_read, socket_close};
+    uint8_t buffer[1000]; // not a multiple of the write block, so that the blocks are filled across requests
+    return ota_download(&transport, driver, image_sha256, buffer, sizeof(buffer), attempts, 0, stats);
+}
+
+static ota_download_nx_transport nx_connection;
+
+static int download_nx(server *s, unsigned int attempts, ota_download_stats *stats) {
+    NX_IP ip = {0, s->port};
+    NX_PACKET_POOL pool = {POOL_PACKETS, POOL_PACKETS, 0};
+    NX_DNS dns;
+    nx_dns_create(&dns, &ip, NULL);
+    ota_download_transport transport;
+    ota_download_nx_transport_init(&transport, &nx_connection, &ip, &pool, &dns, "blob.example.com", "/image.bin",
+            host_test_device_cert, sizeof(host_test_device_cert), 5 * NX_IP_PERIODIC_RATE);
+    lookups = 0;
+    uint8_t buffer[1000];
+    const int result = ota_download(&transport, driver, image_sha256, buffer, sizeof(buffer), attempts, 0, stats);
+    CHECK_EQUAL(stats->attempts, lookups);
+    // every packet of the body went back to the pool
+    CHECK_EQUAL(POOL_PACKETS, pool.nx_packet_pool_available);
+    // TLS was set up in the buffers of the transport, not in the heap
+    const NX_SECURE_TLS_SESSION *tls = &nx_connection.client.nx_web_http_client_tls_session;
+    CHECK(tls->metadata == (VOID *) nx_connection.tls_metadata);
+    CHECK(tls->packet_buffer == nx_connection.tls_packet_buffer);
+    CHECK_EQUAL(OTA_DOWNLOAD_NX_REMOTE_CERT_COUNT, tls->remote_cert_count);
+    CHECK(tls->remote_certs[0]->buffer == nx_connection.remote_cert_buffers[0]);
+    CHECK(tls->trusted_cert->certificate_data == host_test_device_cert);
+    CHECK(0 == strcmp("blob.example.com", tls->sni_name->name));
+    return result;
+}
+
+static void check_staged(void) {
+    size_t staged_size;
+    const uint8_t *staged = psa_fwu_port_staged(DOWNLOAD_IMAGE_ID, &staged_size);
+    CHECK(staged != NULL);
+    CHECK(staged_size >= IMAGE_SIZE && staged_size < IMAGE_SIZE + FLASH0_PROG_UNIT);
+    CHECK(0 == memcmp(staged, image, IMAGE_SIZE));
+}
+
+// All ITS assets are still free
+static void check_its_unused(void) {
+    const uint8_t data = 0;
+    for (psa_storage_uid_t uid = 1; uid <= ITS_NUM_ASSETS; uid++) {
+        CHECK_EQUAL(PSA_SUCCESS, psa_its_set(uid, sizeof(data), &data, PSA_STORAGE_FLAG_NONE));
+    }
+    psa_its_port_reset();
+}
+
+static void test_content_range(void) {
+    uint32_t first = 0;
+    uint32_t size = 0;
+    const char *good = "bytes 100-199/200";
+    CHECK_EQUAL(0, ota_download_parse_content_range(good, (uint32_t) strlen(good), &first, &size));
+    CHECK_EQUAL(100, first);
+    CHECK_EQUAL(200, size);
+    const char *bad[] = {"bytes 100-199/*", "bytes 100-200/200", "bytes 200-100/300", "items 0-1/2", "bytes -1/2",
+            "bytes 0-4294967296/4294967297"};
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        CHECK(0 != ota_download_parse_content_range(bad[i], (uint32_t) strlen(bad[i]), &first, &size));
+    }
+}
+
+static void reset(void) {
+    psa_fwu_port_reset();
+    psa_its_port_reset();
+    const psa_image_version_t version = {1, 1, 0, 0};
+    psa_fwu_port_set_active(ACTIVE_IMAGE_ID, &version);
+    memset(&driver_context, 0, sizeof(driver_context));
+    driver_context.active_image_id = ACTIVE_IMAGE_ID;
+    driver_context.download_image_id = DOWNLOAD_IMAGE_ID;
+}
+
+// Each retry requests the rest of the file, and the driver continues from there
+static void test_resume(uint32_t seed) {
+    reset();
+    server s;
+    const uint32_t drops = 5;
+    server_start(&s, true, drops, seed);
+    ota_download_stats stats;
+    CHECK_EQUAL(0, download(&s, drops + 1, &stats));
+    server_stop(&s);
+    printf("resume, seed %u: %u attempts, %u resumed, %llu bytes received, %llu bytes programmed\n", seed,
+            stats.attempts, stats.resumes, (unsigned long long) stats.bytes_received,
+            (unsigned long long) psa_fwu_port_bytes_written());
+    CHECK_EQUAL(drops + 1, stats.attempts);
+    CHECK_EQUAL(drops, stats.resumes);
+    CHECK_EQUAL(drops, s.range_requests);
+    CHECK_EQUAL(IMAGE_SIZE, stats.bytes_received);
+    // programmed once, up to the padding of the last unit
+    CHECK(psa_fwu_port_bytes_written() < IMAGE_SIZE + FLASH0_PROG_UNIT);
+    check_staged();
+    check_its_unused();
+}
+
+// The server answers a Range request with the whole file, so each retry starts the update over
+static void test_range_ignored(void) {
+    reset();
+    server s;
+    const uint32_t drops = 2;
+    server_start(&s, false, drops, 7);
+    ota_download_stats stats;
+    CHECK_EQUAL(0, download(&s, drops + 1, &stats));
+    server_stop(&s);
+    printf("range ignored: %u attempts, %u restarted, %llu bytes received\n", stats.attempts, stats.restarts,
+            (unsigned long long) stats.bytes_received);
+    CHECK_EQUAL(0, stats.resumes);
+    CHECK_EQUAL(drops, stats.restarts);
+    CHECK(stats.bytes_received > IMAGE_SIZE);
+    check_staged();
+    check_its_unused();
+}
+
+// All attempts fail: the update is cancelled in the driver
+static void test_give_up(void) {
+    reset();
+    server s;
+    server_start(&s, true, 3, 11);
+    ota_download_stats stats;
+    CHECK_EQUAL(OTA_DOWNLOAD_ERROR_TRANSPORT, download(&s, 3, &stats));
+    server_stop(&s);
+    check_its_unused();
+    psa_image_info_t info;
+    CHECK_EQUAL(PSA_SUCCESS, psa_fwu_query(DOWNLOAD_IMAGE_ID, &info));
+    CHECK_EQUAL(PSA_IMAGE_UNDEFINED, info.state);
+    // and a new download of the image does not resume the cancelled one
+    server_start(&s, true, 0, 13);
+    CHECK_EQUAL(0, download(&s, 1, &stats));
+    server_stop(&s);
+    CHECK_EQUAL(0, stats.resumes);
+    check_staged();
+}
+
+// The same on the NetX transport: each retry reconnects, looks the host up again and sends a Range request
+static void test_nx_transport(void) {
+    reset();
+    server s;
+    const uint32_t drops = 3;
+    server_start(&s, true, drops, 17);
+    ota_download_stats stats;
+    CHECK_EQUAL(0, download_nx(&s, drops + 1, &stats));
+    server_stop(&s);
+    printf("NetX transport: %u attempts, %u resumed, %llu bytes received\n", stats.attempts, stats.resumes,
+            (unsigned long long) stats.bytes_received);
+    CHECK_EQUAL(drops + 1, stats.attempts);
+    CHECK_EQUAL(drops, stats.resumes);
+    CHECK_EQUAL(drops, s.range_requests);
+    CHECK_EQUAL(IMAGE_SIZE, stats.bytes_received);
+    check_staged();
+    check_its_unused();
+
+    // and a server that ignores the Range requests
+    reset();
+    server_start(&s, false, 1, 19);
+    CHECK_EQUAL(0, download_nx(&s, 2, &stats));
+    server_stop(&s);
+    CHECK_EQUAL(1, stats.restarts);
+    check_staged();
+}
+
+int main(void) {
+    make_image();
+    test_content_range();
+    for (uint32_t seed = 1; seed <= 5; seed++) {
+        test_resume(seed * 2654435761u);
+    }
+    test_range_ignored();
+    test_give_up();
+    test_nx_transport();
+    free(image);
+    return 0;
+}
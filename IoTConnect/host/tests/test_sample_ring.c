@@ -0,0 +1,138 @@
+//
+// Copyright: Avnet 2023
+//
+
+// Stress test of sample_ring.c with a producer and a consumer thread on the ThreadX port.
+// Every sample carries its sequence number in all of its fields, so the consumer detects torn reads and any
+// reordering, and the gaps in the sequence must add up to the drop counter.
+// Runs the ring at full speed, then with a paced producer and a consumer that is slowed down like a publisher
+// that waits on the network, and reports samples/s and the drop rate of each run.
+//
+// Usage: test_sample_ring [full speed samples]
+
+#include <string.h>
+#include "host_test.h"
+#include "sample_ring.h"
+#include "tx_api.h"
+
+#define DEFAULT_SAMPLES 2000000UL
+
+typedef struct stress_run {
+    const char *name;
+    uint32_t samples;
+    uint32_t producer_period_us;    // 0 for full speed
+    bool lossless;                  // the producer waits for a free slot instead of dropping
+    uint32_t consumer_batch;        // the consumer stalls after this many samples. 0 never stalls.
+    uint32_t consumer_stall_us;
+} stress_run;
+
+static sample_ring ring;
+static const stress_run *run;
+static TX_SEMAPHORE finished;
+static volatile int producer_done;
+static uint32_t pushed;
+
+static void sleep_us(uint32_t us) {
+    struct timespec ts = {(time_t) (us / 1000000), (long) (us % 1000000) * 1000L};
+    nanosleep(&ts, NULL);
+}
+
+static void make_sample(telemetry_sample *sample, uint32_t sequence) {
+    sample->timestamp = (time_t) sequence;
+    sample->temperature = (double) sequence * 0.5;
+    sample->button_counter = sequence ^ 0xA5A5A5A5u;
+    sample->has_sensor_values = (sequence & 1) != 0;
+}
+
+static void producer_entry(ULONG input) {
+    (void) input;
+    telemetry_sample sample;
+    uint64_t next_ns = host_test_ns();
+    for (uint32_t sequence = 1; sequence <= run->samples; sequence++) {
+        if (run->producer_period_us) {
+            next_ns += (uint64_t) run->producer_period_us * 1000;
+            while (host_test_ns() < next_ns) {
+                sleep_us(run->producer_period_us / 4 + 1);
+            }
+        }
+        make_sample(&sample, sequence);
+        while (run->lossless && sample_ring_count(&ring) >= SAMPLE_RING_CAPACITY) {
+            tx_thread_sleep(0);
+        }
+        if (sample_ring_push(&ring, &sample)) {
+            pushed++;
+        }
+    }
+    __atomic_store_n(&producer_done, 1, __ATOMIC_RELEASE);
+    tx_semaphore_put(&finished);
+}
+
+static void run_stress(const stress_run *stress) {
+    static TX_THREAD producer;
+    run = stress;
+    pushed = 0;
+    producer_done = 0;
+    sample_ring_init(&ring);
+    tx_semaphore_create(&finished, "Finished", 0);
+
+    const uint64_t start_ns = host_test_ns();
+    CHECK_EQUAL(TX_SUCCESS, tx_thread_create(&producer, "Producer", producer_entry, 0, NULL, 0, 1, 1,
+            TX_NO_TIME_SLICE, TX_AUTO_START));
+    uint32_t popped = 0, last = 0, gaps = 0, since_stall = 0;
+    telemetry_sample sample;
+    for (;;) {
+        if (!sample_ring_pop(&ring, &sample)) {
+            if (__atomic_load_n(&producer_done, __ATOMIC_ACQUIRE) && 0 == sample_ring_count(&ring)) {
+                break;
+            }
+            tx_thread_sleep(0);
+            continue;
+        }
+        const uint32_t sequence = (uint32_t) sample.timestamp;
+        telemetry_sample expected;
+        make_sample(&expected, sequence);
+        CHECK(sequence > last);
+        CHECK(expected.temperature == sample.temperature);
+        CHECK_EQUAL(expected.button_counter, sample.button_counter);
+        CHECK_EQUAL(expected.has_sensor_values, sample.has_sensor_values);
+        gaps += sequence - last - 1;
+        last = sequence;
+        popped++;
+        if (run->consumer_batch && ++since_stall == run->consumer_batch) {
+            since_stall = 0;
+            sleep_us(run->consumer_stall_us);
+        }
+    }
+    tx_semaphore_get(&finished, TX_WAIT_FOREVER);
+    const double seconds = (double) (host_test_ns() - start_ns) / 1e9;
+    gaps += run->samples - last;
+
+    const uint32_t dropped = sample_ring_dropped(&ring);
+    CHECK(!run->lossless || 0 == dropped);
+    CHECK_EQUAL(pushed, popped);
+    CHECK_EQUAL(run->samples, popped + dropped);
+    CHECK_EQUAL(dropped, gaps);
+    printf("%-28s %10u %12.0f %10u %9.3f%%\n", run->name, run->samples, (double) run->samples / seconds, dropped,
+            100.0 * dropped / run->samples);
+    tx_semaphore_delete(&finished);
+}
+
+int main(int argc, char *argv[]) {
+    const uint32_t samples = (uint32_t) (argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_SAMPLES);
+    const stress_run runs[] = {
+        // both sides as fast as they can, to shake out races: the transfer rate of the ring without drops,
+        // then with the drop policy, where the producer outruns the consumer
+        {"full speed, lossless", samples, 0, true, 0, 0},
+        {"full speed, drop when full", samples, 0, false, 0, 0},
+        // 10 kHz sampling against a publisher that takes 1 ms every 20 samples, which keeps up on average
+        {"10 kHz, 1 ms per 20 samples", 10000, 100, false, 20, 1000},
+        // the same sampling against a publisher that stalls 50 ms every 100 samples, 5x too slow
+        {"10 kHz, 50 ms per 100", 10000, 100, false, 100, 50000},
+    };
+    printf("SAMPLE_RING_CAPACITY %d\n", SAMPLE_RING_CAPACITY);
+    printf("%-28s %10s %12s %10s %10s\n", "run", "samples", "samples/s", "dropped", "drop rate");
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        run_stress(&runs[i]);
+    }
+    return 0;
+}
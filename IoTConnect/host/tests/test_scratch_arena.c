@@ -0,0 +1,366 @@
+//
+// Copyright: Avnet 2023
+//
+
+// Checks scratch_arena.c, then soaks the heap use of the OTA and command event handlers of iotconnect_app.c.
+// Simulated cloud events are replayed against a model of the first-fit ThreadX byte pool that malloc() is
+// routed to with IOTC_ROUTE_MALLOC_TO_TX_BYTE_POOL, once with the previous handlers, which kept the cloned
+// strings and the split URL in the pool while the event was handled, and once with the event arena, where the
+// strings are copied and the URL is split with scratch_arena.c and ota_download_split_url(). Other heap users,
+// like the MQTT buffers, keep allocating in the background. A download allocates nothing else from the pool:
+// its TLS buffers, about 30 KB, are static in ota_download_nx_transport (see ota_download_nx.h). Reports the
+// fragmentation of the pool and the peak use of the pool and of the arena.
+//
+// Usage: test_scratch_arena [events] [pool size]
+
+#include <string.h>
+#include "host_test.h"
+#include "scratch_arena.h"
+#include "ota_download.h"
+
+#define BLOCK_OVERHEAD      8       // ThreadX byte pool block header
+#define ALIGNMENT           8
+#define ARENA_SIZE          2048    // APP_EVENT_ARENA_SIZE
+#define OTA_EVENT_PERCENT   5       // the rest are commands
+#define OTA_EVENT_DURATION  20      // background allocations made while a download runs
+#define MAX_BLOCKS          4096
+#define MAX_LIVE            4096
+#define MAX_HELD            8
+
+typedef struct pool_block {
+    uint32_t address;
+    uint32_t size;
+    bool free;
+} pool_block;
+
+// First fit over an address ordered list of blocks. Free neighbours are merged when a block is released.
+typedef struct byte_pool {
+    pool_block blocks[MAX_BLOCKS];
+    uint32_t count;
+    uint32_t used;
+    uint32_t peak;
+    uint32_t failures;
+} byte_pool;
+
+typedef struct live_block {
+    uint64_t expiry;
+    uint32_t address;
+} live_block;
+
+// Other heap users: allocations that live for a random number of steps
+typedef struct background {
+    live_block live[MAX_LIVE];
+    uint32_t count;
+    uint64_t step;
+} background;
+
+typedef struct soak_result {
+    uint32_t pool_peak;
+    uint32_t pool_failures;
+    uint32_t fragments;
+    uint32_t worst_fragments;
+    uint32_t largest_free;
+    uint32_t worst_largest_free;
+    size_t arena_peak;
+    uint32_t arena_failures;
+} soak_result;
+
+#define NO_BLOCK UINT32_MAX
+
+static uint32_t seed;
+
+static uint32_t next_random(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+// A random number from first to last
+static uint32_t random_between(uint32_t first, uint32_t last) {
+    return first + next_random() % (last - first + 1);
+}
+
+static uint32_t block_size(uint32_t size) {
+    return (size + BLOCK_OVERHEAD + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+static void pool_init(byte_pool *pool, uint32_t size) {
+    memset(pool, 0, sizeof(*pool));
+    pool->blocks[0] = (pool_block) {0, size, true};
+    pool->count = 1;
+}
+
+static uint32_t pool_allocate(byte_pool *pool, uint32_t size) {
+    size = block_size(size);
+    for (uint32_t i = 0; i < pool->count; i++) {
+        pool_block *block = &pool->blocks[i];
+        if (!block->free || block->size < size) {
+            continue;
+        }
+        if (block->size - size >= block_size(1)) {
+            CHECK(pool->count < MAX_BLOCKS);
+            memmove(&pool->blocks[i + 2], &pool->blocks[i + 1], (pool->count - i - 1) * sizeof(pool_block));
+            pool->blocks[i + 1] = (pool_block) {block->address + size, block->size - size, true};
+            pool->count++;
+            block->size = size;
+        }
+        block->free = false;
+        pool->used += block->size;
+        if (pool->used > pool->peak) {
+            pool->peak = pool->used;
+        }
+        return block->address;
+    }
+    pool->failures++;
+    return NO_BLOCK;
+}
+
+static void pool_remove(byte_pool *pool, uint32_t i) {
+    memmove(&pool->blocks[i], &pool->blocks[i + 1], (pool->count - i - 1) * sizeof(pool_block));
+    pool->count--;
+}
+
+static void pool_release(byte_pool *pool, uint32_t address) {
+    if (NO_BLOCK == address) {
+        return;
+    }
+    for (uint32_t i = 0; i < pool->count; i++) {
+        pool_block *block = &pool->blocks[i];
+        if (block->address != address) {
+            continue;
+        }
+        CHECK(!block->free);
+        block->free = true;
+        pool->used -= block->size;
+        if (i + 1 < pool->count && pool->blocks[i + 1].free) {
+            block->size += pool->blocks[i + 1].size;
+            pool_remove(pool, i + 1);
+        }
+        if (i > 0 && pool->blocks[i - 1].free) {
+            pool->blocks[i - 1].size += block->size;
+            pool_remove(pool, i);
+        }
+        return;
+    }
+    CHECK(false); // released an unknown block
+}
+
+static void pool_fragments(const byte_pool *pool, uint32_t *count, uint32_t *largest) {
+    *count = 0;
+    *largest = 0;
+    for (uint32_t i = 0; i < pool->count; i++) {
+        if (pool->blocks[i].free) {
+            (*count)++;
+            if (pool->blocks[i].size > *largest) {
+                *largest = pool->blocks[i].size;
+            }
+        }
+    }
+}
+
+static void background_step(background *bg, byte_pool *pool) {
+    bg->step++;
+    for (uint32_t i = 0; i < bg->count;) {
+        if (bg->live[i].expiry <= bg->step) {
+            pool_release(pool, bg->live[i].address);
+            bg->live[i] = bg->live[--bg->count];
+        } else {
+            i++;
+        }
+    }
+    if (next_random() % 2) {
+        static const uint32_t sizes[] = {64, 128, 256, 512, 1536};
+        const uint32_t address = pool_allocate(pool, sizes[next_random() % (sizeof(sizes) / sizeof(sizes[0]))]);
+        if (NO_BLOCK != address) {
+            CHECK(bg->count < MAX_LIVE);
+            // mostly short lived, with the odd long lived one, like the buffers of a new connection
+            const uint32_t lifetime = next_random() % 100 ? random_between(1, 40) : random_between(200, 2000);
+            bg->live[bg->count++] = (live_block) {bg->step + lifetime, address};
+        }
+    }
+}
+
+static void random_string(char *s, uint32_t length) {
+    for (uint32_t i = 0; i < length; i++) {
+        s[i] = (char) ('a' + next_random() % 26);
+    }
+    s[length] = 0;
+}
+
+// The SDK always clones into the heap. With the arena, the clone is copied and released right away,
+// like arena_clone() does.
+static char *sdk_clone(byte_pool *pool, scratch_arena *arena, const char *value, uint32_t *held, uint32_t *count) {
+    const uint32_t address = pool_allocate(pool, (uint32_t) strlen(value) + 1);
+    if (NULL == arena) {
+        held[(*count)++] = address;
+        return (char *) value;
+    }
+    char *copy = scratch_arena_strndup(arena, value, strlen(value));
+    pool_release(pool, address);
+    return copy;
+}
+
+static void handle_event(byte_pool *pool, scratch_arena *arena, background *bg) {
+    // the SDK parses the event into a cJSON tree that lives until the ack is created
+    uint32_t event[16];
+    const uint32_t nodes = random_between(8, 16);
+    for (uint32_t i = 0; i < nodes; i++) {
+        event[i] = pool_allocate(pool, random_between(24, 64));
+    }
+    uint32_t held[MAX_HELD];
+    uint32_t held_count = 0;
+    char value[512];
+    if (next_random() % 100 < OTA_EVENT_PERCENT) {
+        const uint32_t url_length = random_between(200, 500);
+        const uint32_t host_length = random_between(30, 60);
+        random_string(value, url_length);
+        memcpy(value, "https://", 8);
+        value[8 + host_length] = '/';
+        const char *url = sdk_clone(pool, arena, value, held, &held_count);
+        random_string(value, 7);
+        sdk_clone(pool, arena, value, held, &held_count); // version
+        if (NULL != arena) {
+            char *host_name;
+            char *resource;
+            if (NULL != url && 0 == ota_download_split_url(arena, url, &host_name, &resource)) {
+                CHECK_EQUAL(host_length, strlen(host_name));
+                CHECK_EQUAL(url_length - 8 - host_length, strlen(resource));
+            }
+        } else {
+            held[held_count++] = pool_allocate(pool, host_length + 1);
+            held[held_count++] = pool_allocate(pool, url_length - 8 - host_length + 1);
+        }
+        for (int i = 0; i < OTA_EVENT_DURATION; i++) {
+            background_step(bg, pool);
+        }
+    } else {
+        random_string(value, random_between(8, 60));
+        sdk_clone(pool, arena, value, held, &held_count);
+        background_step(bg, pool); // the command runs on the worker thread
+    }
+    for (uint32_t i = 0; i < nodes; i++) {
+        pool_release(pool, event[i]);
+    }
+    pool_release(pool, pool_allocate(pool, random_between(80, 160))); // the ack
+    for (uint32_t i = 0; i < held_count; i++) {
+        pool_release(pool, held[i]);
+    }
+    if (NULL != arena) {
+        scratch_arena_reset(arena);
+    }
+    background_step(bg, pool);
+}
+
+static void soak(uint32_t events, uint32_t pool_size, bool use_arena, soak_result *result) {
+    static byte_pool pool;
+    static background bg;
+    static uint8_t arena_buffer[ARENA_SIZE];
+    scratch_arena arena;
+    seed = 2463534242u;
+    pool_init(&pool, pool_size);
+    memset(&bg, 0, sizeof(bg));
+    scratch_arena_init(&arena, arena_buffer, sizeof(arena_buffer));
+    memset(result, 0, sizeof(*result));
+    result->worst_largest_free = pool_size;
+    for (uint32_t i = 0; i < events; i++) {
+        handle_event(&pool, use_arena ? &arena : NULL, &bg);
+        if (0 == i % 100) {
+            uint32_t count;
+            uint32_t largest;
+            pool_fragments(&pool, &count, &largest);
+            if (count > result->worst_fragments) {
+                result->worst_fragments = count;
+            }
+            if (largest < result->worst_largest_free) {
+                result->worst_largest_free = largest;
+            }
+        }
+    }
+    pool_fragments(&pool, &result->fragments, &result->largest_free);
+    result->pool_peak = pool.peak;
+    result->pool_failures = pool.failures;
+    result->arena_peak = arena.peak;
+    result->arena_failures = arena.failures;
+}
+
+static void test_arena(void) {
+    uint8_t buffer[64 + 1];
+    scratch_arena arena;
+    // the buffer is not aligned, the allocations are
+    scratch_arena_init(&arena, &buffer[1], 64);
+    uint8_t *a = (uint8_t *) scratch_arena_alloc(&arena, 3);
+    uint8_t *b = (uint8_t *) scratch_arena_alloc(&arena, 5);
+    CHECK(a != NULL && b != NULL);
+    CHECK_EQUAL(0, (uintptr_t) a % SCRATCH_ARENA_ALIGNMENT);
+    CHECK_EQUAL(0, (uintptr_t) b % SCRATCH_ARENA_ALIGNMENT);
+    CHECK(b >= a + 3 && b + 5 <= &buffer[sizeof(buffer)]);
+    // an allocation that does not fit fails and is counted, and leaves the arena as it was
+    const size_t used = arena.used;
+    CHECK(NULL == scratch_arena_alloc(&arena, 64));
+    CHECK_EQUAL(1, arena.failures);
+    CHECK_EQUAL(used, arena.used);
+    CHECK(NULL == scratch_arena_alloc(&arena, SIZE_MAX));
+    CHECK_EQUAL(2, arena.failures);
+
+    // the copy is terminated, also when the length is shorter than the string
+    char *s = scratch_arena_strndup(&arena, "firmware", 4);
+    CHECK(s != NULL && 0 == strcmp(s, "firm"));
+    const size_t peak = arena.peak;
+    CHECK(peak >= arena.used && peak <= 64);
+
+    // reset frees everything and keeps the peak
+    scratch_arena_reset(&arena);
+    CHECK_EQUAL(0, arena.used);
+    CHECK_EQUAL(peak, arena.peak);
+    CHECK(scratch_arena_alloc(&arena, 56) != NULL);
+}
+
+static void test_split_url(void) {
+    static uint8_t buffer[256];
+    scratch_arena arena;
+    scratch_arena_init(&arena, buffer, sizeof(buffer));
+    char *host_name;
+    char *resource;
+    CHECK_EQUAL(0, ota_download_split_url(&arena, "https://example.blob.core.windows.net/fw/app.bin?sv=1", &host_name,
+            &resource));
+    CHECK(0 == strcmp(host_name, "example.blob.core.windows.net"));
+    CHECK(0 == strcmp(resource, "/fw/app.bin?sv=1"));
+    CHECK_EQUAL(0, ota_download_split_url(&arena, "http://host/", &host_name, &resource));
+    CHECK(0 == strcmp(host_name, "host") && 0 == strcmp(resource, "/"));
+    // no resource, no host, or no scheme
+    CHECK(0 != ota_download_split_url(&arena, "https://host", &host_name, &resource));
+    CHECK(NULL == host_name && NULL == resource);
+    CHECK(0 != ota_download_split_url(&arena, "https:///file", &host_name, &resource));
+    CHECK(0 != ota_download_split_url(&arena, "host/file", &host_name, &resource));
+    // a URL that does not fit into the arena
+    scratch_arena_init(&arena, buffer, 16);
+    CHECK(0 != ota_download_split_url(&arena, "https://example.com/firmware.bin", &host_name, &resource));
+}
+
+int main(int argc, char *argv[]) {
+    const uint32_t events = argc > 1 ? (uint32_t) strtoul(argv[1], NULL, 10) : 1000000;
+    const uint32_t pool_size = argc > 2 ? (uint32_t) strtoul(argv[2], NULL, 10) : 32768;
+    test_arena();
+    test_split_url();
+
+    printf("%u events, %u byte pool, %d byte arena\n\n", events, pool_size, ARENA_SIZE);
+    printf("%-14s %10s %10s %16s %20s %12s %10s\n", "", "pool peak", "failures", "fragments", "largest free",
+            "arena peak", "arena fail");
+    soak_result heap;
+    soak_result arena;
+    soak(events, pool_size, false, &heap);
+    soak(events, pool_size, true, &arena);
+    printf("%-14s %10u %10u %6u (max %4u) %8u (min %5u) %12s %10s\n", "Heap strings", heap.pool_peak,
+            heap.pool_failures, heap.fragments, heap.worst_fragments, heap.largest_free, heap.worst_largest_free,
+            "-", "-");
+    printf("%-14s %10u %10u %6u (max %4u) %8u (min %5u) %12zu %10u\n", "Event arena", arena.pool_peak,
+            arena.pool_failures, arena.fragments, arena.worst_fragments, arena.largest_free,
+            arena.worst_largest_free, arena.arena_peak, arena.arena_failures);
+    // the strings of every event fit into the arena, and the pool fragments less without them
+    CHECK_EQUAL(0, arena.arena_failures);
+    CHECK(arena.arena_peak <= ARENA_SIZE);
+    CHECK(arena.worst_fragments <= heap.worst_fragments);
+    CHECK(arena.worst_largest_free >= heap.worst_largest_free);
+    return 0;
+}
@@ -0,0 +1,184 @@
+//
+// Copyright: Avnet 2023
+//
+
+// Checks the flush policy of telemetry_batch.c and reports the bytes that go over the wire per sample for
+// batch sizes 1, 8 and 32. The messages are the ones telemetry_batch.c produces. The transport overhead on
+// top of them is counted per message, as the device sends it:
+// - MQTT PUBLISH at QoS 1 to the IoT Hub telemetry topic, and the PUBACK that comes back,
+// - one TLS 1.2 AES-GCM record per MQTT packet, as NetX sends each packet in its own record,
+// - TCP/IPv4 headers per segment of MSS bytes, and the ACK of the PUBLISH.
+// The PUBACK and the ACK are counted because they are paid per message as well.
+// The buffer is APP_TELEMETRY_BUFFER_SIZE, so a batch that outgrows it is sent early, as on the device.
+//
+// Usage: test_telemetry_batch [samples]
+
+#include <string.h>
+#include "host_test.h"
+#include "iotconnect_lib.h"
+#include "telemetry_batch.h"
+
+#define BUFFER_SIZE         4096    // APP_TELEMETRY_BUFFER_SIZE
+#define DEFAULT_SAMPLES     3200
+#define TOPIC_FORMAT        "devices/%s-%s/messages/events/"
+#define MQTT_PUBACK         4
+#define TLS_RECORD_OVERHEAD (5 + 8 + 16)   // header, explicit nonce, tag
+#define TLS_MAX_RECORD      16384
+#define TCP_IP_OVERHEAD     40
+#define TCP_MSS             1460
+
+static size_t remaining_length_bytes(size_t length) {
+    size_t bytes = 1;
+    while (length >= 128) {
+        length /= 128;
+        bytes++;
+    }
+    return bytes;
+}
+
+static size_t tls_tcp_bytes(size_t payload) {
+    const size_t records = (payload + TLS_MAX_RECORD - 1) / TLS_MAX_RECORD;
+    const size_t tls = payload + records * TLS_RECORD_OVERHEAD;
+    const size_t segments = (tls + TCP_MSS - 1) / TCP_MSS;
+    return tls + segments * TCP_IP_OVERHEAD;
+}
+
+// PUBLISH and its PUBACK, and the TCP ACK of the PUBLISH
+static size_t wire_bytes(size_t message_length) {
+    IotclConfig *config = iotcl_get_config();
+    char topic[128];
+    const size_t topic_length = (size_t) snprintf(topic, sizeof(topic), TOPIC_FORMAT, config->device.cpid,
+            config->device.duid);
+    const size_t remaining = 2 + topic_length + 2 + message_length; // topic, packet id, payload
+    const size_t publish = 1 + remaining_length_bytes(remaining) + remaining;
+    return tls_tcp_bytes(publish) + tls_tcp_bytes(MQTT_PUBACK) + TCP_IP_OVERHEAD;
+}
+
+static void make_sample(telemetry_sample *sample, size_t i) {
+    sample->timestamp = 1700000000 + 5 * (time_t) i;
+    sample->temperature = (23000 + (int) ((i * 7919) % 1500)) / 1000.0;
+    sample->button_counter = (uint32_t) (i / 10);
+    sample->has_sensor_values = true;
+}
+
+static size_t count_datapoints(const char *message) {
+    size_t count = 0;
+    for (const char *p = message; NULL != (p = strstr(p, "{\"id\":")); p++) {
+        count++;
+    }
+    return count;
+}
+
+static void test_policy(void) {
+    static char buffer[BUFFER_SIZE];
+    telemetry_batch batch;
+    telemetry_sample sample;
+    make_sample(&sample, 0);
+
+    // count
+    telemetry_batch_policy policy = {3, 0, 0};
+    telemetry_batch_init(&batch, &policy, "1.1.0", buffer, sizeof(buffer));
+    CHECK(NULL == telemetry_batch_finish(&batch));
+    for (size_t i = 0; i < 3; i++) {
+        CHECK(!telemetry_batch_is_due(&batch, 0));
+        CHECK(telemetry_batch_add(&batch, &sample, 0));
+    }
+    CHECK(telemetry_batch_is_due(&batch, 0));
+    CHECK_EQUAL(3, count_datapoints(telemetry_batch_finish(&batch)));
+    telemetry_batch_reset(&batch);
+    CHECK_EQUAL(0, telemetry_batch_count(&batch));
+
+    // age, from the first sample
+    policy = (telemetry_batch_policy) {100, 1000, 0};
+    telemetry_batch_init(&batch, &policy, "1.1.0", buffer, sizeof(buffer));
+    CHECK(!telemetry_batch_is_due(&batch, 5000));
+    CHECK(telemetry_batch_add(&batch, &sample, 5000));
+    CHECK(telemetry_batch_add(&batch, &sample, 5900));
+    CHECK(!telemetry_batch_is_due(&batch, 5999));
+    CHECK(telemetry_batch_is_due(&batch, 6000));
+
+    // bytes: a sample that does not fit is refused, and the message stays within the budget
+    policy = (telemetry_batch_policy) {100, 0, 600};
+    telemetry_batch_init(&batch, &policy, "1.1.0", buffer, sizeof(buffer));
+    size_t added = 0;
+    while (telemetry_batch_add(&batch, &sample, 0)) {
+        added++;
+        CHECK(added < 100);
+    }
+    CHECK(added > 1);
+    const char *message = telemetry_batch_finish(&batch);
+    CHECK(strlen(message) + 1 <= 600);
+    CHECK_EQUAL(added, count_datapoints(message));
+
+    // a single sample beyond the budget is taken, so that the caller flushes, and the flush fails
+    policy = (telemetry_batch_policy) {100, 0, 100};
+    telemetry_batch_init(&batch, &policy, "1.1.0", buffer, sizeof(buffer));
+    CHECK(telemetry_batch_add(&batch, &sample, 0));
+    CHECK_EQUAL(1, telemetry_batch_count(&batch));
+    CHECK(NULL == telemetry_batch_finish(&batch));
+
+    // budgets and buffers smaller than the terminator, in both formats, do not write past the budget
+    static const telemetry_format formats[] = {TELEMETRY_FORMAT_JSON, TELEMETRY_FORMAT_CBOR};
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        for (size_t size = 0; size <= TELEMETRY_CBOR_TERMINATOR_LEN + TELEMETRY_JSON_TERMINATOR_LEN; size++) {
+            memset(buffer, 0x5A, sizeof(buffer));
+            policy = (telemetry_batch_policy) {100, 0, size};
+            telemetry_batch_init(&batch, &policy, "1.1.0", buffer, size ? sizeof(buffer) : 0);
+            telemetry_batch_set_format(&batch, formats[f]);
+            CHECK(telemetry_batch_add(&batch, &sample, 0));
+            CHECK(NULL == telemetry_batch_finish(&batch));
+            for (size_t i = size; i < sizeof(buffer); i++) {
+                CHECK_EQUAL(0x5A, (unsigned char) buffer[i]);
+            }
+        }
+    }
+}
+
+static void flush(telemetry_batch *batch, size_t *messages, size_t *payload, size_t *wire) {
+    const char *message = telemetry_batch_finish(batch);
+    CHECK(NULL != message);
+    CHECK_EQUAL(telemetry_batch_count(batch), count_datapoints(message));
+    (*messages)++;
+    *payload += strlen(message);
+    *wire += wire_bytes(strlen(message));
+    telemetry_batch_reset(batch);
+}
+
+static void report_wire_bytes(size_t samples) {
+    static const size_t batch_sizes[] = {1, 8, 32};
+    static char buffer[BUFFER_SIZE];
+    double previous = 0;
+    printf("%6s %9s %14s %14s %16s\n", "batch", "messages", "payload B/smp", "wire B/smp", "vs batch size 1");
+    double single = 0;
+    for (size_t b = 0; b < sizeof(batch_sizes) / sizeof(batch_sizes[0]); b++) {
+        const telemetry_batch_policy policy = {batch_sizes[b], 0, 0};
+        telemetry_batch batch;
+        telemetry_batch_init(&batch, &policy, "1.1.0", buffer, sizeof(buffer));
+        size_t messages = 0, payload = 0, wire = 0;
+        for (size_t i = 0; i < samples; i++) {
+            telemetry_sample sample;
+            make_sample(&sample, i);
+            // as add_sample() does: a sample that does not fit flushes the batch and starts the next one
+            while (!telemetry_batch_add(&batch, &sample, 0)) {
+                flush(&batch, &messages, &payload, &wire);
+            }
+            if (telemetry_batch_is_due(&batch, 0) || i + 1 == samples) {
+                flush(&batch, &messages, &payload, &wire);
+            }
+        }
+        const double per_sample = (double) wire / (double) samples;
+        if (0 == b) {
+            single = per_sample;
+        }
+        printf("%6zu %9zu %14.1f %14.1f %15.2fx\n", batch_sizes[b], messages, (double) payload / (double) samples,
+                per_sample, single / per_sample);
+        CHECK(0 == b || per_sample < previous);
+        previous = per_sample;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    test_policy();
+    report_wire_bytes(argc > 1 ? (size_t) atol(argv[1]) : DEFAULT_SAMPLES);
+    return 0;
+}
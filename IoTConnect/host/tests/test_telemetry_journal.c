@@ -0,0 +1,240 @@
+//
+// Copyright: Avnet 2023
+//
+
+// Checks telemetry_journal.c on the file backend: order, recovery after a "reboot", the drop of the oldest
+// block when full and a corrupted record. Then benchmarks append and replay throughput, and the storage writes
+// per sample, with the device layout (APP_JOURNAL_BLOCK_SIZE x APP_JOURNAL_BLOCK_COUNT, synced every
+// APP_JOURNAL_SYNC_SAMPLES) and with a larger one. The file is flushed on every write, as the backend does.
+//
+// Usage: test_telemetry_journal [samples]
+
+#include <string.h>
+#include "host_test.h"
+#include "telemetry_journal.h"
+
+#define JOURNAL_PATH        "test_telemetry_journal.bin"
+#define DEFAULT_SAMPLES     200000
+#define MAX_BLOCK_SIZE      4096
+#define BLOCK_HEADER_SIZE   16      // as telemetry_journal.c stores blocks and records
+#define RECORD_SIZE         26
+
+typedef struct counting_storage {
+    telemetry_journal_storage file;
+    telemetry_journal_storage storage;
+    uint32_t writes;
+    uint32_t erases;
+    uint64_t bytes_written;
+} counting_storage;
+
+static uint8_t write_buffer[MAX_BLOCK_SIZE];
+static uint8_t read_buffer[MAX_BLOCK_SIZE];
+
+static int counting_read(void *context, uint32_t block, uint8_t *data, uint32_t size) {
+    counting_storage *c = (counting_storage *) context;
+    return c->file.read(c->file.context, block, data, size);
+}
+
+static int counting_write(void *context, uint32_t block, const uint8_t *data, uint32_t size) {
+    counting_storage *c = (counting_storage *) context;
+    c->writes++;
+    c->bytes_written += size;
+    return c->file.write(c->file.context, block, data, size);
+}
+
+static int counting_erase(void *context, uint32_t block) {
+    counting_storage *c = (counting_storage *) context;
+    c->erases++;
+    return c->file.erase(c->file.context, block);
+}
+
+static void open_storage(counting_storage *c, uint32_t block_size, uint32_t block_count, bool fresh) {
+    if (fresh) {
+        remove(JOURNAL_PATH);
+    }
+    memset(c, 0, sizeof(*c));
+    CHECK_EQUAL(0, telemetry_journal_file_storage_init(&c->file, JOURNAL_PATH, block_size, block_count));
+    c->storage = c->file;
+    c->storage.context = c;
+    c->storage.read = counting_read;
+    c->storage.write = counting_write;
+    c->storage.erase = counting_erase;
+}
+
+static void close_storage(counting_storage *c) {
+    telemetry_journal_file_storage_close(&c->file);
+}
+
+static void make_sample(telemetry_sample *sample, uint32_t i) {
+    sample->timestamp = 1700000000 + 5 * (time_t) i;
+    sample->temperature = 20.0 + (double) (i % 1000) / 100.0;
+    sample->button_counter = i;
+    sample->has_sensor_values = (i % 7) != 0;
+}
+
+static void check_sample(const telemetry_sample *sample, uint32_t i) {
+    telemetry_sample expected;
+    make_sample(&expected, i);
+    CHECK_EQUAL(expected.timestamp, sample->timestamp);
+    CHECK(expected.temperature == sample->temperature);
+    CHECK_EQUAL(expected.button_counter, sample->button_counter);
+    CHECK_EQUAL(expected.has_sensor_values, sample->has_sensor_values);
+}
+
+static void test_order_and_recovery(void) {
+    counting_storage c;
+    telemetry_journal journal;
+    telemetry_sample sample;
+    open_storage(&c, 512, 4, true);
+    CHECK_EQUAL(0, telemetry_journal_init(&journal, &c.storage, write_buffer, read_buffer));
+    CHECK(!telemetry_journal_read(&journal, &sample));
+
+    // across block boundaries, partly in RAM
+    for (uint32_t i = 0; i < 40; i++) {
+        make_sample(&sample, i);
+        CHECK_EQUAL(0, telemetry_journal_append(&journal, &sample));
+    }
+    CHECK_EQUAL(40, telemetry_journal_pending(&journal));
+    for (uint32_t i = 0; i < 40; i++) {
+        CHECK(telemetry_journal_read(&journal, &sample));
+        check_sample(&sample, i);
+    }
+    CHECK(!telemetry_journal_read(&journal, &sample));
+
+    // what was synced survives a reboot, in order. What was not synced is lost.
+    for (uint32_t i = 100; i < 130; i++) {
+        make_sample(&sample, i);
+        telemetry_journal_append(&journal, &sample);
+    }
+    CHECK_EQUAL(0, telemetry_journal_sync(&journal));
+    make_sample(&sample, 130);
+    telemetry_journal_append(&journal, &sample);
+    close_storage(&c);
+
+    open_storage(&c, 512, 4, false);
+    CHECK_EQUAL(0, telemetry_journal_init(&journal, &c.storage, write_buffer, read_buffer));
+    CHECK_EQUAL(30, telemetry_journal_pending(&journal));
+    for (uint32_t i = 130; i < 140; i++) { // appending continues behind the recovered samples
+        make_sample(&sample, i);
+        telemetry_journal_append(&journal, &sample);
+    }
+    for (uint32_t i = 100; i < 140; i++) {
+        CHECK(telemetry_journal_read(&journal, &sample));
+        check_sample(&sample, i);
+    }
+    CHECK(!telemetry_journal_read(&journal, &sample));
+    close_storage(&c);
+}
+
+static void test_full_and_corrupted(void) {
+    counting_storage c;
+    telemetry_journal journal;
+    telemetry_sample sample;
+    open_storage(&c, 512, 4, true);
+    CHECK_EQUAL(0, telemetry_journal_init(&journal, &c.storage, write_buffer, read_buffer));
+
+    // the oldest block is dropped when full. What is left is the newest samples, in order.
+    const uint32_t appended = 500;
+    for (uint32_t i = 0; i < appended; i++) {
+        make_sample(&sample, i);
+        telemetry_journal_append(&journal, &sample);
+    }
+    const uint32_t pending = telemetry_journal_pending(&journal);
+    CHECK(telemetry_journal_dropped(&journal) > 0);
+    CHECK_EQUAL(appended, pending + telemetry_journal_dropped(&journal));
+    for (uint32_t i = appended - pending; i < appended; i++) {
+        CHECK(telemetry_journal_read(&journal, &sample));
+        check_sample(&sample, i);
+    }
+    CHECK(!telemetry_journal_read(&journal, &sample));
+
+    // a corrupted record in storage is skipped and counted, its neighbors are delivered
+    for (uint32_t i = 0; i < 40; i++) {
+        make_sample(&sample, i);
+        telemetry_journal_append(&journal, &sample);
+    }
+    CHECK_EQUAL(0, telemetry_journal_sync(&journal));
+    close_storage(&c);
+    FILE *f = fopen(JOURNAL_PATH, "r+b");
+    CHECK(f != NULL);
+    uint8_t block[512];
+    long corrupted_block = -1;
+    for (long b = 0; b < 4 && corrupted_block < 0; b++) {
+        // the block that holds sample 0
+        CHECK(0 == fseek(f, b * 512, SEEK_SET) && 1 == fread(block, sizeof(block), 1, f));
+        for (size_t offset = 0; offset + 8 <= sizeof(block); offset++) {
+            const uint64_t timestamp = 1700000000;
+            if (0 == memcmp(&block[offset], &timestamp, 8)) { // little endian, as the journal stores it
+                corrupted_block = b;
+                block[offset + 9] ^= 0x40; // in the temperature
+                break;
+            }
+        }
+    }
+    CHECK(corrupted_block >= 0);
+    CHECK(0 == fseek(f, corrupted_block * 512, SEEK_SET) && 1 == fwrite(block, sizeof(block), 1, f));
+    fclose(f);
+
+    open_storage(&c, 512, 4, false);
+    CHECK_EQUAL(0, telemetry_journal_init(&journal, &c.storage, write_buffer, read_buffer));
+    const uint32_t dropped_before = telemetry_journal_dropped(&journal);
+    for (uint32_t i = 1; i < 40; i++) {
+        CHECK(telemetry_journal_read(&journal, &sample));
+        check_sample(&sample, i);
+    }
+    CHECK(!telemetry_journal_read(&journal, &sample));
+    CHECK_EQUAL(dropped_before + 1, telemetry_journal_dropped(&journal));
+    close_storage(&c);
+}
+
+static void benchmark(const char *name, uint32_t block_size, uint32_t block_count, uint32_t sync_samples,
+        uint32_t samples) {
+    counting_storage c;
+    telemetry_journal journal;
+    telemetry_sample sample;
+    open_storage(&c, block_size, block_count, true);
+    CHECK_EQUAL(0, telemetry_journal_init(&journal, &c.storage, write_buffer, read_buffer));
+
+    // appends in rounds that fit the journal, each replayed before the next, like an outage and its reconnect
+    uint64_t append_ns = 0, replay_ns = 0;
+    uint32_t appended = 0, replayed = 0;
+    const uint32_t round = (block_size - BLOCK_HEADER_SIZE) / RECORD_SIZE * (block_count - 1);
+    while (appended < samples) {
+        uint64_t start = host_test_ns();
+        for (uint32_t i = 0; i < round && appended < samples; i++, appended++) {
+            make_sample(&sample, appended);
+            CHECK_EQUAL(0, telemetry_journal_append(&journal, &sample));
+            if (sync_samples && 0 == (appended + 1) % sync_samples) {
+                CHECK_EQUAL(0, telemetry_journal_sync(&journal));
+            }
+        }
+        append_ns += host_test_ns() - start;
+        start = host_test_ns();
+        while (telemetry_journal_read(&journal, &sample)) {
+            check_sample(&sample, replayed);
+            replayed++;
+        }
+        replay_ns += host_test_ns() - start;
+    }
+    CHECK_EQUAL(samples, replayed);
+    CHECK_EQUAL(0, telemetry_journal_dropped(&journal));
+    printf("%-24s %6u %6u %5u %12.0f %12.0f %12.2f %12.1f\n", name, block_size, block_count, sync_samples,
+            samples / (append_ns / 1e9), samples / (replay_ns / 1e9), (double) c.writes / samples,
+            (double) c.bytes_written / samples);
+    close_storage(&c);
+}
+
+int main(int argc, char *argv[]) {
+    const uint32_t samples = (uint32_t) (argc > 1 ? strtoul(argv[1], NULL, 10) : DEFAULT_SAMPLES);
+    test_order_and_recovery();
+    test_full_and_corrupted();
+
+    printf("%-24s %6s %6s %5s %12s %12s %12s %12s\n", "layout", "block", "blocks", "sync", "append/s", "replay/s",
+            "writes/smp", "bytes/smp");
+    benchmark("device, synced", 512, 4, 6, samples);
+    benchmark("device, not synced", 512, 4, 0, samples);
+    benchmark("large blocks, synced", 4096, 64, 6, samples);
+    benchmark("large blocks, not synced", 4096, 64, 0, samples);
+    remove(JOURNAL_PATH);
+    return 0;
+}
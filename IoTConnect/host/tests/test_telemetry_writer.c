@@ -0,0 +1,266 @@
+//
+// Copyright: Avnet 2023
+//
+
+// Checks the JSON of telemetry_writer.c and benchmarks it: heap allocations, peak heap and time per message.
+// With the IoTConnect SDK checked out, the same message is also built the way iotc-c-lib does, as a cJSON
+// tree that is printed and freed, for comparison. The heap is counted by wrapping malloc and friends at link time.
+//
+// Usage: test_telemetry_writer [messages]
+
+#include <math.h>
+#include <string.h>
+#include "host_test.h"
+#include "iotconnect_lib.h"
+#include "telemetry_writer.h"
+#ifdef HAVE_CJSON
+#include "cJSON.h"
+#endif
+
+#define DEFAULT_MESSAGES 200000
+
+static size_t allocations;
+static size_t heap_in_use;
+static size_t peak_heap;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+void __real_free(void *pointer);
+
+// Each block carries its size in front, to track the heap in use
+static void *track(size_t *block, size_t size) {
+    if (NULL == block) {
+        return NULL;
+    }
+    allocations++;
+    heap_in_use += size;
+    if (heap_in_use > peak_heap) {
+        peak_heap = heap_in_use;
+    }
+    block[0] = size;
+    return &block[2];
+}
+
+void *__wrap_malloc(size_t size) {
+    return track(__real_malloc(size + 2 * sizeof(size_t)), size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    return track(__real_calloc(1, count * size + 2 * sizeof(size_t)), count * size);
+}
+
+void __wrap_free(void *pointer) {
+    if (pointer) {
+        size_t *block = (size_t *) pointer - 2;
+        heap_in_use -= block[0];
+        __real_free(block);
+    }
+}
+
+void *__wrap_realloc(void *pointer, size_t size) {
+    void *copy = __wrap_malloc(size);
+    if (copy && pointer) {
+        const size_t old_size = ((size_t *) pointer)[-2];
+        memcpy(copy, pointer, old_size < size ? old_size : size);
+        __wrap_free(pointer);
+    }
+    return copy;
+}
+
+static const telemetry_sample sample = {1700000000, 23.25, 42, true};
+
+static const char expected_message[] =
+        "{\"cpId\":\"avtds\",\"dtg\":\"5a2b3c4d-0000-4000-8000-0123456789ab\",\"mt\":0,"
+        "\"sdk\":{\"l\":\"M_C\",\"v\":\"2.0\",\"e\":\"poc\"},\"t\":\"2023-11-14T22:13:20.000Z\","
+        "\"d\":[{\"id\":\"stm32h5-0123456789\",\"tg\":\"\",\"dt\":\"2023-11-14T22:13:20.000Z\","
+        "\"d\":{\"version\":\"1.1.0\",\"temperature\":23.25,\"button_counter\":42}}]}";
+
+static const char *write_message(char *buffer, size_t size) {
+    telemetry_writer w;
+    telemetry_writer_init(&w, buffer, size);
+    telemetry_writer_begin_message(&w, sample.timestamp);
+    telemetry_writer_add_sample(&w, "1.1.0", &sample);
+    return telemetry_writer_finish(&w);
+}
+
+static void test_message(void) {
+    char buffer[512];
+    const char *message = write_message(buffer, sizeof(buffer));
+    CHECK(message != NULL);
+    if (0 != strcmp(expected_message, message)) {
+        fprintf(stderr, "got      %s\nexpected %s\n", message, expected_message);
+        CHECK(0 == strcmp(expected_message, message));
+    }
+
+    // every buffer that is too short fails cleanly, without writing past its end
+    const size_t length = strlen(expected_message);
+    for (size_t size = 0; size < length + TELEMETRY_JSON_TERMINATOR_LEN + 1; size++) {
+        memset(buffer, 0x5A, sizeof(buffer));
+        message = write_message(buffer, size);
+        CHECK(NULL == message || size > length);
+        for (size_t i = size; i < sizeof(buffer); i++) {
+            CHECK_EQUAL(0x5A, (unsigned char) buffer[i]);
+        }
+    }
+
+    // the configuration may not be complete yet, like before the discovery
+    IotclConfig *config = iotcl_get_config();
+    const IotclConfig saved = *config;
+    config->device.cpid = NULL;
+    config->device.env = NULL;
+    config->device.duid = NULL;
+    config->telemetry.dtg = NULL;
+    message = write_message(buffer, sizeof(buffer));
+    CHECK(message != NULL);
+    CHECK(NULL != strstr(message, "{\"cpId\":\"\",\"dtg\":\"\","));
+    CHECK(NULL != strstr(message, "\"e\":\"\"}"));
+    *config = saved;
+}
+
+// The JSON of the value, from the data point of a message that has only this value
+static void write_number(double value, char *number, size_t size) {
+    char buffer[512];
+    telemetry_writer w;
+    telemetry_writer_init(&w, buffer, sizeof(buffer));
+    telemetry_writer_begin_message(&w, sample.timestamp);
+    telemetry_writer_begin_datapoint(&w, sample.timestamp);
+    telemetry_writer_add_number(&w, "value", value);
+    telemetry_writer_end_datapoint(&w);
+    const char *message = telemetry_writer_finish(&w);
+    CHECK(message != NULL);
+    const char *start = strstr(message, "\"value\":");
+    CHECK(start != NULL);
+    start += strlen("\"value\":");
+    const size_t length = strcspn(start, "}");
+    CHECK(length < size);
+    memcpy(number, start, length);
+    number[length] = 0;
+}
+
+// Numbers are printed like cJSON does: 15 digits, or 17 if 15 do not read back as the same value
+static void test_numbers(void) {
+    static const struct {
+        double value;
+        const char *json;
+    } cases[] = {
+        {0, "0"},
+        {42, "42"},
+        {-7.5, "-7.5"},
+        {23.25, "23.25"},
+        {0.1, "0.1"},
+        {0.1 + 0.2, "0.30000000000000004"},
+        {1.0 / 3.0, "0.33333333333333331"},
+        {1e300, "1e+300"},
+        {123456789012345678.0, "1.2345678901234568e+17"},
+        {(double) 23.1f, "23.100000381469727"},
+        {NAN, "null"},
+    };
+    char number[64];
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        write_number(cases[i].value, number, sizeof(number));
+        if (0 != strcmp(cases[i].json, number)) {
+            fprintf(stderr, "got %s, expected %s\n", number, cases[i].json);
+            CHECK(0 == strcmp(cases[i].json, number));
+        }
+#ifdef HAVE_CJSON
+        cJSON *item = cJSON_CreateNumber(cases[i].value);
+        char *printed = cJSON_PrintUnformatted(item);
+        CHECK(0 == strcmp(printed, number));
+        cJSON_free(printed);
+        cJSON_Delete(item);
+#endif
+    }
+}
+
+#ifdef HAVE_CJSON
+// The message as iotc-c-lib builds it for iotcl_create_serialized_string(): a cJSON tree, printed and freed
+static char *cjson_message(void) {
+    IotclConfig *config = iotcl_get_config();
+    char now[TELEMETRY_ISO_TIME_LEN + 1];
+    telemetry_format_iso_time(sample.timestamp, now, sizeof(now));
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "cpId", config->device.cpid);
+    cJSON_AddStringToObject(root, "dtg", config->telemetry.dtg);
+    cJSON_AddNumberToObject(root, "mt", 0);
+    cJSON *sdk = cJSON_CreateObject();
+    cJSON_AddStringToObject(sdk, "l", "M_C");
+    cJSON_AddStringToObject(sdk, "v", "2.0");
+    cJSON_AddStringToObject(sdk, "e", config->device.env);
+    cJSON_AddItemToObject(root, "sdk", sdk);
+    cJSON_AddStringToObject(root, "t", now);
+    cJSON *datapoints = cJSON_CreateArray();
+    cJSON *datapoint = cJSON_CreateObject();
+    cJSON_AddStringToObject(datapoint, "id", config->device.duid);
+    cJSON_AddStringToObject(datapoint, "tg", "");
+    cJSON_AddStringToObject(datapoint, "dt", now);
+    cJSON *fields = cJSON_CreateObject();
+    cJSON_AddStringToObject(fields, "version", "1.1.0");
+    cJSON_AddNumberToObject(fields, "temperature", sample.temperature);
+    cJSON_AddNumberToObject(fields, "button_counter", sample.button_counter);
+    cJSON_AddItemToObject(datapoint, "d", fields);
+    cJSON_AddItemToArray(datapoints, datapoint);
+    cJSON_AddItemToObject(root, "d", datapoints);
+    char *message = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return message;
+}
+#endif
+
+typedef struct benchmark_result {
+    double ns_per_message;
+    double allocations_per_message;
+    size_t peak_heap;
+    size_t length;
+} benchmark_result;
+
+static void report(const char *name, const benchmark_result *result) {
+    printf("%-18s %10.0f %14.1f %11zu %8zu\n", name, result->ns_per_message, result->allocations_per_message,
+            result->peak_heap, result->length);
+}
+
+static void benchmark(long messages) {
+    static char buffer[512];
+    benchmark_result result = {0};
+    printf("%-18s %10s %14s %11s %8s\n", "path", "ns/message", "allocs/message", "peak heap B", "bytes");
+
+    allocations = 0;
+    peak_heap = heap_in_use = 0;
+    size_t length = 0;
+    uint64_t start = host_test_ns();
+    for (long i = 0; i < messages; i++) {
+        length += strlen(write_message(buffer, sizeof(buffer)));
+    }
+    result.ns_per_message = (double) (host_test_ns() - start) / (double) messages;
+    result.allocations_per_message = (double) allocations / (double) messages;
+    result.peak_heap = peak_heap;
+    result.length = length / (size_t) messages;
+    report("telemetry_writer", &result);
+    CHECK_EQUAL(0, allocations);
+
+#ifdef HAVE_CJSON
+    allocations = 0;
+    peak_heap = heap_in_use = 0;
+    length = 0;
+    start = host_test_ns();
+    for (long i = 0; i < messages; i++) {
+        char *message = cjson_message();
+        length += strlen(message);
+        cJSON_free(message);
+    }
+    result.ns_per_message = (double) (host_test_ns() - start) / (double) messages;
+    result.allocations_per_message = (double) allocations / (double) messages;
+    result.peak_heap = peak_heap;
+    result.length = length / (size_t) messages;
+    report("cJSON (iotc-c-lib)", &result);
+#else
+    printf("cJSON: the IoTConnect SDK is not checked out, not compared\n");
+#endif
+}
+
+int main(int argc, char *argv[]) {
+    test_message();
+    test_numbers();
+    benchmark(argc > 1 ? atol(argv[1]) : DEFAULT_MESSAGES);
+    return 0;
+}
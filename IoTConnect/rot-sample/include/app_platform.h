@@ -0,0 +1,33 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef APP_PLATFORM_H
+#define APP_PLATFORM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// Platform services used by the app logic. app_platform.c implements them with ThreadX and
+// the STM32H5 HAL. A host build of the app logic only needs to provide these with POSIX calls.
+
+// Monotonic milliseconds. Wraps around.
+uint32_t app_platform_time_ms(void);
+
+void app_platform_sleep_ms(uint32_t ms);
+
+// CPU cycle counter for profiling. Wraps around. Returns 0 if the counter is not available.
+uint32_t app_platform_cycles(void);
+
+uint32_t app_platform_cycles_per_us(void);
+
+void app_platform_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // APP_PLATFORM_H
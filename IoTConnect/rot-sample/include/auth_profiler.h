@@ -0,0 +1,66 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef AUTH_PROFILER_H
+#define AUTH_PROFILER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "iotconnect_app_config.h"
+
+#ifndef APP_AUTH_PROFILER
+#define APP_AUTH_PROFILER 0
+#endif
+
+// Points of the X.509 authentication path that are measured
+typedef enum {
+    AUTH_PROFILE_GET_CERT,              // IotcAuthInterface get_cert
+    AUTH_PROFILE_GET_PRIVATE_KEY,       // IotcAuthInterface get_private_key
+    AUTH_PROFILE_RETRIEVE_CREDENTIALS,  // device_identity_retrieve_credentials()
+    AUTH_PROFILE_EXTRACT_CN,            // extract_operational_cn / extract_bootstrap_cn
+    AUTH_PROFILE_X509_INITIALIZE,       // nx_secure_x509_certificate_initialize(), once per driver
+    AUTH_PROFILE_ECDSA_OPERATION,       // crypto_method_ecdsa_psa_crypto operation, i.e. the TLS client signature
+    AUTH_PROFILE_COUNT
+} auth_profile_point;
+
+typedef struct auth_profile_entry {
+    uint32_t calls;
+    uint64_t cycles;      // cumulative
+    uint32_t max_cycles;
+    uint64_t bytes;       // cumulative payload size, where it applies
+} auth_profile_entry;
+
+#if APP_AUTH_PROFILER
+
+#include "app_platform.h"
+
+// Cycles are counted with app_platform_cycles(): DWT on the target, clock_gettime() based in a host build.
+#define AUTH_PROFILE_BEGIN(name) const uint32_t name = app_platform_cycles()
+#define AUTH_PROFILE_END(name, point, size) auth_profiler_record((point), app_platform_cycles() - (name), (size))
+
+void auth_profiler_record(auth_profile_point point, uint32_t cycles, size_t size);
+const auth_profile_entry *auth_profiler_get(auth_profile_point point);
+const char *auth_profiler_name(auth_profile_point point);
+void auth_profiler_reset(void);
+
+// Prints a table of all points to the console
+void auth_profiler_print(void);
+
+#else
+
+// compiled out. The arguments are not evaluated.
+#define AUTH_PROFILE_BEGIN(name)
+#define AUTH_PROFILE_END(name, point, size)
+
+#endif // APP_AUTH_PROFILER
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUTH_PROFILER_H
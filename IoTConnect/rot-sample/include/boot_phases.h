@@ -0,0 +1,51 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef BOOT_PHASES_H
+#define BOOT_PHASES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "tx_api.h"
+
+// Startup milestones, in the order that they are printed. Some of them are reached concurrently.
+typedef enum {
+    BOOT_PHASE_IP_ADDRESS = 0,      // DHCP completed
+    BOOT_PHASE_DNS_READY,           // DNS client created
+    BOOT_PHASE_DISCOVERY_LOOKUP,    // lookup of APP_DISCOVERY_HOST_NAME finished, successfully or not
+    BOOT_PHASE_TIME_SYNCED,         // SNTP time sync completed
+    BOOT_PHASE_APP_READY,           // app_startup() initialized everything that does not need the network
+    BOOT_PHASE_CONNECTED,           // first IoTConnect connection established
+    BOOT_PHASE_FIRST_PUBLISH,       // first telemetry message sent
+    BOOT_PHASE_COUNT
+} boot_phase;
+
+#define BOOT_PHASE_BIT(phase) (1UL << (phase))
+
+// Timestamps of the startup phases, and a way to wait for the phases that a startup step depends on.
+// Times are in ms since boot_phases_init(). Call boot_phases_init() before any of the threads that mark phases
+// are started.
+UINT boot_phases_init(void);
+
+// Records the phase. Only the first time is kept, so reconnects do not move CONNECTED or FIRST_PUBLISH.
+void boot_phases_mark(boot_phase phase);
+
+bool boot_phases_reached(boot_phase phase);
+
+// Waits until all phases of the mask, made of BOOT_PHASE_BIT(), are reached.
+// Returns TX_SUCCESS or the status of tx_event_flags_get() if the wait timed out.
+UINT boot_phases_wait(ULONG phase_mask, ULONG wait_ticks);
+
+// Prints the time of each phase that was reached, and the time since the previous one.
+void boot_phases_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOT_PHASES_H
@@ -0,0 +1,97 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef CERT_STORE_H
+#define CERT_STORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CERT_STORE_SLOT_COUNT       2
+#define CERT_STORE_NONE             (-1)
+
+// The default ITS_MAX_ASSET_SIZE of TF-M. Enough for a DER P-256 device certificate.
+#ifndef CERT_STORE_MAX_CERT_SIZE
+#define CERT_STORE_MAX_CERT_SIZE    512
+#endif
+
+#define CERT_STORE_ERROR_STORAGE    (-1) // the storage failed
+#define CERT_STORE_ERROR_STATE      (-2) // the slot is active, or has no staged key
+#define CERT_STORE_ERROR_SIZE       (-3) // the certificate does not fit CERT_STORE_MAX_CERT_SIZE
+
+// Storage items. The table is written last, so that the switch to a new certificate happens with one item write.
+#define CERT_STORE_ITEM_TABLE       0
+#define CERT_STORE_ITEM_CERT(slot)  (1 + (slot))
+
+// Item storage. A write must replace the whole item atomically, like psa_its_set() does.
+// All functions return 0 on success.
+typedef struct cert_store_storage {
+    void *context;
+    // Returns CERT_STORE_ERROR_STORAGE if the item does not exist.
+    int (*read)(void *context, uint32_t item, uint8_t *data, uint32_t size, uint32_t *actual_size);
+    int (*write)(void *context, uint32_t item, const uint8_t *data, uint32_t size);
+} cert_store_storage;
+
+typedef enum {
+    CERT_STORE_SLOT_EMPTY = 0,
+    CERT_STORE_SLOT_KEY_STAGED,  // a key was generated for a CSR, the certificate was not received yet
+    CERT_STORE_SLOT_READY        // key and certificate
+} cert_store_slot_state;
+
+typedef struct cert_store_slot {
+    uint8_t state;
+    uint32_t key_id;       // PSA key ID of the private key
+    uint32_t generation;   // store generation that committed the certificate
+    uint32_t cert_size;
+    uint8_t cert[CERT_STORE_MAX_CERT_SIZE];
+} cert_store_slot;
+
+// Table of operational certificate slots, each with its own private key.
+// A new certificate is staged in a slot that is not active and then made active with a single table write,
+// so a power loss at any point leaves either the old or the new certificate active.
+// Certificates are read from storage once, when the store is initialized or the certificate is committed,
+// and are served from RAM afterwards. The certificate of a slot that was active stays intact until
+// a key is staged in that slot again, so a handshake that is already using it is not affected by a swap.
+typedef struct cert_store {
+    const cert_store_storage *storage;
+    cert_store_slot slots[CERT_STORE_SLOT_COUNT];
+    volatile int active;   // slot in use, or CERT_STORE_NONE
+    uint32_t generation;
+} cert_store;
+
+// Loads the table and the certificates. A store that was never written is empty.
+int cert_store_init(cert_store *store, const cert_store_storage *storage);
+
+// Returns the slot that a new certificate should be staged in, i.e. one that is not active.
+int cert_store_staging_slot(const cert_store *store);
+
+// Records that a new private key was generated for the slot. Any certificate that the slot held is discarded.
+int cert_store_stage_key(cert_store *store, int slot, uint32_t key_id);
+
+// Stores the certificate for the key staged in the slot and makes the slot active.
+int cert_store_commit(cert_store *store, int slot, const uint8_t *cert, uint32_t cert_size);
+
+// Returns false if no slot is active. Any of the output pointers can be NULL.
+bool cert_store_active(const cert_store *store, const uint8_t **cert, uint32_t *cert_size, uint32_t *key_id);
+
+// Storage backed by PSA Internal Trusted Storage. One ITS asset per item, so it needs
+// CERT_STORE_SLOT_COUNT + 1 assets of up to CERT_STORE_MAX_CERT_SIZE bytes.
+void cert_store_its_storage_init(cert_store_storage *storage);
+
+#ifdef CERT_STORE_FILE_STORAGE
+// Storage backed by one file per item in an existing directory, as a stand-in for ITS on hosts with a file system.
+// Items are written to a temporary file and renamed, to keep writes atomic. Returns 0 on success.
+int cert_store_file_storage_init(cert_store_storage *storage, const char *directory);
+void cert_store_file_storage_close(cert_store_storage *storage);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CERT_STORE_H
@@ -0,0 +1,110 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef COMMAND_DISPATCHER_H
+#define COMMAND_DISPATCHER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "tx_api.h"
+
+#ifndef COMMAND_DISPATCHER_MAX_HANDLERS
+#define COMMAND_DISPATCHER_MAX_HANDLERS 8
+#endif
+
+// Commands that are queued or running at the same time. Further commands are rejected with a "Busy" ack.
+#ifndef COMMAND_DISPATCHER_QUEUE_DEPTH
+#define COMMAND_DISPATCHER_QUEUE_DEPTH  4
+#endif
+
+#ifndef COMMAND_DISPATCHER_MAX_LENGTH
+#define COMMAND_DISPATCHER_MAX_LENGTH   128 // command name and arguments
+#endif
+
+#ifndef COMMAND_DISPATCHER_MAX_ARGS
+#define COMMAND_DISPATCHER_MAX_ARGS     8   // including the command name
+#endif
+
+#ifndef COMMAND_DISPATCHER_MESSAGE_SIZE
+#define COMMAND_DISPATCHER_MESSAGE_SIZE 64
+#endif
+
+// The handler acknowledges when it is accepted and reports its result only to the console.
+// Use it for commands that take longer than the cloud waits for an ack.
+#define COMMAND_FLAG_ACK_ON_ACCEPT      0x01
+
+// Runs on the worker thread. argv[0] is the command name. The message is sent with the ack.
+typedef bool (*command_handler_fn)(int argc, const char *argv[], char *message, size_t message_size);
+
+// Sends the ack for the event of a command. Called only from the thread that calls
+// command_dispatcher_submit() and command_dispatcher_process(), i.e. the thread that polls the SDK.
+typedef void (*command_ack_fn)(void *event, bool success, const char *command_name, const char *message);
+
+typedef struct command_handler_entry {
+    const char *name;
+    command_handler_fn handler;
+    uint32_t flags;
+} command_handler_entry;
+
+typedef struct command_job {
+    const command_handler_entry *entry;
+    void *event;          // SDK event to ack on completion. NULL if it was acked already.
+    int argc;
+    const char *argv[COMMAND_DISPATCHER_MAX_ARGS];
+    char text[COMMAND_DISPATCHER_MAX_LENGTH];
+    bool success;
+    char message[COMMAND_DISPATCHER_MESSAGE_SIZE];
+} command_job;
+
+// Runs cloud commands on a worker thread, so that a slow handler does not hold up the SDK polling.
+// A command is parsed into a preallocated job and queued by command_dispatcher_submit(), from the SDK callback.
+// The worker runs the handler and queues the job back. command_dispatcher_process(), called between polls,
+// sends the acks of the completed jobs and frees them. Nothing is allocated after command_dispatcher_init().
+typedef struct command_dispatcher {
+    command_handler_entry handlers[COMMAND_DISPATCHER_MAX_HANDLERS];
+    unsigned int handler_count;
+    command_ack_fn ack;
+    command_job jobs[COMMAND_DISPATCHER_QUEUE_DEPTH];
+    TX_QUEUE free_jobs;
+    TX_QUEUE pending_jobs;
+    TX_QUEUE done_jobs;
+    ULONG free_storage[COMMAND_DISPATCHER_QUEUE_DEPTH];
+    ULONG pending_storage[COMMAND_DISPATCHER_QUEUE_DEPTH];
+    ULONG done_storage[COMMAND_DISPATCHER_QUEUE_DEPTH];
+    TX_THREAD worker;
+    uint32_t completed;
+    uint32_t rejected;    // unknown, malformed, or the queue was full
+} command_dispatcher;
+
+// Starts the worker thread with the given stack.
+UINT command_dispatcher_init(command_dispatcher *dispatcher, command_ack_fn ack, void *stack, ULONG stack_size,
+        UINT priority);
+
+// Call before commands can arrive. The name must stay valid. Returns false if the registry is full.
+bool command_dispatcher_register(command_dispatcher *dispatcher, const char *name, command_handler_fn handler,
+        uint32_t flags);
+
+// Queues the command, or acks the event right away if the command is unknown or can not be queued. Never blocks.
+// The event is NULL for commands that do not need an ack.
+void command_dispatcher_submit(command_dispatcher *dispatcher, void *event, const char *command);
+
+// Sends the acks of completed commands. Waits up to wait_ticks for the first one.
+// Returns the number of completed commands.
+unsigned int command_dispatcher_process(command_dispatcher *dispatcher, ULONG wait_ticks);
+
+// Runs count no-op commands through the dispatcher and prints the throughput and the longest time that
+// command_dispatcher_submit() took, which is the delay added to the SDK polling. Call from the polling thread
+// while no other commands are pending.
+void command_dispatcher_benchmark(command_dispatcher *dispatcher, unsigned int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COMMAND_DISPATCHER_H
@@ -0,0 +1,59 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef CONNECTION_SUPERVISOR_H
+#define CONNECTION_SUPERVISOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Stage at which a connection attempt failed
+typedef enum {
+    CONNECTION_STAGE_NETWORK, // the cloud host name could not be resolved. The local network or DNS is down.
+    CONNECTION_STAGE_CLOUD    // discovery, TLS or MQTT failed, or the connection was lost
+} connection_stage;
+
+typedef struct connection_backoff_policy {
+    uint32_t min_delay_ms;         // delay after the first failure
+    uint32_t max_delay_ms;         // cap for cloud stage failures
+    uint32_t network_max_delay_ms; // cap for network stage failures, which are usually local and short
+    uint32_t stable_ms;            // a connection that lasted this long resets the backoff
+} connection_backoff_policy;
+
+// Decides how long to wait before each reconnect attempt.
+// The delay doubles with each consecutive failure up to the cap of the failed stage. Half of each delay is
+// randomized (equal jitter), so that a fleet that lost the connection at the same time does not come back
+// in lockstep. After a lost connection, the first attempt is also randomized over min_delay_ms.
+typedef struct connection_supervisor {
+    connection_backoff_policy policy;
+    uint32_t failures;      // consecutive failures
+    uint32_t random;        // xorshift32 state
+    uint32_t connected_ms;
+    bool connected;
+} connection_supervisor;
+
+// The seed should differ between devices, e.g. derived from the device ID.
+void connection_supervisor_init(connection_supervisor *supervisor, const connection_backoff_policy *policy,
+        uint32_t seed);
+
+// Returns the delay before the next attempt
+uint32_t connection_supervisor_on_failure(connection_supervisor *supervisor, connection_stage stage);
+
+void connection_supervisor_on_connected(connection_supervisor *supervisor, uint32_t now_ms);
+
+// Returns the delay before the next attempt
+uint32_t connection_supervisor_on_disconnected(connection_supervisor *supervisor, uint32_t now_ms);
+
+// FNV-1a hash, for deriving a seed from a string
+uint32_t connection_supervisor_seed(const char *str, uint32_t salt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONNECTION_SUPERVISOR_H
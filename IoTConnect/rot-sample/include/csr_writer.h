@@ -0,0 +1,35 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef CSR_WRITER_H
+#define CSR_WRITER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CSR_WRITER_PUBLIC_KEY_SIZE  65 // uncompressed secp256r1 point: 0x04 X Y
+#define CSR_WRITER_SIGNATURE_SIZE   64 // raw r and s, as returned by psa_sign_hash()
+
+#define CSR_WRITER_ERROR_SIZE       (-1) // the buffer is too small
+#define CSR_WRITER_ERROR_SIGN       (-2)
+
+// Signs the SHA-256 digest of the data with the private key of the CSR. Returns 0 on success.
+typedef int (*csr_writer_sign_fn)(void *context, const uint8_t *data, size_t size,
+        uint8_t signature[CSR_WRITER_SIGNATURE_SIZE]);
+
+// Writes a DER encoded PKCS#10 certificate signing request for a secp256r1 key, with the CN as the only subject field
+// and ecdsa-with-SHA256 as the signature algorithm. About 200 bytes plus the CN length.
+// Returns the length of the CSR or a CSR_WRITER_ERROR_* code.
+int csr_writer_build(uint8_t *buffer, size_t buffer_size, const char *cn,
+        const uint8_t public_key[CSR_WRITER_PUBLIC_KEY_SIZE], csr_writer_sign_fn sign, void *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CSR_WRITER_H
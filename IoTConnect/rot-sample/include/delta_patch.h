@@ -0,0 +1,87 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef DELTA_PATCH_H
+#define DELTA_PATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Streaming binary delta, generated by scripts/delta-generate.py.
+ * All values are little endian.
+ *   header: magic "DLT1"(4) source_size(4) target_size(4) flags(4) source_sha256(32)
+ *   COPY:   0x01 length(4) source_offset(4)              - copy a range of the source
+ *   INSERT: 0x02 length(4) data(length)                  - new bytes
+ *   ADD:    0x03 length(4) source_offset(4) data(length) - source bytes plus the data bytes, modulo 256
+ * The patch ends once target_size bytes have been produced.
+ */
+#define DELTA_PATCH_MAGIC        0x31544C44 // "DLT1"
+#define DELTA_PATCH_HEADER_SIZE  48
+#define DELTA_PATCH_DIGEST_SIZE  32
+
+#define DELTA_PATCH_ERROR_FORMAT (-1) // malformed or truncated delta
+#define DELTA_PATCH_ERROR_SOURCE (-2) // the delta was made against a different source image
+
+#ifndef DELTA_PATCH_ADD_CHUNK
+#define DELTA_PATCH_ADD_CHUNK    64
+#endif
+
+// Receives reconstructed target bytes, in order. Returns 0 on success.
+typedef int (*delta_patch_write_fn)(void *context, const uint8_t *data, size_t size);
+
+// Called once the header is received, to confirm that the first source_size bytes of the source
+// are the image the delta was made against. Returns 0 if they are.
+typedef int (*delta_patch_check_source_fn)(void *context, const uint8_t *digest, uint32_t source_size);
+
+// Applies a delta as it arrives. The source must be memory mapped (e.g. the active flash slot).
+// COPY data is passed to the writer directly from the source and INSERT data directly from the input,
+// so RAM usage is this structure only, regardless of the image size.
+typedef struct delta_patch {
+    const uint8_t *source;
+    uint32_t source_size;    // size of the slot, then of the source image once the header is received
+    delta_patch_write_fn write;
+    delta_patch_check_source_fn check_source;
+    void *context;
+    int state;
+    uint8_t op;
+    uint8_t fields[DELTA_PATCH_HEADER_SIZE]; // header or op fields, while they are incomplete
+    uint32_t fields_length;
+    uint32_t remaining;      // bytes left in the current op
+    uint32_t source_offset;  // current source position of a COPY or ADD
+    uint32_t target_size;
+    uint32_t written;
+    uint8_t scratch[DELTA_PATCH_ADD_CHUNK];
+} delta_patch;
+
+// source_size is the size of the memory available at source, e.g. the slot size.
+// check_source can be NULL if the source is trusted to match.
+void delta_patch_init(delta_patch *patch, const uint8_t *source, uint32_t source_size, delta_patch_write_fn write,
+        delta_patch_check_source_fn check_source, void *context);
+
+// Returns true if the data starts with a delta header.
+bool delta_patch_is_delta(const uint8_t *data, size_t size);
+
+// Returns 0 on success, a DELTA_PATCH_ERROR_* code, or the error returned by the writer.
+// Once an error is returned, all further calls fail.
+int delta_patch_feed(delta_patch *patch, const uint8_t *data, size_t size);
+
+// Returns true once the whole target has been produced.
+bool delta_patch_done(const delta_patch *patch);
+
+// Size of the reconstructed image. Valid once the header is received.
+static inline uint32_t delta_patch_target_size(const delta_patch *patch) {
+    return patch->target_size;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DELTA_PATCH_H
@@ -0,0 +1,141 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "tx_api.h"
+#include "nx_api.h"
+#include "nxd_dns.h"
+
+// The defaults keep DNS_CACHE_IMAGE_SIZE within the default ITS_MAX_ASSET_SIZE of TF-M (512 bytes)
+#ifndef DNS_CACHE_ENTRIES
+#define DNS_CACHE_ENTRIES           6
+#endif
+
+#ifndef DNS_CACHE_MAX_HOST_LENGTH
+#define DNS_CACHE_MAX_HOST_LENGTH   64  // including the terminating null
+#endif
+
+// Answers are kept for at least the min and at most the max TTL, whatever the DNS server says
+#ifndef DNS_CACHE_MIN_TTL_S
+#define DNS_CACHE_MIN_TTL_S         30
+#endif
+#ifndef DNS_CACHE_MAX_TTL_S
+#define DNS_CACHE_MAX_TTL_S         86400
+#endif
+
+#define DNS_CACHE_ERROR_STORAGE     (-1)
+#define DNS_CACHE_ERROR_RESOLVE     (-2) // not cached and the lookup failed
+#define DNS_CACHE_ERROR_NAME        (-3) // the host name does not fit DNS_CACHE_MAX_HOST_LENGTH
+
+// magic(4) count(4), then per entry: host(DNS_CACHE_MAX_HOST_LENGTH) address(4) resolved(4) expires(4)
+#define DNS_CACHE_IMAGE_SIZE        (8 + DNS_CACHE_ENTRIES * (DNS_CACHE_MAX_HOST_LENGTH + 12))
+
+// Resolves the IPv4 address of the host, with the TTL of the answer. Returns 0 on success.
+typedef int (*dns_cache_resolve_fn)(void *context, const char *host, uint32_t *address, uint32_t *ttl_s);
+
+// Storage of the cache as a single item. A save must replace the item atomically, like psa_its_set() does.
+// All functions return 0 on success.
+typedef struct dns_cache_storage {
+    void *context;
+    // Returns DNS_CACHE_ERROR_STORAGE if the item does not exist.
+    int (*load)(void *context, uint8_t *data, uint32_t size, uint32_t *actual_size);
+    int (*save)(void *context, const uint8_t *data, uint32_t size);
+} dns_cache_storage;
+
+typedef struct dns_cache_entry {
+    char host[DNS_CACHE_MAX_HOST_LENGTH]; // empty if the entry is free
+    uint32_t address;           // IPv4, host byte order as NetX uses it
+    uint32_t resolved;          // time(NULL) of the lookup
+    uint32_t expires;           // resolved + TTL
+    uint32_t last_used;         // use counter value, for eviction
+    bool refresh_pending;
+} dns_cache_entry;
+
+typedef struct dns_cache_stats {
+    uint32_t hits;
+    uint32_t stale_hits;        // served expired, and refreshed in the background
+    uint32_t misses;
+    uint32_t failures;          // misses that could not be resolved
+    uint32_t refreshes;
+    uint32_t refresh_failures;  // the stale answer stays in use
+} dns_cache_stats;
+
+// Cache of host name lookups in front of the DNS client, persisted across reboots.
+// A fresh answer is served without a lookup. An expired answer is still served, for up to max_stale_s after
+// it expired, and is refreshed by the refresh thread in the meantime. So a reconnect does not wait for a lookup,
+// and can go ahead while the DNS server is not reachable. Only misses wait for the resolver.
+// The storage is written only when a host is added or its address changes, not when an answer is renewed,
+// so after a reboot an answer that was renewed since it was saved is served stale until its next refresh.
+// Answers that were resolved "in the future", i.e. before the time was synced, count as expired.
+typedef struct dns_cache {
+    dns_cache_entry entries[DNS_CACHE_ENTRIES];
+    uint32_t max_stale_s;
+    dns_cache_resolve_fn resolve;
+    void *resolve_context;
+    const dns_cache_storage *storage;
+    uint32_t use_counter;
+    dns_cache_stats stats;
+    TX_MUTEX mutex;             // held for table access and saves, never while resolving
+    TX_SEMAPHORE refresh_needed;
+    TX_THREAD refresh_thread;
+    uint8_t image[DNS_CACHE_IMAGE_SIZE];
+} dns_cache;
+
+// Loads the persisted entries. A storage that was never written gives an empty cache.
+int dns_cache_init(dns_cache *cache, const dns_cache_storage *storage, dns_cache_resolve_fn resolve,
+        void *resolve_context, uint32_t max_stale_s);
+
+// Starts the thread that refreshes the answers that were served stale.
+UINT dns_cache_start_refresh(dns_cache *cache, void *stack, ULONG stack_size, UINT priority);
+
+// Returns 0 and the address from the cache, or from the resolver on a miss.
+int dns_cache_lookup(dns_cache *cache, const char *host, uint32_t *address);
+
+// Resolves the entries that were served stale. Called by the refresh thread.
+void dns_cache_refresh(dns_cache *cache);
+
+void dns_cache_print(dns_cache *cache);
+
+// Storage backed by PSA Internal Trusted Storage, as one asset of DNS_CACHE_IMAGE_SIZE bytes.
+void dns_cache_its_storage_init(dns_cache_storage *storage);
+
+#ifdef DNS_CACHE_FILE_STORAGE
+// Storage backed by a file, as a stand-in for ITS on hosts with a file system.
+// The file is written to a temporary file and renamed, to keep writes atomic. Returns 0 on success.
+int dns_cache_file_storage_init(dns_cache_storage *storage, const char *path);
+void dns_cache_file_storage_close(dns_cache_storage *storage);
+#endif
+
+// Resolver that sends its own query to the servers of the NetX DNS client, because nx_dns_host_by_name_get()
+// does not return the TTL. One attempt per server.
+typedef struct dns_cache_nx_resolver {
+    NX_IP *ip;
+    NX_PACKET_POOL *pool;
+    NX_DNS *dns;
+    ULONG timeout_ticks;
+} dns_cache_nx_resolver;
+
+int dns_cache_nx_resolve(void *context, const char *host, uint32_t *address, uint32_t *ttl_s);
+
+#ifdef DNS_CACHE_WRAP_NETX
+// Routes the nx_dns_host_by_name_get() calls of the whole image, including the SDK, through the cache.
+// Needs the matching linker option: -Wl,--wrap=_nxe_dns_host_by_name_get, or -Wl,--wrap=_nx_dns_host_by_name_get
+// if NetX is built with NX_DISABLE_ERROR_CHECKING. Lookups that miss and can not be resolved by the cache
+// fall back to the NetX lookup.
+void dns_cache_nx_route_lookups(dns_cache *cache);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DNS_CACHE_H
@@ -0,0 +1,115 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef DTS_SAMPLER_H
+#define DTS_SAMPLER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "tx_api.h"
+
+// Number of readings in the rolling window
+#ifndef DTS_SAMPLER_WINDOW
+#define DTS_SAMPLER_WINDOW 32
+#endif
+
+#define DTS_SAMPLER_ERROR_HW    (-1)
+
+struct dts_sampler;
+
+// Temperature sensor hardware. Readings are delivered asynchronously, usually from the end of measurement
+// interrupt, by calling dts_sampler_on_reading().
+typedef struct dts_sampler_hw {
+    void *context;
+    // Prepares the sensor and its interrupt. Returns 0 on success.
+    int (*start)(void *context, struct dts_sampler *sampler);
+    // Starts a single measurement. Called by the rate timer. Returns 0 on success, or non-zero if the sensor
+    // is still busy with the previous measurement.
+    int (*trigger)(void *context);
+} dts_sampler_hw;
+
+// Statistics over the readings in the window, in milli degrees Celsius
+typedef struct dts_sampler_stats {
+    uint32_t count;             // readings in the window. The other values are 0 if there are none.
+    int32_t min;
+    int32_t max;
+    int32_t mean;
+    int32_t last;
+    uint32_t readings;          // since the start
+    uint32_t missed_triggers;   // the sensor was busy when the timer fired
+} dts_sampler_stats;
+
+// Samples the temperature sensor at a fixed rate from a ThreadX timer, and keeps the last DTS_SAMPLER_WINDOW
+// readings. The readings are added by the interrupt handler, and the statistics are read with a short
+// interrupt lock, so neither side ever blocks on the other.
+// With a deadband, the sampler also tracks the last value that was reported, and signals a change when
+// the mean of the window moved away from it by the deadband or more. See dts_sampler_wait_change().
+typedef struct dts_sampler {
+    const dts_sampler_hw *hw;
+    int32_t window[DTS_SAMPLER_WINDOW];
+    uint32_t head;              // free running write index
+    uint32_t count;
+    int64_t sum;                // of the readings in the window
+    uint32_t readings;
+    uint32_t missed_triggers;
+    int32_t deadband;           // 0 to disable change detection
+    int32_t reported;
+    bool has_reported;
+    bool change_signaled;       // cleared when a new value is reported
+    TX_SEMAPHORE changed;
+    TX_TIMER timer;
+} dts_sampler;
+
+// Starts the hardware and the timer. rate_hz must not exceed the tick rate. A deadband of 0 disables
+// change detection. Returns 0 on success.
+int dts_sampler_start(dts_sampler *sampler, const dts_sampler_hw *hw, uint32_t rate_hz, int32_t deadband);
+
+// Adds a reading in milli degrees Celsius. Safe to call from an interrupt.
+void dts_sampler_on_reading(dts_sampler *sampler, int32_t temperature);
+
+void dts_sampler_get_stats(dts_sampler *sampler, dts_sampler_stats *stats);
+
+// Waits up to the timeout for the mean to move by the deadband from the reported value.
+// Returns true if it did. Returns false right away if change detection is disabled.
+bool dts_sampler_wait_change(dts_sampler *sampler, ULONG wait_ticks);
+
+// Returns true if the value differs from the last reported one by the deadband or more, or if there is
+// no reported value yet
+bool dts_sampler_exceeds_deadband(dts_sampler *sampler, int32_t temperature);
+
+// Records the value that was reported, as the reference for change detection
+void dts_sampler_set_reported(dts_sampler *sampler, int32_t temperature);
+
+void dts_sampler_print(dts_sampler *sampler);
+
+// The DTS peripheral of the STM32H5, set up by MX_DTS_Init(). Readings are taken in the DTS interrupt.
+void dts_sampler_stm32_hw_init(dts_sampler_hw *hw);
+
+#ifdef DTS_SAMPLER_FAKE
+// Sensor for host tests. Each trigger produces the next value of the waveform right away, as if the
+// measurement completed instantly. A test can also call dts_sampler_fake_step() to produce readings faster
+// than any timer would.
+typedef struct dts_sampler_fake {
+    int32_t (*waveform)(void *context, uint32_t index); // milli degrees Celsius of the index-th reading
+    void *waveform_context;
+    uint32_t index;
+    bool busy;                  // makes triggers fail, to test missed triggers
+    dts_sampler *sampler;
+} dts_sampler_fake;
+
+void dts_sampler_fake_hw_init(dts_sampler_hw *hw, dts_sampler_fake *fake);
+
+// Produces the given number of readings
+void dts_sampler_fake_step(dts_sampler_fake *fake, uint32_t count);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DTS_SAMPLER_H
@@ -8,4 +8,123 @@
 
 #define SAMPLE_SNTP_SERVER_NAME "time.google.com"    /* SNTP Server.  */
 
+// Size of the static buffer that telemetry messages are formatted into.
+// Messages that do not fit are dropped. A single sample needs about 250 bytes
+// and each additional sample in a batch about 120 bytes.
+#define APP_TELEMETRY_BUFFER_SIZE 4096
+
+#define APP_TELEMETRY_SAMPLE_INTERVAL_MS 5000
+
+// Sensors are sampled on a dedicated thread and queued for the publisher,
+// so that slow sends or reconnects do not affect the sampling cadence.
+#define APP_SAMPLER_THREAD_STACK_SIZE   2048
+#define APP_SAMPLER_THREAD_PRIORITY     10
+
+// Set APP_DTS_SAMPLER to 1 to measure the temperature with the DTS in the background at this rate, in its
+// interrupt, and report the mean of the last DTS_SAMPLER_WINDOW readings with each sample. This installs
+// DTS_IRQHandler. 0 reads the sensors with std_component_read_sensor_values().
+#define APP_DTS_SAMPLER                 0
+#define APP_DTS_SAMPLE_RATE_HZ          10
+
+// Set to report a sample only when the temperature moved by at least this many milli degrees Celsius since
+// the last report, or the button was pushed. Such a change is reported right away, without waiting for the
+// sample interval. A sample is still reported every APP_TELEMETRY_HEARTBEAT_MS. 0 reports every sample.
+#define APP_TEMPERATURE_DEADBAND_MC     0
+#define APP_TELEMETRY_HEARTBEAT_MS      60000
+
+// Set to report, instead of each sample, the min, max, mean, standard deviation and count of each value over
+// windows of this many seconds. A window is not reported if all values stayed within the deadband around the
+// mean that was last reported, unless it is the APP_AGGREGATION_HEARTBEAT_WINDOWS-th window in a row.
+// The "aggregate" cloud command changes these at runtime. The template needs attributes like temperature_mean.
+// 0 reports every sample.
+#define APP_AGGREGATION_WINDOW_S                0
+#define APP_AGGREGATION_HEARTBEAT_WINDOWS       10
+#define APP_AGGREGATION_TEMPERATURE_DEADBAND    0.5
+#define APP_AGGREGATION_BUTTON_DEADBAND         0.5
+
+// Samples taken while disconnected are stored in a journal in PSA ITS and replayed after reconnecting.
+// Block size and count must fit the ITS_MAX_ASSET_SIZE and ITS_NUM_ASSETS configuration of the secure image.
+// With the TF-M defaults of 10 assets of 512 bytes, the journal gets 2 assets. The metadata (1), the cert store
+// (CERT_STORE_SLOT_COUNT + 1 = 3), the DNS cache (1) and the persistent keys that generate_csr creates for the
+// cert store slots (CERT_STORE_SLOT_COUNT = 2), which the crypto partition keeps in ITS as well, take 7 more.
+// That is 9 in total, and one is left for the device identity key, in case the secure image keeps it in ITS.
+// Each block holds up to 19 samples with the default block size, and the journal keeps count - 1 blocks of them.
+// Raise the count along with ITS_NUM_ASSETS.
+#define APP_JOURNAL_BLOCK_SIZE          512
+#define APP_JOURNAL_BLOCK_COUNT         2
+#define APP_JOURNAL_SYNC_SAMPLES        6   // store the partially filled journal block after this many samples
+#define APP_JOURNAL_REPLAY_BATCH        32  // max replayed samples per APP_TELEMETRY_PUBLISH_POLL_MS
+
+// Reconnects back off exponentially from the min to the max delay, with jitter.
+// Failures to resolve APP_DISCOVERY_HOST_NAME are local network problems and back off to a shorter max delay.
+#define APP_RECONNECT_MIN_DELAY_MS          2000
+#define APP_RECONNECT_MAX_DELAY_MS          300000
+#define APP_RECONNECT_NETWORK_MAX_DELAY_MS  30000
+#define APP_RECONNECT_STABLE_MS             60000 // a connection that lasted this long resets the backoff
+#define APP_DISCOVERY_HOST_NAME             "discovery.iotconnect.io"
+#define APP_DNS_TIMEOUT_MS                  5000
+
+// Host names are resolved through a cache that keeps the answers for their DNS TTL and is persisted to PSA ITS.
+// Expired answers are still used, for up to APP_DNS_CACHE_MAX_STALE_S, while they are refreshed in the background,
+// so a reconnect does not wait for a lookup, and a DNS outage alone does not stop it.
+// The lookups of the SDK and of the OTA download are routed through the cache as well: the project defines
+// DNS_CACHE_WRAP_NETX and links with -Wl,--wrap=_nxe_dns_host_by_name_get. See dns_cache.h.
+#define APP_DNS_CACHE_MAX_STALE_S           (7 * 24 * 3600)
+#define APP_DNS_REFRESH_THREAD_STACK_SIZE   2048
+#define APP_DNS_REFRESH_THREAD_PRIORITY     12
+
+// The discovery host is first resolved by a short lived thread, while the time is synced and the app initializes
+#define APP_DISCOVERY_LOOKUP_STACK_SIZE     2048
+
+// Set to 1 to measure the calls of the X.509 auth driver and its ECDSA operation.
+// The results are printed after each connect and with the "auth-profile" cloud command.
+// The host build sets it for the app and the auth driver test.
+#ifndef APP_AUTH_PROFILER
+#define APP_AUTH_PROFILER                   0
+#endif
+
+// Set to 1 for the "hash-bench" cloud command, which times psa_hash_update() per block size on the device,
+// the cost of the SHA-256 that the OTA driver keeps over each write
+#define APP_HASH_BENCH                      0
+
+// Cloud commands are run by a worker thread and acknowledged from the publisher thread once they complete.
+// The worker runs below the publisher priority, so that a long command does not hold up the SDK polling.
+#define APP_COMMAND_THREAD_STACK_SIZE   2048
+#define APP_COMMAND_THREAD_PRIORITY     12
+
+// Set to 1 to add a data point with the heap, packet pool and thread stack use to a telemetry message
+// once every APP_HEALTH_INTERVAL_MS. The "health" cloud command prints the same data to the console either way.
+// The heap is reported only if malloc() is routed to a ThreadX byte pool (IOTC_ROUTE_MALLOC_TO_TX_BYTE_POOL).
+// The IoTConnect device template needs an attribute for each of the fields. See system_health_write().
+#define APP_HEALTH_TELEMETRY            0
+#define APP_HEALTH_INTERVAL_MS          300000
+
+// How long the publisher polls for cloud messages between draining the sample queue
+#define APP_TELEMETRY_PUBLISH_POLL_MS   1000
+
+// Batching of multiple samples into a single message. The batch is sent when
+// any of the conditions is met. Batch size of 1 sends a message per sample.
+#define APP_TELEMETRY_BATCH_SIZE        1
+#define APP_TELEMETRY_BATCH_MAX_AGE_MS  60000 // 0 to disable
+#define APP_TELEMETRY_BATCH_MAX_BYTES   APP_TELEMETRY_BUFFER_SIZE
+
+// TELEMETRY_FORMAT_CBOR sends the telemetry as base64 encoded CBOR with integer keys (see telemetry_writer.h),
+// at a half to a quarter of the size of the JSON, for a backend that decodes it. IoTConnect itself needs JSON.
+// Set APP_TELEMETRY_CBOR_BACKEND to 1 when the telemetry goes to such a backend, to add the "telemetry-format"
+// cloud command that switches the format at runtime. Without it, a device could be switched to a format that
+// IoTConnect rejects.
+#define APP_TELEMETRY_FORMAT            TELEMETRY_FORMAT_JSON
+#define APP_TELEMETRY_CBOR_BACKEND      0
+
+// Strings of an OTA or command event (download URL, its host and path, version, command) are kept in this
+// arena while the event is handled, instead of in the heap. A firmware URL with a SAS token is up to about 500 bytes.
+#define APP_EVENT_ARENA_SIZE            2048
+
+// An interrupted firmware download is retried. A retry asks for the rest of the file with an HTTP Range request
+// and the driver continues the update where it stopped, if no reboot came in between (see ota_download.h).
+#define APP_OTA_DOWNLOAD_ATTEMPTS       3
+#define APP_OTA_RETRY_DELAY_MS          5000
+#define APP_OTA_TIMEOUT_MS              10000 // connecting, and waiting for each part of the response
+#define APP_OTA_BUFFER_SIZE             1024 // passed to the driver at a time
+
 #endif // APP_CONFIG_H
@@ -0,0 +1,79 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef LZSS_STREAM_H
+#define LZSS_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Compressed image container, generated by scripts/compress-image.py.
+ *   header: magic "HSZ1"(4) window_bits(1) lookahead_bits(1) reserved(2) size(4, little endian)
+ *   data:   heatshrink compatible LZSS bit stream, so it can also be produced with
+ *           "heatshrink -e -w <window_bits> -l <lookahead_bits>"
+ */
+#define LZSS_STREAM_MAGIC       0x315A5348 // "HSZ1"
+#define LZSS_STREAM_HEADER_SIZE 12
+
+// The window is the only large buffer. Streams with larger windows are rejected.
+#ifndef LZSS_STREAM_MAX_WINDOW_BITS
+#define LZSS_STREAM_MAX_WINDOW_BITS 11
+#endif
+
+#ifndef LZSS_STREAM_OUTPUT_SIZE
+#define LZSS_STREAM_OUTPUT_SIZE 128
+#endif
+
+#define LZSS_STREAM_ERROR_FORMAT (-1)
+
+// Receives decompressed bytes, in order. Returns 0 on success.
+typedef int (*lzss_stream_write_fn)(void *context, const uint8_t *data, size_t size);
+
+// Streaming decompressor. Input can be fed in chunks of any size.
+// RAM usage is this structure, about 2^LZSS_STREAM_MAX_WINDOW_BITS + LZSS_STREAM_OUTPUT_SIZE bytes.
+typedef struct lzss_stream {
+    lzss_stream_write_fn write;
+    void *context;
+    int state;
+    uint8_t header[LZSS_STREAM_HEADER_SIZE];
+    uint32_t header_length;
+    uint8_t window_bits;
+    uint8_t lookahead_bits;
+    uint32_t size;           // decompressed size
+    uint32_t produced;
+    uint32_t bits;           // bits of the field being read
+    uint8_t bit_count;
+    uint16_t index;          // back reference distance
+    uint8_t current;         // input byte being consumed
+    uint8_t current_bits;    // bits left in current
+    uint32_t position;       // free running window position
+    uint8_t window[1 << LZSS_STREAM_MAX_WINDOW_BITS];
+    uint8_t output[LZSS_STREAM_OUTPUT_SIZE];
+    uint32_t output_length;
+} lzss_stream;
+
+void lzss_stream_init(lzss_stream *stream, lzss_stream_write_fn write, void *context);
+
+// Returns true if the data starts with a compressed image header.
+bool lzss_stream_is_compressed(const uint8_t *data, size_t size);
+
+// Returns 0 on success, LZSS_STREAM_ERROR_FORMAT or the error returned by the writer.
+// Decompressed data is passed to the writer as the output buffer fills. All of the data decoded
+// from the input has been passed by the time the call returns.
+int lzss_stream_feed(lzss_stream *stream, const uint8_t *data, size_t size);
+
+// Returns true once the whole image has been decompressed.
+bool lzss_stream_done(const lzss_stream *stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LZSS_STREAM_H
@@ -0,0 +1,76 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef OTA_DOWNLOAD_H
+#define OTA_DOWNLOAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "nx_api.h"
+#include "nx_azure_iot_adu_agent.h"
+#include "scratch_arena.h"
+
+#define OTA_DOWNLOAD_ERROR_TRANSPORT    (-1) // every attempt failed, or the server did not send what was asked for
+#define OTA_DOWNLOAD_ERROR_DRIVER       (-2) // the firmware driver rejected the image
+#define OTA_DOWNLOAD_ERROR_SIZE         (-3) // the server did not report the size of the file
+
+// Where the body of a response starts in the file, and the size of the whole file
+typedef struct ota_download_response {
+    uint32_t offset;    // 0 for a 200 response, the first byte of the Content-Range for a 206 response
+    uint32_t file_size; // the Content-Length of a 200 response, the complete length of the Content-Range of a 206
+} ota_download_response;
+
+// An HTTP GET of the file. All functions return 0 on success.
+typedef struct ota_download_transport {
+    void *context;
+    // Connects and requests the file from the offset on, with "Range: bytes=<offset>-" if the offset is not 0,
+    // and reads the response headers. A response other than 200 or 206 is an error.
+    int (*open)(void *context, uint32_t offset, ota_download_response *response);
+    // Returns the number of bytes of the body that were read into the buffer, 0 at the end of the body,
+    // or a negative value if the connection failed.
+    int (*read)(void *context, uint8_t *buffer, uint32_t size);
+    // Disconnects. Called after each open, also one that failed.
+    void (*close)(void *context);
+} ota_download_transport;
+
+// The firmware driver of the Azure IoT ADU agent, like nx_azure_iot_adu_agent_ns_driver()
+typedef void (*ota_download_driver)(NX_AZURE_IOT_ADU_AGENT_DRIVER *driver_req_ptr);
+
+typedef struct ota_download_stats {
+    uint32_t attempts;
+    uint32_t resumes;           // attempts that continued where the previous one stopped
+    uint32_t restarts;          // attempts after the first that had to start from the beginning of the file
+    uint64_t bytes_received;    // over all attempts
+} ota_download_stats;
+
+// Downloads the file into the firmware driver and installs it, in up to the given number of attempts.
+// When an attempt fails, the next one asks the server for the rest of the file only, with a Range request,
+// and the driver continues the update where it stopped. If the server sends the whole file instead, or the
+// driver cannot continue, the download starts over. The driver must support the resume offset of the
+// preprocess request, like NetXDuo/App/nx_azure_iot_adu_agent_psa_driver.c. If all attempts fail, the update
+// is cancelled in the driver. sha256_base64 is the digest of the file for the driver, or NULL.
+// The buffer holds the data that is passed to the driver at a time. Returns 0 on success.
+int ota_download(const ota_download_transport *transport, ota_download_driver driver, const char *sha256_base64,
+        uint8_t *buffer, uint32_t buffer_size, unsigned int attempts, uint32_t retry_delay_ms,
+        ota_download_stats *stats);
+
+// Requests the driver to boot the installed image
+int ota_download_apply(ota_download_driver driver);
+
+// Splits an http(s) URL into the host name and the resource path, allocated in the arena.
+// Returns 0 on success, or -1 if the URL has no path or the strings do not fit into the arena.
+int ota_download_split_url(scratch_arena *arena, const char *url, char **host_name, char **resource);
+
+// Parses the "bytes <first>-<last>/<complete length>" value of a Content-Range header. Returns 0 on success.
+int ota_download_parse_content_range(const char *value, uint32_t length, uint32_t *first, uint32_t *file_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OTA_DOWNLOAD_H
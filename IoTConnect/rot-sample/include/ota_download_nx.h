@@ -0,0 +1,70 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef OTA_DOWNLOAD_NX_H
+#define OTA_DOWNLOAD_NX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "nx_api.h"
+#include "nxd_dns.h"
+#include "nx_web_http_client.h"
+#include "ota_download.h"
+
+#ifndef OTA_DOWNLOAD_NX_TLS_METADATA_SIZE
+#define OTA_DOWNLOAD_NX_TLS_METADATA_SIZE       (10 * 1024) // at least nx_secure_tls_metadata_size_calculate()
+#endif
+#ifndef OTA_DOWNLOAD_NX_TLS_PACKET_BUFFER_SIZE
+#define OTA_DOWNLOAD_NX_TLS_PACKET_BUFFER_SIZE  (16 * 1024 + 512) // a whole TLS record, as blob storage sends them
+#endif
+#ifndef OTA_DOWNLOAD_NX_REMOTE_CERT_SIZE
+#define OTA_DOWNLOAD_NX_REMOTE_CERT_SIZE        2048
+#endif
+#define OTA_DOWNLOAD_NX_REMOTE_CERT_COUNT       2
+
+// The transport of ota_download() on the NetX Duo Web HTTPS client. Each open connects to the host,
+// sends the GET with the Range header and reads the response headers. The TLS buffers are part of the
+// transport, about 30 KB with the defaults, so that a download does not take them from the byte pool
+// on each attempt. Keep the transport in static memory.
+typedef struct ota_download_nx_transport {
+    NX_WEB_HTTP_CLIENT client;  // first, so that the callbacks of the client find the transport
+    NX_IP *ip;
+    NX_PACKET_POOL *pool;
+    NX_DNS *dns;
+    char *host;
+    char *resource;
+    const unsigned char *tls_cert;
+    size_t tls_cert_len;
+    ULONG timeout_ticks;
+    // the connection
+    bool created;
+    NX_PACKET *packet;          // received and not passed on completely
+    ULONG packet_offset;
+    bool body_done;
+    uint32_t content_length;
+    bool has_content_range;
+    uint32_t range_first;
+    uint32_t range_file_size;
+    NX_SECURE_X509_CERT trusted_cert;
+    NX_SECURE_X509_CERT remote_certs[OTA_DOWNLOAD_NX_REMOTE_CERT_COUNT];
+    NX_SECURE_X509_DNS_NAME sni_name;
+    ULONG tls_metadata[OTA_DOWNLOAD_NX_TLS_METADATA_SIZE / sizeof(ULONG)];
+    UCHAR tls_packet_buffer[OTA_DOWNLOAD_NX_TLS_PACKET_BUFFER_SIZE];
+    UCHAR remote_cert_buffers[OTA_DOWNLOAD_NX_REMOTE_CERT_COUNT][OTA_DOWNLOAD_NX_REMOTE_CERT_SIZE];
+} ota_download_nx_transport;
+
+// Sets up the transport for the file at https://<host><resource>, with the trusted root certificate
+void ota_download_nx_transport_init(ota_download_transport *transport, ota_download_nx_transport *nx, NX_IP *ip,
+        NX_PACKET_POOL *pool, NX_DNS *dns, char *host, char *resource, const unsigned char *tls_cert,
+        size_t tls_cert_len, ULONG timeout_ticks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OTA_DOWNLOAD_NX_H
@@ -0,0 +1,52 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "telemetry_writer.h"
+
+// Must be a power of two
+#ifndef SAMPLE_RING_CAPACITY
+#define SAMPLE_RING_CAPACITY 32
+#endif
+
+#if (SAMPLE_RING_CAPACITY & (SAMPLE_RING_CAPACITY - 1)) != 0
+#error "SAMPLE_RING_CAPACITY must be a power of two"
+#endif
+
+// Lock-free single producer / single consumer ring of telemetry samples.
+// The producer owns head, the consumer owns tail. No mutex is taken and nothing is allocated.
+// When the ring is full, the newest sample is dropped and counted, so that the consumer
+// never races with the producer over a slot it is reading.
+typedef struct sample_ring {
+    telemetry_sample slots[SAMPLE_RING_CAPACITY];
+    uint32_t head;    // free running write index. Written only by the producer.
+    uint32_t tail;    // free running read index. Written only by the consumer.
+    uint32_t dropped; // written only by the producer
+} sample_ring;
+
+void sample_ring_init(sample_ring *ring);
+
+// Producer side. Returns false if the ring was full and the sample was dropped.
+bool sample_ring_push(sample_ring *ring, const telemetry_sample *sample);
+
+// Consumer side. Returns false if the ring is empty.
+bool sample_ring_pop(sample_ring *ring, telemetry_sample *sample);
+
+// Safe to call from either side
+uint32_t sample_ring_count(const sample_ring *ring);
+uint32_t sample_ring_dropped(const sample_ring *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SAMPLE_RING_H
@@ -0,0 +1,46 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef SCRATCH_ARENA_H
+#define SCRATCH_ARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SCRATCH_ARENA_ALIGNMENT 8
+
+// Bump allocator over a static buffer, for the short lived strings of a single cloud event.
+// Allocations are not freed one by one. The whole arena is reset once the event is handled,
+// so nothing is left behind in the heap or the byte pool between events, and there is nothing to fragment.
+// Not thread safe. Use one arena per thread.
+typedef struct scratch_arena {
+    uint8_t *buffer;
+    size_t size;
+    size_t used;
+    size_t peak;       // highest use since init
+    uint32_t failures; // allocations that did not fit
+} scratch_arena;
+
+void scratch_arena_init(scratch_arena *arena, uint8_t *buffer, size_t size);
+
+// Returns NULL if the allocation does not fit.
+void *scratch_arena_alloc(scratch_arena *arena, size_t size);
+
+// Copies length characters of the string and terminates the copy. Returns NULL if it does not fit.
+char *scratch_arena_strndup(scratch_arena *arena, const char *str, size_t length);
+
+// Invalidates all allocations
+static inline void scratch_arena_reset(scratch_arena *arena) {
+    arena->used = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCRATCH_ARENA_H
@@ -12,6 +12,7 @@ extern   "C" {
 #endif
 
 #include "iotc_auth_driver.h"
+#include "auth_profiler.h"
 
 struct stm32_psa_driver_parameters {
 	// TODO: No parameters for now
@@ -26,6 +27,11 @@ int stm32_psa_create_auth_driver( //
 		);
 int stm32_psa_release_auth_driver(IotcAuthInterfaceContext* context);
 
+#if APP_AUTH_PROFILER
+// Times repeated CN extraction from the cached certificate view against parsing the certificate on each call
+int stm32_psa_benchmark_extract_cn(IotcAuthInterfaceContext context, unsigned int iterations);
+#endif
+
 
 #ifdef _cplusplus
 }
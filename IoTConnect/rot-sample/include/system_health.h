@@ -0,0 +1,88 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef SYSTEM_HEALTH_H
+#define SYSTEM_HEALTH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "tx_api.h"
+#include "nx_api.h"
+#include "telemetry_writer.h"
+
+#ifndef SYSTEM_HEALTH_MAX_THREADS
+#define SYSTEM_HEALTH_MAX_THREADS       12
+#endif
+
+// The byte pool is walked with interrupts disabled for at most this many blocks at a time
+#ifndef SYSTEM_HEALTH_WALK_CHUNK
+#define SYSTEM_HEALTH_WALK_CHUNK        16
+#endif
+
+// The walk restarts when another thread uses the pool in between chunks. It is given up after this many attempts.
+#ifndef SYSTEM_HEALTH_WALK_ATTEMPTS
+#define SYSTEM_HEALTH_WALK_ATTEMPTS     4
+#endif
+
+typedef struct system_health_thread {
+    const char *name;
+    ULONG stack_size;
+    ULONG stack_used;       // high-water mark, from the part of the stack that still has the ThreadX fill pattern
+} system_health_thread;
+
+typedef struct system_health {
+    time_t timestamp;
+
+    bool has_heap;
+    ULONG heap_size;
+    ULONG heap_free;
+    ULONG heap_blocks;      // allocated and free blocks, as reported by tx_byte_pool_info_get()
+    bool has_heap_walk;     // false if the pool was too busy to walk
+    ULONG heap_fragments;   // free fragments that an allocation can not span
+    ULONG heap_largest_free;
+
+    bool has_packet_pool;
+    ULONG packets_total;
+    ULONG packets_free;
+    ULONG packets_empty_requests; // allocations that found the pool empty since it was created
+
+    unsigned int thread_count;
+    system_health_thread threads[SYSTEM_HEALTH_MAX_THREADS];
+} system_health;
+
+// Pools to report. Either can be NULL.
+typedef struct system_health_sampler {
+    TX_BYTE_POOL *heap;
+    NX_PACKET_POOL *packet_pool;
+    TX_MUTEX mutex;             // samples are taken by the publisher and by the health command
+} system_health_sampler;
+
+// Returns 0 on success, or -1 if the mutex could not be created
+int system_health_init(system_health_sampler *sampler, TX_BYTE_POOL *heap, NX_PACKET_POOL *packet_pool);
+
+// Returns the byte pool that malloc() allocates from, or NULL if malloc() is not routed to a byte pool.
+// Call from a thread.
+TX_BYTE_POOL *system_health_find_heap(void);
+
+// Takes a snapshot of the pools and of the stacks of all threads. Call from a thread.
+// Samples of different threads are taken one after the other, so that their heap walks do not restart each other.
+// Interrupts are never disabled for longer than it takes to examine SYSTEM_HEALTH_WALK_CHUNK blocks of the heap.
+void system_health_sample(system_health_sampler *sampler, system_health *health);
+
+// Writes the snapshot as a whole data point. The stack of each thread is reported as "stack_<thread name>",
+// with the name in lowercase and anything other than letters and digits replaced by "_".
+void system_health_write(telemetry_writer *w, const system_health *health);
+
+void system_health_print(const system_health *health);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYSTEM_HEALTH_H
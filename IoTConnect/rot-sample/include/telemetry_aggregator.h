@@ -0,0 +1,116 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef TELEMETRY_AGGREGATOR_H
+#define TELEMETRY_AGGREGATOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "tx_api.h"
+#include "telemetry_writer.h"
+
+#ifndef TELEMETRY_AGGREGATOR_MAX_FIELDS
+#define TELEMETRY_AGGREGATOR_MAX_FIELDS 4
+#endif
+
+#define TELEMETRY_AGGREGATOR_ERROR_FIELD    (-1) // no such field, or no room for another one
+
+// Statistics of one field over a closed window
+typedef struct telemetry_field_aggregate {
+    const char *name;
+    uint32_t count;
+    double min;
+    double max;
+    double mean;
+    double stddev;              // population standard deviation
+} telemetry_field_aggregate;
+
+// A closed window, to be reported
+typedef struct telemetry_aggregate {
+    time_t start;
+    uint32_t window_s;
+    size_t field_count;
+    telemetry_field_aggregate fields[TELEMETRY_AGGREGATOR_MAX_FIELDS];
+} telemetry_aggregate;
+
+typedef struct telemetry_aggregator_field {
+    const char *name;           // also the prefix of the reported names, like "temperature_mean"
+    double deadband;
+    // running statistics of the open window, with Welford's method
+    uint32_t count;
+    double min;
+    double max;
+    double mean;
+    double m2;                  // sum of the squared differences from the mean
+    // reference for the deadband
+    double reported;
+    bool has_reported;
+} telemetry_aggregator_field;
+
+typedef struct telemetry_aggregator_stats {
+    uint32_t samples;
+    uint32_t windows;
+    uint32_t reported;          // windows that were reported
+} telemetry_aggregator_stats;
+
+// Aggregates the samples of each field over tumbling windows of window_s seconds, aligned to the clock,
+// and reports each window as a single data point with the min, max, mean, standard deviation and count of
+// every field, when the window closes.
+// A window is not reported if all values of all fields stayed within the deadband of the field around the
+// mean that was last reported, unless max_silent_windows windows in a row were suppressed (0 for no limit).
+// A deadband of 0 reports every window.
+// All memory is in the structure. The configuration can be changed from another thread, and takes effect
+// with the next window.
+typedef struct telemetry_aggregator {
+    uint32_t window_s;          // 0 disables the aggregation
+    uint32_t next_window_s;     // set by telemetry_aggregator_set_window()
+    uint32_t max_silent_windows;
+    size_t field_count;
+    telemetry_aggregator_field fields[TELEMETRY_AGGREGATOR_MAX_FIELDS];
+    time_t window_start;
+    bool window_open;
+    uint32_t silent_windows;
+    telemetry_aggregator_stats stats;
+    TX_MUTEX mutex;
+} telemetry_aggregator;
+
+int telemetry_aggregator_init(telemetry_aggregator *aggregator, uint32_t window_s, uint32_t max_silent_windows);
+
+// Returns the index of the field, or TELEMETRY_AGGREGATOR_ERROR_FIELD. The name must stay valid.
+// Add all fields before the first sample.
+int telemetry_aggregator_add_field(telemetry_aggregator *aggregator, const char *name, double deadband);
+
+// Changes the window length from the next window on. 0 disables the aggregation once the open window closed.
+void telemetry_aggregator_set_window(telemetry_aggregator *aggregator, uint32_t window_s);
+
+// Returns TELEMETRY_AGGREGATOR_ERROR_FIELD if there is no field with the name
+int telemetry_aggregator_set_deadband(telemetry_aggregator *aggregator, const char *name, double deadband);
+
+// Adds a sample with one value per field, in the order of telemetry_aggregator_add_field().
+// If the sample is past the open window, that window is closed first, and report is set if it is to be
+// reported, in the aggregate. Returns false if the aggregation is disabled and the sample was not taken.
+// It should be reported as it is then.
+bool telemetry_aggregator_add(telemetry_aggregator *aggregator, time_t timestamp, const double *values,
+        telemetry_aggregate *aggregate, bool *report);
+
+// Closes the open window once the time is past it, even if no further sample came.
+// Returns true if it is to be reported, in the aggregate.
+bool telemetry_aggregator_poll(telemetry_aggregator *aggregator, time_t now, telemetry_aggregate *aggregate);
+
+// Writes the fields of the aggregate into the open data point
+void telemetry_aggregator_write_fields(telemetry_writer *w, const telemetry_aggregate *aggregate);
+
+void telemetry_aggregator_print(telemetry_aggregator *aggregator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_AGGREGATOR_H
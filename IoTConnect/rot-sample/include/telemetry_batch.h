@@ -0,0 +1,74 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef TELEMETRY_BATCH_H
+#define TELEMETRY_BATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "telemetry_writer.h"
+
+typedef struct telemetry_batch_policy {
+    size_t max_samples;   // flush once this many samples are collected
+    uint32_t max_age_ms;  // flush once the oldest sample is this old. 0 to disable.
+    size_t max_bytes;     // never let the message grow beyond this size. 0 to use the whole buffer.
+} telemetry_batch_policy;
+
+// Collects multiple samples into a single multi-datapoint IoTConnect message.
+// Samples are serialized as they are added, so the byte budget is exact and no sample array is kept.
+typedef struct telemetry_batch {
+    telemetry_batch_policy policy;
+    const char *version;
+    char *buffer;
+    size_t size;
+    telemetry_format format;
+    telemetry_writer writer;
+    size_t count;
+    uint32_t first_sample_ms;
+} telemetry_batch;
+
+void telemetry_batch_init(telemetry_batch *batch, const telemetry_batch_policy *policy, const char *version, char *buffer,
+        size_t size);
+
+// Returns false if the sample did not fit into the byte budget of a non-empty batch.
+// The batch should be flushed and the sample added again in that case.
+bool telemetry_batch_add(telemetry_batch *batch, const telemetry_sample *sample, uint32_t now_ms);
+
+// Writes one whole data point that is not a sample, like the device health, into a non-empty batch.
+// It does not count towards max_samples. Returns false, with the batch unchanged, if it does not fit.
+typedef void (*telemetry_batch_write_fn)(telemetry_writer *w, const void *context);
+bool telemetry_batch_add_datapoint(telemetry_batch *batch, telemetry_batch_write_fn write, const void *context);
+
+// Writes one whole data point that takes the place of samples, like an aggregate of them.
+// It counts as a sample, and returns false in the same cases as telemetry_batch_add().
+bool telemetry_batch_add_record(telemetry_batch *batch, time_t timestamp, telemetry_batch_write_fn write,
+        const void *context, uint32_t now_ms);
+
+// Returns true if any of the flush conditions of the policy are met.
+bool telemetry_batch_is_due(const telemetry_batch *batch, uint32_t now_ms);
+
+static inline size_t telemetry_batch_count(const telemetry_batch *batch) {
+    return batch->count;
+}
+
+// Closes the message and returns it, or NULL if the batch is empty.
+// The returned string is valid until telemetry_batch_reset() is called.
+const char *telemetry_batch_finish(telemetry_batch *batch);
+
+void telemetry_batch_reset(telemetry_batch *batch);
+
+// Selects the format of the messages, JSON by default. Takes effect with the next message if the batch
+// is not empty.
+void telemetry_batch_set_format(telemetry_batch *batch, telemetry_format format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_BATCH_H
@@ -0,0 +1,84 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef TELEMETRY_JOURNAL_H
+#define TELEMETRY_JOURNAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "telemetry_writer.h"
+
+// Block storage used by the journal. Blocks are always written as a whole.
+// All functions return 0 on success.
+typedef struct telemetry_journal_storage {
+    void *context;
+    uint32_t block_size;
+    uint32_t block_count;
+    // Reading a block that was never written or was erased may either fail or return data without a valid header.
+    int (*read)(void *context, uint32_t block, uint8_t *data, uint32_t size);
+    int (*write)(void *context, uint32_t block, const uint8_t *data, uint32_t size);
+    int (*erase)(void *context, uint32_t block);
+} telemetry_journal_storage;
+
+// Append-only store-and-forward journal of telemetry samples.
+// Samples are CRC framed records in a circular log of storage blocks. The block being appended to is kept in RAM
+// until it is full or telemetry_journal_sync() is called. When the log is full, the oldest block is dropped.
+// RAM usage is bounded to the two block buffers provided by the caller.
+// Delivery is at-least-once: samples read out of a block that was not yet fully consumed may be replayed after a reboot.
+typedef struct telemetry_journal {
+    const telemetry_journal_storage *storage;
+    uint8_t *write_buffer;     // the tail block
+    uint8_t *read_buffer;      // the head block, when it is not the tail block
+    uint32_t head;             // oldest persisted full block
+    uint32_t head_offset;      // read position in read_buffer. 0 if the head block is not loaded.
+    uint32_t tail;             // block that write_buffer will be stored to
+    uint32_t tail_offset;      // write position in write_buffer
+    uint32_t full_blocks;      // number of persisted full blocks from head up to tail
+    uint32_t next_sequence;
+    bool tail_stored;          // a partial tail block was stored and needs to be erased once consumed
+    uint32_t pending;          // number of unread samples
+    uint32_t dropped;          // samples lost because the journal was full or storage failed
+} telemetry_journal;
+
+// Storage block size should be the same as the size of each of the buffers.
+// Recovers any samples left in the storage.
+int telemetry_journal_init(telemetry_journal *journal, const telemetry_journal_storage *storage, uint8_t *write_buffer,
+        uint8_t *read_buffer);
+
+int telemetry_journal_append(telemetry_journal *journal, const telemetry_sample *sample);
+
+// Stores the partially filled tail block, so that its samples survive a reboot.
+int telemetry_journal_sync(telemetry_journal *journal);
+
+// Reads the oldest sample and removes it from the journal. Returns false if the journal is empty.
+bool telemetry_journal_read(telemetry_journal *journal, telemetry_sample *sample);
+
+static inline uint32_t telemetry_journal_pending(const telemetry_journal *journal) {
+    return journal->pending;
+}
+
+static inline uint32_t telemetry_journal_dropped(const telemetry_journal *journal) {
+    return journal->dropped;
+}
+
+// Storage backed by PSA Internal Trusted Storage (internal flash). One ITS asset per block,
+// so the block size and count need to fit the ITS_MAX_ASSET_SIZE and ITS_NUM_ASSETS configuration of the secure image.
+void telemetry_journal_its_storage_init(telemetry_journal_storage *storage, uint32_t block_size, uint32_t block_count);
+
+#ifdef TELEMETRY_JOURNAL_FILE_STORAGE
+// Storage backed by a regular file, for hosts with a file system. Returns 0 on success.
+int telemetry_journal_file_storage_init(telemetry_journal_storage *storage, const char *path, uint32_t block_size,
+        uint32_t block_count);
+void telemetry_journal_file_storage_close(telemetry_journal_storage *storage);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_JOURNAL_H
@@ -0,0 +1,96 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifndef TELEMETRY_WRITER_H
+#define TELEMETRY_WRITER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// "2023-01-11T12:34:56.000Z" - same format as iotcl_iso_timestamp_now()
+#define TELEMETRY_ISO_TIME_LEN 24
+
+typedef enum telemetry_format {
+    TELEMETRY_FORMAT_JSON = 0,  // the IoTConnect telemetry message
+    TELEMETRY_FORMAT_CBOR       // the same message in compact CBOR, base64 encoded. See below.
+} telemetry_format;
+
+// The CBOR message is a map with these integer keys:
+//   0: TELEMETRY_CBOR_VERSION, 1: cpId, 2: dtg, 3: env, 4: device ID, 5: time as seconds since the epoch,
+//   6: array of data points.
+// Each data point is a map of the fields. Key 0 is its time as seconds after the time of the message,
+// the fields of the application telemetry model have the integer keys below, and other fields are keyed by
+// their name. Integral numbers are encoded as integers, and others as float32 if that is exact.
+// Maps and arrays have indefinite length, so that they can be streamed.
+#define TELEMETRY_CBOR_VERSION              1
+#define TELEMETRY_CBOR_KEY_VERSION          1
+#define TELEMETRY_CBOR_KEY_TEMPERATURE      2
+#define TELEMETRY_CBOR_KEY_BUTTON_COUNTER   3
+
+// Space that telemetry_writer_finish() needs to close the message, in the final text:
+// "]}" in JSON, and two CBOR break bytes, which take up to 4 bytes in base64
+#define TELEMETRY_JSON_TERMINATOR_LEN 2
+#define TELEMETRY_CBOR_TERMINATOR_LEN 4
+
+// A single reading of the application telemetry model.
+typedef struct telemetry_sample {
+    time_t timestamp;
+    double temperature;
+    uint32_t button_counter;
+    bool has_sensor_values; // false if the sensors could not be read. Only "version" is reported then.
+} telemetry_sample;
+
+// Streaming IoTConnect telemetry JSON or CBOR writer.
+// Formats the message directly into a caller supplied buffer without any dynamic allocation.
+// Once the buffer overflows, all subsequent calls are ignored and telemetry_writer_finish() returns NULL.
+// The size is that of the final, null-terminated text. CBOR is written in binary into the first 3/4 of the
+// buffer and base64 encoded in place by telemetry_writer_finish().
+typedef struct telemetry_writer {
+    char *buffer;
+    size_t size;
+    size_t length;
+    bool overflow;
+    bool has_datapoint;
+    bool has_field;
+    telemetry_format format;
+    time_t message_time;    // the data point times are relative to it in CBOR
+} telemetry_writer;
+
+// Initializes a JSON writer
+void telemetry_writer_init(telemetry_writer *w, char *buffer, size_t size);
+void telemetry_writer_init_format(telemetry_writer *w, char *buffer, size_t size, telemetry_format format);
+
+static inline size_t telemetry_writer_terminator_length(telemetry_format format) {
+    return TELEMETRY_FORMAT_CBOR == format ? TELEMETRY_CBOR_TERMINATOR_LEN : TELEMETRY_JSON_TERMINATOR_LEN;
+}
+
+// Writes the message envelope (cpId, dtg, sdk info etc.) and opens the data point array.
+void telemetry_writer_begin_message(telemetry_writer *w, time_t now);
+
+// Opens a data point with the given timestamp. Fields can be added until telemetry_writer_end_datapoint().
+void telemetry_writer_begin_datapoint(telemetry_writer *w, time_t timestamp);
+void telemetry_writer_add_string(telemetry_writer *w, const char *name, const char *value);
+void telemetry_writer_add_number(telemetry_writer *w, const char *name, double value);
+void telemetry_writer_end_datapoint(telemetry_writer *w);
+
+// Convenience: writes a whole data point for the application telemetry model.
+void telemetry_writer_add_sample(telemetry_writer *w, const char *version, const telemetry_sample *sample);
+
+// Closes the message. Returns the null-terminated message or NULL if the buffer was too small.
+const char *telemetry_writer_finish(telemetry_writer *w);
+
+// Formats the timestamp in the same format as iotcl_iso_timestamp_now(). Buffer must fit TELEMETRY_ISO_TIME_LEN + 1.
+void telemetry_format_iso_time(time_t timestamp, char *buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_WRITER_H
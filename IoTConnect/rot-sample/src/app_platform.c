@@ -0,0 +1,37 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include "tx_api.h"
+#include "stm32h5xx_hal.h"
+#include "app_platform.h"
+
+uint32_t app_platform_time_ms(void) {
+    return (uint32_t) ((uint64_t) tx_time_get() * 1000 / TX_TIMER_TICKS_PER_SECOND);
+}
+
+void app_platform_sleep_ms(uint32_t ms) {
+    // round up, so that we never sleep shorter than requested
+    tx_thread_sleep((ULONG) (((uint64_t) ms * TX_TIMER_TICKS_PER_SECOND + 999) / 1000));
+}
+
+uint32_t app_platform_cycles(void) {
+    if (0 == (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+        // The counter may not be accessible to the non-secure image, depending on the debug authentication
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+        if (0 == (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+            return 0;
+        }
+    }
+    return DWT->CYCCNT;
+}
+
+uint32_t app_platform_cycles_per_us(void) {
+    return SystemCoreClock / 1000000;
+}
+
+void app_platform_reset(void) {
+    NVIC_SystemReset();
+}
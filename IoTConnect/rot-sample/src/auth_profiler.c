@@ -0,0 +1,59 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include "auth_profiler.h"
+
+#if APP_AUTH_PROFILER
+
+#include <stdio.h>
+#include <string.h>
+
+static auth_profile_entry entries[AUTH_PROFILE_COUNT];
+
+static const char *const names[AUTH_PROFILE_COUNT] = {
+    "get_cert",
+    "get_private_key",
+    "retrieve_credentials",
+    "extract_cn",
+    "x509_initialize",
+    "ecdsa_operation"
+};
+
+void auth_profiler_record(auth_profile_point point, uint32_t cycles, size_t size) {
+    if (point >= AUTH_PROFILE_COUNT) {
+        return;
+    }
+    auth_profile_entry *e = &entries[point];
+    e->calls++;
+    e->cycles += cycles;
+    e->bytes += size;
+    if (cycles > e->max_cycles) {
+        e->max_cycles = cycles;
+    }
+}
+
+const auth_profile_entry *auth_profiler_get(auth_profile_point point) {
+    return (point < AUTH_PROFILE_COUNT) ? &entries[point] : NULL;
+}
+
+const char *auth_profiler_name(auth_profile_point point) {
+    return (point < AUTH_PROFILE_COUNT) ? names[point] : "?";
+}
+
+void auth_profiler_reset(void) {
+    memset(entries, 0, sizeof(entries));
+}
+
+void auth_profiler_print(void) {
+    const uint32_t cycles_per_us = app_platform_cycles_per_us() ? app_platform_cycles_per_us() : 1;
+    printf("%-22s %8s %12s %12s %10s\r\n", "auth profile", "calls", "total us", "max us", "bytes");
+    for (int i = 0; i < AUTH_PROFILE_COUNT; i++) {
+        const auth_profile_entry *e = &entries[i];
+        printf("%-22s %8lu %12lu %12lu %10lu\r\n", names[i], (unsigned long) e->calls,
+                (unsigned long) (e->cycles / cycles_per_us), (unsigned long) (e->max_cycles / cycles_per_us),
+                (unsigned long) e->bytes);
+    }
+}
+
+#endif // APP_AUTH_PROFILER
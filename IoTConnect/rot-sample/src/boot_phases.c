@@ -0,0 +1,61 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "app_platform.h"
+#include "boot_phases.h"
+
+static const char *const phase_names[BOOT_PHASE_COUNT] = {
+        "IP address",
+        "DNS ready",
+        "Discovery host lookup",
+        "Time synced",
+        "App ready",
+        "Connected",
+        "First publish"
+};
+
+static TX_EVENT_FLAGS_GROUP reached;
+static uint32_t start_ms;
+static uint32_t phase_ms[BOOT_PHASE_COUNT];
+
+UINT boot_phases_init(void) {
+    memset(phase_ms, 0, sizeof(phase_ms));
+    start_ms = app_platform_time_ms();
+    return tx_event_flags_create(&reached, "Boot Phases");
+}
+
+void boot_phases_mark(boot_phase phase) {
+    // each phase is marked by a single thread, so there is no race between the check and the set
+    if (boot_phases_reached(phase)) {
+        return;
+    }
+    phase_ms[phase] = app_platform_time_ms() - start_ms;
+    tx_event_flags_set(&reached, BOOT_PHASE_BIT(phase), TX_OR);
+}
+
+bool boot_phases_reached(boot_phase phase) {
+    ULONG flags;
+    return TX_SUCCESS == tx_event_flags_get(&reached, BOOT_PHASE_BIT(phase), TX_OR, &flags, TX_NO_WAIT);
+}
+
+UINT boot_phases_wait(ULONG phase_mask, ULONG wait_ticks) {
+    ULONG flags;
+    return tx_event_flags_get(&reached, phase_mask, TX_AND, &flags, wait_ticks);
+}
+
+void boot_phases_print(void) {
+    uint32_t previous_ms = 0;
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        if (!boot_phases_reached((boot_phase) i)) {
+            continue;
+        }
+        printf("Boot: %-22s %7lu ms (+%lu)\r\n", phase_names[i], (unsigned long) phase_ms[i],
+                (unsigned long) (phase_ms[i] > previous_ms ? phase_ms[i] - previous_ms : 0));
+        if (phase_ms[i] > previous_ms) {
+            previous_ms = phase_ms[i];
+        }
+    }
+}
@@ -0,0 +1,177 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <string.h>
+#include "cert_store.h"
+
+/*
+ * Table item, all values little endian:
+ *   magic "CST1"(4) generation(4) active(4)
+ *   per slot: state(4) key_id(4) generation(4) cert_size(4)
+ * active is 0xFFFFFFFF when no slot is active.
+ */
+#define TABLE_MAGIC       0x31545343 // "CST1"
+#define TABLE_HEADER_SIZE 12
+#define TABLE_SLOT_SIZE   16
+#define TABLE_SIZE        (TABLE_HEADER_SIZE + CERT_STORE_SLOT_COUNT * TABLE_SLOT_SIZE)
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static void put_u32(uint8_t *p, uint32_t value) {
+    p[0] = (uint8_t) value;
+    p[1] = (uint8_t) (value >> 8);
+    p[2] = (uint8_t) (value >> 16);
+    p[3] = (uint8_t) (value >> 24);
+}
+
+static bool is_valid_slot(int slot) {
+    return slot >= 0 && slot < CERT_STORE_SLOT_COUNT;
+}
+
+// Writes the table as it would be with the given active slot and generation
+static int write_table(const cert_store *store, int active, uint32_t generation) {
+    uint8_t table[TABLE_SIZE];
+    put_u32(&table[0], TABLE_MAGIC);
+    put_u32(&table[4], generation);
+    put_u32(&table[8], (uint32_t) active);
+    for (int i = 0; i < CERT_STORE_SLOT_COUNT; i++) {
+        uint8_t *p = &table[TABLE_HEADER_SIZE + i * TABLE_SLOT_SIZE];
+        const cert_store_slot *slot = &store->slots[i];
+        put_u32(&p[0], slot->state);
+        put_u32(&p[4], slot->key_id);
+        put_u32(&p[8], slot->generation);
+        put_u32(&p[12], slot->cert_size);
+    }
+    if (store->storage->write(store->storage->context, CERT_STORE_ITEM_TABLE, table, sizeof(table))) {
+        return CERT_STORE_ERROR_STORAGE;
+    }
+    return 0;
+}
+
+static bool load_cert(cert_store *store, int index) {
+    cert_store_slot *slot = &store->slots[index];
+    uint32_t actual_size = 0;
+    if (slot->cert_size > CERT_STORE_MAX_CERT_SIZE
+            || store->storage->read(store->storage->context, CERT_STORE_ITEM_CERT(index), slot->cert, slot->cert_size,
+                    &actual_size)) {
+        return false;
+    }
+    return actual_size == slot->cert_size;
+}
+
+int cert_store_init(cert_store *store, const cert_store_storage *storage) {
+    memset(store, 0, sizeof(*store));
+    store->storage = storage;
+    store->active = CERT_STORE_NONE;
+
+    uint8_t table[TABLE_SIZE];
+    uint32_t actual_size = 0;
+    if (storage->read(storage->context, CERT_STORE_ITEM_TABLE, table, sizeof(table), &actual_size)
+            || actual_size != sizeof(table) || get_u32(&table[0]) != TABLE_MAGIC) {
+        return 0; // never written
+    }
+    store->generation = get_u32(&table[4]);
+    int active = (int) get_u32(&table[8]);
+    for (int i = 0; i < CERT_STORE_SLOT_COUNT; i++) {
+        const uint8_t *p = &table[TABLE_HEADER_SIZE + i * TABLE_SLOT_SIZE];
+        cert_store_slot *slot = &store->slots[i];
+        slot->state = (uint8_t) get_u32(&p[0]);
+        slot->key_id = get_u32(&p[4]);
+        slot->generation = get_u32(&p[8]);
+        slot->cert_size = get_u32(&p[12]);
+        if (CERT_STORE_SLOT_READY == slot->state && !load_cert(store, i)) {
+            // leave the slot for the next rotation and fall back to another one, or to the bootstrap identity
+            slot->state = CERT_STORE_SLOT_EMPTY;
+            slot->cert_size = 0;
+        }
+    }
+    if (is_valid_slot(active) && CERT_STORE_SLOT_READY == store->slots[active].state) {
+        store->active = active;
+    } else {
+        // the newest of the other certificates, if any
+        for (int i = 0; i < CERT_STORE_SLOT_COUNT; i++) {
+            const cert_store_slot *slot = &store->slots[i];
+            if (CERT_STORE_SLOT_READY == slot->state
+                    && (CERT_STORE_NONE == store->active || slot->generation > store->slots[store->active].generation)) {
+                store->active = i;
+            }
+        }
+    }
+    return 0;
+}
+
+int cert_store_staging_slot(const cert_store *store) {
+    // with the current active slot excluded, prefer an empty slot, then the oldest one
+    int staging = CERT_STORE_NONE;
+    for (int i = 0; i < CERT_STORE_SLOT_COUNT; i++) {
+        const cert_store_slot *slot = &store->slots[i];
+        if (i == store->active) {
+            continue;
+        }
+        if (CERT_STORE_NONE == staging
+                || (CERT_STORE_SLOT_EMPTY != store->slots[staging].state
+                        && (CERT_STORE_SLOT_EMPTY == slot->state
+                                || slot->generation < store->slots[staging].generation))) {
+            staging = i;
+        }
+    }
+    return staging;
+}
+
+int cert_store_stage_key(cert_store *store, int slot, uint32_t key_id) {
+    if (!is_valid_slot(slot) || slot == store->active) {
+        return CERT_STORE_ERROR_STATE;
+    }
+    cert_store_slot *s = &store->slots[slot];
+    s->state = CERT_STORE_SLOT_KEY_STAGED;
+    s->key_id = key_id;
+    s->cert_size = 0;
+    return write_table(store, store->active, store->generation);
+}
+
+int cert_store_commit(cert_store *store, int slot, const uint8_t *cert, uint32_t cert_size) {
+    if (!is_valid_slot(slot) || slot == store->active || CERT_STORE_SLOT_KEY_STAGED != store->slots[slot].state) {
+        return CERT_STORE_ERROR_STATE;
+    }
+    if (0 == cert_size || cert_size > CERT_STORE_MAX_CERT_SIZE) {
+        return CERT_STORE_ERROR_SIZE;
+    }
+    cert_store_slot *s = &store->slots[slot];
+    if (store->storage->write(store->storage->context, CERT_STORE_ITEM_CERT(slot), cert, cert_size)) {
+        return CERT_STORE_ERROR_STORAGE;
+    }
+    memcpy(s->cert, cert, cert_size);
+    s->cert_size = cert_size;
+    s->state = CERT_STORE_SLOT_READY;
+    s->generation = store->generation + 1;
+    int status = write_table(store, slot, s->generation);
+    if (status) {
+        s->state = CERT_STORE_SLOT_KEY_STAGED;
+        s->cert_size = 0;
+        return status;
+    }
+    store->generation = s->generation;
+    store->active = slot; // everything else is in place before readers see the new slot
+    return 0;
+}
+
+bool cert_store_active(const cert_store *store, const uint8_t **cert, uint32_t *cert_size, uint32_t *key_id) {
+    const int active = store->active;
+    if (CERT_STORE_NONE == active) {
+        return false;
+    }
+    const cert_store_slot *slot = &store->slots[active];
+    if (cert) {
+        *cert = slot->cert;
+    }
+    if (cert_size) {
+        *cert_size = slot->cert_size;
+    }
+    if (key_id) {
+        *key_id = slot->key_id;
+    }
+    return true;
+}
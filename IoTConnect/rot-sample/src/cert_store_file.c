@@ -0,0 +1,78 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifdef CERT_STORE_FILE_STORAGE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cert_store.h"
+
+#define PATH_SIZE 256
+
+struct file_storage_context {
+    char directory[PATH_SIZE];
+};
+
+static int item_path(const struct file_storage_context *c, char *path, uint32_t item, const char *suffix) {
+    int length = snprintf(path, PATH_SIZE, "%s/cert-store-%lu%s", c->directory, (unsigned long) item, suffix);
+    return (length > 0 && length < PATH_SIZE) ? 0 : -1;
+}
+
+static int file_read(void *context, uint32_t item, uint8_t *data, uint32_t size, uint32_t *actual_size) {
+    char path[PATH_SIZE];
+    if (item_path((struct file_storage_context *) context, path, item, "")) {
+        return CERT_STORE_ERROR_STORAGE;
+    }
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return CERT_STORE_ERROR_STORAGE;
+    }
+    *actual_size = (uint32_t) fread(data, 1, size, file);
+    fclose(file);
+    return 0;
+}
+
+static int file_write(void *context, uint32_t item, const uint8_t *data, uint32_t size) {
+    struct file_storage_context *c = (struct file_storage_context *) context;
+    char path[PATH_SIZE];
+    char temp_path[PATH_SIZE];
+    if (item_path(c, path, item, "") || item_path(c, temp_path, item, ".tmp")) {
+        return CERT_STORE_ERROR_STORAGE;
+    }
+    FILE *file = fopen(temp_path, "wb");
+    if (!file) {
+        return CERT_STORE_ERROR_STORAGE;
+    }
+    const bool written = fwrite(data, 1, size, file) == size;
+    if (fclose(file) || !written || rename(temp_path, path)) {
+        remove(temp_path);
+        return CERT_STORE_ERROR_STORAGE;
+    }
+    return 0;
+}
+
+int cert_store_file_storage_init(cert_store_storage *storage, const char *directory) {
+    struct file_storage_context *c = (struct file_storage_context *) malloc(sizeof(struct file_storage_context));
+    if (!c) {
+        return -1;
+    }
+    if (strlen(directory) >= sizeof(c->directory)) {
+        printf("Cert store: Directory name is too long\r\n");
+        free(c);
+        return -1;
+    }
+    strcpy(c->directory, directory);
+    storage->context = c;
+    storage->read = file_read;
+    storage->write = file_write;
+    return 0;
+}
+
+void cert_store_file_storage_close(cert_store_storage *storage) {
+    free(storage->context);
+    storage->context = NULL;
+}
+
+#endif // CERT_STORE_FILE_STORAGE
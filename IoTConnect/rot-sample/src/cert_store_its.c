@@ -0,0 +1,32 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include "psa/internal_trusted_storage.h"
+#include "cert_store.h"
+
+// ID in PSA storage of the table. Certificates use the following IDs.
+// Keep clear of METADATA_UID and the telemetry journal.
+#define CERT_STORE_UID_BASE 0x300
+
+static int its_read(void *context, uint32_t item, uint8_t *data, uint32_t size, uint32_t *actual_size) {
+    (void) context;
+    size_t length = 0;
+    psa_status_t status = psa_its_get(CERT_STORE_UID_BASE + item, 0, size, data, &length);
+    if (PSA_SUCCESS != status) {
+        return CERT_STORE_ERROR_STORAGE;
+    }
+    *actual_size = (uint32_t) length;
+    return 0;
+}
+
+static int its_write(void *context, uint32_t item, const uint8_t *data, uint32_t size) {
+    (void) context;
+    return (PSA_SUCCESS == psa_its_set(CERT_STORE_UID_BASE + item, size, data, 0)) ? 0 : CERT_STORE_ERROR_STORAGE;
+}
+
+void cert_store_its_storage_init(cert_store_storage *storage) {
+    storage->context = NULL;
+    storage->read = its_read;
+    storage->write = its_write;
+}
@@ -0,0 +1,184 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "app_platform.h"
+#include "command_dispatcher.h"
+
+static bool benchmark_handler(int argc, const char *argv[], char *message, size_t message_size) {
+    (void) argc;
+    (void) argv;
+    (void) message;
+    (void) message_size;
+    return true;
+}
+
+static const command_handler_entry benchmark_entry = {"benchmark", benchmark_handler, 0};
+
+static void worker_entry(ULONG parameter) {
+    command_dispatcher *dispatcher = (command_dispatcher *) parameter;
+    while (true) {
+        command_job *job;
+        if (TX_SUCCESS != tx_queue_receive(&dispatcher->pending_jobs, &job, TX_WAIT_FOREVER)) {
+            continue;
+        }
+        job->message[0] = 0;
+        job->success = job->entry->handler(job->argc, job->argv, job->message, sizeof(job->message));
+        // cannot fail. There are only as many jobs as the queue can hold.
+        tx_queue_send(&dispatcher->done_jobs, &job, TX_NO_WAIT);
+    }
+}
+
+// Splits the text of the job into arguments, in place. Returns false if there are too many.
+static bool parse(command_job *job) {
+    job->argc = 0;
+    char *p = job->text;
+    while (*p) {
+        while (' ' == *p) {
+            *p++ = 0;
+        }
+        if (!*p) {
+            break;
+        }
+        if (COMMAND_DISPATCHER_MAX_ARGS == job->argc) {
+            return false;
+        }
+        job->argv[job->argc++] = p;
+        while (*p && ' ' != *p) {
+            p++;
+        }
+    }
+    return job->argc > 0;
+}
+
+static const command_handler_entry *find_handler(const command_dispatcher *dispatcher, const char *command) {
+    size_t name_length = strcspn(command, " ");
+    for (unsigned int i = 0; i < dispatcher->handler_count; i++) {
+        const command_handler_entry *entry = &dispatcher->handlers[i];
+        if (strlen(entry->name) == name_length && 0 == strncmp(entry->name, command, name_length)) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+// Returns NULL on success, or the reason for the ack
+static const char *queue_job(command_dispatcher *dispatcher, const command_handler_entry *entry, void *event,
+        const char *command) {
+    command_job *job;
+    if (strlen(command) >= COMMAND_DISPATCHER_MAX_LENGTH) {
+        return "Command is too long";
+    }
+    if (TX_SUCCESS != tx_queue_receive(&dispatcher->free_jobs, &job, TX_NO_WAIT)) {
+        return "Busy";
+    }
+    job->entry = entry;
+    job->event = event;
+    strcpy(job->text, command);
+    if (!parse(job)) {
+        tx_queue_send(&dispatcher->free_jobs, &job, TX_NO_WAIT);
+        return "Too many arguments";
+    }
+    tx_queue_send(&dispatcher->pending_jobs, &job, TX_NO_WAIT);
+    return NULL;
+}
+
+UINT command_dispatcher_init(command_dispatcher *dispatcher, command_ack_fn ack, void *stack, ULONG stack_size,
+        UINT priority) {
+    memset(dispatcher, 0, sizeof(*dispatcher));
+    dispatcher->ack = ack;
+    UINT status = tx_queue_create(&dispatcher->free_jobs, "Command Jobs", TX_1_ULONG, dispatcher->free_storage,
+            sizeof(dispatcher->free_storage));
+    if (TX_SUCCESS == status) {
+        status = tx_queue_create(&dispatcher->pending_jobs, "Pending Commands", TX_1_ULONG,
+                dispatcher->pending_storage, sizeof(dispatcher->pending_storage));
+    }
+    if (TX_SUCCESS == status) {
+        status = tx_queue_create(&dispatcher->done_jobs, "Completed Commands", TX_1_ULONG, dispatcher->done_storage,
+                sizeof(dispatcher->done_storage));
+    }
+    for (int i = 0; TX_SUCCESS == status && i < COMMAND_DISPATCHER_QUEUE_DEPTH; i++) {
+        command_job *job = &dispatcher->jobs[i];
+        status = tx_queue_send(&dispatcher->free_jobs, &job, TX_NO_WAIT);
+    }
+    if (TX_SUCCESS == status) {
+        status = tx_thread_create(&dispatcher->worker, "Command Worker", worker_entry, (ULONG) dispatcher,
+                stack, stack_size, priority, priority, TX_NO_TIME_SLICE, TX_AUTO_START);
+    }
+    return status;
+}
+
+bool command_dispatcher_register(command_dispatcher *dispatcher, const char *name, command_handler_fn handler,
+        uint32_t flags) {
+    if (COMMAND_DISPATCHER_MAX_HANDLERS == dispatcher->handler_count) {
+        return false;
+    }
+    command_handler_entry *entry = &dispatcher->handlers[dispatcher->handler_count++];
+    entry->name = name;
+    entry->handler = handler;
+    entry->flags = flags;
+    return true;
+}
+
+void command_dispatcher_submit(command_dispatcher *dispatcher, void *event, const char *command) {
+    const command_handler_entry *entry = find_handler(dispatcher, command);
+    const char *error;
+    if (NULL == entry) {
+        error = "Not implemented";
+    } else {
+        error = queue_job(dispatcher, entry, (entry->flags & COMMAND_FLAG_ACK_ON_ACCEPT) ? NULL : event, command);
+    }
+    if (error) {
+        dispatcher->rejected++;
+        if (event) {
+            dispatcher->ack(event, false, command, error);
+        }
+    } else if (event && (entry->flags & COMMAND_FLAG_ACK_ON_ACCEPT)) {
+        dispatcher->ack(event, true, command, "Accepted");
+    }
+}
+
+unsigned int command_dispatcher_process(command_dispatcher *dispatcher, ULONG wait_ticks) {
+    unsigned int count = 0;
+    command_job *job;
+    while (TX_SUCCESS == tx_queue_receive(&dispatcher->done_jobs, &job, (0 == count) ? wait_ticks : TX_NO_WAIT)) {
+        if (job->event) {
+            dispatcher->ack(job->event, job->success, job->argv[0], job->message);
+        } else if (job->entry != &benchmark_entry) {
+            printf("command: %s completed, status=%s: %s\r\n", job->argv[0], job->success ? "OK" : "Failed",
+                    job->message);
+        }
+        dispatcher->completed++;
+        tx_queue_send(&dispatcher->free_jobs, &job, TX_NO_WAIT);
+        count++;
+    }
+    return count;
+}
+
+void command_dispatcher_benchmark(command_dispatcher *dispatcher, unsigned int count) {
+    const uint32_t cycles_per_us = app_platform_cycles_per_us();
+    uint32_t max_submit_cycles = 0;
+    unsigned int submitted = 0;
+    unsigned int done = 0;
+    const uint32_t start_ms = app_platform_time_ms();
+    while (done < count) {
+        while (submitted < count) {
+            const uint32_t start = app_platform_cycles();
+            if (queue_job(dispatcher, &benchmark_entry, NULL, benchmark_entry.name)) {
+                break; // all jobs are in flight
+            }
+            const uint32_t cycles = app_platform_cycles() - start;
+            if (cycles > max_submit_cycles) {
+                max_submit_cycles = cycles;
+            }
+            submitted++;
+        }
+        done += command_dispatcher_process(dispatcher, 1);
+    }
+    const uint32_t elapsed_ms = app_platform_time_ms() - start_ms;
+    printf("Commands: %u in %lu ms (%lu/s). Longest submit %lu us\r\n", count, (unsigned long) elapsed_ms,
+            (unsigned long) (elapsed_ms ? (uint64_t) count * 1000 / elapsed_ms : 0),
+            (unsigned long) (cycles_per_us ? max_submit_cycles / cycles_per_us : 0));
+}
@@ -0,0 +1,71 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include "connection_supervisor.h"
+
+static uint32_t next_random(connection_supervisor *supervisor) {
+    uint32_t x = supervisor->random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    supervisor->random = x;
+    return x;
+}
+
+// Returns half of the delay plus a random part of the other half
+static uint32_t jitter(connection_supervisor *supervisor, uint32_t delay_ms) {
+    const uint32_t half = delay_ms / 2;
+    return half + (half ? next_random(supervisor) % (half + 1) : 0);
+}
+
+void connection_supervisor_init(connection_supervisor *supervisor, const connection_backoff_policy *policy,
+        uint32_t seed) {
+    supervisor->policy = *policy;
+    supervisor->failures = 0;
+    supervisor->random = seed ? seed : 0x2545F491; // xorshift state must not be zero
+    supervisor->connected_ms = 0;
+    supervisor->connected = false;
+}
+
+uint32_t connection_supervisor_on_failure(connection_supervisor *supervisor, connection_stage stage) {
+    const uint32_t cap = (CONNECTION_STAGE_NETWORK == stage) ?
+            supervisor->policy.network_max_delay_ms : supervisor->policy.max_delay_ms;
+    uint32_t delay = supervisor->policy.min_delay_ms;
+    for (uint32_t i = 0; i < supervisor->failures && delay < cap; i++) {
+        delay *= 2;
+    }
+    if (delay > cap) {
+        delay = cap;
+    }
+    supervisor->failures++;
+    return jitter(supervisor, delay);
+}
+
+void connection_supervisor_on_connected(connection_supervisor *supervisor, uint32_t now_ms) {
+    supervisor->connected = true;
+    supervisor->connected_ms = now_ms;
+}
+
+uint32_t connection_supervisor_on_disconnected(connection_supervisor *supervisor, uint32_t now_ms) {
+    if (supervisor->connected && (uint32_t) (now_ms - supervisor->connected_ms) >= supervisor->policy.stable_ms) {
+        supervisor->failures = 0;
+    }
+    supervisor->connected = false;
+    if (0 == supervisor->failures) {
+        // Everyone connected to the same broker lost the connection at once. Spread the first attempts.
+        supervisor->failures++;
+        return next_random(supervisor) % (supervisor->policy.min_delay_ms + 1);
+    }
+    // the connection was not stable. Keep backing off.
+    return connection_supervisor_on_failure(supervisor, CONNECTION_STAGE_CLOUD);
+}
+
+uint32_t connection_supervisor_seed(const char *str, uint32_t salt) {
+    uint32_t hash = 2166136261u ^ salt;
+    while (str && *str) {
+        hash ^= (uint8_t) *str++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
@@ -0,0 +1,143 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <string.h>
+#include "csr_writer.h"
+
+#define TAG_INTEGER     0x02
+#define TAG_BIT_STRING  0x03
+#define TAG_UTF8_STRING 0x0C
+#define TAG_SEQUENCE    0x30
+#define TAG_SET         0x31
+
+static const uint8_t VERSION_0[] = {TAG_INTEGER, 0x01, 0x00};
+static const uint8_t OID_COMMON_NAME[] = {0x06, 0x03, 0x55, 0x04, 0x03};
+// SEQUENCE {ecPublicKey, prime256v1}
+static const uint8_t EC_P256_ALGORITHM[] = {
+    TAG_SEQUENCE, 0x13,
+    0x06, 0x07, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x02, 0x01,
+    0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x03, 0x01, 0x07
+};
+// SEQUENCE {ecdsa-with-SHA256}
+static const uint8_t ECDSA_SHA256_ALGORITHM[] = {
+    TAG_SEQUENCE, 0x0A,
+    0x06, 0x08, 0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02
+};
+// [0] attributes, empty
+static const uint8_t NO_ATTRIBUTES[] = {0xA0, 0x00};
+
+typedef struct der_writer {
+    uint8_t *buffer;
+    size_t size;
+    size_t length;
+} der_writer;
+
+static size_t header_size(size_t content_length) {
+    return (content_length < 0x80) ? 2 : ((content_length < 0x100) ? 3 : 4);
+}
+
+static size_t tlv_size(size_t content_length) {
+    return header_size(content_length) + content_length;
+}
+
+static void put(der_writer *w, const uint8_t *data, size_t size) {
+    if (w->length + size <= w->size) {
+        memcpy(&w->buffer[w->length], data, size);
+    }
+    w->length += size; // past the size once the buffer is too small
+}
+
+static void put_header(der_writer *w, uint8_t tag, size_t content_length) {
+    uint8_t header[4] = {tag};
+    size_t size = header_size(content_length);
+    if (2 == size) {
+        header[1] = (uint8_t) content_length;
+    } else if (3 == size) {
+        header[1] = 0x81;
+        header[2] = (uint8_t) content_length;
+    } else {
+        header[1] = 0x82;
+        header[2] = (uint8_t) (content_length >> 8);
+        header[3] = (uint8_t) content_length;
+    }
+    put(w, header, size);
+}
+
+// DER INTEGER of a 32 byte unsigned big endian value
+static size_t integer_content_size(const uint8_t *value) {
+    size_t skip = 0;
+    while (skip < 31 && 0 == value[skip]) {
+        skip++;
+    }
+    return 32 - skip + ((value[skip] & 0x80) ? 1 : 0);
+}
+
+static void put_integer(der_writer *w, const uint8_t *value) {
+    const size_t content_size = integer_content_size(value);
+    put_header(w, TAG_INTEGER, content_size);
+    if (content_size > 32) {
+        const uint8_t zero = 0;
+        put(w, &zero, 1);
+        put(w, value, 32);
+    } else {
+        put(w, &value[32 - content_size], content_size);
+    }
+}
+
+int csr_writer_build(uint8_t *buffer, size_t buffer_size, const char *cn,
+        const uint8_t public_key[CSR_WRITER_PUBLIC_KEY_SIZE], csr_writer_sign_fn sign, void *context) {
+    const size_t cn_length = strlen(cn);
+    const size_t attribute_size = tlv_size(sizeof(OID_COMMON_NAME) + tlv_size(cn_length));
+    const size_t name_size = tlv_size(tlv_size(attribute_size));
+    const size_t key_info_size = tlv_size(sizeof(EC_P256_ALGORITHM) + tlv_size(1 + CSR_WRITER_PUBLIC_KEY_SIZE));
+    const size_t info_content_size = sizeof(VERSION_0) + name_size + key_info_size + sizeof(NO_ATTRIBUTES);
+    const size_t info_size = tlv_size(info_content_size);
+
+    // CertificationRequestInfo goes to the start of the buffer first, so that it can be signed
+    der_writer w = {buffer, buffer_size, 0};
+    put_header(&w, TAG_SEQUENCE, info_content_size);
+    put(&w, VERSION_0, sizeof(VERSION_0));
+    put_header(&w, TAG_SEQUENCE, tlv_size(attribute_size));
+    put_header(&w, TAG_SET, attribute_size);
+    put_header(&w, TAG_SEQUENCE, sizeof(OID_COMMON_NAME) + tlv_size(cn_length));
+    put(&w, OID_COMMON_NAME, sizeof(OID_COMMON_NAME));
+    put_header(&w, TAG_UTF8_STRING, cn_length);
+    put(&w, (const uint8_t *) cn, cn_length);
+    put_header(&w, TAG_SEQUENCE, sizeof(EC_P256_ALGORITHM) + tlv_size(1 + CSR_WRITER_PUBLIC_KEY_SIZE));
+    put(&w, EC_P256_ALGORITHM, sizeof(EC_P256_ALGORITHM));
+    put_header(&w, TAG_BIT_STRING, 1 + CSR_WRITER_PUBLIC_KEY_SIZE);
+    put(&w, (const uint8_t *) "", 1); // no unused bits
+    put(&w, public_key, CSR_WRITER_PUBLIC_KEY_SIZE);
+    put(&w, NO_ATTRIBUTES, sizeof(NO_ATTRIBUTES));
+    if (w.length != info_size || w.length > buffer_size) {
+        return CSR_WRITER_ERROR_SIZE;
+    }
+
+    uint8_t signature[CSR_WRITER_SIGNATURE_SIZE];
+    if (sign(context, buffer, info_size, signature)) {
+        return CSR_WRITER_ERROR_SIGN;
+    }
+    const size_t ecdsa_value_content_size = tlv_size(integer_content_size(&signature[0]))
+            + tlv_size(integer_content_size(&signature[32]));
+    const size_t signature_size = tlv_size(1 + tlv_size(ecdsa_value_content_size));
+    const size_t csr_content_size = info_size + sizeof(ECDSA_SHA256_ALGORITHM) + signature_size;
+    const size_t csr_size = tlv_size(csr_content_size);
+    if (csr_size > buffer_size) {
+        return CSR_WRITER_ERROR_SIZE;
+    }
+
+    // make room for the outer header in front of the signed part
+    const size_t outer_header_size = header_size(csr_content_size);
+    memmove(&buffer[outer_header_size], buffer, info_size);
+    w.length = 0;
+    put_header(&w, TAG_SEQUENCE, csr_content_size);
+    w.length += info_size;
+    put(&w, ECDSA_SHA256_ALGORITHM, sizeof(ECDSA_SHA256_ALGORITHM));
+    put_header(&w, TAG_BIT_STRING, 1 + tlv_size(ecdsa_value_content_size));
+    put(&w, (const uint8_t *) "", 1);
+    put_header(&w, TAG_SEQUENCE, ecdsa_value_content_size);
+    put_integer(&w, &signature[0]);
+    put_integer(&w, &signature[32]);
+    return (int) w.length;
+}
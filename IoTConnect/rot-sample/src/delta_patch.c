@@ -0,0 +1,183 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <string.h>
+#include "delta_patch.h"
+
+#define OP_COPY   0x01
+#define OP_INSERT 0x02
+#define OP_ADD    0x03
+
+enum {
+    STATE_HEADER,
+    STATE_OP,      // collecting the op code and its fields
+    STATE_DATA,    // INSERT or ADD data
+    STATE_DONE,
+    STATE_ERROR
+};
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint32_t op_fields_size(uint8_t op) {
+    switch (op) {
+    case OP_COPY:
+    case OP_ADD:
+        return 9;
+    case OP_INSERT:
+        return 5;
+    default:
+        return 0;
+    }
+}
+
+// Collects up to `needed` bytes into patch->fields. Returns true once they are all there.
+static bool collect(delta_patch *patch, uint32_t needed, const uint8_t **data, size_t *size) {
+    uint32_t count = needed - patch->fields_length;
+    if (count > *size) {
+        count = (uint32_t) *size;
+    }
+    memcpy(&patch->fields[patch->fields_length], *data, count);
+    patch->fields_length += count;
+    *data += count;
+    *size -= count;
+    return patch->fields_length == needed;
+}
+
+static int fail(delta_patch *patch, int status) {
+    patch->state = STATE_ERROR;
+    return status;
+}
+
+static int emit(delta_patch *patch, const uint8_t *data, size_t size) {
+    int status = patch->write(patch->context, data, size);
+    if (status) {
+        return fail(patch, status);
+    }
+    patch->written += (uint32_t) size;
+    if (patch->written == patch->target_size) {
+        patch->state = STATE_DONE;
+    }
+    return 0;
+}
+
+static int parse_header(delta_patch *patch) {
+    const uint8_t *h = patch->fields;
+    if (get_u32(&h[0]) != DELTA_PATCH_MAGIC || get_u32(&h[12]) != 0) {
+        return fail(patch, DELTA_PATCH_ERROR_FORMAT);
+    }
+    const uint32_t source_size = get_u32(&h[4]);
+    if (source_size > patch->source_size) {
+        return fail(patch, DELTA_PATCH_ERROR_SOURCE);
+    }
+    if (patch->check_source && patch->check_source(patch->context, &h[16], source_size)) {
+        return fail(patch, DELTA_PATCH_ERROR_SOURCE);
+    }
+    patch->source_size = source_size;
+    patch->target_size = get_u32(&h[8]);
+    patch->state = (0 == patch->target_size) ? STATE_DONE : STATE_OP;
+    patch->fields_length = 0;
+    return 0;
+}
+
+// Validates a complete op and performs a COPY right away
+static int start_op(delta_patch *patch) {
+    const uint8_t op = patch->op;
+    const uint32_t length = get_u32(&patch->fields[1]);
+    patch->fields_length = 0;
+    if (0 == length || length > patch->target_size - patch->written) {
+        return fail(patch, DELTA_PATCH_ERROR_FORMAT);
+    }
+    if (OP_COPY == op || OP_ADD == op) {
+        const uint32_t offset = get_u32(&patch->fields[5]);
+        if (offset > patch->source_size || length > patch->source_size - offset) {
+            return fail(patch, DELTA_PATCH_ERROR_FORMAT);
+        }
+        patch->source_offset = offset;
+    }
+    if (OP_COPY == op) {
+        return emit(patch, &patch->source[patch->source_offset], length);
+    }
+    patch->remaining = length;
+    patch->state = STATE_DATA;
+    return 0;
+}
+
+static int apply_data(delta_patch *patch, const uint8_t **data, size_t *size) {
+    uint32_t count = patch->remaining;
+    if (count > *size) {
+        count = (uint32_t) *size;
+    }
+    if (OP_ADD == patch->op && count > DELTA_PATCH_ADD_CHUNK) {
+        count = DELTA_PATCH_ADD_CHUNK;
+    }
+    const uint8_t *chunk = *data;
+    if (OP_ADD == patch->op) {
+        for (uint32_t i = 0; i < count; i++) {
+            patch->scratch[i] = (uint8_t) (patch->source[patch->source_offset + i] + chunk[i]);
+        }
+        patch->source_offset += count;
+        chunk = patch->scratch;
+    }
+    *data += count;
+    *size -= count;
+    patch->remaining -= count;
+    if (0 == patch->remaining) {
+        patch->state = STATE_OP;
+    }
+    return emit(patch, chunk, count);
+}
+
+void delta_patch_init(delta_patch *patch, const uint8_t *source, uint32_t source_size, delta_patch_write_fn write,
+        delta_patch_check_source_fn check_source, void *context) {
+    memset(patch, 0, sizeof(*patch));
+    patch->source = source;
+    patch->source_size = source_size;
+    patch->write = write;
+    patch->check_source = check_source;
+    patch->context = context;
+    patch->state = STATE_HEADER;
+}
+
+bool delta_patch_is_delta(const uint8_t *data, size_t size) {
+    return size >= 4 && get_u32(data) == DELTA_PATCH_MAGIC;
+}
+
+int delta_patch_feed(delta_patch *patch, const uint8_t *data, size_t size) {
+    int status = 0;
+    while (size > 0 && 0 == status) {
+        switch (patch->state) {
+        case STATE_HEADER:
+            if (collect(patch, DELTA_PATCH_HEADER_SIZE, &data, &size)) {
+                status = parse_header(patch);
+            }
+            break;
+        case STATE_OP:
+            if (0 == patch->fields_length) {
+                patch->op = *data;
+                if (0 == op_fields_size(patch->op)) {
+                    return fail(patch, DELTA_PATCH_ERROR_FORMAT);
+                }
+            }
+            if (collect(patch, op_fields_size(patch->op), &data, &size)) {
+                status = start_op(patch);
+            }
+            break;
+        case STATE_DATA:
+            status = apply_data(patch, &data, &size);
+            break;
+        case STATE_DONE:
+            // trailing data after the target is complete
+            return fail(patch, DELTA_PATCH_ERROR_FORMAT);
+        default:
+            return DELTA_PATCH_ERROR_FORMAT;
+        }
+    }
+    return (STATE_ERROR == patch->state && 0 == status) ? DELTA_PATCH_ERROR_FORMAT : status;
+}
+
+bool delta_patch_done(const delta_patch *patch) {
+    return STATE_DONE == patch->state;
+}
@@ -0,0 +1,264 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "dns_cache.h"
+
+#define IMAGE_MAGIC         0x31434E44 // "DNC1"
+#define IMAGE_HEADER_SIZE   8
+#define IMAGE_ENTRY_SIZE    (DNS_CACHE_MAX_HOST_LENGTH + 12)
+
+typedef enum {
+    LOOKUP_MISS = 0,
+    LOOKUP_FRESH,
+    LOOKUP_STALE
+} lookup_result;
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static void put_u32(uint8_t *p, uint32_t value) {
+    p[0] = (uint8_t) value;
+    p[1] = (uint8_t) (value >> 8);
+    p[2] = (uint8_t) (value >> 16);
+    p[3] = (uint8_t) (value >> 24);
+}
+
+static uint32_t now_s(void) {
+    return (uint32_t) time(NULL);
+}
+
+static uint32_t clamp_ttl(uint32_t ttl_s) {
+    if (ttl_s < DNS_CACHE_MIN_TTL_S) {
+        return DNS_CACHE_MIN_TTL_S;
+    }
+    return ttl_s > DNS_CACHE_MAX_TTL_S ? DNS_CACHE_MAX_TTL_S : ttl_s;
+}
+
+static dns_cache_entry *find(dns_cache *cache, const char *host) {
+    for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+        if (0 == strcmp(cache->entries[i].host, host)) {
+            return &cache->entries[i];
+        }
+    }
+    return NULL;
+}
+
+// A free entry, or the least recently used one
+static dns_cache_entry *victim(dns_cache *cache) {
+    dns_cache_entry *oldest = &cache->entries[0];
+    for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+        dns_cache_entry *entry = &cache->entries[i];
+        if (!entry->host[0]) {
+            return entry;
+        }
+        if ((int32_t) (entry->last_used - oldest->last_used) < 0) {
+            oldest = entry;
+        }
+    }
+    return oldest;
+}
+
+// Call with the mutex held
+static int save(dns_cache *cache) {
+    uint32_t count = 0;
+    for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+        const dns_cache_entry *entry = &cache->entries[i];
+        if (!entry->host[0]) {
+            continue;
+        }
+        uint8_t *p = &cache->image[IMAGE_HEADER_SIZE + count * IMAGE_ENTRY_SIZE];
+        memset(p, 0, DNS_CACHE_MAX_HOST_LENGTH);
+        strcpy((char *) p, entry->host);
+        p += DNS_CACHE_MAX_HOST_LENGTH;
+        put_u32(&p[0], entry->address);
+        put_u32(&p[4], entry->resolved);
+        put_u32(&p[8], entry->expires);
+        count++;
+    }
+    put_u32(&cache->image[0], IMAGE_MAGIC);
+    put_u32(&cache->image[4], count);
+    if (cache->storage->save(cache->storage->context, cache->image, IMAGE_HEADER_SIZE + count * IMAGE_ENTRY_SIZE)) {
+        return DNS_CACHE_ERROR_STORAGE;
+    }
+    return 0;
+}
+
+static void load(dns_cache *cache) {
+    uint32_t actual_size = 0;
+    if (cache->storage->load(cache->storage->context, cache->image, sizeof(cache->image), &actual_size)
+            || actual_size < IMAGE_HEADER_SIZE || get_u32(&cache->image[0]) != IMAGE_MAGIC) {
+        return; // never written
+    }
+    uint32_t count = get_u32(&cache->image[4]);
+    if (count > DNS_CACHE_ENTRIES || actual_size < IMAGE_HEADER_SIZE + count * IMAGE_ENTRY_SIZE) {
+        return;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t *p = &cache->image[IMAGE_HEADER_SIZE + i * IMAGE_ENTRY_SIZE];
+        dns_cache_entry *entry = &cache->entries[i];
+        if (!memchr(p, 0, DNS_CACHE_MAX_HOST_LENGTH)) {
+            continue;
+        }
+        strcpy(entry->host, (const char *) p);
+        p += DNS_CACHE_MAX_HOST_LENGTH;
+        entry->address = get_u32(&p[0]);
+        entry->resolved = get_u32(&p[4]);
+        entry->expires = get_u32(&p[8]);
+    }
+}
+
+// Stores the answer. Call with the mutex held.
+static void store(dns_cache *cache, dns_cache_entry *entry, const char *host, uint32_t address, uint32_t ttl_s) {
+    const bool is_new = 0 != strcmp(entry->host, host);
+    const bool changed = is_new || entry->address != address;
+    if (is_new) {
+        memset(entry, 0, sizeof(*entry));
+        strcpy(entry->host, host);
+        entry->last_used = cache->use_counter++;
+    }
+    entry->address = address;
+    entry->resolved = now_s();
+    entry->expires = entry->resolved + clamp_ttl(ttl_s);
+    entry->refresh_pending = false;
+    if (changed && save(cache)) {
+        printf("DNS cache: Failed to save\r\n");
+    }
+}
+
+static lookup_result lookup_entry(dns_cache *cache, const char *host, uint32_t *address) {
+    dns_cache_entry *entry = find(cache, host);
+    if (!entry) {
+        return LOOKUP_MISS;
+    }
+    const uint32_t now = now_s();
+    entry->last_used = cache->use_counter++;
+    *address = entry->address;
+    if ((int32_t) (now - entry->resolved) >= 0 && (int32_t) (entry->expires - now) > 0) {
+        return LOOKUP_FRESH;
+    }
+    if ((int32_t) (now - entry->resolved) >= 0 && (uint32_t) (now - entry->expires) > cache->max_stale_s) {
+        return LOOKUP_MISS; // too old to be trusted
+    }
+    return LOOKUP_STALE;
+}
+
+static void refresh_thread_entry(ULONG parameter) {
+    dns_cache *cache = (dns_cache *) parameter;
+    while (true) {
+        if (TX_SUCCESS == tx_semaphore_get(&cache->refresh_needed, TX_WAIT_FOREVER)) {
+            dns_cache_refresh(cache);
+        }
+    }
+}
+
+int dns_cache_init(dns_cache *cache, const dns_cache_storage *storage, dns_cache_resolve_fn resolve,
+        void *resolve_context, uint32_t max_stale_s) {
+    memset(cache, 0, sizeof(*cache));
+    cache->storage = storage;
+    cache->resolve = resolve;
+    cache->resolve_context = resolve_context;
+    cache->max_stale_s = max_stale_s;
+    if (TX_SUCCESS != tx_mutex_create(&cache->mutex, "DNS Cache", TX_INHERIT)
+            || TX_SUCCESS != tx_semaphore_create(&cache->refresh_needed, "DNS Refresh", 0)) {
+        return DNS_CACHE_ERROR_STORAGE;
+    }
+    load(cache);
+    return 0;
+}
+
+UINT dns_cache_start_refresh(dns_cache *cache, void *stack, ULONG stack_size, UINT priority) {
+    return tx_thread_create(&cache->refresh_thread, "DNS Refresh", refresh_thread_entry, (ULONG) cache, stack,
+            stack_size, priority, priority, TX_NO_TIME_SLICE, TX_AUTO_START);
+}
+
+int dns_cache_lookup(dns_cache *cache, const char *host, uint32_t *address) {
+    if (strlen(host) >= DNS_CACHE_MAX_HOST_LENGTH) {
+        return DNS_CACHE_ERROR_NAME;
+    }
+    tx_mutex_get(&cache->mutex, TX_WAIT_FOREVER);
+    lookup_result result = lookup_entry(cache, host, address);
+    if (LOOKUP_FRESH == result) {
+        cache->stats.hits++;
+    } else if (LOOKUP_STALE == result) {
+        cache->stats.stale_hits++;
+        dns_cache_entry *entry = find(cache, host);
+        if (!entry->refresh_pending) {
+            entry->refresh_pending = true;
+            tx_semaphore_ceiling_put(&cache->refresh_needed, 1);
+        }
+    } else {
+        cache->stats.misses++;
+    }
+    tx_mutex_put(&cache->mutex);
+    if (LOOKUP_MISS != result) {
+        return 0;
+    }
+
+    uint32_t ttl_s;
+    if (cache->resolve(cache->resolve_context, host, address, &ttl_s)) {
+        tx_mutex_get(&cache->mutex, TX_WAIT_FOREVER);
+        cache->stats.failures++;
+        tx_mutex_put(&cache->mutex);
+        return DNS_CACHE_ERROR_RESOLVE;
+    }
+    tx_mutex_get(&cache->mutex, TX_WAIT_FOREVER);
+    dns_cache_entry *entry = find(cache, host);
+    store(cache, entry ? entry : victim(cache), host, *address, ttl_s);
+    tx_mutex_put(&cache->mutex);
+    return 0;
+}
+
+void dns_cache_refresh(dns_cache *cache) {
+    for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+        char host[DNS_CACHE_MAX_HOST_LENGTH];
+        tx_mutex_get(&cache->mutex, TX_WAIT_FOREVER);
+        const bool pending = cache->entries[i].refresh_pending;
+        strcpy(host, cache->entries[i].host);
+        tx_mutex_put(&cache->mutex);
+        if (!pending) {
+            continue;
+        }
+
+        uint32_t address;
+        uint32_t ttl_s;
+        const int status = cache->resolve(cache->resolve_context, host, &address, &ttl_s);
+
+        tx_mutex_get(&cache->mutex, TX_WAIT_FOREVER);
+        dns_cache_entry *entry = &cache->entries[i];
+        if (0 != strcmp(entry->host, host)) {
+            // evicted while it was resolved
+        } else if (status) {
+            cache->stats.refresh_failures++;
+            entry->refresh_pending = false; // the next stale hit tries again
+        } else {
+            cache->stats.refreshes++;
+            store(cache, entry, host, address, ttl_s);
+        }
+        tx_mutex_put(&cache->mutex);
+    }
+}
+
+void dns_cache_print(dns_cache *cache) {
+    tx_mutex_get(&cache->mutex, TX_WAIT_FOREVER);
+    const uint32_t now = now_s();
+    const dns_cache_stats *s = &cache->stats;
+    printf("DNS cache: %lu hits, %lu stale hits, %lu misses, %lu failed, %lu refreshes, %lu failed\r\n",
+            (unsigned long) s->hits, (unsigned long) s->stale_hits, (unsigned long) s->misses,
+            (unsigned long) s->failures, (unsigned long) s->refreshes, (unsigned long) s->refresh_failures);
+    for (int i = 0; i < DNS_CACHE_ENTRIES; i++) {
+        const dns_cache_entry *entry = &cache->entries[i];
+        if (!entry->host[0]) {
+            continue;
+        }
+        printf("  %-40s %lu.%lu.%lu.%lu expires in %ld s\r\n", entry->host,
+                (unsigned long) (entry->address >> 24), (unsigned long) (entry->address >> 16 & 0xFF),
+                (unsigned long) (entry->address >> 8 & 0xFF), (unsigned long) (entry->address & 0xFF),
+                (long) (int32_t) (entry->expires - now));
+    }
+    tx_mutex_put(&cache->mutex);
+}
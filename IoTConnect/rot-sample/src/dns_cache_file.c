@@ -0,0 +1,66 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifdef DNS_CACHE_FILE_STORAGE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dns_cache.h"
+
+#define PATH_SIZE 256
+
+struct file_storage_context {
+    char path[PATH_SIZE];
+    char temp_path[PATH_SIZE];
+};
+
+static int file_load(void *context, uint8_t *data, uint32_t size, uint32_t *actual_size) {
+    FILE *file = fopen(((struct file_storage_context *) context)->path, "rb");
+    if (!file) {
+        return DNS_CACHE_ERROR_STORAGE;
+    }
+    *actual_size = (uint32_t) fread(data, 1, size, file);
+    fclose(file);
+    return 0;
+}
+
+static int file_save(void *context, const uint8_t *data, uint32_t size) {
+    struct file_storage_context *c = (struct file_storage_context *) context;
+    FILE *file = fopen(c->temp_path, "wb");
+    if (!file) {
+        return DNS_CACHE_ERROR_STORAGE;
+    }
+    const bool written = fwrite(data, 1, size, file) == size;
+    if (fclose(file) || !written || rename(c->temp_path, c->path)) {
+        remove(c->temp_path);
+        return DNS_CACHE_ERROR_STORAGE;
+    }
+    return 0;
+}
+
+int dns_cache_file_storage_init(dns_cache_storage *storage, const char *path) {
+    struct file_storage_context *c = (struct file_storage_context *) malloc(sizeof(struct file_storage_context));
+    if (!c) {
+        return -1;
+    }
+    int length = snprintf(c->temp_path, sizeof(c->temp_path), "%s.tmp", path);
+    if (length < 0 || (size_t) length >= sizeof(c->temp_path)) {
+        printf("DNS cache: Path is too long\r\n");
+        free(c);
+        return -1;
+    }
+    strcpy(c->path, path);
+    storage->context = c;
+    storage->load = file_load;
+    storage->save = file_save;
+    return 0;
+}
+
+void dns_cache_file_storage_close(dns_cache_storage *storage) {
+    free(storage->context);
+    storage->context = NULL;
+}
+
+#endif // DNS_CACHE_FILE_STORAGE
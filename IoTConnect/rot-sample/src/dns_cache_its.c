@@ -0,0 +1,31 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include "psa/internal_trusted_storage.h"
+#include "dns_cache.h"
+
+// ID in PSA storage. Keep clear of METADATA_UID, the telemetry journal and the cert store.
+#define DNS_CACHE_UID 0x400
+
+static int its_load(void *context, uint8_t *data, uint32_t size, uint32_t *actual_size) {
+    (void) context;
+    size_t length = 0;
+    psa_status_t status = psa_its_get(DNS_CACHE_UID, 0, size, data, &length);
+    if (PSA_SUCCESS != status) {
+        return DNS_CACHE_ERROR_STORAGE;
+    }
+    *actual_size = (uint32_t) length;
+    return 0;
+}
+
+static int its_save(void *context, const uint8_t *data, uint32_t size) {
+    (void) context;
+    return (PSA_SUCCESS == psa_its_set(DNS_CACHE_UID, size, data, 0)) ? 0 : DNS_CACHE_ERROR_STORAGE;
+}
+
+void dns_cache_its_storage_init(dns_cache_storage *storage) {
+    storage->context = NULL;
+    storage->load = its_load;
+    storage->save = its_save;
+}
@@ -0,0 +1,218 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <string.h>
+#include "app_platform.h"
+#include "dns_cache.h"
+
+#define DNS_PORT            53
+#define DNS_HEADER_SIZE     12
+#define DNS_TYPE_A          1
+#define DNS_CLASS_IN        1
+#define DNS_FLAG_RESPONSE   0x8000
+#define DNS_FLAG_RECURSION  0x0100
+#define DNS_RCODE_MASK      0x000F
+#define MAX_MESSAGE_SIZE    512 // plain UDP DNS
+#define MAX_SERVERS         4
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t) ((p[0] << 8) | p[1]);
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+static uint8_t *put_u16(uint8_t *p, uint16_t value) {
+    p[0] = (uint8_t) (value >> 8);
+    p[1] = (uint8_t) value;
+    return p + 2;
+}
+
+// Returns the length of the query, or 0 if the host name is not valid
+static size_t build_query(uint8_t *buffer, size_t size, uint16_t id, const char *host) {
+    const size_t host_length = strlen(host);
+    // the labels take one byte more than the name, plus the terminating zero label, type and class
+    if (0 == host_length || DNS_HEADER_SIZE + host_length + 2 + 4 > size) {
+        return 0;
+    }
+    uint8_t *p = buffer;
+    p = put_u16(p, id);
+    p = put_u16(p, DNS_FLAG_RECURSION);
+    p = put_u16(p, 1); // question
+    p = put_u16(p, 0);
+    p = put_u16(p, 0);
+    p = put_u16(p, 0);
+    const char *label = host;
+    while (*label) {
+        const char *dot = strchr(label, '.');
+        size_t length = dot ? (size_t) (dot - label) : strlen(label);
+        if (0 == length || length > 63) {
+            return 0;
+        }
+        *p++ = (uint8_t) length;
+        memcpy(p, label, length);
+        p += length;
+        label += length + (dot ? 1 : 0);
+    }
+    *p++ = 0;
+    p = put_u16(p, DNS_TYPE_A);
+    p = put_u16(p, DNS_CLASS_IN);
+    return (size_t) (p - buffer);
+}
+
+// Returns the offset after the (possibly compressed) name at the offset, or 0 if it runs past the message
+static size_t skip_name(const uint8_t *message, size_t length, size_t offset) {
+    while (offset < length) {
+        const uint8_t label = message[offset];
+        if (0 == label) {
+            return offset + 1;
+        }
+        if (0xC0 == (label & 0xC0)) {
+            return (offset + 2 <= length) ? offset + 2 : 0; // a pointer ends the name
+        }
+        offset += 1 + label;
+    }
+    return 0;
+}
+
+// Finds the first A record of the answer. The TTL is the lowest of the records up to it, so that a CNAME
+// in front of the address does not outlive its own TTL. Returns 0 on success.
+static int parse_response(const uint8_t *message, size_t length, uint16_t id, uint32_t *address, uint32_t *ttl_s) {
+    if (length < DNS_HEADER_SIZE || get_u16(&message[0]) != id) {
+        return -1;
+    }
+    const uint16_t flags = get_u16(&message[2]);
+    if (!(flags & DNS_FLAG_RESPONSE) || (flags & DNS_RCODE_MASK)) {
+        return -1;
+    }
+    const uint16_t questions = get_u16(&message[4]);
+    const uint16_t answers = get_u16(&message[6]);
+    size_t offset = DNS_HEADER_SIZE;
+    for (uint16_t i = 0; i < questions; i++) {
+        offset = skip_name(message, length, offset);
+        if (0 == offset || offset + 4 > length) {
+            return -1;
+        }
+        offset += 4;
+    }
+    uint32_t lowest_ttl = UINT32_MAX;
+    for (uint16_t i = 0; i < answers; i++) {
+        offset = skip_name(message, length, offset);
+        if (0 == offset || offset + 10 > length) {
+            return -1;
+        }
+        const uint16_t type = get_u16(&message[offset]);
+        const uint16_t class = get_u16(&message[offset + 2]);
+        const uint32_t ttl = get_u32(&message[offset + 4]);
+        const uint16_t data_length = get_u16(&message[offset + 8]);
+        offset += 10;
+        if (offset + data_length > length) {
+            return -1;
+        }
+        if (ttl < lowest_ttl) {
+            lowest_ttl = ttl;
+        }
+        if (DNS_TYPE_A == type && DNS_CLASS_IN == class && 4 == data_length) {
+            *address = get_u32(&message[offset]);
+            *ttl_s = lowest_ttl;
+            return 0;
+        }
+        offset += data_length;
+    }
+    return -1;
+}
+
+static int query_server(const dns_cache_nx_resolver *r, NX_UDP_SOCKET *socket, ULONG server, uint16_t id,
+        const uint8_t *query, size_t query_length, uint32_t *address, uint32_t *ttl_s) {
+    NX_PACKET *packet;
+    if (NX_SUCCESS != nx_packet_allocate(r->pool, &packet, NX_UDP_PACKET, r->timeout_ticks)) {
+        return -1;
+    }
+    if (NX_SUCCESS != nx_packet_data_append(packet, (VOID *) query, (ULONG) query_length, r->pool, r->timeout_ticks)
+            || NX_SUCCESS != nx_udp_socket_send(socket, packet, server, DNS_PORT)) {
+        nx_packet_release(packet);
+        return -1;
+    }
+    // answers to an earlier query that timed out have a different ID and are skipped
+    const uint32_t start_ms = app_platform_time_ms();
+    const uint32_t timeout_ms = (uint32_t) ((uint64_t) r->timeout_ticks * 1000 / NX_IP_PERIODIC_RATE);
+    uint32_t elapsed_ms;
+    while ((elapsed_ms = app_platform_time_ms() - start_ms) < timeout_ms) {
+        if (NX_SUCCESS != nx_udp_socket_receive(socket, &packet,
+                (ULONG) ((uint64_t) (timeout_ms - elapsed_ms) * NX_IP_PERIODIC_RATE / 1000))) {
+            return -1;
+        }
+        uint8_t message[MAX_MESSAGE_SIZE];
+        ULONG length = 0;
+        int status = -1;
+        if (packet->nx_packet_length <= sizeof(message)
+                && NX_SUCCESS == nx_packet_data_retrieve(packet, message, &length)) {
+            status = parse_response(message, length, id, address, ttl_s);
+        }
+        nx_packet_release(packet);
+        if (0 == status) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int dns_cache_nx_resolve(void *context, const char *host, uint32_t *address, uint32_t *ttl_s) {
+    static uint16_t counter;
+    const dns_cache_nx_resolver *r = (const dns_cache_nx_resolver *) context;
+    const uint16_t id = (uint16_t) (app_platform_cycles() ^ app_platform_time_ms() ^ ++counter);
+    uint8_t query[DNS_HEADER_SIZE + DNS_CACHE_MAX_HOST_LENGTH + 6];
+    const size_t query_length = build_query(query, sizeof(query), id, host);
+    if (0 == query_length) {
+        return -1;
+    }
+
+    NX_UDP_SOCKET socket;
+    if (NX_SUCCESS != nx_udp_socket_create(r->ip, &socket, "DNS Cache", NX_IP_NORMAL, NX_FRAGMENT_OKAY,
+            NX_IP_TIME_TO_LIVE, 4)) {
+        return -1;
+    }
+    int status = -1;
+    if (NX_SUCCESS == nx_udp_socket_bind(&socket, NX_ANY_PORT, r->timeout_ticks)) {
+        for (UINT i = 0; i < MAX_SERVERS && 0 != status; i++) {
+            ULONG server = 0;
+            if (NX_SUCCESS != nx_dns_server_get(r->dns, i, &server) || 0 == server) {
+                break;
+            }
+            status = query_server(r, &socket, server, id, query, query_length, address, ttl_s);
+        }
+        nx_udp_socket_unbind(&socket);
+    }
+    nx_udp_socket_delete(&socket);
+    return status;
+}
+
+#ifdef DNS_CACHE_WRAP_NETX
+static dns_cache *routed_cache;
+
+void dns_cache_nx_route_lookups(dns_cache *cache) {
+    routed_cache = cache;
+}
+
+#ifdef NX_DISABLE_ERROR_CHECKING
+#define WRAP(name) __wrap__nx_##name
+#define REAL(name) __real__nx_##name
+#else
+#define WRAP(name) __wrap__nxe_##name
+#define REAL(name) __real__nxe_##name
+#endif
+
+UINT REAL(dns_host_by_name_get)(NX_DNS *dns_ptr, UCHAR *host_name, ULONG *host_address_ptr, ULONG wait_option);
+
+UINT WRAP(dns_host_by_name_get)(NX_DNS *dns_ptr, UCHAR *host_name, ULONG *host_address_ptr, ULONG wait_option) {
+    uint32_t address;
+    if (routed_cache && host_name && host_address_ptr
+            && 0 == dns_cache_lookup(routed_cache, (const char *) host_name, &address)) {
+        *host_address_ptr = address;
+        return NX_SUCCESS;
+    }
+    return REAL(dns_host_by_name_get)(dns_ptr, host_name, host_address_ptr, wait_option);
+}
+#endif // DNS_CACHE_WRAP_NETX
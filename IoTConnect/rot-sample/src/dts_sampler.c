@@ -0,0 +1,139 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "dts_sampler.h"
+
+static int32_t window_mean(const dts_sampler *sampler) {
+    return (int32_t) (sampler->sum / (int64_t) sampler->count);
+}
+
+static bool exceeds(const dts_sampler *sampler, int32_t temperature) {
+    if (!sampler->has_reported) {
+        return true;
+    }
+    const int32_t difference = temperature - sampler->reported;
+    return difference >= sampler->deadband || -difference >= sampler->deadband;
+}
+
+static void timer_expired(ULONG parameter) {
+    dts_sampler *sampler = (dts_sampler *) parameter;
+    if (sampler->hw->trigger(sampler->hw->context)) {
+        sampler->missed_triggers++;
+    }
+}
+
+int dts_sampler_start(dts_sampler *sampler, const dts_sampler_hw *hw, uint32_t rate_hz, int32_t deadband) {
+    memset(sampler, 0, sizeof(*sampler));
+    sampler->hw = hw;
+    sampler->deadband = deadband;
+    if (TX_SUCCESS != tx_semaphore_create(&sampler->changed, "DTS Change", 0)) {
+        return DTS_SAMPLER_ERROR_HW;
+    }
+    if (hw->start(hw->context, sampler)) {
+        printf("DTS: Failed to start the sensor\r\n");
+        return DTS_SAMPLER_ERROR_HW;
+    }
+    ULONG period = (ULONG) (TX_TIMER_TICKS_PER_SECOND / (rate_hz ? rate_hz : 1));
+    if (0 == period) {
+        period = 1;
+    }
+    if (TX_SUCCESS != tx_timer_create(&sampler->timer, "DTS Rate", timer_expired, (ULONG) sampler, period, period,
+            TX_AUTO_ACTIVATE)) {
+        return DTS_SAMPLER_ERROR_HW;
+    }
+    return 0;
+}
+
+void dts_sampler_on_reading(dts_sampler *sampler, int32_t temperature) {
+    UINT posture = tx_interrupt_control(TX_INT_DISABLE);
+    const uint32_t slot = sampler->head % DTS_SAMPLER_WINDOW;
+    if (sampler->count == DTS_SAMPLER_WINDOW) {
+        sampler->sum -= sampler->window[slot]; // the oldest reading leaves the window
+    } else {
+        sampler->count++;
+    }
+    sampler->window[slot] = temperature;
+    sampler->sum += temperature;
+    sampler->head++;
+    sampler->readings++;
+    bool signal = false;
+    if (sampler->deadband > 0 && sampler->has_reported && !sampler->change_signaled
+            && exceeds(sampler, window_mean(sampler))) {
+        sampler->change_signaled = true;
+        signal = true;
+    }
+    tx_interrupt_control(posture);
+    if (signal) {
+        tx_semaphore_ceiling_put(&sampler->changed, 1);
+    }
+}
+
+void dts_sampler_get_stats(dts_sampler *sampler, dts_sampler_stats *stats) {
+    int32_t window[DTS_SAMPLER_WINDOW];
+    memset(stats, 0, sizeof(*stats));
+
+    // copy with the interrupt locked out, and compute outside of the lock
+    UINT posture = tx_interrupt_control(TX_INT_DISABLE);
+    const uint32_t count = sampler->count;
+    const uint32_t head = sampler->head;
+    const int64_t sum = sampler->sum;
+    memcpy(window, sampler->window, sizeof(window));
+    stats->readings = sampler->readings;
+    stats->missed_triggers = sampler->missed_triggers;
+    tx_interrupt_control(posture);
+
+    stats->count = count;
+    if (0 == count) {
+        return;
+    }
+    stats->last = window[(head - 1) % DTS_SAMPLER_WINDOW];
+    stats->mean = (int32_t) (sum / (int64_t) count);
+    stats->min = stats->last;
+    stats->max = stats->last;
+    for (uint32_t i = 0; i < count; i++) {
+        const int32_t value = window[i];
+        if (value < stats->min) {
+            stats->min = value;
+        }
+        if (value > stats->max) {
+            stats->max = value;
+        }
+    }
+}
+
+bool dts_sampler_wait_change(dts_sampler *sampler, ULONG wait_ticks) {
+    if (0 == sampler->deadband) {
+        return false;
+    }
+    return TX_SUCCESS == tx_semaphore_get(&sampler->changed, wait_ticks);
+}
+
+bool dts_sampler_exceeds_deadband(dts_sampler *sampler, int32_t temperature) {
+    UINT posture = tx_interrupt_control(TX_INT_DISABLE);
+    const bool result = exceeds(sampler, temperature);
+    tx_interrupt_control(posture);
+    return result;
+}
+
+void dts_sampler_set_reported(dts_sampler *sampler, int32_t temperature) {
+    UINT posture = tx_interrupt_control(TX_INT_DISABLE);
+    sampler->reported = temperature;
+    sampler->has_reported = true;
+    sampler->change_signaled = false;
+    tx_interrupt_control(posture);
+    // drop a change that was signaled for the previous value
+    while (TX_SUCCESS == tx_semaphore_get(&sampler->changed, TX_NO_WAIT)) {
+    }
+}
+
+void dts_sampler_print(dts_sampler *sampler) {
+    dts_sampler_stats stats;
+    dts_sampler_get_stats(sampler, &stats);
+    printf("DTS: last %ld, mean %ld, min %ld, max %ld mC over the last %lu readings\r\n",
+            (long) stats.last, (long) stats.mean, (long) stats.min, (long) stats.max, (unsigned long) stats.count);
+    printf("DTS: %lu readings, %lu missed triggers\r\n", (unsigned long) stats.readings,
+            (unsigned long) stats.missed_triggers);
+}
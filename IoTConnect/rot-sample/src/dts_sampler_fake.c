@@ -0,0 +1,35 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifdef DTS_SAMPLER_FAKE
+
+#include "dts_sampler.h"
+
+static int fake_start(void *context, dts_sampler *sampler) {
+    ((dts_sampler_fake *) context)->sampler = sampler;
+    return 0;
+}
+
+static int fake_trigger(void *context) {
+    dts_sampler_fake *fake = (dts_sampler_fake *) context;
+    if (fake->busy) {
+        return DTS_SAMPLER_ERROR_HW;
+    }
+    dts_sampler_on_reading(fake->sampler, fake->waveform(fake->waveform_context, fake->index++));
+    return 0;
+}
+
+void dts_sampler_fake_hw_init(dts_sampler_hw *hw, dts_sampler_fake *fake) {
+    hw->context = fake;
+    hw->start = fake_start;
+    hw->trigger = fake_trigger;
+}
+
+void dts_sampler_fake_step(dts_sampler_fake *fake, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        fake_trigger(fake);
+    }
+}
+
+#endif // DTS_SAMPLER_FAKE
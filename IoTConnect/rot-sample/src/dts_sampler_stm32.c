@@ -0,0 +1,53 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include "iotconnect_app_config.h"
+
+#if APP_DTS_SAMPLER
+
+#include "stm32h5xx_hal.h"
+#include "dts_sampler.h"
+
+// The handler is short and only calls ThreadX services that are allowed from interrupts
+#define DTS_IRQ_PRIORITY 7
+
+extern DTS_HandleTypeDef hdts; // set up by MX_DTS_Init() in main.c
+
+static dts_sampler *active_sampler;
+
+static int stm32_start(void *context, dts_sampler *sampler) {
+    (void) context;
+    active_sampler = sampler;
+    HAL_NVIC_SetPriority(DTS_IRQn, DTS_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(DTS_IRQn);
+    return 0;
+}
+
+static int stm32_trigger(void *context) {
+    (void) context;
+    return (HAL_OK == HAL_DTS_Start_IT(&hdts)) ? 0 : DTS_SAMPLER_ERROR_HW;
+}
+
+// The measurement is complete. Read it and stop the sensor until the next trigger.
+void HAL_DTS_EndCallback(DTS_HandleTypeDef *dts) {
+    int32_t temperature;
+    const bool ok = HAL_OK == HAL_DTS_GetTemperature(dts, &temperature);
+    HAL_DTS_Stop_IT(dts);
+    if (ok && active_sampler) {
+        dts_sampler_on_reading(active_sampler, temperature * 1000);
+    }
+}
+
+// The DTS interrupt is not enabled by the generated code, so the handler is here
+void DTS_IRQHandler(void) {
+    HAL_DTS_IRQHandler(&hdts);
+}
+
+void dts_sampler_stm32_hw_init(dts_sampler_hw *hw) {
+    hw->context = NULL;
+    hw->start = stm32_start;
+    hw->trigger = stm32_trigger;
+}
+
+#endif // APP_DTS_SAMPLER
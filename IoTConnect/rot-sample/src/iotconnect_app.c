@@ -5,21 +5,71 @@
 
 #include "iotconnect_app_config.h"
 
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include "nx_api.h"
 #include "nxd_dns.h"
 #include "iotconnect_certs.h"
 #include "iotconnect_common.h"
 #include "iotconnect.h"
-#include "azrtos_ota_fw_client.h"
 #include "iotc_auth_driver.h"
 #include "sw_auth_driver.h"
 #include "std_component.h"
 #include "metadata.h"
+#include "app_platform.h"
 #include "stm32_psa_auth_driver.h"
+#include "telemetry_writer.h"
+#include "telemetry_batch.h"
+#include "sample_ring.h"
+#include "telemetry_journal.h"
+#include "connection_supervisor.h"
+#include "auth_profiler.h"
+#include "command_dispatcher.h"
+#include "scratch_arena.h"
+#include "system_health.h"
+#include "boot_phases.h"
+#include "dns_cache.h"
+#include "dts_sampler.h"
+#include "telemetry_aggregator.h"
+#include "ota_download.h"
+#include "ota_download_nx.h"
+#if APP_HASH_BENCH
+#include "psa/crypto.h"
+#endif
 
 static STD_COMPONENT std_comp;
 static IotConnectAzrtosConfig azrtos_config;
 static IotcAuthInterfaceContext auth_driver_context = NULL;
+static TX_THREAD sampler_thread;
+static ULONG sampler_thread_stack[APP_SAMPLER_THREAD_STACK_SIZE / sizeof(ULONG)];
+static sample_ring samples;
+static telemetry_journal journal;
+static telemetry_journal_storage journal_storage;
+static uint8_t journal_write_buffer[APP_JOURNAL_BLOCK_SIZE];
+static uint8_t journal_read_buffer[APP_JOURNAL_BLOCK_SIZE];
+static command_dispatcher commands;
+static ULONG command_thread_stack[APP_COMMAND_THREAD_STACK_SIZE / sizeof(ULONG)];
+static scratch_arena event_arena; // strings of the OTA or command event being handled
+static uint8_t event_arena_buffer[APP_EVENT_ARENA_SIZE];
+static system_health_sampler health_sampler;
+static TX_THREAD discovery_lookup_thread;
+static ULONG discovery_lookup_stack[APP_DISCOVERY_LOOKUP_STACK_SIZE / sizeof(ULONG)];
+static volatile bool discovery_prefetched = false; // the lookup thread resolved the discovery host
+static dns_cache host_cache;
+static dns_cache_storage host_cache_storage;
+static dns_cache_nx_resolver host_resolver;
+static ULONG dns_refresh_stack[APP_DNS_REFRESH_THREAD_STACK_SIZE / sizeof(ULONG)];
+#if APP_DTS_SAMPLER
+static dts_sampler dts;
+static dts_sampler_hw dts_hw;
+#endif
+static telemetry_aggregator aggregator;
+static ota_download_nx_transport ota_connection;
+static uint8_t ota_buffer[APP_OTA_BUFFER_SIZE];
+static volatile telemetry_format telemetry_message_format = APP_TELEMETRY_FORMAT; // applied between messages
 
 // provided by nx_azure_iot_adu_agent__ns_driver.c:
 extern void nx_azure_iot_adu_agent_ns_driver(NX_AZURE_IOT_ADU_AGENT_DRIVER *driver_req_ptr);
@@ -27,101 +77,48 @@ extern void nx_azure_iot_adu_agent_ns_driver(NX_AZURE_IOT_ADU_AGENT_DRIVER *driv
 #define APP_VERSION "1.1.0"
 #define std_component_name "std_comp"
 
-static bool download_event_handler(IotConnectDownloadEvent* event) {
-    switch (event->type) {
-    case IOTC_DL_STATUS:
-        if (event->status == NX_SUCCESS) {
-            printf("Download success\r\n");
-        } else {
-            printf("Download failed with code 0x%x\r\n", event->status);
-        }
-        break;
-    case IOTC_DL_FILE_SIZE:
-        printf("Download file size is %i\r\n", event->file_size);
-        break;
-    case IOTC_DL_DATA:
-        printf("%i%%\r\n", (event->data.offset + event->data.data_size) * 100 / event->data.file_size);
-        break;
-    default:
-        printf("Unknown event type %d received from download client!\r\n", event->type);
-        break;
-    }
-    return true;
-}
-
-// Parses the URL into host and resource strings which will be malloced
-// Ensure to free the two pointers on success
-static UINT split_url(const char *url, char **host_name, char**resource) {
-    int host_name_start = 0;
-    size_t url_len = strlen(url);
-
-    if (!host_name || !resource) {
-        printf("split_url: Invalid usage\r\n");
-        return NX_INVALID_PARAMETERS;
+// Moves a string cloned by the SDK into the event arena, so that its heap block is released right away
+// instead of staying allocated while the event is handled.
+static char *arena_clone(char *cloned) {
+    if (NULL == cloned) {
+        return NULL;
     }
-    *host_name = NULL;
-    *resource = NULL;
-    int slash_count = 0;
-    for (size_t i = 0; i < url_len; i++) {
-        if (url[i] == '/') {
-            slash_count++;
-            if (slash_count == 2) {
-                host_name_start = i + 1;
-            } else if (slash_count == 3) {
-                const size_t slash_start = i;
-                const size_t host_name_len = i - host_name_start;
-                const size_t resource_len = url_len - i;
-                *host_name = malloc(host_name_len + 1); //+1 for null
-                if (NULL == *host_name) {
-                    return NX_POOL_ERROR;
-                }
-                memcpy(*host_name, &url[host_name_start], host_name_len);
-                (*host_name)[host_name_len] = 0; // terminate the string
-
-                *resource = malloc(resource_len + 1); //+1 for null
-                if (NULL == *resource) {
-                    free(*host_name);
-                    return NX_POOL_ERROR;
-                }
-                memcpy(*resource, &url[slash_start], resource_len);
-                (*resource)[resource_len] = 0; // terminate the string
-
-                return NX_SUCCESS;
-            }
-        }
+    char *copy = scratch_arena_strndup(&event_arena, cloned, strlen(cloned));
+    if (NULL == copy) {
+        printf("Event data does not fit into the %u byte event arena\r\n", (unsigned int) APP_EVENT_ARENA_SIZE);
     }
-    return NX_INVALID_PARAMETERS; // URL could not be parsed
+    free(cloned);
+    return copy;
 }
 
-// Parses the URL into host and path strings.
-// It re-uses the URL storage by splitting it into two null-terminated strings.
+// Downloads the firmware at the URL into the firmware driver and installs it
 static UINT start_ota(char *url) {
-    IotConnectHttpRequest req = { 0 };
-
-    UINT status = split_url(url, &req.host_name, &req.resource);
-    if (status) {
-        printf("start_ota: Error while splitting the URL, code: 0x%x\r\n", status);
-        return status;
+    char *host_name;
+    char *resource;
+    if (ota_download_split_url(&event_arena, url, &host_name, &resource)) {
+        printf("start_ota: Error while splitting the URL\r\n");
+        return NX_INVALID_PARAMETERS;
     }
 
-    req.azrtos_config = &azrtos_config;
     // URLs should come in with blob.core.windows.net and similar so Digicert cert should work for all
-    req.tls_cert = (unsigned char*) IOTCONNECT_DIGICERT_GLOBAL_ROOT_G2;
-    req.tls_cert_len = IOTCONNECT_DIGICERT_GLOBAL_ROOT_G2_SIZE;
-
-    status = iotc_ota_fw_download(
-            &req,
-			nx_azure_iot_adu_agent_ns_driver,
-            false,
-            download_event_handler);
-    if (status) {
-        printf("OTA Failed with code 0x%x\r\n", status);
-    } else {
-        printf("OTA Download Success\r\n");
+    ota_download_transport transport;
+    ota_download_nx_transport_init(&transport, &ota_connection, azrtos_config.ip_ptr, azrtos_config.pool_ptr,
+            azrtos_config.dns_ptr, host_name, resource, (const unsigned char*) IOTCONNECT_DIGICERT_GLOBAL_ROOT_G2,
+            IOTCONNECT_DIGICERT_GLOBAL_ROOT_G2_SIZE, APP_OTA_TIMEOUT_MS * NX_IP_PERIODIC_RATE / 1000);
+
+    // IoTConnect does not send a digest of the file, so the driver cannot check the download against one.
+    // This works with IOTC_IGNORE_FW_DOWNLOAD_SHA256_DIGEST, which the Debug configuration of the project defines.
+    // Without it, the driver needs the digest and refuses the update. The image is verified at the next boot.
+    ota_download_stats stats;
+    const int result = ota_download(&transport, nx_azure_iot_adu_agent_ns_driver, NULL, ota_buffer,
+            sizeof(ota_buffer), APP_OTA_DOWNLOAD_ATTEMPTS, APP_OTA_RETRY_DELAY_MS, &stats);
+    if (result) {
+        printf("OTA Failed with code %d after %lu attempts\r\n", result, (unsigned long) stats.attempts);
+        return NX_NOT_SUCCESSFUL;
     }
-    free(req.host_name);
-    free(req.resource);
-    return status;
+    printf("OTA Download Success: %llu bytes received in %lu attempts, %lu resumed\r\n",
+            (unsigned long long) stats.bytes_received, (unsigned long) stats.attempts, (unsigned long) stats.resumes);
+    return NX_SUCCESS;
 }
 
 static bool is_app_version_same_as_ota(const char *version) {
@@ -135,11 +132,12 @@ static bool app_needs_ota_update(const char *version) {
 static void on_ota(IotclEventData data) {
     const char *message = NULL;
     bool needs_ota_commit = false;
-    char *url = iotcl_clone_download_url(data, 0);
+    scratch_arena_reset(&event_arena);
+    char *url = arena_clone(iotcl_clone_download_url(data, 0));
     bool success = false;
     if (NULL != url) {
         printf("Download URL is: %s\r\n", url);
-        const char *version = iotcl_clone_sw_version(data);
+        const char *version = arena_clone(iotcl_clone_sw_version(data));
         if (!version) {
             printf("Failed to clone SW version! Out of memory?");
             message = "Failed to clone SW version";
@@ -166,18 +164,14 @@ static void on_ota(IotclEventData data) {
             success = false;
             message = "Device firmware version is newer";
         }
-
-        free((void*) url);
-        free((void*) version);
     } else {
         // compatibility with older events
         // This app does not support FOTA with older back ends, but the user can add the functionality
-        const char *command = iotcl_clone_command(data);
+        const char *command = arena_clone(iotcl_clone_command(data));
         if (NULL != command) {
             // URL will be inside the command
             printf("Command is: %s\r\n", command);
             message = "Old back end URLS are not supported by the app";
-            free((void*) command);
         }
     }
     const char *ack = iotcl_create_ack_string_and_destroy_event(data, success, message);
@@ -186,32 +180,204 @@ static void on_ota(IotclEventData data) {
         iotconnect_sdk_send_packet(ack);
         free((void*) ack);
     }
+    scratch_arena_reset(&event_arena);
     if (needs_ota_commit) {
         printf("Waiting for ack to be sent by the network\r\n.,,");
         tx_thread_sleep(5 * NX_IP_PERIODIC_RATE);
-        UINT status = iotc_ota_fw_apply();
-        if (status) {
-            printf("Failed to apply firmware! Error was: %d\r\n", status);
+        if (ota_download_apply(nx_azure_iot_adu_agent_ns_driver)) {
+            printf("Failed to apply firmware!\r\n");
         }
     }
 }
 
-static void command_status(IotclEventData data, bool status, const char *command_name, const char *message) {
-    const char *ack = iotcl_create_ack_string_and_destroy_event(data, status, message);
+static void command_status(void *event, bool status, const char *command_name, const char *message) {
+    const char *ack = iotcl_create_ack_string_and_destroy_event((IotclEventData) event, status, message);
     printf("command: %s status=%s: %s\r\n", command_name, status ? "OK" : "Failed", message);
     printf("Sent CMD ack: %s\r\n", ack);
     iotconnect_sdk_send_packet(ack);
     free((void*) ack);
 }
 
+#if APP_AUTH_PROFILER
+static bool on_auth_profile_command(int argc, const char *argv[], char *message, size_t message_size) {
+    auth_profiler_print();
+    snprintf(message, message_size, "Printed to the console");
+    return true;
+}
+
+static bool on_auth_bench_cn_command(int argc, const char *argv[], char *message, size_t message_size) {
+    bool ok = NULL != auth_driver_context && 0 == stm32_psa_benchmark_extract_cn(auth_driver_context, 100);
+    snprintf(message, message_size, ok ? "Printed to the console" : "Failed");
+    return ok;
+}
+#endif
+
+#if APP_HASH_BENCH
+#define HASH_BENCH_BYTES (64 * 1024)
+
+// Times psa_hash_update() of SHA-256 over 64 KB for each block size, as the OTA driver hashes each write
+static bool on_hash_bench_command(int argc, const char *argv[], char *message, size_t message_size) {
+    static uint8_t data[4096];
+    static const uint32_t block_sizes[] = {64, 256, 1024, 4096};
+    const uint32_t cycles_per_us = app_platform_cycles_per_us() ? app_platform_cycles_per_us() : 1;
+    for (size_t i = 0; i < sizeof(block_sizes) / sizeof(block_sizes[0]); i++) {
+        psa_hash_operation_t operation = PSA_HASH_OPERATION_INIT;
+        uint8_t digest[PSA_HASH_LENGTH(PSA_ALG_SHA_256)];
+        size_t digest_length;
+        const uint32_t calls = HASH_BENCH_BYTES / block_sizes[i];
+        const uint32_t start = app_platform_cycles();
+        psa_status_t status = psa_hash_setup(&operation, PSA_ALG_SHA_256);
+        for (uint32_t call = 0; PSA_SUCCESS == status && call < calls; call++) {
+            status = psa_hash_update(&operation, data, block_sizes[i]);
+        }
+        if (PSA_SUCCESS == status) {
+            status = psa_hash_finish(&operation, digest, sizeof(digest), &digest_length);
+        }
+        const uint32_t us = (app_platform_cycles() - start) / cycles_per_us + 1;
+        if (PSA_SUCCESS != status) {
+            psa_hash_abort(&operation);
+            snprintf(message, message_size, "Hash failed with %ld", (long) status);
+            return false;
+        }
+        printf("hash-bench: %4lu B blocks: %lu us per update, %lu KB/s\r\n", (unsigned long) block_sizes[i],
+                (unsigned long) (us / calls), (unsigned long) ((uint64_t) HASH_BENCH_BYTES * 1000000 / 1024 / us));
+    }
+    snprintf(message, message_size, "Printed to the console");
+    return true;
+}
+#endif
+
+static bool on_health_command(int argc, const char *argv[], char *message, size_t message_size) {
+    system_health health;
+    system_health_sample(&health_sampler, &health);
+    system_health_print(&health);
+    snprintf(message, message_size, "Heap free %lu, largest %lu. Packets free %lu of %lu",
+            (unsigned long) health.heap_free, (unsigned long) health.heap_largest_free,
+            (unsigned long) health.packets_free, (unsigned long) health.packets_total);
+    return true;
+}
+
+#if APP_DTS_SAMPLER
+static bool on_dts_command(int argc, const char *argv[], char *message, size_t message_size) {
+    dts_sampler_stats stats;
+    dts_sampler_get_stats(&dts, &stats);
+    dts_sampler_print(&dts);
+    snprintf(message, message_size, "Last %ld, mean %ld, min %ld, max %ld mC", (long) stats.last, (long) stats.mean,
+            (long) stats.min, (long) stats.max);
+    return true;
+}
+#endif
+
+// "aggregate" prints the aggregation, "aggregate window <seconds>" changes the window, 0 to report every sample,
+// and "aggregate deadband <field> <value>" the deadband of a field
+static bool on_aggregate_command(int argc, const char *argv[], char *message, size_t message_size) {
+    if (argc == 3 && 0 == strcmp(argv[1], "window")) {
+        char *end;
+        const unsigned long window_s = strtoul(argv[2], &end, 10);
+        if (end == argv[2] || *end) {
+            snprintf(message, message_size, "Invalid window");
+            return false;
+        }
+        telemetry_aggregator_set_window(&aggregator, (uint32_t) window_s);
+        snprintf(message, message_size, "Window %lu s from the next window", window_s);
+        return true;
+    }
+    if (argc == 4 && 0 == strcmp(argv[1], "deadband")) {
+        char *end;
+        const double deadband = strtod(argv[3], &end);
+        if (end == argv[3] || *end || deadband < 0) {
+            snprintf(message, message_size, "Invalid deadband");
+            return false;
+        }
+        if (telemetry_aggregator_set_deadband(&aggregator, argv[2], deadband)) {
+            snprintf(message, message_size, "No field %s", argv[2]);
+            return false;
+        }
+        snprintf(message, message_size, "Deadband of %s %g", argv[2], deadband);
+        return true;
+    }
+    if (argc > 1) {
+        snprintf(message, message_size, "Usage: aggregate [window <seconds> | deadband <field> <value>]");
+        return false;
+    }
+    telemetry_aggregator_print(&aggregator);
+    snprintf(message, message_size, "Printed to the console");
+    return true;
+}
+
+#if APP_TELEMETRY_CBOR_BACKEND
+// "telemetry-format" prints the format of the telemetry messages, "telemetry-format json|cbor" changes it
+static bool on_telemetry_format_command(int argc, const char *argv[], char *message, size_t message_size) {
+    if (argc > 1) {
+        if (0 == strcmp(argv[1], "json")) {
+            telemetry_message_format = TELEMETRY_FORMAT_JSON;
+        } else if (0 == strcmp(argv[1], "cbor")) {
+            telemetry_message_format = TELEMETRY_FORMAT_CBOR;
+        } else {
+            snprintf(message, message_size, "Usage: telemetry-format [json|cbor]");
+            return false;
+        }
+    }
+    snprintf(message, message_size, "Telemetry format %s",
+            TELEMETRY_FORMAT_CBOR == telemetry_message_format ? "cbor" : "json");
+    return true;
+}
+#endif
+
+static bool on_dns_cache_command(int argc, const char *argv[], char *message, size_t message_size) {
+    dns_cache_print(&host_cache);
+    snprintf(message, message_size, "Printed to the console");
+    return true;
+}
+
+// Runs on the SDK polling thread, so the handlers are run by the command worker
 static void on_command(IotclEventData data) {
-    char *command = iotcl_clone_command(data);
+    scratch_arena_reset(&event_arena);
+    char *command = arena_clone(iotcl_clone_command(data));
     if (NULL != command) {
-		command_status(data, false, command, "Not implemented");
-        free((void*) command);
+        if (0 == strcmp(command, "command-bench")) {
+            // measured from this thread, which is the one that the dispatcher must not hold up
+            command_dispatcher_benchmark(&commands, 1000);
+            command_status(data, true, command, "Printed to the console");
+        } else {
+            command_dispatcher_submit(&commands, data, command);
+        }
     } else {
         command_status(data, false, "?", "Internal error");
     }
+    scratch_arena_reset(&event_arena);
+}
+
+static UINT start_command_dispatcher(void) {
+    static bool started = false;
+    if (started) {
+        return TX_SUCCESS;
+    }
+    UINT status = command_dispatcher_init(&commands, command_status, command_thread_stack,
+            sizeof(command_thread_stack), APP_COMMAND_THREAD_PRIORITY);
+    if (TX_SUCCESS != status) {
+        return status;
+    }
+    // Register the handlers of your commands here.
+    // Pass COMMAND_FLAG_ACK_ON_ACCEPT for commands that take longer than the cloud waits for the ack.
+    command_dispatcher_register(&commands, "health", on_health_command, 0);
+    command_dispatcher_register(&commands, "dns-cache", on_dns_cache_command, 0);
+    command_dispatcher_register(&commands, "aggregate", on_aggregate_command, 0);
+#if APP_TELEMETRY_CBOR_BACKEND
+    command_dispatcher_register(&commands, "telemetry-format", on_telemetry_format_command, 0);
+#endif
+#if APP_DTS_SAMPLER
+    command_dispatcher_register(&commands, "dts", on_dts_command, 0);
+#endif
+#if APP_AUTH_PROFILER
+    command_dispatcher_register(&commands, "auth-profile", on_auth_profile_command, 0);
+    command_dispatcher_register(&commands, "auth-bench-cn", on_auth_bench_cn_command, 0);
+#endif
+#if APP_HASH_BENCH
+    command_dispatcher_register(&commands, "hash-bench", on_hash_bench_command, 0);
+#endif
+    started = true;
+    return TX_SUCCESS;
 }
 
 static void on_connection_status(IotConnectConnectionStatus status) {
@@ -227,36 +393,375 @@ static void on_connection_status(IotConnectConnectionStatus status) {
         printf("IoTConnect Client ERROR\r\n");
         break;
     }
-    if (NULL != auth_driver_context) {
-    	stm32_psa_release_auth_driver(auth_driver_context);
-    	auth_driver_context = NULL;
+}
+
+static void read_sample(telemetry_sample *sample) {
+    memset(sample, 0, sizeof(*sample));
+    sample->timestamp = time(NULL);
+
+#if APP_DTS_SAMPLER
+    // the DTS is sampled in the background, so this does not wait for a measurement
+    dts_sampler_stats stats;
+    dts_sampler_get_stats(&dts, &stats);
+    if (stats.count > 0) {
+        sample->temperature = stats.mean / 1000.0;
+        sample->button_counter = std_comp.ButtonCounter;
+        sample->has_sensor_values = true;
+    } else {
+        printf("No temperature readings yet\r\n");
     }
+#else
+    UINT status;
+    if ((status = std_component_read_sensor_values(&std_comp)) == NX_AZURE_IOT_SUCCESS) {
+        sample->temperature = std_comp.Temperature;
+        // note the hook into app_azure_iot.c for button interrupt handler
+        sample->button_counter = std_comp.ButtonCounter;
+        sample->has_sensor_values = true;
+    } else {
+    	printf("Failed to read sensor values, error: %u\r\n", status);
+    }
+#endif
 }
 
-static void publish_telemetry() {
-    IotclMessageHandle msg = iotcl_telemetry_create();
+#if !APP_DTS_SAMPLER && APP_TEMPERATURE_DEADBAND_MC > 0
+#error "APP_TEMPERATURE_DEADBAND_MC needs APP_DTS_SAMPLER"
+#endif
+
+#if APP_DTS_SAMPLER && APP_TEMPERATURE_DEADBAND_MC > 0
+// Reports a sample if the temperature moved by the deadband or the button was pushed since the last report,
+// or if the heartbeat is due
+static bool is_reportable(const telemetry_sample *sample) {
+    static bool reported = false;
+    static uint32_t button_counter;
+    static uint32_t report_time_ms;
+    const uint32_t now_ms = app_platform_time_ms();
+    const int32_t temperature = (int32_t) lround(sample->temperature * 1000);
+    if (reported && sample->button_counter == button_counter
+            && (uint32_t) (now_ms - report_time_ms) < APP_TELEMETRY_HEARTBEAT_MS
+            && !(sample->has_sensor_values && dts_sampler_exceeds_deadband(&dts, temperature))) {
+        return false;
+    }
+    if (sample->has_sensor_values) {
+        dts_sampler_set_reported(&dts, temperature);
+    }
+    reported = true;
+    button_counter = sample->button_counter;
+    report_time_ms = now_ms;
+    return true;
+}
 
-    // Optional. The first time you create a data point, the current timestamp will be automatically added
-    // TelemetryAddWith* calls are only required if sending multiple data points in one packet.
-    iotcl_telemetry_add_with_iso_time(msg, iotcl_iso_timestamp_now());
-    iotcl_telemetry_set_string(msg, "version", APP_VERSION);
+// Returns true if a temperature change woke it up before the delay
+static bool wait_for_sample(uint32_t delay_ms) {
+    return dts_sampler_wait_change(&dts, (ULONG) (((uint64_t) delay_ms * TX_TIMER_TICKS_PER_SECOND + 999) / 1000));
+}
+#else
+static bool is_reportable(const telemetry_sample *sample) {
+    (void) sample;
+    return true;
+}
 
-    UINT status;
-    if ((status = std_component_read_sensor_values(&std_comp)) == NX_AZURE_IOT_SUCCESS) {
-    	iotcl_telemetry_set_number(msg, "temperature", std_comp.Temperature);
+static bool wait_for_sample(uint32_t delay_ms) {
+    app_platform_sleep_ms(delay_ms);
+    return false;
+}
+#endif
 
-    	// note the hook into app_azure_iot.c for button interrupt handler
-    	iotcl_telemetry_set_number(msg, "button_counter", std_comp.ButtonCounter);
+#if APP_HEALTH_TELEMETRY
+static void write_health(telemetry_writer *w, const void *context) {
+    system_health_write(w, (const system_health *) context);
+}
 
+// Adds a health data point to the batch once every APP_HEALTH_INTERVAL_MS
+static void add_health(telemetry_batch *batch) {
+    static system_health health;
+    static bool reported = false;
+    static uint32_t report_time_ms;
+    const uint32_t now_ms = app_platform_time_ms();
+    if (0 == telemetry_batch_count(batch)
+            || (reported && (uint32_t) (now_ms - report_time_ms) < APP_HEALTH_INTERVAL_MS)) {
+        return;
+    }
+    system_health_sample(&health_sampler, &health);
+    if (!telemetry_batch_add_datapoint(batch, write_health, &health)) {
+        printf("Health data does not fit into the telemetry message. Sending it with the next one.\r\n");
+        return;
+    }
+    reported = true;
+    report_time_ms = now_ms;
+}
+#endif
+
+static void publish_telemetry(telemetry_batch *batch) {
+#if APP_HEALTH_TELEMETRY
+    add_health(batch);
+#endif
+    const char *str = telemetry_batch_finish(batch);
+    if (NULL == str) {
+        printf("Telemetry message does not fit into %u bytes\r\n", (unsigned int) APP_TELEMETRY_BATCH_MAX_BYTES);
     } else {
-    	printf("Failed to read sensor values, error: %u\r\n", status);
+        printf("Sending %u sample(s): %s\r\n", (unsigned int) telemetry_batch_count(batch), str);
+        iotconnect_sdk_send_packet(str); // underlying code will report an error
+        if (!boot_phases_reached(BOOT_PHASE_FIRST_PUBLISH)) {
+            boot_phases_mark(BOOT_PHASE_FIRST_PUBLISH);
+            boot_phases_print();
+        }
+    }
+    telemetry_batch_set_format(batch, telemetry_message_format);
+    telemetry_batch_reset(batch);
+}
+
+static void sampler_thread_entry(ULONG parameter) {
+    (void) parameter;
+    uint32_t next_sample_time = app_platform_time_ms();
+    while (true) {
+        telemetry_sample sample;
+        read_sample(&sample);
+        if (is_reportable(&sample) && !sample_ring_push(&samples, &sample)) {
+            printf("Sample queue is full. Dropped %lu sample(s) so far\r\n", (unsigned long) sample_ring_dropped(&samples));
+        }
+        // keep the cadence regardless of how long reading the sensors took
+        next_sample_time += APP_TELEMETRY_SAMPLE_INTERVAL_MS;
+        uint32_t now = app_platform_time_ms();
+        if ((int32_t) (next_sample_time - now) > 0) {
+            if (wait_for_sample(next_sample_time - now)) {
+                next_sample_time = app_platform_time_ms(); // sample the change now, and keep the cadence from here
+            }
+        } else {
+            next_sample_time = now; // we fell behind. Don't try to catch up with a burst.
+        }
+    }
+}
+
+static UINT start_sampler(void) {
+    static bool started = false;
+    if (started) {
+        return TX_SUCCESS;
+    }
+    sample_ring_init(&samples);
+    UINT status = tx_thread_create(&sampler_thread, "Telemetry Sampler", sampler_thread_entry, 0,
+            sampler_thread_stack, sizeof(sampler_thread_stack),
+            APP_SAMPLER_THREAD_PRIORITY, APP_SAMPLER_THREAD_PRIORITY,
+            TX_NO_TIME_SLICE, TX_AUTO_START);
+    if (TX_SUCCESS == status) {
+        started = true;
+    }
+    return status;
+}
+
+#if APP_DTS_SAMPLER
+static bool start_dts_sampler(void) {
+    static bool started = false;
+    if (started) {
+        return true;
+    }
+    dts_sampler_stm32_hw_init(&dts_hw);
+    if (dts_sampler_start(&dts, &dts_hw, APP_DTS_SAMPLE_RATE_HZ, APP_TEMPERATURE_DEADBAND_MC)) {
+        return false;
+    }
+    started = true;
+    return true;
+}
+#endif
+
+static bool start_aggregator(void) {
+    static bool started = false;
+    if (started) {
+        return true;
+    }
+    // in the order of the values in add_sample()
+    if (telemetry_aggregator_init(&aggregator, APP_AGGREGATION_WINDOW_S, APP_AGGREGATION_HEARTBEAT_WINDOWS)
+            || telemetry_aggregator_add_field(&aggregator, "temperature", APP_AGGREGATION_TEMPERATURE_DEADBAND) < 0
+            || telemetry_aggregator_add_field(&aggregator, "button_counter", APP_AGGREGATION_BUTTON_DEADBAND) < 0) {
+        return false;
+    }
+    started = true;
+    return true;
+}
+
+struct aggregate_record {
+    const char *version;
+    const telemetry_aggregate *aggregate;
+};
+
+static void write_aggregate(telemetry_writer *w, const void *context) {
+    const struct aggregate_record *record = (const struct aggregate_record *) context;
+    telemetry_writer_begin_datapoint(w, record->aggregate->start);
+    telemetry_writer_add_string(w, "version", record->version);
+    telemetry_aggregator_write_fields(w, record->aggregate);
+    telemetry_writer_end_datapoint(w);
+}
+
+static void add_aggregate(telemetry_batch *batch, const telemetry_aggregate *aggregate) {
+    const struct aggregate_record record = {APP_VERSION, aggregate};
+    if (!telemetry_batch_add_record(batch, aggregate->start, write_aggregate, &record, app_platform_time_ms())) {
+        publish_telemetry(batch);
+        telemetry_batch_add_record(batch, aggregate->start, write_aggregate, &record, app_platform_time_ms());
+    }
+}
+
+static void add_sample(telemetry_batch *batch, const telemetry_sample *sample) {
+    // with the aggregation enabled, only the windows are reported
+    telemetry_aggregate aggregate;
+    bool report = false;
+    bool aggregated = false;
+    if (sample->has_sensor_values) {
+        const double values[] = {sample->temperature, sample->button_counter};
+        aggregated = telemetry_aggregator_add(&aggregator, sample->timestamp, values, &aggregate, &report);
+    }
+    if (report) {
+        add_aggregate(batch, &aggregate);
+    }
+    if (aggregated) {
+        return;
+    }
+    if (!telemetry_batch_add(batch, sample, app_platform_time_ms())) {
+        // byte budget reached. Send what we have and start a new batch with this sample
+        publish_telemetry(batch);
+        telemetry_batch_add(batch, sample, app_platform_time_ms());
+    }
+}
+
+static void publish_samples(telemetry_batch *batch) {
+    telemetry_sample sample;
+    if (0 == telemetry_journal_pending(&journal)) {
+        while (sample_ring_pop(&samples, &sample)) {
+            add_sample(batch, &sample);
+            if (telemetry_batch_is_due(batch, app_platform_time_ms())) {
+                publish_telemetry(batch);
+            }
+        }
+        // a window also closes when no further sample comes
+        telemetry_aggregate aggregate;
+        if (telemetry_aggregator_poll(&aggregator, time(NULL), &aggregate)) {
+            add_aggregate(batch, &aggregate);
+        }
+        return;
     }
 
-    const char *str = iotcl_create_serialized_string(msg, false);
-    iotcl_telemetry_destroy(msg);
-    printf("Sending: %s\r\n", str);
-    iotconnect_sdk_send_packet(str); // underlying code will report an error
-    iotcl_destroy_serialized(str);
+    // Replaying the backlog. New samples queue up behind it to keep the order.
+    while (sample_ring_pop(&samples, &sample)) {
+        telemetry_journal_append(&journal, &sample);
+    }
+    for (int i = 0; i < APP_JOURNAL_REPLAY_BATCH && telemetry_journal_read(&journal, &sample); i++) {
+        add_sample(batch, &sample);
+    }
+    if (telemetry_batch_count(batch) > 0) {
+        publish_telemetry(batch);
+    }
+    if (0 == telemetry_journal_pending(&journal)) {
+        printf("Journal backlog sent\r\n");
+    }
+}
+
+// Stores the samples to the journal while there is no connection
+static void journal_samples(uint32_t duration_ms) {
+    static unsigned int unsynced = 0;
+    const uint32_t start = app_platform_time_ms();
+    do {
+        telemetry_sample sample;
+        while (sample_ring_pop(&samples, &sample)) {
+            telemetry_journal_append(&journal, &sample);
+            unsynced++;
+        }
+        if (unsynced >= APP_JOURNAL_SYNC_SAMPLES) {
+            telemetry_journal_sync(&journal);
+            unsynced = 0;
+        }
+        app_platform_sleep_ms(APP_TELEMETRY_PUBLISH_POLL_MS);
+    } while ((uint32_t) (app_platform_time_ms() - start) < duration_ms);
+    telemetry_journal_sync(&journal);
+    unsynced = 0;
+}
+
+// Resolves the cloud host name before connecting, to tell a local network or DNS problem from a cloud one.
+// A cached answer counts, even an expired one, so a DNS outage alone does not hold up the connection.
+static bool is_network_up(void) {
+    uint32_t address = 0;
+    int status = dns_cache_lookup(&host_cache, APP_DISCOVERY_HOST_NAME, &address);
+    if (status) {
+        printf("Unable to resolve %s. Error: %d\r\n", APP_DISCOVERY_HOST_NAME, status);
+        return false;
+    }
+    return true;
+}
+
+static bool start_dns_cache(void) {
+    static bool started = false;
+    if (started) {
+        return true;
+    }
+    host_resolver.ip = azrtos_config.ip_ptr;
+    host_resolver.pool = azrtos_config.pool_ptr;
+    host_resolver.dns = azrtos_config.dns_ptr;
+    host_resolver.timeout_ticks = APP_DNS_TIMEOUT_MS * NX_IP_PERIODIC_RATE / 1000;
+    dns_cache_its_storage_init(&host_cache_storage);
+    if (dns_cache_init(&host_cache, &host_cache_storage, dns_cache_nx_resolve, &host_resolver,
+            APP_DNS_CACHE_MAX_STALE_S)) {
+        return false;
+    }
+    if (dns_cache_start_refresh(&host_cache, dns_refresh_stack, sizeof(dns_refresh_stack),
+            APP_DNS_REFRESH_THREAD_PRIORITY)) {
+        return false;
+    }
+#ifdef DNS_CACHE_WRAP_NETX
+    dns_cache_nx_route_lookups(&host_cache);
+#endif
+    started = true;
+    return true;
+}
+
+static void discovery_lookup_entry(ULONG parameter) {
+    (void) parameter;
+    discovery_prefetched = is_network_up();
+    boot_phases_mark(BOOT_PHASE_DISCOVERY_LOOKUP);
+}
+
+// Resolves the discovery host while the rest of the startup runs, at a priority above the calling thread,
+// so that the query goes out right away. The DNS client serializes it with the lookup of the SNTP server.
+static UINT start_discovery_lookup(void) {
+    UINT priority;
+    UINT status = tx_thread_info_get(tx_thread_identify(), TX_NULL, TX_NULL, TX_NULL, &priority, TX_NULL, TX_NULL,
+            TX_NULL, TX_NULL);
+    if (TX_SUCCESS != status) {
+        return status;
+    }
+    if (priority > 0) {
+        priority--;
+    }
+    return tx_thread_create(&discovery_lookup_thread, "Discovery Lookup", discovery_lookup_entry, 0,
+            discovery_lookup_stack, sizeof(discovery_lookup_stack), priority, priority, TX_NO_TIME_SLICE,
+            TX_AUTO_START);
+}
+
+static bool create_auth_driver(IotConnectClientConfig *config) {
+    struct stm32_psa_driver_parameters parameters = {0}; // dummy, for now
+    IotcDdimInterface ddim_interface;
+    IotcAuthInterfaceContext auth_context;
+    if(stm32_psa_create_auth_driver( //
+            &(config->auth.data.x509.auth_interface), //
+            &ddim_interface, //
+            &auth_context, //
+            &parameters)) { //
+        return false;
+    }
+    config->auth.data.x509.auth_interface_context = auth_context;
+
+    uint8_t* cert;
+    size_t cert_size;
+
+    config->auth.data.x509.auth_interface.get_cert(
+            auth_context, //
+            &cert, //
+            &cert_size //
+            );
+    if (0 == cert_size) {
+        printf("Unable to get the certificate from the driver.\r\n");
+        stm32_psa_release_auth_driver(auth_context);
+        return false;
+    }
+
+    auth_driver_context = auth_context;
+    return true;
 }
 
 
@@ -284,11 +789,36 @@ bool app_startup(NX_IP *ip_ptr, NX_PACKET_POOL *pool_ptr, NX_DNS *dns_ptr) {
     	return false;
     }
 
-	UINT status;
+    if (!start_dns_cache()) {
+        printf("Failed to start the DNS cache\r\n");
+        return false;
+    }
+
+    // The time sync runs on its own thread, started by App_Azure_IoT_Thread_Entry(). The discovery host lookup
+    // and the local initialization below run at the same time, and the connection starts once all are done.
+    UINT status;
+    if ((status = start_discovery_lookup())) {
+        printf("Failed to start the discovery host lookup: error code = 0x%08x\r\n", status);
+        boot_phases_mark(BOOT_PHASE_DISCOVERY_LOOKUP); // the first connect attempt resolves it
+    }
+
     if ((status = std_component_init(&std_comp, (UCHAR *)std_component_name,  sizeof(std_component_name) - 1))) {
         printf("Failed to initialize %s: error code = 0x%08x\r\n", std_component_name, status);
     }
 
+#if APP_DTS_SAMPLER
+    // started ahead of the sampler thread, so that the window fills while the time is synced
+    if (!start_dts_sampler()) {
+        printf("Failed to start the DTS sampler\r\n");
+        return false;
+    }
+#endif
+
+    scratch_arena_init(&event_arena, event_arena_buffer, sizeof(event_arena_buffer));
+    if (system_health_init(&health_sampler, system_health_find_heap(), pool_ptr)) {
+        printf("Failed to initialize the health sampler\r\n");
+        return false;
+    }
     config->cmd_cb = on_command;
     config->ota_cb = on_ota;
     config->status_cb = on_connection_status;
@@ -298,60 +828,102 @@ bool app_startup(NX_IP *ip_ptr, NX_PACKET_POOL *pool_ptr, NX_DNS *dns_ptr) {
 		config->auth.data.symmetric_key = md->symmetric_key;
     } else {
     	config->auth.type = IOTC_X509;
-
-        auth_driver_context = NULL;
-        struct stm32_psa_driver_parameters parameters = {0}; // dummy, for now
-        IotcDdimInterface ddim_interface;
-        IotcAuthInterfaceContext auth_context;
-        if(stm32_psa_create_auth_driver( //
-                &(config->auth.data.x509.auth_interface), //
-                &ddim_interface, //
-                &auth_context, //
-                &parameters)) { //
+        // The driver lives as long as the app. It keeps the cert store and the parsed certificates across
+        // reconnects, and the DDIM calls and the commands use it while connected.
+        if (!create_auth_driver(config)) {
             return false;
         }
-        config->auth.data.x509.auth_interface_context = auth_context;
-
-        uint8_t* cert;
-        size_t cert_size;
-
-        config->auth.data.x509.auth_interface.get_cert(
-                auth_context, //
-                &cert, //
-                &cert_size //
-                );
-        if (0 == cert_size) {
-            printf("Unable to get the certificate from the driver.\r\n");
-            stm32_psa_release_auth_driver(auth_context);
-            return false;
-        }
-
-        auth_driver_context = auth_context;
     }
 
     printf("CPID: %s\r\n", config->cpid);
     printf("ENV : %s\r\n", config->env);
     printf("DUID: %s\r\n", config->duid);
 
+    // The messages are formatted in place, so that publishing does not churn the heap
+    static char telemetry_buffer[APP_TELEMETRY_BUFFER_SIZE];
+    static telemetry_batch batch;
+    const telemetry_batch_policy policy = {
+            .max_samples = APP_TELEMETRY_BATCH_SIZE,
+            .max_age_ms = APP_TELEMETRY_BATCH_MAX_AGE_MS,
+            .max_bytes = APP_TELEMETRY_BATCH_MAX_BYTES
+    };
+    telemetry_batch_init(&batch, &policy, APP_VERSION, telemetry_buffer, sizeof(telemetry_buffer));
+    telemetry_batch_set_format(&batch, telemetry_message_format);
+    if (!start_aggregator()) {
+        printf("Failed to initialize the telemetry aggregator\r\n");
+        return false;
+    }
+
+    telemetry_journal_its_storage_init(&journal_storage, APP_JOURNAL_BLOCK_SIZE, APP_JOURNAL_BLOCK_COUNT);
+    if (telemetry_journal_init(&journal, &journal_storage, journal_write_buffer, journal_read_buffer)) {
+        printf("Failed to initialize the telemetry journal\r\n");
+        return false;
+    }
+
+    if ((status = start_command_dispatcher())) {
+        printf("Failed to start the command dispatcher: error code = 0x%08x\r\n", status);
+        return false;
+    }
+
+    boot_phases_mark(BOOT_PHASE_APP_READY);
+    boot_phases_wait(BOOT_PHASE_BIT(BOOT_PHASE_TIME_SYNCED) | BOOT_PHASE_BIT(BOOT_PHASE_DISCOVERY_LOOKUP),
+            TX_WAIT_FOREVER);
+
+    // samples need the synced time for their timestamps
+    if ((status = start_sampler())) {
+        printf("Failed to start the sampler thread: error code = 0x%08x\r\n", status);
+        return false;
+    }
+
+    // The IP instance, packet pool and DNS client stay up across reconnects. Only the SDK connection is redone.
+    const connection_backoff_policy backoff = {
+            .min_delay_ms = APP_RECONNECT_MIN_DELAY_MS,
+            .max_delay_ms = APP_RECONNECT_MAX_DELAY_MS,
+            .network_max_delay_ms = APP_RECONNECT_NETWORK_MAX_DELAY_MS,
+            .stable_ms = APP_RECONNECT_STABLE_MS
+    };
+    connection_supervisor supervisor;
+    connection_supervisor_init(&supervisor, &backoff,
+            connection_supervisor_seed(config->duid, app_platform_cycles() ^ app_platform_time_ms()));
+    uint32_t delay_ms;
+
     while (true) {
+        // the first check was done by the discovery lookup thread
+        const bool prefetched = discovery_prefetched;
+        discovery_prefetched = false;
+        if (!prefetched && !is_network_up()) {
+            delay_ms = connection_supervisor_on_failure(&supervisor, CONNECTION_STAGE_NETWORK);
+            printf("Network is not available. Retrying in %lu ms.\r\n", (unsigned long) delay_ms);
+            journal_samples(delay_ms);
+            continue;
+        }
+        // The connect time is dominated by the TLS handshake, and its client signature in the secure image
+        const uint32_t connect_start_ms = app_platform_time_ms();
         if (iotconnect_sdk_init(&azrtos_config)) {
-            printf("Unable to establish the IoTConnect connection.\r\n");
-            return false;
+            delay_ms = connection_supervisor_on_failure(&supervisor, CONNECTION_STAGE_CLOUD);
+            printf("Unable to establish the IoTConnect connection. Retrying in %lu ms.\r\n", (unsigned long) delay_ms);
+            journal_samples(delay_ms);
+            continue;
         }
-    	// if 1 msg every 5 seconds with total of 100 messages
-    	const int num_messages =  100;
-    	const int message_delay = 5000;
-
-        // send telemetry periodically
-        for (int i = 0; i < num_messages; i++) {
-            if (iotconnect_sdk_is_connected()) {
-                publish_telemetry();  // underlying code will report an error
-                iotconnect_sdk_poll(message_delay);
-            } else {
-                return false;
+        connection_supervisor_on_connected(&supervisor, app_platform_time_ms());
+        boot_phases_mark(BOOT_PHASE_CONNECTED);
+        printf("Connected in %lu ms\r\n", (unsigned long) (app_platform_time_ms() - connect_start_ms));
+#if APP_AUTH_PROFILER
+        auth_profiler_print();
+#endif
+
+        // drain the samples taken by the sampler thread into telemetry messages
+        while (iotconnect_sdk_is_connected()) {
+            publish_samples(&batch);
+            if (telemetry_batch_is_due(&batch, app_platform_time_ms())) {
+                publish_telemetry(&batch); // max age reached
             }
+            iotconnect_sdk_poll(APP_TELEMETRY_PUBLISH_POLL_MS);
+            command_dispatcher_process(&commands, TX_NO_WAIT); // acks of the completed commands
         }
+        delay_ms = connection_supervisor_on_disconnected(&supervisor, app_platform_time_ms());
+        printf("IoTConnect connection lost. Reconnecting in %lu ms.\r\n", (unsigned long) delay_ms);
+        journal_samples(delay_ms);
     }
-    printf("Done.\r\n");
-    return true;
+    return false;
 }
@@ -0,0 +1,168 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <string.h>
+#include "lzss_stream.h"
+
+enum {
+    STATE_HEADER,
+    STATE_TAG,       // 1: literal follows, 0: back reference follows
+    STATE_LITERAL,
+    STATE_INDEX,     // back reference distance - 1, window_bits wide
+    STATE_COUNT,     // back reference length - 1, lookahead_bits wide
+    STATE_DONE,
+    STATE_ERROR
+};
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint8_t field_bits(const lzss_stream *stream) {
+    switch (stream->state) {
+    case STATE_TAG:
+        return 1;
+    case STATE_LITERAL:
+        return 8;
+    case STATE_INDEX:
+        return stream->window_bits;
+    default:
+        return stream->lookahead_bits;
+    }
+}
+
+static int fail(lzss_stream *stream, int status) {
+    stream->state = STATE_ERROR;
+    return status;
+}
+
+static int flush(lzss_stream *stream) {
+    if (0 == stream->output_length) {
+        return 0;
+    }
+    int status = stream->write(stream->context, stream->output, stream->output_length);
+    stream->output_length = 0;
+    return status ? fail(stream, status) : 0;
+}
+
+static int emit(lzss_stream *stream, uint8_t byte) {
+    if (stream->produced == stream->size) {
+        return fail(stream, LZSS_STREAM_ERROR_FORMAT);
+    }
+    stream->window[stream->position++ & ((1u << stream->window_bits) - 1)] = byte;
+    stream->output[stream->output_length++] = byte;
+    stream->produced++;
+    if (stream->output_length == LZSS_STREAM_OUTPUT_SIZE) {
+        return flush(stream);
+    }
+    return 0;
+}
+
+static int parse_header(lzss_stream *stream) {
+    const uint8_t *h = stream->header;
+    stream->window_bits = h[4];
+    stream->lookahead_bits = h[5];
+    stream->size = get_u32(&h[8]);
+    if (get_u32(&h[0]) != LZSS_STREAM_MAGIC || stream->window_bits < 4 || stream->window_bits > LZSS_STREAM_MAX_WINDOW_BITS
+            || stream->lookahead_bits < 3 || stream->lookahead_bits >= stream->window_bits) {
+        return fail(stream, LZSS_STREAM_ERROR_FORMAT);
+    }
+    stream->state = (0 == stream->size) ? STATE_DONE : STATE_TAG;
+    return 0;
+}
+
+static int on_field(lzss_stream *stream, uint32_t value) {
+    int status = 0;
+    switch (stream->state) {
+    case STATE_TAG:
+        stream->state = value ? STATE_LITERAL : STATE_INDEX;
+        return 0;
+    case STATE_LITERAL:
+        status = emit(stream, (uint8_t) value);
+        break;
+    case STATE_INDEX:
+        stream->index = (uint16_t) (value + 1);
+        stream->state = STATE_COUNT;
+        return 0;
+    default: {
+        const uint32_t mask = (1u << stream->window_bits) - 1;
+        for (uint32_t i = 0; i <= value && 0 == status; i++) {
+            status = emit(stream, stream->window[(stream->position - stream->index) & mask]);
+        }
+        break;
+    }
+    }
+    if (status) {
+        return status;
+    }
+    stream->state = (stream->produced == stream->size) ? STATE_DONE : STATE_TAG;
+    return 0;
+}
+
+// Consumes the bits of the current input byte
+static int decode_bits(lzss_stream *stream) {
+    while (stream->current_bits > 0 && stream->state != STATE_DONE) {
+        const uint8_t needed = field_bits(stream) - stream->bit_count;
+        const uint8_t take = (needed < stream->current_bits) ? needed : stream->current_bits;
+        const uint32_t bits = (stream->current >> (stream->current_bits - take)) & ((1u << take) - 1);
+        stream->bits = (stream->bits << take) | bits;
+        stream->bit_count += take;
+        stream->current_bits -= take;
+        if (stream->bit_count == field_bits(stream)) {
+            const uint32_t value = stream->bits;
+            stream->bits = 0;
+            stream->bit_count = 0;
+            int status = on_field(stream, value);
+            if (status) {
+                return status;
+            }
+        }
+    }
+    // the rest of the last byte is padding
+    return 0;
+}
+
+void lzss_stream_init(lzss_stream *stream, lzss_stream_write_fn write, void *context) {
+    memset(stream, 0, sizeof(*stream));
+    stream->write = write;
+    stream->context = context;
+    stream->state = STATE_HEADER;
+}
+
+bool lzss_stream_is_compressed(const uint8_t *data, size_t size) {
+    return size >= 4 && get_u32(data) == LZSS_STREAM_MAGIC;
+}
+
+int lzss_stream_feed(lzss_stream *stream, const uint8_t *data, size_t size) {
+    int status = 0;
+    for (size_t i = 0; i < size && 0 == status; i++) {
+        switch (stream->state) {
+        case STATE_HEADER:
+            stream->header[stream->header_length++] = data[i];
+            if (LZSS_STREAM_HEADER_SIZE == stream->header_length) {
+                status = parse_header(stream);
+            }
+            break;
+        case STATE_DONE:
+            // trailing data after the image is complete
+            status = fail(stream, LZSS_STREAM_ERROR_FORMAT);
+            break;
+        case STATE_ERROR:
+            return LZSS_STREAM_ERROR_FORMAT;
+        default:
+            stream->current = data[i];
+            stream->current_bits = 8;
+            status = decode_bits(stream);
+            break;
+        }
+    }
+    if (status) {
+        return status;
+    }
+    return flush(stream);
+}
+
+bool lzss_stream_done(const lzss_stream *stream) {
+    return STATE_DONE == stream->state && 0 == stream->output_length;
+}
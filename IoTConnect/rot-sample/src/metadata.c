@@ -21,7 +21,7 @@
 #include <string.h>
 #include "metadata.h"
 #include "psa/internal_trusted_storage.h"
-#include "stm32h5xx_hal.h" // for resolution to NVIC_SystemReset()
+#include "app_platform.h"
 
 
 #define METADATA_UID 1 // ID in PSA storage
@@ -105,12 +105,12 @@ uint32_t config_process_command(char command) {
 	case CLEAR_AND_RESET:
 		metadata_set_default();
 		metadata_write_data();
-		NVIC_SystemReset();
+		app_platform_reset();
 		break;
 
 	case WRITE_AND_RESET:
 		metadata_write_data();
-		NVIC_SystemReset();
+		app_platform_reset();
 		break;
 
 	default:
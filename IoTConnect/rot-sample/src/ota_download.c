@@ -0,0 +1,216 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "app_platform.h"
+#include "ota_download.h"
+
+static UINT driver_request(ota_download_driver driver, UINT command, uint32_t file_size, const char *sha256_base64,
+        uint8_t *data, uint32_t offset, uint32_t size, ULONG *return_ptr) {
+    NX_AZURE_IOT_ADU_AGENT_DRIVER request;
+    memset(&request, 0, sizeof(request));
+    request.nx_azure_iot_adu_agent_driver_command = command;
+    request.nx_azure_iot_adu_agent_driver_firmware_size = file_size;
+    if (NULL != sha256_base64) {
+        request.nx_azure_iot_adu_agent_driver_firmware_sha256 = (const UCHAR *) sha256_base64;
+        request.nx_azure_iot_adu_agent_driver_firmware_sha256_length = (UINT) strlen(sha256_base64);
+    }
+    request.nx_azure_iot_adu_agent_driver_firmware_data_offset = offset;
+    request.nx_azure_iot_adu_agent_driver_firmware_data_ptr = data;
+    request.nx_azure_iot_adu_agent_driver_firmware_data_size = size;
+    request.nx_azure_iot_adu_agent_driver_return_ptr = return_ptr;
+    driver(&request);
+    return request.nx_azure_iot_adu_agent_driver_status;
+}
+
+// Prepares the driver for the body of the response. Returns 0 and the offset of the body in the driver's
+// image if the driver can take it, a positive value if another attempt has to request the returned offset,
+// or a negative value if the driver failed.
+static int driver_prepare(ota_download_driver driver, const char *sha256_base64, const ota_download_response *r,
+        uint32_t *received) {
+    ULONG resume_offset = 0;
+    // with the return pointer, the driver continues an update of the same image in progress
+    if (driver_request(driver, NX_AZURE_IOT_ADU_AGENT_DRIVER_PREPROCESS, r->file_size, sha256_base64, NULL, 0, 0,
+            &resume_offset)) {
+        return -1;
+    }
+    if (resume_offset == r->offset) {
+        *received = r->offset;
+        return 0;
+    }
+    if (0 == r->offset) {
+        // the server sent the whole file. Start the update over instead of skipping what the driver has.
+        if (driver_request(driver, NX_AZURE_IOT_ADU_AGENT_DRIVER_PREPROCESS, r->file_size, sha256_base64, NULL, 0,
+                0, NULL)) {
+            return -1;
+        }
+        *received = 0;
+        return 0;
+    }
+    // the driver is at another offset than the body, possibly 0 after starting the update over
+    *received = (uint32_t) resume_offset;
+    return 1;
+}
+
+static void print_progress(uint32_t received, uint32_t file_size, unsigned int *last_tenth) {
+    const unsigned int tenth = (unsigned int) ((uint64_t) received * 10 / file_size);
+    if (tenth != *last_tenth) {
+        *last_tenth = tenth;
+        printf("OTA download %u%%\r\n", tenth * 10);
+    }
+}
+
+int ota_download(const ota_download_transport *transport, ota_download_driver driver, const char *sha256_base64,
+        uint8_t *buffer, uint32_t buffer_size, unsigned int attempts, uint32_t retry_delay_ms,
+        ota_download_stats *stats) {
+    ota_download_stats local_stats;
+    if (NULL == stats) {
+        stats = &local_stats;
+    }
+    memset(stats, 0, sizeof(*stats));
+    uint32_t file_size = 0;
+    uint32_t received = 0;
+    unsigned int last_tenth = 0;
+    int result = OTA_DOWNLOAD_ERROR_TRANSPORT;
+    for (unsigned int attempt = 1; attempt <= attempts; attempt++) {
+        if (attempt > 1) {
+            printf("OTA download interrupted at %lu of %lu bytes (attempt %u of %u)\r\n", (unsigned long) received,
+                    (unsigned long) file_size, attempt - 1, attempts);
+            app_platform_sleep_ms(retry_delay_ms);
+        }
+        stats->attempts++;
+        ota_download_response response = {0, 0};
+        const uint32_t requested = received;
+        if (transport->open(transport->context, requested, &response)) {
+            transport->close(transport->context);
+            continue;
+        }
+        if (0 == response.file_size) {
+            transport->close(transport->context);
+            result = OTA_DOWNLOAD_ERROR_SIZE;
+            break;
+        }
+        if (response.offset != 0 && (response.offset != requested || response.file_size != file_size)) {
+            // a range of another file, or not the one asked for
+            printf("OTA download: unexpected range %lu of %lu bytes\r\n", (unsigned long) response.offset,
+                    (unsigned long) response.file_size);
+            transport->close(transport->context);
+            received = 0;
+            continue;
+        }
+        const int prepared = driver_prepare(driver, sha256_base64, &response, &received);
+        if (prepared < 0) {
+            transport->close(transport->context);
+            result = OTA_DOWNLOAD_ERROR_DRIVER;
+            break;
+        }
+        file_size = response.file_size;
+        if (prepared > 0) {
+            transport->close(transport->context);
+            continue;
+        }
+        if (received > 0) {
+            stats->resumes++;
+        } else if (attempt > 1) {
+            stats->restarts++;
+        }
+        if (0 == received) {
+            printf("OTA download file size is %lu\r\n", (unsigned long) file_size);
+            last_tenth = 0;
+        }
+        bool driver_failed = false;
+        while (received < file_size) {
+            const uint32_t wanted = file_size - received < buffer_size ? file_size - received : buffer_size;
+            const int length = transport->read(transport->context, buffer, wanted);
+            if (length <= 0) {
+                break; // the connection failed, or the body ended early
+            }
+            stats->bytes_received += (uint64_t) length;
+            if (driver_request(driver, NX_AZURE_IOT_ADU_AGENT_DRIVER_WRITE, file_size, sha256_base64, buffer,
+                    received, (uint32_t) length, NULL)) {
+                driver_failed = true; // the driver dropped the update
+                break;
+            }
+            received += (uint32_t) length;
+            print_progress(received, file_size, &last_tenth);
+        }
+        transport->close(transport->context);
+        if (driver_failed) {
+            return OTA_DOWNLOAD_ERROR_DRIVER;
+        }
+        if (received == file_size) {
+            if (driver_request(driver, NX_AZURE_IOT_ADU_AGENT_DRIVER_INSTALL, file_size, sha256_base64, NULL, 0, 0,
+                    NULL)) {
+                printf("OTA install failed\r\n");
+                return OTA_DOWNLOAD_ERROR_DRIVER;
+            }
+            return 0;
+        }
+    }
+    // cancel the update, so that nothing of it is kept
+    driver_request(driver, NX_AZURE_IOT_ADU_AGENT_DRIVER_PREPROCESS, 0, NULL, NULL, 0, 0, NULL);
+    return result;
+}
+
+int ota_download_apply(ota_download_driver driver) {
+    return driver_request(driver, NX_AZURE_IOT_ADU_AGENT_DRIVER_APPLY, 0, NULL, NULL, 0, 0, NULL) ? -1 : 0;
+}
+
+int ota_download_split_url(scratch_arena *arena, const char *url, char **host_name, char **resource) {
+    *host_name = NULL;
+    *resource = NULL;
+    // the host name starts after the second slash and the resource at the third
+    const char *host = strchr(url, '/');
+    if (NULL == host || '/' != host[1]) {
+        return -1;
+    }
+    host += 2;
+    const char *path = strchr(host, '/');
+    if (NULL == path || path == host) {
+        return -1;
+    }
+    *host_name = scratch_arena_strndup(arena, host, (size_t) (path - host));
+    *resource = scratch_arena_strndup(arena, path, strlen(path));
+    return (NULL == *host_name || NULL == *resource) ? -1 : 0;
+}
+
+static const char *parse_u32(const char *p, const char *end, uint32_t *value) {
+    uint64_t v = 0;
+    const char *start = p;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (uint64_t) (*p - '0');
+        if (v > UINT32_MAX) {
+            return NULL;
+        }
+        p++;
+    }
+    if (p == start) {
+        return NULL;
+    }
+    *value = (uint32_t) v;
+    return p;
+}
+
+int ota_download_parse_content_range(const char *value, uint32_t length, uint32_t *first, uint32_t *file_size) {
+    static const char unit[] = "bytes ";
+    const char *end = value + length;
+    if (length < sizeof(unit) - 1 || 0 != memcmp(value, unit, sizeof(unit) - 1)) {
+        return -1;
+    }
+    uint32_t last;
+    const char *p = parse_u32(value + sizeof(unit) - 1, end, first);
+    if (NULL == p || p == end || *p++ != '-') {
+        return -1;
+    }
+    p = parse_u32(p, end, &last);
+    if (NULL == p || p == end || *p++ != '/') {
+        return -1;
+    }
+    p = parse_u32(p, end, file_size); // "*" for an unknown length fails here
+    if (NULL == p || *first > last || last >= *file_size) {
+        return -1;
+    }
+    return 0;
+}
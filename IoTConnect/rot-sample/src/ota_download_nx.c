@@ -0,0 +1,199 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "ota_download_nx.h"
+
+#define HTTPS_PORT          443
+#define RANGE_VALUE_SIZE    24 // "bytes=" and a 32 bit offset and "-"
+
+extern const NX_SECURE_TLS_CRYPTO nx_crypto_tls_ciphers;
+
+static bool field_is(const CHAR *name, UINT length, const char *expected) {
+    if (length != strlen(expected)) {
+        return false;
+    }
+    for (UINT i = 0; i < length; i++) {
+        char c = name[i];
+        if (c >= 'A' && c <= 'Z') {
+            c = (char) (c - 'A' + 'a');
+        }
+        if (c != expected[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static VOID on_response_header(NX_WEB_HTTP_CLIENT *client_ptr, CHAR *field_name, UINT field_name_length,
+        CHAR *field_value, UINT field_value_length) {
+    ota_download_nx_transport *nx = (ota_download_nx_transport *) client_ptr;
+    if (field_is(field_name, field_name_length, "content-range")) {
+        nx->has_content_range = 0 == ota_download_parse_content_range(field_value, field_value_length,
+                &nx->range_first, &nx->range_file_size);
+    } else if (field_is(field_name, field_name_length, "content-length")) {
+        uint32_t length = 0;
+        for (UINT i = 0; i < field_value_length && field_value[i] >= '0' && field_value[i] <= '9'; i++) {
+            length = length * 10 + (uint32_t) (field_value[i] - '0');
+        }
+        nx->content_length = length;
+    }
+}
+
+static UINT tls_setup(NX_WEB_HTTP_CLIENT *client_ptr, NX_SECURE_TLS_SESSION *tls_session) {
+    ota_download_nx_transport *nx = (ota_download_nx_transport *) client_ptr;
+    ULONG metadata_size;
+    UINT status = nx_secure_tls_metadata_size_calculate(&nx_crypto_tls_ciphers, &metadata_size);
+    if (status) {
+        return status;
+    }
+    if (metadata_size > sizeof(nx->tls_metadata)) {
+        printf("OTA download: TLS needs %lu bytes of metadata, OTA_DOWNLOAD_NX_TLS_METADATA_SIZE is %u\r\n",
+                (unsigned long) metadata_size, (unsigned) sizeof(nx->tls_metadata));
+        return NX_SECURE_TLS_INSUFFICIENT_METADATA_SPACE;
+    }
+    status = nx_secure_tls_session_create(tls_session, &nx_crypto_tls_ciphers, nx->tls_metadata,
+            sizeof(nx->tls_metadata));
+    if (!status) {
+        status = nx_secure_tls_session_packet_buffer_set(tls_session, nx->tls_packet_buffer,
+                sizeof(nx->tls_packet_buffer));
+    }
+    if (!status) {
+        status = nx_secure_x509_certificate_initialize(&nx->trusted_cert, (UCHAR *) nx->tls_cert,
+                (USHORT) nx->tls_cert_len, NX_NULL, 0, NX_NULL, 0, NX_SECURE_X509_KEY_TYPE_NONE);
+    }
+    if (!status) {
+        status = nx_secure_tls_trusted_certificate_add(tls_session, &nx->trusted_cert);
+    }
+    for (int i = 0; !status && i < OTA_DOWNLOAD_NX_REMOTE_CERT_COUNT; i++) {
+        status = nx_secure_tls_remote_certificate_allocate(tls_session, &nx->remote_certs[i],
+                nx->remote_cert_buffers[i], sizeof(nx->remote_cert_buffers[i]));
+    }
+    if (!status) {
+        status = nx_secure_x509_dns_name_initialize(&nx->sni_name, (const UCHAR *) nx->host, strlen(nx->host));
+    }
+    if (!status) {
+        status = nx_secure_tls_session_sni_extension_set(tls_session, &nx->sni_name);
+    }
+    return status;
+}
+
+static void nx_close(void *context) {
+    ota_download_nx_transport *nx = (ota_download_nx_transport *) context;
+    if (nx->packet) {
+        nx_packet_release(nx->packet);
+        nx->packet = NULL;
+    }
+    if (nx->created) {
+        nx_web_http_client_delete(&nx->client); // disconnects and ends the TLS session
+        nx->created = false;
+    }
+}
+
+static int nx_open(void *context, uint32_t offset, ota_download_response *response) {
+    ota_download_nx_transport *nx = (ota_download_nx_transport *) context;
+    nx->packet = NULL;
+    nx->packet_offset = 0;
+    nx->body_done = false;
+    nx->content_length = 0;
+    nx->has_content_range = false;
+
+    NXD_ADDRESS server_ip;
+    memset(&server_ip, 0, sizeof(server_ip));
+    server_ip.nxd_ip_version = NX_IP_VERSION_V4;
+    UINT status = nx_dns_host_by_name_get(nx->dns, (UCHAR *) nx->host, &server_ip.nxd_ip_address.v4,
+            nx->timeout_ticks);
+    if (status) {
+        printf("OTA download: failed to resolve %s, code 0x%x\r\n", nx->host, status);
+        return -1;
+    }
+    status = nx_web_http_client_create(&nx->client, "OTA download", nx->ip, nx->pool,
+            OTA_DOWNLOAD_NX_TLS_PACKET_BUFFER_SIZE);
+    if (status) {
+        return -1;
+    }
+    nx->created = true;
+    nx_web_http_client_response_header_callback_set(&nx->client, on_response_header);
+    status = nx_web_http_client_secure_connect(&nx->client, &server_ip, HTTPS_PORT, tls_setup, nx->timeout_ticks);
+    if (!status) {
+        status = nx_web_http_client_request_initialize(&nx->client, NX_WEB_HTTP_METHOD_GET, nx->resource, nx->host,
+                0, NX_FALSE, NX_NULL, NX_NULL, nx->timeout_ticks);
+    }
+    if (!status && offset > 0) {
+        char range[RANGE_VALUE_SIZE];
+        const int length = snprintf(range, sizeof(range), "bytes=%lu-", (unsigned long) offset);
+        status = nx_web_http_client_request_header_add(&nx->client, "Range", 5, range, (UINT) length,
+                nx->timeout_ticks);
+    }
+    if (!status) {
+        status = nx_web_http_client_request_send(&nx->client, nx->timeout_ticks);
+    }
+    if (status) {
+        printf("OTA download: request failed, code 0x%x\r\n", status);
+        return -1;
+    }
+    // the headers arrive with the first part of the body. A status other than 2xx is an error here.
+    status = nx_web_http_client_response_body_get(&nx->client, &nx->packet, nx->timeout_ticks);
+    if (NX_WEB_HTTP_GET_DONE == status) {
+        nx->body_done = true;
+    } else if (status) {
+        nx->packet = NULL;
+        printf("OTA download: response failed, code 0x%x\r\n", status);
+        return -1;
+    }
+    if (nx->has_content_range) {
+        response->offset = nx->range_first;
+        response->file_size = nx->range_file_size;
+    } else {
+        response->offset = 0;
+        response->file_size = nx->content_length;
+    }
+    return 0;
+}
+
+static int nx_read(void *context, uint8_t *buffer, uint32_t size) {
+    ota_download_nx_transport *nx = (ota_download_nx_transport *) context;
+    while (NULL == nx->packet || nx->packet_offset >= nx->packet->nx_packet_length) {
+        if (nx->packet) {
+            nx_packet_release(nx->packet);
+            nx->packet = NULL;
+        }
+        if (nx->body_done) {
+            return 0;
+        }
+        nx->packet_offset = 0;
+        const UINT status = nx_web_http_client_response_body_get(&nx->client, &nx->packet, nx->timeout_ticks);
+        if (NX_WEB_HTTP_GET_DONE == status) {
+            nx->body_done = true; // with the last packet
+        } else if (status) {
+            nx->packet = NULL;
+            return -1;
+        }
+    }
+    ULONG copied = 0;
+    if (nx_packet_data_extract_offset(nx->packet, nx->packet_offset, buffer, size, &copied)) {
+        return -1;
+    }
+    nx->packet_offset += copied;
+    return (int) copied;
+}
+
+void ota_download_nx_transport_init(ota_download_transport *transport, ota_download_nx_transport *nx, NX_IP *ip,
+        NX_PACKET_POOL *pool, NX_DNS *dns, char *host, char *resource, const unsigned char *tls_cert,
+        size_t tls_cert_len, ULONG timeout_ticks) {
+    memset(nx, 0, sizeof(*nx));
+    nx->ip = ip;
+    nx->pool = pool;
+    nx->dns = dns;
+    nx->host = host;
+    nx->resource = resource;
+    nx->tls_cert = tls_cert;
+    nx->tls_cert_len = tls_cert_len;
+    nx->timeout_ticks = timeout_ticks;
+    transport->context = nx;
+    transport->open = nx_open;
+    transport->read = nx_read;
+    transport->close = nx_close;
+}
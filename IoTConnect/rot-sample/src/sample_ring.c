@@ -0,0 +1,47 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <string.h>
+#include "sample_ring.h"
+
+#define RING_MASK (SAMPLE_RING_CAPACITY - 1)
+
+void sample_ring_init(sample_ring *ring) {
+    memset(ring, 0, sizeof(*ring));
+}
+
+bool sample_ring_push(sample_ring *ring, const telemetry_sample *sample) {
+    const uint32_t head = ring->head; // only we write it
+    const uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= SAMPLE_RING_CAPACITY) {
+        __atomic_store_n(&ring->dropped, ring->dropped + 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    ring->slots[head & RING_MASK] = *sample;
+    // publish the slot contents before the new head
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool sample_ring_pop(sample_ring *ring, telemetry_sample *sample) {
+    const uint32_t tail = ring->tail; // only we write it
+    const uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return false;
+    }
+    *sample = ring->slots[tail & RING_MASK];
+    // release the slot back to the producer only after it has been copied out
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint32_t sample_ring_count(const sample_ring *ring) {
+    const uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    const uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    return head - tail;
+}
+
+uint32_t sample_ring_dropped(const sample_ring *ring) {
+    return __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+}
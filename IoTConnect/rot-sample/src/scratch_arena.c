@@ -0,0 +1,37 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <string.h>
+#include "scratch_arena.h"
+
+void scratch_arena_init(scratch_arena *arena, uint8_t *buffer, size_t size) {
+    memset(arena, 0, sizeof(*arena));
+    arena->buffer = buffer;
+    arena->size = size;
+}
+
+void *scratch_arena_alloc(scratch_arena *arena, size_t size) {
+    // the buffer itself may not be aligned, so align the address
+    const uintptr_t base = (uintptr_t) arena->buffer;
+    const uintptr_t start = (base + arena->used + SCRATCH_ARENA_ALIGNMENT - 1) & ~(uintptr_t) (SCRATCH_ARENA_ALIGNMENT - 1);
+    const size_t offset = (size_t) (start - base);
+    if (offset > arena->size || size > arena->size - offset) {
+        arena->failures++;
+        return NULL;
+    }
+    arena->used = offset + size;
+    if (arena->used > arena->peak) {
+        arena->peak = arena->used;
+    }
+    return &arena->buffer[offset];
+}
+
+char *scratch_arena_strndup(scratch_arena *arena, const char *str, size_t length) {
+    char *copy = (char *) scratch_arena_alloc(arena, length + 1);
+    if (copy) {
+        memcpy(copy, str, length);
+        copy[length] = 0;
+    }
+    return copy;
+}
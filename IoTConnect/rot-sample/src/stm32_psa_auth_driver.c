@@ -25,8 +25,12 @@
 //
 
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "tx_api.h"
 #include "nx_api.h"
@@ -37,6 +41,10 @@
 #include "iotc_algorithms.h"
 #include "azrtos_crypto_config.h"
 #include "stm32_psa_auth_driver.h"
+#include "auth_profiler.h"
+#include "cert_store.h"
+#include "csr_writer.h"
+#include "psa/crypto.h"
 
 #ifndef NX_SECURE_X509_KEY_TYPE_HARDWARE
 #error "Need NetX 6.1.7 or newer to compile stm32_psa_auth_driver!"
@@ -48,6 +56,31 @@ extern NX_CRYPTO_METHOD crypto_method_ecdsa_psa_crypto;
 #define SR_BUFFER_SIZE TO_SIGNATURE_SIZE // two big integers (32 bytes each)
 #define DC_MAGIC 0x4e
 
+// Certificate slot numbers of get_cert. Slot 0 is the device identity, which is also the bootstrap identity.
+// Slots 1 to CERT_STORE_SLOT_COUNT are the operational certificates of the cert store.
+#define STM32_PSA_SLOT_BOOTSTRAP 0
+#define STM32_PSA_SLOT_UNSELECTED (-2)
+
+// PSA key IDs of the operational keys, one per cert store slot
+#define STM32_PSA_OPERATIONAL_KEY_ID_BASE 0x300
+
+#define STM32_PSA_CSR_BUFFER_SIZE (256 + IOTC_COMMON_NAME_MAX_LEN)
+
+// Fields of a certificate, parsed once. Pointers are into the certificate DER.
+struct stm32_psa_cert_view {
+    bool parsed;
+    const UCHAR *cert; // the certificate that was parsed
+    uint32_t generation; // cert store generation of the certificate, 0 for the device identity
+    NX_SECURE_X509_DISTINGUISHED_NAME subject;
+    const UCHAR *not_before;
+    USHORT not_before_length;
+    const UCHAR *not_after;
+    USHORT not_after_length;
+    const UCHAR *public_key;
+    USHORT public_key_length;
+    char cn[IOTC_COMMON_NAME_MAX_LEN + 1];
+};
+
 struct stm32_psa_driver_context {
     struct stm32_psa_driver_parameters driver_parameters;
     IotcAzccCryptoConfig crypto_config;
@@ -55,7 +88,13 @@ struct stm32_psa_driver_context {
     UINT cert_size;
     const UCHAR *key;
     UINT key_size;
-    char cn_buffer[IOTC_COMMON_NAME_MAX_LEN + 1];
+    struct stm32_psa_cert_view bootstrap_view;
+    struct stm32_psa_cert_view operational_view;
+    cert_store_storage store_storage;
+    cert_store store;
+    int connection_slot; // cert store slot handed out for the connection, CERT_STORE_NONE for the device identity
+    int csr_slot; // cert store slot of the key of the last CSR
+    uint8_t csr[STM32_PSA_CSR_BUFFER_SIZE];
     char magic;
 };
 
@@ -68,6 +107,103 @@ static bool is_context_valid(IotcAuthInterfaceContext context) {
 	return ret;
 }
 
+static UINT stm32_psa_load_credentials(struct stm32_psa_driver_context *stm32_psa_context) {
+	UINT status;
+	AUTH_PROFILE_BEGIN(retrieve_start);
+	status = device_identity_retrieve_credentials(
+    		&stm32_psa_context->cert,
+			&stm32_psa_context->cert_size,
+			&stm32_psa_context->key,
+			&stm32_psa_context->key_size
+			);
+	AUTH_PROFILE_END(retrieve_start, AUTH_PROFILE_RETRIEVE_CREDENTIALS, stm32_psa_context->cert_size);
+    if (status) {
+        printf("Failed to retrieve device identity: error code = 0x%08x\r\n", status);
+    }
+    return status;
+}
+
+// Parses the certificate into the view. Returns 0 on success, or if the view already holds this certificate.
+static UINT stm32_psa_parse_cert(struct stm32_psa_cert_view *view, const UCHAR *cert, UINT cert_size, uint32_t generation) {
+    if (view->parsed && view->cert == cert && view->generation == generation) {
+        return 0;
+    }
+    view->parsed = false;
+
+    NX_SECURE_X509_CERT dev_certificate;
+    UINT nx_status;
+
+    AUTH_PROFILE_BEGIN(x509_start);
+    nx_status = nx_secure_x509_certificate_initialize(&dev_certificate,
+                                (UCHAR *)cert, (USHORT)cert_size,
+                                NX_NULL, 0,
+                                (UCHAR *)"0", 1,
+                                NX_SECURE_X509_KEY_TYPE_HARDWARE);
+    AUTH_PROFILE_END(x509_start, AUTH_PROFILE_X509_INITIALIZE, cert_size);
+    if (nx_status) {
+        printf("nx_secure_x509_certificate_initialize failed with status %d\r\n", nx_status);
+        return nx_status;
+    }
+
+    USHORT cn_length = dev_certificate.nx_secure_x509_distinguished_name.nx_secure_x509_common_name_length;
+    if (cn_length > IOTC_COMMON_NAME_MAX_LEN) {
+        printf("TFM-PSA: Certificate common name is too long\r\n");
+        return NX_SECURE_X509_INVALID_CERTIFICATE;
+    }
+    NX_CRYPTO_MEMCPY(
+            view->cn,
+            dev_certificate.nx_secure_x509_distinguished_name.nx_secure_x509_common_name,
+            cn_length);
+    view->cn[cn_length] = 0; // terminate the string
+
+    view->subject = dev_certificate.nx_secure_x509_distinguished_name;
+    view->not_before = dev_certificate.nx_secure_x509_not_before;
+    view->not_before_length = dev_certificate.nx_secure_x509_not_before_length;
+    view->not_after = dev_certificate.nx_secure_x509_not_after;
+    view->not_after_length = dev_certificate.nx_secure_x509_not_after_length;
+    view->public_key = dev_certificate.nx_secure_x509_public_key.ec_public_key.nx_secure_ec_public_key;
+    view->public_key_length = dev_certificate.nx_secure_x509_public_key.ec_public_key.nx_secure_ec_public_key_length;
+    view->cert = cert;
+    view->generation = generation;
+    view->parsed = true;
+    return 0;
+}
+
+// Returns the parsed view of the device identity certificate, or NULL
+static struct stm32_psa_cert_view *stm32_psa_bootstrap_view(struct stm32_psa_driver_context *stm32_psa_context) {
+    if (!stm32_psa_context->cert && stm32_psa_load_credentials(stm32_psa_context)) {
+        return NULL;
+    }
+    struct stm32_psa_cert_view *view = &stm32_psa_context->bootstrap_view;
+    if (stm32_psa_parse_cert(view, stm32_psa_context->cert, stm32_psa_context->cert_size, 0)) {
+        return NULL;
+    }
+    return view;
+}
+
+// Returns the parsed view of the active operational certificate, or of the device identity if there is none
+static struct stm32_psa_cert_view *stm32_psa_operational_view(struct stm32_psa_driver_context *stm32_psa_context) {
+    const cert_store *store = &stm32_psa_context->store;
+    const int active = store->active;
+    if (CERT_STORE_NONE == active) {
+        return stm32_psa_bootstrap_view(stm32_psa_context);
+    }
+    const cert_store_slot *slot = &store->slots[active];
+    struct stm32_psa_cert_view *view = &stm32_psa_context->operational_view;
+    if (stm32_psa_parse_cert(view, slot->cert, slot->cert_size, slot->generation)) {
+        return NULL;
+    }
+    return view;
+}
+
+// The device identity key holds the ID of its PSA key
+static psa_key_id_t stm32_psa_bootstrap_key_id(struct stm32_psa_driver_context *stm32_psa_context) {
+    if (!stm32_psa_context->key && stm32_psa_load_credentials(stm32_psa_context)) {
+        return 0;
+    }
+    return (psa_key_id_t) *((uint32_t*)stm32_psa_context->key);
+}
+
 // Return a DER formatted certificate given the slot number
 static int stm32_psa_get_cert(IotcAuthInterfaceContext context, uint8_t cert_slot, uint8_t **cert, size_t *cert_size) {
 	*cert = NULL;
@@ -76,29 +212,35 @@ static int stm32_psa_get_cert(IotcAuthInterfaceContext context, uint8_t cert_slo
 	if (!is_context_valid(context)) return -1;
 	struct stm32_psa_driver_context *stm32_psa_context = (struct stm32_psa_driver_context*) context;
 
-    if (stm32_psa_context->cert) {
-        // shortcut... skip loading again and avoid printing the cert twice
-        *cert = (uint8_t*)stm32_psa_context->cert;
-        *cert_size = stm32_psa_context->cert_size;
-        return 0;
-    }
-	if (cert_slot != 0) {
-		printf("TFM-PSA: get_cert: Slot must be 0 \r\n");
+	if (cert_slot > CERT_STORE_SLOT_COUNT) {
+		printf("TFM-PSA: get_cert: Slot must be 0 to %d\r\n", CERT_STORE_SLOT_COUNT);
 		return -2;
 	}
 	if (!cert || cert_size == NULL) {
 		printf("TFM-PSA: get_cert: Invalid parameters for get_cert operation\r\n");
 		return -3;
 	}
+    if (cert_slot != STM32_PSA_SLOT_BOOTSTRAP) {
+        // served from RAM, the cert store reads the certificates once
+        const cert_store_slot *slot = &stm32_psa_context->store.slots[cert_slot - 1];
+        if (CERT_STORE_SLOT_READY != slot->state) {
+            printf("TFM-PSA: get_cert: Slot %d has no certificate\r\n", cert_slot);
+            return -2;
+        }
+        *cert = (uint8_t*)slot->cert;
+        *cert_size = slot->cert_size;
+        return 0;
+    }
+
+    if (stm32_psa_context->cert) {
+        // shortcut... skip loading again and avoid printing the cert twice
+        *cert = (uint8_t*)stm32_psa_context->cert;
+        *cert_size = stm32_psa_context->cert_size;
+        return 0;
+    }
 
 	UINT status;
-    if ((status = device_identity_retrieve_credentials(
-    		&stm32_psa_context->cert,
-			&stm32_psa_context->cert_size,
-			&stm32_psa_context->key,
-			&stm32_psa_context->key_size
-			))) {
-        printf("Failed to retrieve device identity: error code = 0x%08x\r\n", status);
+    if ((status = stm32_psa_load_credentials(stm32_psa_context))) {
         return(status);
     }
 
@@ -110,17 +252,25 @@ static int stm32_psa_get_cert(IotcAuthInterfaceContext context, uint8_t cert_slo
     return 0;
 }
 
+// Picks the identity for a new connection: the active operational certificate, or the device identity.
+// A certificate that is committed later is used from the next connection on, so a rotation does not force a reconnect.
+static void stm32_psa_select_connection_slot(struct stm32_psa_driver_context *stm32_psa_context) {
+    stm32_psa_context->connection_slot = stm32_psa_context->store.active;
+}
 
 // Return a DER formatted certificate that will be used to authenticate the IoTConnect connection
 static int stm32_psa_get_operational_cert(IotcAuthInterfaceContext context, uint8_t **cert, size_t *cert_size) {
 	if (!is_context_valid(context)) return -1;
-    return stm32_psa_get_cert(context, 0, cert, cert_size);
+	struct stm32_psa_driver_context *stm32_psa_context = (struct stm32_psa_driver_context*) context;
+    stm32_psa_select_connection_slot(stm32_psa_context);
+    const int slot = stm32_psa_context->connection_slot;
+    return stm32_psa_get_cert(context, (CERT_STORE_NONE == slot) ? STM32_PSA_SLOT_BOOTSTRAP : (uint8_t)(slot + 1),
+            cert, cert_size);
 }
 // Return a DER formatted certificate that will be used for dynamic identity
 static int stm32_psa_get_bootstrap_cert(IotcAuthInterfaceContext context, uint8_t **cert, size_t *cert_size) {
-    //TODO: Decide how to deal with multiple slots
 	if (!is_context_valid(context)) return -1;
-    return stm32_psa_get_cert(context, 0, cert, cert_size);
+    return stm32_psa_get_cert(context, STM32_PSA_SLOT_BOOTSTRAP, cert, cert_size);
 }
 
 // In case of NX_SECURE_X509_KEY_TYPE_HARDWARE, the private key is ignored by AzureRTOS.
@@ -129,6 +279,16 @@ static int stm32_psa_get_private_key(IotcAuthInterfaceContext context, uint8_t**
 	if (!is_context_valid(context)) return -1;
 	struct stm32_psa_driver_context *stm32_psa_context = (struct stm32_psa_driver_context*) context;
 
+    if (STM32_PSA_SLOT_UNSELECTED == stm32_psa_context->connection_slot) {
+        stm32_psa_select_connection_slot(stm32_psa_context);
+    }
+    if (CERT_STORE_NONE != stm32_psa_context->connection_slot) {
+        // like the device identity key, the key of an operational certificate is passed on as its PSA key ID
+        *key = (uint8_t*)&stm32_psa_context->store.slots[stm32_psa_context->connection_slot].key_id;
+        *key_size = sizeof(uint32_t);
+        return 0;
+    }
+
     if (stm32_psa_context->key) {
         // shortcut... skip loading again and avoid printing the cert twice
         *key = (uint8_t*)stm32_psa_context->key;
@@ -140,13 +300,7 @@ static int stm32_psa_get_private_key(IotcAuthInterfaceContext context, uint8_t**
     }
 
 	UINT status;
-    if ((status = device_identity_retrieve_credentials(
-    		&stm32_psa_context->cert,
-			&stm32_psa_context->cert_size,
-			&stm32_psa_context->key,
-			&stm32_psa_context->key_size
-			))) {
-        printf("Failed to retrieve device identity: error code = 0x%08x\r\n", status);
+    if ((status = stm32_psa_load_credentials(stm32_psa_context))) {
         return(status);
     }
 
@@ -165,21 +319,136 @@ static int stm32_psa_get_serial(IotcAuthInterfaceContext context, uint8_t *seria
     return -1;
 }
 
+// Signs with PSA the SHA-256 digest of the data. Output is the raw r and s.
+static psa_status_t stm32_psa_sign_digest(psa_key_id_t key_id, const uint8_t *hash, uint8_t *output) {
+    size_t signature_length = 0;
+    psa_status_t status = psa_sign_hash(key_id, PSA_ALG_ECDSA(PSA_ALG_SHA_256), hash, PSA_HASH_LENGTH(PSA_ALG_SHA_256),
+            output, SR_BUFFER_SIZE, &signature_length);
+    if (PSA_SUCCESS == status && SR_BUFFER_SIZE != signature_length) {
+        status = PSA_ERROR_GENERIC_ERROR;
+    }
+    return status;
+}
+
+static int stm32_psa_csr_sign(void *context, const uint8_t *data, size_t size, uint8_t signature[CSR_WRITER_SIGNATURE_SIZE]) {
+    const psa_key_id_t *key_id = (const psa_key_id_t *) context;
+    uint8_t hash[PSA_HASH_LENGTH(PSA_ALG_SHA_256)];
+    size_t hash_length = 0;
+    psa_status_t status = psa_hash_compute(PSA_ALG_SHA_256, data, size, hash, sizeof(hash), &hash_length);
+    if (PSA_SUCCESS == status) {
+        status = stm32_psa_sign_digest(*key_id, hash, signature);
+    }
+    return (PSA_SUCCESS == status) ? 0 : -1;
+}
+
 // Generate a CSR using the CSR slot defined in driver parameters and return the pointer to the CSR
 // NOTE: The request will invalidate any cert or CSR previously stored in the cert buffer.
+// A new key is generated in a cert store slot that is not active, so the current identity stays usable until
+// the certificate for the CSR is stored.
 static int stm32_psa_generate_csr(IotcAuthInterfaceContext context, const char *cn, uint8_t **csr, size_t *len) {
-    printf("TFM-PSA: stm32_psa_generate_csr not implemented\r\n");
-	return -1;
+	if (!is_context_valid(context)) return -1;
+	struct stm32_psa_driver_context *stm32_psa_context = (struct stm32_psa_driver_context*) context;
+
+    const int slot = cert_store_staging_slot(&stm32_psa_context->store);
+    psa_key_id_t key_id = (psa_key_id_t)(STM32_PSA_OPERATIONAL_KEY_ID_BASE + slot);
+    psa_status_t status;
+
+    // the slot does not hold the active certificate, so its previous key is not needed any more
+    status = psa_destroy_key(key_id);
+    if (PSA_SUCCESS != status && PSA_ERROR_INVALID_HANDLE != status && PSA_ERROR_DOES_NOT_EXIST != status) {
+        printf("TFM-PSA: Unable to destroy the key of slot %d: %d\r\n", slot, (int)status);
+        return -2;
+    }
+
+    psa_key_attributes_t attributes = PSA_KEY_ATTRIBUTES_INIT;
+    psa_set_key_id(&attributes, key_id);
+    psa_set_key_lifetime(&attributes, PSA_KEY_LIFETIME_PERSISTENT);
+    psa_set_key_type(&attributes, PSA_KEY_TYPE_ECC_KEY_PAIR(PSA_ECC_FAMILY_SECP_R1));
+    psa_set_key_bits(&attributes, 256);
+    psa_set_key_usage_flags(&attributes, PSA_KEY_USAGE_SIGN_HASH);
+    psa_set_key_algorithm(&attributes, PSA_ALG_ECDSA(PSA_ALG_SHA_256));
+    status = psa_generate_key(&attributes, &key_id);
+    psa_reset_key_attributes(&attributes);
+    if (PSA_SUCCESS != status) {
+        printf("TFM-PSA: Unable to generate a key for slot %d: %d\r\n", slot, (int)status);
+        return -2;
+    }
+
+    uint8_t public_key[CSR_WRITER_PUBLIC_KEY_SIZE];
+    size_t public_key_length = 0;
+    status = psa_export_public_key(key_id, public_key, sizeof(public_key), &public_key_length);
+    if (PSA_SUCCESS != status || sizeof(public_key) != public_key_length) {
+        printf("TFM-PSA: Unable to export the public key of slot %d: %d\r\n", slot, (int)status);
+        return -2;
+    }
+    if (cert_store_stage_key(&stm32_psa_context->store, slot, (uint32_t)key_id)) {
+        printf("TFM-PSA: Unable to stage the key of slot %d\r\n", slot);
+        return -3;
+    }
+
+    int csr_length = csr_writer_build(stm32_psa_context->csr, sizeof(stm32_psa_context->csr), cn, public_key,
+            stm32_psa_csr_sign, &key_id);
+    if (csr_length < 0) {
+        printf("TFM-PSA: Unable to create the CSR: %d\r\n", csr_length);
+        return -4;
+    }
+    stm32_psa_context->csr_slot = slot;
+    *csr = stm32_psa_context->csr;
+    *len = (size_t)csr_length;
+	return 0;
 }
 
+// Stores the certificate issued for the last CSR and makes it the operational certificate for the next connection
 static int stm32_psa_store_operational_cert(IotcAuthInterfaceContext context, uint8_t* cert, size_t cert_len) {
-    printf("TFM-PSA: stm32_psa_store_operational_cert not implemented\r\n");
-	return -1;
+	if (!is_context_valid(context)) return -1;
+	struct stm32_psa_driver_context *stm32_psa_context = (struct stm32_psa_driver_context*) context;
+
+    const int slot = stm32_psa_context->csr_slot;
+    if (CERT_STORE_NONE == slot || CERT_STORE_SLOT_KEY_STAGED != stm32_psa_context->store.slots[slot].state) {
+        printf("TFM-PSA: store_operational_cert: No CSR is pending\r\n");
+        return -2;
+    }
+
+    // the certificate has to be for the staged key
+    struct stm32_psa_cert_view view;
+    memset(&view, 0, sizeof(view));
+    uint8_t public_key[CSR_WRITER_PUBLIC_KEY_SIZE];
+    size_t public_key_length = 0;
+    if (cert_len > CERT_STORE_MAX_CERT_SIZE
+            || stm32_psa_parse_cert(&view, cert, (UINT)cert_len, 0)
+            || PSA_SUCCESS != psa_export_public_key((psa_key_id_t)stm32_psa_context->store.slots[slot].key_id,
+                    public_key, sizeof(public_key), &public_key_length)
+            || view.public_key_length != public_key_length
+            || 0 != memcmp(view.public_key, public_key, public_key_length)) {
+        printf("TFM-PSA: store_operational_cert: The certificate does not match the key of the CSR\r\n");
+        return -3;
+    }
+
+    int status = cert_store_commit(&stm32_psa_context->store, slot, cert, (uint32_t)cert_len);
+    if (status) {
+        printf("TFM-PSA: store_operational_cert: Unable to store the certificate: %d\r\n", status);
+        return -4;
+    }
+    stm32_psa_context->csr_slot = CERT_STORE_NONE;
+    printf("TFM-PSA: Operational certificate %d is active for the next connection\r\n", slot + 1);
+	return 0;
 }
 
+// Signs the SHA-256 hash with the key of the current identity. The output is SR_BUFFER_SIZE bytes of r and s.
 static int stm32_psa_sign_hash(IotcAuthInterfaceContext context, uint8_t* input_hash, uint8_t* output) {
-    printf("TFM-PSA: stm32_psa_sign_hash not implemented\r\n");
-	return -1;
+	if (!is_context_valid(context)) return -1;
+	struct stm32_psa_driver_context *stm32_psa_context = (struct stm32_psa_driver_context*) context;
+
+    uint32_t key_id;
+    if (!cert_store_active(&stm32_psa_context->store, NULL, NULL, &key_id)) {
+        key_id = stm32_psa_bootstrap_key_id(stm32_psa_context);
+    }
+    psa_status_t status = stm32_psa_sign_digest((psa_key_id_t)key_id, input_hash, output);
+    if (PSA_SUCCESS != status) {
+        printf("TFM-PSA: sign_hash failed: %d\r\n", (int)status);
+        return -2;
+    }
+	return 0;
 }
 
 static IotcAzccCryptoConfig* stm32_psa_get_crypto_config(IotcAuthInterfaceContext context) {
@@ -188,49 +457,98 @@ static IotcAzccCryptoConfig* stm32_psa_get_crypto_config(IotcAuthInterfaceContex
 	return &(stm32_psa_context->crypto_config);
 }
 
-static char* stm32_psa_extract_cn(IotcAuthInterfaceContext context, int cert_index) {
-    
-    (void)cert_index; //TODO: make use of index
+// Certificates are parsed once, when the driver is created or a certificate is activated, so these are lookups
+static char* stm32_psa_extract_operational_cn(IotcAuthInterfaceContext context) {
 	if (!is_context_valid(context)) return NULL;
-	struct stm32_psa_driver_context* stm32_psa_context = (struct stm32_psa_driver_context*) context;
+    struct stm32_psa_cert_view *view = stm32_psa_operational_view((struct stm32_psa_driver_context*) context);
+	return view ? view->cn : NULL;
+}
 
-    NX_SECURE_X509_CERT dev_certificate;
-    UINT nx_status;
+static char* stm32_psa_extract_botstrap_cn(IotcAuthInterfaceContext context) {
+	if (!is_context_valid(context)) return NULL;
+    struct stm32_psa_cert_view *view = stm32_psa_bootstrap_view((struct stm32_psa_driver_context*) context);
+	return view ? view->cn : NULL;
+}
 
-    nx_status = nx_secure_x509_certificate_initialize(&dev_certificate,
-                                (UCHAR *)stm32_psa_context->cert, (USHORT)stm32_psa_context->cert_size,
-                                NX_NULL, 0,
-                                (UCHAR *)"0", 1,
-                                NX_SECURE_X509_KEY_TYPE_HARDWARE);
-    if (nx_status) {                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                    
-        printf("nx_secure_x509_certificate_initialize failed with status %d\r\n", nx_status);
-        return NULL;
+#if APP_AUTH_PROFILER
+int stm32_psa_benchmark_extract_cn(IotcAuthInterfaceContext context, unsigned int iterations) {
+	if (!is_context_valid(context) || 0 == iterations) return -1;
+	struct stm32_psa_driver_context* stm32_psa_context = (struct stm32_psa_driver_context*) context;
+    if (NULL == stm32_psa_bootstrap_view(stm32_psa_context)) {
+        return -2;
     }
-    
-    USHORT cn_length = dev_certificate.nx_secure_x509_distinguished_name.nx_secure_x509_common_name_length;
-    if (cn_length <= IOTC_COMMON_NAME_MAX_LEN) {
-        NX_CRYPTO_MEMCPY(
-                stm32_psa_context->cn_buffer, 
-                dev_certificate.nx_secure_x509_distinguished_name.nx_secure_x509_common_name, 
-                cn_length);
-        stm32_psa_context->cn_buffer[cn_length] = 0; // terminate the string
-    } else {
-        return NULL;
+
+    // What every extract_cn call used to do: parse the whole certificate. This runs on the command worker, so
+    // it parses into a view of its own and leaves the one that the SDK reads alone.
+    struct stm32_psa_cert_view view;
+    uint32_t start = app_platform_cycles();
+    for (unsigned int i = 0; i < iterations; i++) {
+        view.parsed = false;
+        if (stm32_psa_parse_cert(&view, stm32_psa_context->cert, stm32_psa_context->cert_size, 0)) {
+            return -2;
+        }
     }
-    
-	return stm32_psa_context->cn_buffer;
+    const uint32_t parse_cycles = app_platform_cycles() - start;
+
+    start = app_platform_cycles();
+    for (unsigned int i = 0; i < iterations; i++) {
+        if (NULL == stm32_psa_extract_botstrap_cn(context)) {
+            return -2;
+        }
+    }
+    const uint32_t cached_cycles = app_platform_cycles() - start;
+
+    const uint32_t cycles_per_us = app_platform_cycles_per_us();
+    printf("TFM-PSA: extract_cn x%u: parse each call %lu ns/call, cached %lu ns/call\r\n",
+            iterations,
+            (unsigned long) ((uint64_t) parse_cycles * 1000 / iterations / cycles_per_us),
+            (unsigned long) ((uint64_t) cached_cycles * 1000 / iterations / cycles_per_us));
+    return 0;
 }
 
-static char* stm32_psa_extract_operational_cn(IotcAuthInterfaceContext context) {
-	if (!is_context_valid(context)) return NULL;
-	return stm32_psa_extract_cn(context, 0);
+// Measuring wrappers around the interface functions and the ECDSA crypto method
+
+static int profiled_get_cert(IotcAuthInterfaceContext context, uint8_t **cert, size_t *cert_size) {
+    AUTH_PROFILE_BEGIN(start);
+    int ret = stm32_psa_get_operational_cert(context, cert, cert_size);
+    AUTH_PROFILE_END(start, AUTH_PROFILE_GET_CERT, *cert_size);
+    return ret;
 }
 
-static char* stm32_psa_extract_botstrap_cn(IotcAuthInterfaceContext context) {
-	if (!is_context_valid(context)) return NULL;
-	return stm32_psa_extract_cn(context, 0);
+static int profiled_get_private_key(IotcAuthInterfaceContext context, uint8_t** key, size_t* key_size) {
+    AUTH_PROFILE_BEGIN(start);
+    int ret = stm32_psa_get_private_key(context, key, key_size);
+    AUTH_PROFILE_END(start, AUTH_PROFILE_GET_PRIVATE_KEY, *key_size);
+    return ret;
 }
 
+static char* profiled_extract_operational_cn(IotcAuthInterfaceContext context) {
+    AUTH_PROFILE_BEGIN(start);
+    char *cn = stm32_psa_extract_operational_cn(context);
+    AUTH_PROFILE_END(start, AUTH_PROFILE_EXTRACT_CN, cn ? strlen(cn) : 0);
+    return cn;
+}
+
+static char* profiled_extract_bootstrap_cn(IotcAuthInterfaceContext context) {
+    AUTH_PROFILE_BEGIN(start);
+    char *cn = stm32_psa_extract_botstrap_cn(context);
+    AUTH_PROFILE_END(start, AUTH_PROFILE_EXTRACT_CN, cn ? strlen(cn) : 0);
+    return cn;
+}
+
+static UINT profiled_ecdsa_operation(UINT op, VOID *handle, struct NX_CRYPTO_METHOD_STRUCT *method, UCHAR *key,
+        NX_CRYPTO_KEY_SIZE key_size_in_bits, UCHAR *input, ULONG input_length_in_byte, UCHAR *iv_ptr, UCHAR *output,
+        ULONG output_length_in_byte, VOID *crypto_metadata, ULONG crypto_metadata_size, VOID *packet_ptr,
+        VOID (*nx_crypto_hw_process_callback)(VOID *, UINT)) {
+    AUTH_PROFILE_BEGIN(start);
+    UINT status = crypto_method_ecdsa_psa_crypto.nx_crypto_operation(op, handle, method, key, key_size_in_bits,
+            input, input_length_in_byte, iv_ptr, output, output_length_in_byte, crypto_metadata, crypto_metadata_size,
+            packet_ptr, nx_crypto_hw_process_callback);
+    AUTH_PROFILE_END(start, AUTH_PROFILE_ECDSA_OPERATION, input_length_in_byte);
+    return status;
+}
+#endif // APP_AUTH_PROFILER
+
 int stm32_psa_create_auth_driver(IotcAuthInterface* driver_interface, IotcDdimInterface* ddim_interface, IotcAuthInterfaceContext* context, struct stm32_psa_driver_parameters *driver_parameters) {
 	if (!driver_parameters) {
 		printf("TFM-PSA: Driver parameters are required\r\n");
@@ -240,13 +558,13 @@ int stm32_psa_create_auth_driver(IotcAuthInterface* driver_interface, IotcDdimIn
 	struct stm32_psa_driver_context *c = 
         (struct stm32_psa_driver_context*) malloc(sizeof(struct stm32_psa_driver_context));
 
-	memset(c, 0, sizeof(struct stm32_psa_driver_context));
-
-	c->magic = DC_MAGIC;
 	if (!c) {
 		printf("TFM-PSA: Unable to allocate context!\r\n");
 		return -3;
 	}
+	memset(c, 0, sizeof(struct stm32_psa_driver_context));
+
+	c->magic = DC_MAGIC;
     memcpy(&(c->driver_parameters), driver_parameters, sizeof(struct stm32_psa_driver_parameters));
 
     if (!driver_interface || !context) {
@@ -263,6 +581,19 @@ int stm32_psa_create_auth_driver(IotcAuthInterface* driver_interface, IotcDdimIn
 	c->crypto_config.custom_crypto_method_storage.nx_crypto_operation = crypto_method_ecdsa_psa_crypto.nx_crypto_operation;
 	c->crypto_config.custom_crypto_method_storage.nx_crypto_init = crypto_method_ecdsa_psa_crypto.nx_crypto_init;
 	c->crypto_config.custom_crypto_method_storage.nx_crypto_cleanup = crypto_method_ecdsa_psa_crypto.nx_crypto_cleanup;
+#if APP_AUTH_PROFILER
+	c->crypto_config.custom_crypto_method_storage.nx_crypto_operation = profiled_ecdsa_operation;
+#endif
+
+    c->connection_slot = STM32_PSA_SLOT_UNSELECTED;
+    c->csr_slot = CERT_STORE_NONE;
+    cert_store_its_storage_init(&c->store_storage);
+    cert_store_init(&c->store, &c->store_storage);
+
+    // Parse the certificates up front, so that later lookups don't need to. If the device identity is not
+    // available yet, this is retried when the CN is requested, and get_cert reports the error.
+    (void) stm32_psa_bootstrap_view(c);
+    (void) stm32_psa_operational_view(c);
 
     *context = (IotcAuthInterfaceContext) c;
 
@@ -280,6 +611,15 @@ int stm32_psa_create_auth_driver(IotcAuthInterface* driver_interface, IotcDdimIn
         ddim_interface->extract_operational_cn = stm32_psa_extract_operational_cn;
         ddim_interface->store_operational_cert = stm32_psa_store_operational_cert;
     }
+
+#if APP_AUTH_PROFILER
+    driver_interface->get_cert = profiled_get_cert;
+    driver_interface->get_private_key = profiled_get_private_key;
+    if (ddim_interface) {
+        ddim_interface->extract_bootstrap_cn = profiled_extract_bootstrap_cn;
+        ddim_interface->extract_operational_cn = profiled_extract_operational_cn;
+    }
+#endif
 	return 0;
 }
 
@@ -0,0 +1,223 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "system_health.h"
+
+// From tx_byte_pool.h and tx_api.h of ThreadX
+#ifndef TX_BYTE_BLOCK_FREE
+#define TX_BYTE_BLOCK_FREE      ((ALIGN_TYPE) 0xFFFFEEEEUL)
+#endif
+#ifndef TX_STACK_FILL
+#define TX_STACK_FILL           ((ULONG) 0xEFEFEFEFUL)
+#endif
+#define BLOCK_OVERHEAD          (sizeof(UCHAR *) + sizeof(ALIGN_TYPE))
+
+#define FIELD_NAME_LENGTH       32
+
+extern TX_BYTE_POOL *_tx_byte_pool_created_ptr;
+extern ULONG _tx_byte_pool_created_count;
+
+static UCHAR *next_block(UCHAR *block) {
+    return *((UCHAR **) ((void *) block));
+}
+
+static bool is_free_block(UCHAR *block) {
+    return TX_BYTE_BLOCK_FREE == *((ALIGN_TYPE *) ((void *) (block + sizeof(UCHAR *))));
+}
+
+// Walks the block list of the pool the same way tx_byte_allocate() searches it. Interrupts are disabled
+// for one chunk of blocks at a time. The pool is marked as owned by this thread, and any allocation or release
+// by another thread in between the chunks takes the ownership away, which restarts the walk.
+// Adjacent free blocks are counted as one fragment, as ThreadX merges them when it allocates.
+static bool walk_pool(TX_BYTE_POOL *pool, ULONG *fragments, ULONG *largest_free) {
+    TX_THREAD *self = tx_thread_identify();
+    for (int attempt = 0; attempt < SYSTEM_HEALTH_WALK_ATTEMPTS; attempt++) {
+        UINT posture = tx_interrupt_control(TX_INT_DISABLE);
+        pool->tx_byte_pool_owner = self;
+        UCHAR *block = pool->tx_byte_pool_list;
+        ULONG remaining = pool->tx_byte_pool_fragments;
+        UCHAR *run_start = NULL;
+        ULONG found_fragments = 0;
+        ULONG found_largest = 0;
+        bool interrupted = false;
+        while (remaining > 0 && !interrupted) {
+            for (int i = 0; i < SYSTEM_HEALTH_WALK_CHUNK && remaining > 0; i++, remaining--) {
+                UCHAR *next = next_block(block);
+                if (!is_free_block(block)) {
+                    run_start = NULL;
+                } else {
+                    if (NULL == run_start) {
+                        run_start = block;
+                        found_fragments++;
+                    }
+                    const ULONG size = (ULONG) (next - run_start) - BLOCK_OVERHEAD;
+                    if (size > found_largest) {
+                        found_largest = size;
+                    }
+                }
+                block = next;
+            }
+            tx_interrupt_control(posture);
+            posture = tx_interrupt_control(TX_INT_DISABLE);
+            interrupted = (pool->tx_byte_pool_owner != self);
+        }
+        tx_interrupt_control(posture);
+        if (!interrupted) {
+            *fragments = found_fragments;
+            *largest_free = found_largest;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void sample_heap(TX_BYTE_POOL *pool, system_health *health) {
+    CHAR *name;
+    if (TX_SUCCESS != tx_byte_pool_info_get(pool, &name, &health->heap_free, &health->heap_blocks, TX_NULL, TX_NULL,
+            TX_NULL)) {
+        return;
+    }
+    health->has_heap = true;
+    health->heap_size = pool->tx_byte_pool_size;
+    health->has_heap_walk = walk_pool(pool, &health->heap_fragments, &health->heap_largest_free);
+}
+
+// The part of the stack below the deepest use still has the fill pattern that tx_thread_create() wrote.
+// Only reads the stack, so it needs no lock. The result is the full stack if stack filling is disabled.
+static ULONG stack_high_water(const TX_THREAD *thread) {
+    const ULONG *p = (const ULONG *) thread->tx_thread_stack_start;
+    const ULONG *end = (const ULONG *) thread->tx_thread_stack_end;
+    while (p < end && TX_STACK_FILL == *p) {
+        p++;
+    }
+    return thread->tx_thread_stack_size - (ULONG) ((const UCHAR *) p - (const UCHAR *) thread->tx_thread_stack_start);
+}
+
+static void sample_threads(system_health *health) {
+    // the created threads are a circular list, which includes this one
+    TX_THREAD *first = tx_thread_identify();
+    TX_THREAD *thread = first;
+    health->thread_count = 0;
+    do {
+        system_health_thread *t = &health->threads[health->thread_count];
+        CHAR *name;
+        TX_THREAD *next;
+        if (TX_SUCCESS != tx_thread_info_get(thread, &name, TX_NULL, TX_NULL, TX_NULL, TX_NULL, TX_NULL, &next,
+                TX_NULL)) {
+            break;
+        }
+        t->name = name ? name : "";
+        t->stack_size = thread->tx_thread_stack_size;
+        t->stack_used = stack_high_water(thread);
+        health->thread_count++;
+        thread = next;
+    } while (thread && thread != first && health->thread_count < SYSTEM_HEALTH_MAX_THREADS);
+}
+
+int system_health_init(system_health_sampler *sampler, TX_BYTE_POOL *heap, NX_PACKET_POOL *packet_pool) {
+    memset(sampler, 0, sizeof(*sampler));
+    sampler->heap = heap;
+    sampler->packet_pool = packet_pool;
+    if (TX_SUCCESS != tx_mutex_create(&sampler->mutex, "System Health", TX_INHERIT)) {
+        return -1;
+    }
+    return 0;
+}
+
+TX_BYTE_POOL *system_health_find_heap(void) {
+    UCHAR *probe = malloc(1);
+    if (NULL == probe) {
+        return NULL;
+    }
+    TX_BYTE_POOL *heap = NULL;
+    UINT posture = tx_interrupt_control(TX_INT_DISABLE);
+    TX_BYTE_POOL *pool = _tx_byte_pool_created_ptr;
+    for (ULONG i = 0; i < _tx_byte_pool_created_count && NULL == heap; i++) {
+        const UCHAR *start = pool->tx_byte_pool_start;
+        if (probe >= start && probe < start + pool->tx_byte_pool_size) {
+            heap = pool;
+        }
+        pool = pool->tx_byte_pool_created_next;
+    }
+    tx_interrupt_control(posture);
+    free(probe);
+    return heap;
+}
+
+void system_health_sample(system_health_sampler *sampler, system_health *health) {
+    tx_mutex_get(&sampler->mutex, TX_WAIT_FOREVER);
+    memset(health, 0, sizeof(*health));
+    health->timestamp = time(NULL);
+    if (sampler->heap) {
+        sample_heap(sampler->heap, health);
+    }
+    if (sampler->packet_pool && NX_SUCCESS == nx_packet_pool_info_get(sampler->packet_pool, &health->packets_total,
+            &health->packets_free, &health->packets_empty_requests, NX_NULL, NX_NULL)) {
+        health->has_packet_pool = true;
+    }
+    sample_threads(health);
+    tx_mutex_put(&sampler->mutex);
+}
+
+static void stack_field_name(const char *thread_name, char *buffer, size_t size) {
+    size_t length = (size_t) snprintf(buffer, size, "stack_");
+    for (const char *p = thread_name; *p && length + 1 < size; p++) {
+        char c = *p;
+        if (c >= 'A' && c <= 'Z') {
+            c = (char) (c - 'A' + 'a');
+        } else if (!(c >= 'a' && c <= 'z') && !(c >= '0' && c <= '9')) {
+            c = '_';
+        }
+        buffer[length++] = c;
+    }
+    buffer[length] = 0;
+}
+
+void system_health_write(telemetry_writer *w, const system_health *health) {
+    telemetry_writer_begin_datapoint(w, health->timestamp);
+    if (health->has_heap) {
+        telemetry_writer_add_number(w, "heap_free", health->heap_free);
+        telemetry_writer_add_number(w, "heap_blocks", health->heap_blocks);
+    }
+    if (health->has_heap_walk) {
+        telemetry_writer_add_number(w, "heap_fragments", health->heap_fragments);
+        telemetry_writer_add_number(w, "heap_largest_free", health->heap_largest_free);
+    }
+    if (health->has_packet_pool) {
+        telemetry_writer_add_number(w, "packets_total", health->packets_total);
+        telemetry_writer_add_number(w, "packets_free", health->packets_free);
+        telemetry_writer_add_number(w, "packets_empty_requests", health->packets_empty_requests);
+    }
+    for (unsigned int i = 0; i < health->thread_count; i++) {
+        char name[FIELD_NAME_LENGTH];
+        stack_field_name(health->threads[i].name, name, sizeof(name));
+        telemetry_writer_add_number(w, name, health->threads[i].stack_used);
+    }
+    telemetry_writer_end_datapoint(w);
+}
+
+void system_health_print(const system_health *health) {
+    if (health->has_heap) {
+        printf("Heap: %lu of %lu bytes free in %lu blocks", (unsigned long) health->heap_free,
+                (unsigned long) health->heap_size, (unsigned long) health->heap_blocks);
+        if (health->has_heap_walk) {
+            printf(", %lu free fragments, largest %lu bytes\r\n", (unsigned long) health->heap_fragments,
+                    (unsigned long) health->heap_largest_free);
+        } else {
+            printf(", the pool was too busy to walk\r\n");
+        }
+    }
+    if (health->has_packet_pool) {
+        printf("Packets: %lu of %lu free, %lu empty pool requests\r\n", (unsigned long) health->packets_free,
+                (unsigned long) health->packets_total, (unsigned long) health->packets_empty_requests);
+    }
+    for (unsigned int i = 0; i < health->thread_count; i++) {
+        const system_health_thread *t = &health->threads[i];
+        printf("Stack: %-24s %5lu of %5lu bytes used\r\n", t->name, (unsigned long) t->stack_used,
+                (unsigned long) t->stack_size);
+    }
+}
@@ -0,0 +1,191 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "telemetry_aggregator.h"
+
+#define FIELD_NAME_LENGTH 48
+
+static void reset_window(telemetry_aggregator *aggregator) {
+    for (size_t i = 0; i < aggregator->field_count; i++) {
+        telemetry_aggregator_field *field = &aggregator->fields[i];
+        field->count = 0;
+        field->mean = 0;
+        field->m2 = 0;
+    }
+    aggregator->window_open = false;
+}
+
+static bool within_deadband(const telemetry_aggregator_field *field) {
+    if (0 == field->count) {
+        return true; // nothing to report
+    }
+    if (!field->has_reported || field->deadband <= 0) {
+        return false;
+    }
+    return fabs(field->min - field->reported) <= field->deadband
+            && fabs(field->max - field->reported) <= field->deadband;
+}
+
+// Closes the open window. Call with the mutex held. Returns true if it is to be reported.
+static bool close_window(telemetry_aggregator *aggregator, telemetry_aggregate *aggregate) {
+    aggregator->stats.windows++;
+    bool report = false;
+    for (size_t i = 0; i < aggregator->field_count; i++) {
+        if (!within_deadband(&aggregator->fields[i])) {
+            report = true;
+        }
+    }
+    if (!report && aggregator->max_silent_windows && ++aggregator->silent_windows >= aggregator->max_silent_windows) {
+        report = true; // heartbeat
+    }
+    if (report) {
+        aggregator->stats.reported++;
+        aggregator->silent_windows = 0;
+        aggregate->start = aggregator->window_start;
+        aggregate->window_s = aggregator->window_s;
+        aggregate->field_count = aggregator->field_count;
+        for (size_t i = 0; i < aggregator->field_count; i++) {
+            telemetry_aggregator_field *field = &aggregator->fields[i];
+            telemetry_field_aggregate *out = &aggregate->fields[i];
+            out->name = field->name;
+            out->count = field->count;
+            out->min = field->min;
+            out->max = field->max;
+            out->mean = field->mean;
+            out->stddev = field->count ? sqrt(field->m2 / field->count) : 0;
+            if (field->count) {
+                field->reported = field->mean;
+                field->has_reported = true;
+            }
+        }
+    }
+    reset_window(aggregator);
+    aggregator->window_s = aggregator->next_window_s;
+    return report;
+}
+
+int telemetry_aggregator_init(telemetry_aggregator *aggregator, uint32_t window_s, uint32_t max_silent_windows) {
+    memset(aggregator, 0, sizeof(*aggregator));
+    aggregator->window_s = window_s;
+    aggregator->next_window_s = window_s;
+    aggregator->max_silent_windows = max_silent_windows;
+    if (TX_SUCCESS != tx_mutex_create(&aggregator->mutex, "Telemetry Aggregator", TX_INHERIT)) {
+        return -1;
+    }
+    return 0;
+}
+
+int telemetry_aggregator_add_field(telemetry_aggregator *aggregator, const char *name, double deadband) {
+    if (aggregator->field_count >= TELEMETRY_AGGREGATOR_MAX_FIELDS) {
+        return TELEMETRY_AGGREGATOR_ERROR_FIELD;
+    }
+    telemetry_aggregator_field *field = &aggregator->fields[aggregator->field_count];
+    memset(field, 0, sizeof(*field));
+    field->name = name;
+    field->deadband = deadband;
+    return (int) aggregator->field_count++;
+}
+
+void telemetry_aggregator_set_window(telemetry_aggregator *aggregator, uint32_t window_s) {
+    tx_mutex_get(&aggregator->mutex, TX_WAIT_FOREVER);
+    aggregator->next_window_s = window_s;
+    if (!aggregator->window_open) {
+        aggregator->window_s = window_s;
+    }
+    tx_mutex_put(&aggregator->mutex);
+}
+
+int telemetry_aggregator_set_deadband(telemetry_aggregator *aggregator, const char *name, double deadband) {
+    int status = TELEMETRY_AGGREGATOR_ERROR_FIELD;
+    tx_mutex_get(&aggregator->mutex, TX_WAIT_FOREVER);
+    for (size_t i = 0; i < aggregator->field_count; i++) {
+        if (0 == strcmp(aggregator->fields[i].name, name)) {
+            aggregator->fields[i].deadband = deadband;
+            status = 0;
+        }
+    }
+    tx_mutex_put(&aggregator->mutex);
+    return status;
+}
+
+bool telemetry_aggregator_add(telemetry_aggregator *aggregator, time_t timestamp, const double *values,
+        telemetry_aggregate *aggregate, bool *report) {
+    *report = false;
+    tx_mutex_get(&aggregator->mutex, TX_WAIT_FOREVER);
+    if (aggregator->window_open && timestamp >= aggregator->window_start + (time_t) aggregator->window_s) {
+        *report = close_window(aggregator, aggregate);
+    }
+    if (0 == aggregator->window_s) {
+        tx_mutex_put(&aggregator->mutex);
+        return false;
+    }
+    if (!aggregator->window_open) {
+        aggregator->window_start = timestamp - timestamp % (time_t) aggregator->window_s;
+        aggregator->window_open = true;
+    }
+    aggregator->stats.samples++;
+    for (size_t i = 0; i < aggregator->field_count; i++) {
+        telemetry_aggregator_field *field = &aggregator->fields[i];
+        const double value = values[i];
+        if (0 == field->count) {
+            field->min = value;
+            field->max = value;
+        } else if (value < field->min) {
+            field->min = value;
+        } else if (value > field->max) {
+            field->max = value;
+        }
+        field->count++;
+        const double delta = value - field->mean;
+        field->mean += delta / field->count;
+        field->m2 += delta * (value - field->mean);
+    }
+    tx_mutex_put(&aggregator->mutex);
+    return true;
+}
+
+bool telemetry_aggregator_poll(telemetry_aggregator *aggregator, time_t now, telemetry_aggregate *aggregate) {
+    bool report = false;
+    tx_mutex_get(&aggregator->mutex, TX_WAIT_FOREVER);
+    if (aggregator->window_open && now >= aggregator->window_start + (time_t) aggregator->window_s) {
+        report = close_window(aggregator, aggregate);
+    }
+    tx_mutex_put(&aggregator->mutex);
+    return report;
+}
+
+void telemetry_aggregator_write_fields(telemetry_writer *w, const telemetry_aggregate *aggregate) {
+    static const char *suffixes[] = {"min", "max", "mean", "stddev", "count"};
+    for (size_t i = 0; i < aggregate->field_count; i++) {
+        const telemetry_field_aggregate *field = &aggregate->fields[i];
+        if (0 == field->count) {
+            continue;
+        }
+        const double values[] = {field->min, field->max, field->mean, field->stddev, field->count};
+        for (size_t j = 0; j < sizeof(values) / sizeof(values[0]); j++) {
+            char name[FIELD_NAME_LENGTH];
+            snprintf(name, sizeof(name), "%s_%s", field->name, suffixes[j]);
+            telemetry_writer_add_number(w, name, values[j]);
+        }
+    }
+}
+
+void telemetry_aggregator_print(telemetry_aggregator *aggregator) {
+    tx_mutex_get(&aggregator->mutex, TX_WAIT_FOREVER);
+    const telemetry_aggregator_stats *s = &aggregator->stats;
+    printf("Aggregation: window %lu s (next %lu s), heartbeat every %lu windows\r\n",
+            (unsigned long) aggregator->window_s, (unsigned long) aggregator->next_window_s,
+            (unsigned long) aggregator->max_silent_windows);
+    printf("Aggregation: %lu samples in %lu windows, %lu reported\r\n", (unsigned long) s->samples,
+            (unsigned long) s->windows, (unsigned long) s->reported);
+    for (size_t i = 0; i < aggregator->field_count; i++) {
+        const telemetry_aggregator_field *field = &aggregator->fields[i];
+        printf("  %-16s deadband %g, last reported %g\r\n", field->name, field->deadband,
+                field->has_reported ? field->reported : 0.0);
+    }
+    tx_mutex_put(&aggregator->mutex);
+}
@@ -0,0 +1,118 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include "telemetry_batch.h"
+
+static size_t byte_budget(const telemetry_batch *batch) {
+    if (0 == batch->policy.max_bytes || batch->policy.max_bytes > batch->size) {
+        return batch->size;
+    }
+    return batch->policy.max_bytes;
+}
+
+void telemetry_batch_init(telemetry_batch *batch, const telemetry_batch_policy *policy, const char *version, char *buffer,
+        size_t size) {
+    batch->policy = *policy;
+    if (0 == batch->policy.max_samples) {
+        batch->policy.max_samples = 1;
+    }
+    batch->version = version;
+    batch->buffer = buffer;
+    batch->size = size;
+    batch->format = TELEMETRY_FORMAT_JSON;
+    telemetry_batch_reset(batch);
+}
+
+struct sample_record {
+    const char *version;
+    const telemetry_sample *sample;
+};
+
+static void write_sample(telemetry_writer *w, const void *context) {
+    const struct sample_record *record = (const struct sample_record *) context;
+    telemetry_writer_add_sample(w, record->version, record->sample);
+}
+
+bool telemetry_batch_add(telemetry_batch *batch, const telemetry_sample *sample, uint32_t now_ms) {
+    const struct sample_record record = {batch->version, sample};
+    return telemetry_batch_add_record(batch, sample->timestamp, write_sample, &record, now_ms);
+}
+
+bool telemetry_batch_add_record(telemetry_batch *batch, time_t timestamp, telemetry_batch_write_fn write,
+        const void *context, uint32_t now_ms) {
+    const telemetry_writer previous = batch->writer;
+
+    if (0 == batch->count) {
+        telemetry_writer_begin_message(&batch->writer, timestamp);
+    }
+    write(&batch->writer, context);
+
+    if (batch->writer.overflow) {
+        if (0 != batch->count) {
+            batch->writer = previous;
+            batch->buffer[batch->writer.length] = 0;
+            return false;
+        }
+        // A single sample does not fit. Count it so that the caller flushes and the error is reported there.
+    }
+    if (0 == batch->count) {
+        batch->first_sample_ms = now_ms;
+    }
+    batch->count++;
+    return true;
+}
+
+bool telemetry_batch_add_datapoint(telemetry_batch *batch, telemetry_batch_write_fn write, const void *context) {
+    if (0 == batch->count) {
+        return false;
+    }
+    const telemetry_writer previous = batch->writer;
+    write(&batch->writer, context);
+    if (batch->writer.overflow) {
+        batch->writer = previous;
+        batch->buffer[batch->writer.length] = 0;
+        return false;
+    }
+    return true;
+}
+
+bool telemetry_batch_is_due(const telemetry_batch *batch, uint32_t now_ms) {
+    if (0 == batch->count) {
+        return false;
+    }
+    if (batch->count >= batch->policy.max_samples) {
+        return true;
+    }
+    if (0 != batch->policy.max_age_ms && (uint32_t)(now_ms - batch->first_sample_ms) >= batch->policy.max_age_ms) {
+        return true;
+    }
+    return false;
+}
+
+const char *telemetry_batch_finish(telemetry_batch *batch) {
+    if (0 == batch->count) {
+        return NULL;
+    }
+    // give back the space that was reserved for the terminator
+    batch->writer.size = byte_budget(batch);
+    return telemetry_writer_finish(&batch->writer);
+}
+
+void telemetry_batch_reset(telemetry_batch *batch) {
+    // Keep room for the message terminator while adding samples. The budget also accounts for the terminating null.
+    // A budget that does not even fit the terminator leaves no room, and every sample overflows.
+    const size_t budget = byte_budget(batch);
+    const size_t terminator = telemetry_writer_terminator_length(batch->format);
+    telemetry_writer_init_format(&batch->writer, batch->buffer, budget > terminator ? budget - terminator : 0,
+            batch->format);
+    batch->count = 0;
+    batch->first_sample_ms = 0;
+}
+
+void telemetry_batch_set_format(telemetry_batch *batch, telemetry_format format) {
+    batch->format = format;
+    if (0 == batch->count) {
+        telemetry_batch_reset(batch);
+    }
+}
@@ -0,0 +1,302 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <stdio.h>
+#include <string.h>
+#include "telemetry_journal.h"
+
+/*
+ * Block layout:
+ *   header: magic(4) sequence(4) record_count(2) reserved(2) crc32(4)
+ *   records: magic(1) timestamp(8) temperature(8) button_counter(4) flags(1) crc32(4)
+ * All values are little endian. Unused space is filled with 0xFF.
+ */
+#define BLOCK_MAGIC         0x314A5454 // "TTJ1"
+#define BLOCK_HEADER_SIZE   16
+#define RECORD_MAGIC        0xA5
+#define RECORD_DATA_SIZE    22
+#define RECORD_SIZE         (RECORD_DATA_SIZE + 4)
+#define RECORD_FLAG_SENSORS 0x01
+
+static uint32_t crc32(const uint8_t *data, size_t len) {
+    // nibble-wise CRC-32 (IEEE 802.3), to keep the table small
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc = table[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+    return ~crc;
+}
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t) v;
+    p[1] = (uint8_t) (v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    put_u16(p, (uint16_t) v);
+    put_u16(p + 2, (uint16_t) (v >> 16));
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+    put_u32(p, (uint32_t) v);
+    put_u32(p + 4, (uint32_t) (v >> 32));
+}
+
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return get_u16(p) | ((uint32_t) get_u16(p + 2) << 16);
+}
+
+static uint64_t get_u64(const uint8_t *p) {
+    return get_u32(p) | ((uint64_t) get_u32(p + 4) << 32);
+}
+
+static uint32_t records_per_block(const telemetry_journal *journal) {
+    return (journal->storage->block_size - BLOCK_HEADER_SIZE) / RECORD_SIZE;
+}
+
+static uint32_t next_block(const telemetry_journal *journal, uint32_t block) {
+    return (block + 1) % journal->storage->block_count;
+}
+
+static uint32_t block_record_count(const uint8_t *block) {
+    return get_u16(&block[8]);
+}
+
+static void encode_record(uint8_t *p, const telemetry_sample *sample) {
+    uint64_t temperature;
+    memcpy(&temperature, &sample->temperature, sizeof(temperature));
+    p[0] = RECORD_MAGIC;
+    put_u64(&p[1], (uint64_t) (int64_t) sample->timestamp);
+    put_u64(&p[9], temperature);
+    put_u32(&p[17], sample->button_counter);
+    p[21] = sample->has_sensor_values ? RECORD_FLAG_SENSORS : 0;
+    put_u32(&p[RECORD_DATA_SIZE], crc32(p, RECORD_DATA_SIZE));
+}
+
+static bool decode_record(const uint8_t *p, telemetry_sample *sample) {
+    if (p[0] != RECORD_MAGIC || get_u32(&p[RECORD_DATA_SIZE]) != crc32(p, RECORD_DATA_SIZE)) {
+        return false;
+    }
+    uint64_t temperature = get_u64(&p[9]);
+    sample->timestamp = (time_t) (int64_t) get_u64(&p[1]);
+    memcpy(&sample->temperature, &temperature, sizeof(temperature));
+    sample->button_counter = get_u32(&p[17]);
+    sample->has_sensor_values = (p[21] & RECORD_FLAG_SENSORS) != 0;
+    return true;
+}
+
+static void finalize_header(const telemetry_journal *journal, uint8_t *block) {
+    put_u16(&block[8], (uint16_t) ((journal->tail_offset - BLOCK_HEADER_SIZE) / RECORD_SIZE));
+    put_u32(&block[12], crc32(block, 12));
+}
+
+// Returns true if the block has a valid header
+static bool read_block(const telemetry_journal *journal, uint32_t block, uint8_t *data) {
+    const telemetry_journal_storage *s = journal->storage;
+    if (s->read(s->context, block, data, s->block_size)) {
+        return false;
+    }
+    if (get_u32(&data[0]) != BLOCK_MAGIC || get_u32(&data[12]) != crc32(data, 12)) {
+        return false;
+    }
+    return block_record_count(data) <= records_per_block(journal);
+}
+
+static void start_tail_block(telemetry_journal *journal) {
+    memset(journal->write_buffer, 0xFF, journal->storage->block_size);
+    put_u32(&journal->write_buffer[0], BLOCK_MAGIC);
+    put_u32(&journal->write_buffer[4], journal->next_sequence++);
+    put_u16(&journal->write_buffer[10], 0);
+    journal->tail_offset = BLOCK_HEADER_SIZE;
+    journal->tail_stored = false;
+}
+
+static void drop_samples(telemetry_journal *journal, uint32_t count) {
+    journal->dropped += count;
+    journal->pending = (journal->pending > count) ? journal->pending - count : 0;
+}
+
+static void release_head_block(telemetry_journal *journal) {
+    const telemetry_journal_storage *s = journal->storage;
+    s->erase(s->context, journal->head);
+    journal->head = next_block(journal, journal->head);
+    journal->head_offset = 0;
+    journal->full_blocks--;
+}
+
+static uint32_t head_block_remaining(telemetry_journal *journal) {
+    if (0 == journal->head_offset) {
+        if (!read_block(journal, journal->head, journal->read_buffer)) {
+            return 0;
+        }
+        journal->head_offset = BLOCK_HEADER_SIZE;
+    }
+    uint32_t end = BLOCK_HEADER_SIZE + block_record_count(journal->read_buffer) * RECORD_SIZE;
+    return (end - journal->head_offset) / RECORD_SIZE;
+}
+
+// Stores the full tail block and starts a new one, dropping the oldest block if the journal is full
+static int flush_tail_block(telemetry_journal *journal) {
+    const telemetry_journal_storage *s = journal->storage;
+    uint32_t count = (journal->tail_offset - BLOCK_HEADER_SIZE) / RECORD_SIZE;
+    finalize_header(journal, journal->write_buffer);
+    int status = s->write(s->context, journal->tail, journal->write_buffer, s->block_size);
+    if (status) {
+        printf("Journal: Failed to store block %u. Error: %d\r\n", (unsigned int) journal->tail, status);
+        drop_samples(journal, count);
+        start_tail_block(journal);
+        return status;
+    }
+    if (0 == journal->full_blocks) {
+        journal->head = journal->tail;
+        journal->head_offset = 0;
+    }
+    journal->full_blocks++;
+    journal->tail = next_block(journal, journal->tail);
+    if (journal->tail == journal->head) {
+        drop_samples(journal, head_block_remaining(journal));
+        release_head_block(journal);
+    }
+    start_tail_block(journal);
+    return 0;
+}
+
+int telemetry_journal_init(telemetry_journal *journal, const telemetry_journal_storage *storage, uint8_t *write_buffer,
+        uint8_t *read_buffer) {
+    memset(journal, 0, sizeof(*journal));
+    journal->storage = storage;
+    journal->write_buffer = write_buffer;
+    journal->read_buffer = read_buffer;
+    journal->next_sequence = 1;
+
+    if (storage->block_count < 2 || storage->block_size < BLOCK_HEADER_SIZE + RECORD_SIZE) {
+        printf("Journal: Invalid storage configuration\r\n");
+        return -1;
+    }
+
+    // find the oldest and the newest valid block
+    bool found = false;
+    uint32_t oldest = 0, oldest_sequence = 0;
+    uint32_t newest = 0, newest_sequence = 0;
+    uint32_t valid_blocks = 0;
+    for (uint32_t i = 0; i < storage->block_count; i++) {
+        if (!read_block(journal, i, read_buffer)) {
+            continue;
+        }
+        uint32_t sequence = get_u32(&read_buffer[4]);
+        if (!found || (int32_t) (sequence - oldest_sequence) < 0) {
+            oldest = i;
+            oldest_sequence = sequence;
+        }
+        if (!found || (int32_t) (sequence - newest_sequence) > 0) {
+            newest = i;
+            newest_sequence = sequence;
+        }
+        found = true;
+        valid_blocks++;
+        journal->pending += block_record_count(read_buffer);
+    }
+
+    if (!found) {
+        start_tail_block(journal);
+        return 0;
+    }
+
+    journal->next_sequence = newest_sequence + 1;
+    journal->head = oldest;
+    journal->full_blocks = valid_blocks;
+    if (read_block(journal, newest, write_buffer) && block_record_count(write_buffer) < records_per_block(journal)) {
+        // continue appending into the partially filled block that was synced last time
+        journal->tail = newest;
+        journal->tail_offset = BLOCK_HEADER_SIZE + block_record_count(write_buffer) * RECORD_SIZE;
+        journal->tail_stored = true;
+        journal->full_blocks--;
+    } else {
+        journal->tail = next_block(journal, newest);
+        if (journal->tail == journal->head) {
+            drop_samples(journal, head_block_remaining(journal));
+            release_head_block(journal);
+        }
+        start_tail_block(journal);
+    }
+    printf("Journal: Recovered %u sample(s)\r\n", (unsigned int) journal->pending);
+    return 0;
+}
+
+int telemetry_journal_append(telemetry_journal *journal, const telemetry_sample *sample) {
+    encode_record(&journal->write_buffer[journal->tail_offset], sample);
+    journal->tail_offset += RECORD_SIZE;
+    journal->pending++;
+    if (journal->tail_offset + RECORD_SIZE > journal->storage->block_size) {
+        return flush_tail_block(journal);
+    }
+    return 0;
+}
+
+int telemetry_journal_sync(telemetry_journal *journal) {
+    const telemetry_journal_storage *s = journal->storage;
+    if (journal->tail_offset == BLOCK_HEADER_SIZE) {
+        return 0; // nothing to store
+    }
+    finalize_header(journal, journal->write_buffer);
+    int status = s->write(s->context, journal->tail, journal->write_buffer, s->block_size);
+    if (0 == status) {
+        journal->tail_stored = true;
+    }
+    return status;
+}
+
+bool telemetry_journal_read(telemetry_journal *journal, telemetry_sample *sample) {
+    const telemetry_journal_storage *s = journal->storage;
+    while (journal->full_blocks > 0) {
+        uint32_t remaining = head_block_remaining(journal);
+        if (0 == remaining) {
+            // consumed (or unreadable). Samples of an unreadable block are lost.
+            if (0 == journal->head_offset) {
+                printf("Journal: Block %u is corrupted\r\n", (unsigned int) journal->head);
+            }
+            release_head_block(journal);
+            continue;
+        }
+        bool valid = decode_record(&journal->read_buffer[journal->head_offset], sample);
+        journal->head_offset += RECORD_SIZE;
+        if (1 == remaining) {
+            release_head_block(journal);
+        }
+        if (valid) {
+            journal->pending--;
+            return true;
+        }
+        drop_samples(journal, 1);
+    }
+
+    // The oldest samples are in the tail block in RAM
+    while (journal->tail_offset > BLOCK_HEADER_SIZE) {
+        bool valid = decode_record(&journal->write_buffer[BLOCK_HEADER_SIZE], sample);
+        memmove(&journal->write_buffer[BLOCK_HEADER_SIZE], &journal->write_buffer[BLOCK_HEADER_SIZE + RECORD_SIZE],
+                journal->tail_offset - BLOCK_HEADER_SIZE - RECORD_SIZE);
+        journal->tail_offset -= RECORD_SIZE;
+        memset(&journal->write_buffer[journal->tail_offset], 0xFF, RECORD_SIZE);
+        if (journal->tail_offset == BLOCK_HEADER_SIZE && journal->tail_stored) {
+            s->erase(s->context, journal->tail);
+            journal->tail_stored = false;
+        }
+        if (valid) {
+            journal->pending--;
+            return true;
+        }
+        drop_samples(journal, 1);
+    }
+    journal->pending = 0;
+    return false;
+}
@@ -0,0 +1,80 @@
+//
+// Copyright: Avnet 2023
+//
+
+#ifdef TELEMETRY_JOURNAL_FILE_STORAGE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "telemetry_journal.h"
+
+struct file_storage_context {
+    FILE *file;
+    uint32_t block_size;
+};
+
+static int file_write_at(struct file_storage_context *c, uint32_t block, const uint8_t *data, uint32_t size) {
+    if (fseek(c->file, (long) block * (long) c->block_size, SEEK_SET)) {
+        return -1;
+    }
+    if (fwrite(data, 1, size, c->file) != size) {
+        return -1;
+    }
+    return fflush(c->file) ? -1 : 0;
+}
+
+static int file_read(void *context, uint32_t block, uint8_t *data, uint32_t size) {
+    struct file_storage_context *c = (struct file_storage_context *) context;
+    if (fseek(c->file, (long) block * (long) c->block_size, SEEK_SET)) {
+        return -1;
+    }
+    return (fread(data, 1, size, c->file) == size) ? 0 : -1;
+}
+
+static int file_write(void *context, uint32_t block, const uint8_t *data, uint32_t size) {
+    return file_write_at((struct file_storage_context *) context, block, data, size);
+}
+
+static int file_erase(void *context, uint32_t block) {
+    // invalidating the block header is sufficient
+    uint8_t erased[16];
+    memset(erased, 0xFF, sizeof(erased));
+    return file_write_at((struct file_storage_context *) context, block, erased, sizeof(erased));
+}
+
+int telemetry_journal_file_storage_init(telemetry_journal_storage *storage, const char *path, uint32_t block_size,
+        uint32_t block_count) {
+    struct file_storage_context *c = (struct file_storage_context *) malloc(sizeof(struct file_storage_context));
+    if (!c) {
+        return -1;
+    }
+    c->block_size = block_size;
+    c->file = fopen(path, "r+b");
+    if (!c->file) {
+        c->file = fopen(path, "w+b");
+    }
+    if (!c->file) {
+        printf("Journal: Unable to open %s\r\n", path);
+        free(c);
+        return -1;
+    }
+    storage->context = c;
+    storage->block_size = block_size;
+    storage->block_count = block_count;
+    storage->read = file_read;
+    storage->write = file_write;
+    storage->erase = file_erase;
+    return 0;
+}
+
+void telemetry_journal_file_storage_close(telemetry_journal_storage *storage) {
+    struct file_storage_context *c = (struct file_storage_context *) storage->context;
+    if (c) {
+        fclose(c->file);
+        free(c);
+        storage->context = NULL;
+    }
+}
+
+#endif // TELEMETRY_JOURNAL_FILE_STORAGE
@@ -0,0 +1,44 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <stdio.h>
+#include "psa/internal_trusted_storage.h"
+#include "telemetry_journal.h"
+
+// ID in PSA storage of the first journal block. Blocks use consecutive IDs.
+// Keep clear of METADATA_UID and any other application assets.
+#define TELEMETRY_JOURNAL_UID_BASE 0x100
+
+static int its_read(void *context, uint32_t block, uint8_t *data, uint32_t size) {
+    (void) context;
+    size_t actual_size = 0;
+    psa_status_t status = psa_its_get(TELEMETRY_JOURNAL_UID_BASE + block, 0, size, data, &actual_size);
+    if (PSA_SUCCESS != status) {
+        return (int) status;
+    }
+    return (actual_size == size) ? 0 : -1;
+}
+
+static int its_write(void *context, uint32_t block, const uint8_t *data, uint32_t size) {
+    (void) context;
+    return (int) psa_its_set(TELEMETRY_JOURNAL_UID_BASE + block, size, data, 0);
+}
+
+static int its_erase(void *context, uint32_t block) {
+    (void) context;
+    psa_status_t status = psa_its_remove(TELEMETRY_JOURNAL_UID_BASE + block);
+    if (PSA_ERROR_DOES_NOT_EXIST == status) {
+        return 0;
+    }
+    return (int) status;
+}
+
+void telemetry_journal_its_storage_init(telemetry_journal_storage *storage, uint32_t block_size, uint32_t block_count) {
+    storage->context = NULL;
+    storage->block_size = block_size;
+    storage->block_count = block_count;
+    storage->read = its_read;
+    storage->write = its_write;
+    storage->erase = its_erase;
+}
@@ -0,0 +1,383 @@
+//
+// Copyright: Avnet 2023
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+
+#include "iotconnect_lib.h"
+#include "telemetry_writer.h"
+
+// Should match what iotc-c-lib reports in its own telemetry messages
+#ifndef CONFIG_IOTCONNECT_SDK_NAME
+#define CONFIG_IOTCONNECT_SDK_NAME "M_C"
+#endif
+#ifndef CONFIG_IOTCONNECT_SDK_VERSION
+#define CONFIG_IOTCONNECT_SDK_VERSION "2.0"
+#endif
+
+// Bytes that can be written before the message is finished: all but the null in JSON, and what base64
+// encodes into the buffer in CBOR
+static size_t capacity(const telemetry_writer *w) {
+    if (TELEMETRY_FORMAT_CBOR == w->format) {
+        return (w->size - 1) / 4 * 3;
+    }
+    return w->size - 1;
+}
+
+static void append_raw(telemetry_writer *w, const char *str, size_t len) {
+    if (w->overflow) return;
+    if (w->length + len > capacity(w)) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(&w->buffer[w->length], str, len);
+    w->length += len;
+    w->buffer[w->length] = 0;
+}
+
+static void append(telemetry_writer *w, const char *str) {
+    append_raw(w, str, strlen(str));
+}
+
+static void append_format(telemetry_writer *w, const char *format, ...) {
+    if (w->overflow) return;
+    size_t available = w->size - w->length;
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(&w->buffer[w->length], available, format, args);
+    va_end(args);
+    if (len < 0 || (size_t) len >= available) {
+        w->overflow = true;
+        w->buffer[w->length] = 0; // undo the partial write
+        return;
+    }
+    w->length += (size_t) len;
+}
+
+// Appends the number like the cJSON of iotc-c-lib prints it: with 15 digits if those read back as the same value,
+// and with 17 otherwise, so that the value always round-trips
+static void append_json_number(telemetry_writer *w, double value) {
+    char number[32];
+    snprintf(number, sizeof(number), "%1.15g", value);
+    if (strtod(number, NULL) != value) {
+        snprintf(number, sizeof(number), "%1.17g", value);
+    }
+    append(w, number);
+}
+
+// Appends a quoted and escaped JSON string
+static void append_string(telemetry_writer *w, const char *str) {
+    const char *chunk_start = str;
+    append_raw(w, "\"", 1);
+    for (const char *p = str; *p && !w->overflow; p++) {
+        unsigned char c = (unsigned char) *p;
+        if (c != '"' && c != '\\' && c >= 0x20) {
+            continue;
+        }
+        append_raw(w, chunk_start, (size_t)(p - chunk_start));
+        switch (c) {
+        case '"': append_raw(w, "\\\"", 2); break;
+        case '\\': append_raw(w, "\\\\", 2); break;
+        case '\n': append_raw(w, "\\n", 2); break;
+        case '\r': append_raw(w, "\\r", 2); break;
+        case '\t': append_raw(w, "\\t", 2); break;
+        default: append_format(w, "\\u%04x", c); break;
+        }
+        chunk_start = p + 1;
+    }
+    append(w, chunk_start);
+    append_raw(w, "\"", 1);
+}
+
+static void append_field_name(telemetry_writer *w, const char *name) {
+    if (w->has_field) {
+        append_raw(w, ",", 1);
+    }
+    w->has_field = true;
+    append_string(w, name);
+    append_raw(w, ":", 1);
+}
+
+static void append_iso_time(telemetry_writer *w, time_t timestamp) {
+    char iso_time[TELEMETRY_ISO_TIME_LEN + 1];
+    telemetry_format_iso_time(timestamp, iso_time, sizeof(iso_time));
+    append_string(w, iso_time);
+}
+
+// CBOR major types
+#define CBOR_UNSIGNED   0
+#define CBOR_NEGATIVE   1
+#define CBOR_TEXT       3
+#define CBOR_ARRAY      4
+#define CBOR_MAP        5
+#define CBOR_FLOAT32    0xfa
+#define CBOR_FLOAT64    0xfb
+#define CBOR_NULL       0xf6
+#define CBOR_BREAK      0xff
+
+#define CBOR_KEY_ENCODING   0
+#define CBOR_KEY_CPID       1
+#define CBOR_KEY_DTG        2
+#define CBOR_KEY_ENV        3
+#define CBOR_KEY_DUID       4
+#define CBOR_KEY_TIME       5
+#define CBOR_KEY_DATAPOINTS 6
+#define CBOR_KEY_DATAPOINT_TIME 0
+
+static const struct {
+    const char *name;
+    uint8_t key;
+} cbor_field_keys[] = {
+    {"version", TELEMETRY_CBOR_KEY_VERSION},
+    {"temperature", TELEMETRY_CBOR_KEY_TEMPERATURE},
+    {"button_counter", TELEMETRY_CBOR_KEY_BUTTON_COUNTER},
+};
+
+static void cbor_byte(telemetry_writer *w, uint8_t byte) {
+    append_raw(w, (const char *) &byte, 1);
+}
+
+// Writes the initial byte and the argument in the shortest form, which makes small integers take one byte
+static void cbor_head(telemetry_writer *w, uint8_t major, uint64_t value) {
+    uint8_t head[9];
+    size_t len;
+    if (value < 24) {
+        head[0] = (uint8_t) (major << 5 | value);
+        len = 1;
+    } else {
+        const size_t bytes = value <= UINT8_MAX ? 1 : value <= UINT16_MAX ? 2 : value <= UINT32_MAX ? 4 : 8;
+        head[0] = (uint8_t) (major << 5 | (bytes == 1 ? 24 : bytes == 2 ? 25 : bytes == 4 ? 26 : 27));
+        for (size_t i = 0; i < bytes; i++) {
+            head[bytes - i] = (uint8_t) (value >> (8 * i));
+        }
+        len = bytes + 1;
+    }
+    append_raw(w, (const char *) head, len);
+}
+
+// Opens an array or map of indefinite length, which is closed by CBOR_BREAK
+static void cbor_open(telemetry_writer *w, uint8_t major) {
+    cbor_byte(w, (uint8_t) (major << 5 | 31));
+}
+
+static void cbor_int(telemetry_writer *w, int64_t value) {
+    if (value < 0) {
+        cbor_head(w, CBOR_NEGATIVE, (uint64_t) (-1 - value));
+    } else {
+        cbor_head(w, CBOR_UNSIGNED, (uint64_t) value);
+    }
+}
+
+static void cbor_text(telemetry_writer *w, const char *str) {
+    const size_t len = strlen(str);
+    cbor_head(w, CBOR_TEXT, len);
+    append_raw(w, str, len);
+}
+
+static void cbor_number(telemetry_writer *w, double value) {
+    if (isnan(value) || isinf(value)) {
+        cbor_byte(w, CBOR_NULL); // same as JSON
+    } else if (value == trunc(value) && fabs(value) < 9007199254740992.0) { // 2^53
+        cbor_int(w, (int64_t) value);
+    } else {
+        // float32 if that is exact, like for values that came from a float, and float64 otherwise
+        const float single = (float) value;
+        uint8_t bytes[9];
+        size_t len;
+        if ((double) single == value) {
+            uint32_t bits;
+            memcpy(&bits, &single, sizeof(bits));
+            bytes[0] = CBOR_FLOAT32;
+            for (size_t i = 0; i < 4; i++) {
+                bytes[4 - i] = (uint8_t) (bits >> (8 * i));
+            }
+            len = 5;
+        } else {
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            bytes[0] = CBOR_FLOAT64;
+            for (size_t i = 0; i < 8; i++) {
+                bytes[8 - i] = (uint8_t) (bits >> (8 * i));
+            }
+            len = 9;
+        }
+        append_raw(w, (const char *) bytes, len);
+    }
+}
+
+static void cbor_field_name(telemetry_writer *w, const char *name) {
+    for (size_t i = 0; i < sizeof(cbor_field_keys) / sizeof(cbor_field_keys[0]); i++) {
+        if (0 == strcmp(cbor_field_keys[i].name, name)) {
+            cbor_head(w, CBOR_UNSIGNED, cbor_field_keys[i].key);
+            return;
+        }
+    }
+    cbor_text(w, name);
+}
+
+// Encodes the binary message in place. The text is longer, so it is written from the end backwards, where
+// each group of 4 characters only overwrites bytes that were encoded already.
+static void base64_encode_in_place(telemetry_writer *w) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    uint8_t *data = (uint8_t *) w->buffer;
+    const size_t groups = (w->length + 2) / 3;
+    for (size_t i = groups; i-- > 0;) {
+        const size_t remaining = w->length - 3 * i;
+        const uint32_t bits = (uint32_t) data[3 * i] << 16
+                | (remaining > 1 ? (uint32_t) data[3 * i + 1] << 8 : 0)
+                | (remaining > 2 ? data[3 * i + 2] : 0);
+        char *out = &w->buffer[4 * i];
+        out[3] = remaining > 2 ? alphabet[bits & 0x3f] : '=';
+        out[2] = remaining > 1 ? alphabet[(bits >> 6) & 0x3f] : '=';
+        out[1] = alphabet[(bits >> 12) & 0x3f];
+        out[0] = alphabet[bits >> 18];
+    }
+    w->length = 4 * groups;
+    w->buffer[w->length] = 0;
+}
+
+void telemetry_format_iso_time(time_t timestamp, char *buffer, size_t size) {
+    struct tm t;
+    gmtime_r(&timestamp, &t);
+    if (0 == strftime(buffer, size, "%Y-%m-%dT%H:%M:%S.000Z", &t) && size > 0) {
+        buffer[0] = 0;
+    }
+}
+
+void telemetry_writer_init(telemetry_writer *w, char *buffer, size_t size) {
+    telemetry_writer_init_format(w, buffer, size, TELEMETRY_FORMAT_JSON);
+}
+
+void telemetry_writer_init_format(telemetry_writer *w, char *buffer, size_t size, telemetry_format format) {
+    w->format = format;
+    w->message_time = 0;
+    w->buffer = buffer;
+    w->size = size;
+    w->length = 0;
+    w->overflow = (NULL == buffer || 0 == size);
+    w->has_datapoint = false;
+    w->has_field = false;
+    if (!w->overflow) {
+        buffer[0] = 0;
+    }
+}
+
+void telemetry_writer_begin_message(telemetry_writer *w, time_t now) {
+    IotclConfig *config = iotcl_get_config();
+    if (!config) {
+        w->overflow = true; // nothing sensible can be produced
+        return;
+    }
+    w->message_time = now;
+    if (TELEMETRY_FORMAT_CBOR == w->format) {
+        cbor_open(w, CBOR_MAP);
+        cbor_head(w, CBOR_UNSIGNED, CBOR_KEY_ENCODING);
+        cbor_head(w, CBOR_UNSIGNED, TELEMETRY_CBOR_VERSION);
+        cbor_head(w, CBOR_UNSIGNED, CBOR_KEY_CPID);
+        cbor_text(w, config->device.cpid ? config->device.cpid : "");
+        cbor_head(w, CBOR_UNSIGNED, CBOR_KEY_DTG);
+        cbor_text(w, config->telemetry.dtg ? config->telemetry.dtg : "");
+        cbor_head(w, CBOR_UNSIGNED, CBOR_KEY_ENV);
+        cbor_text(w, config->device.env ? config->device.env : "");
+        cbor_head(w, CBOR_UNSIGNED, CBOR_KEY_DUID);
+        cbor_text(w, config->device.duid ? config->device.duid : "");
+        cbor_head(w, CBOR_UNSIGNED, CBOR_KEY_TIME);
+        cbor_int(w, (int64_t) now);
+        cbor_head(w, CBOR_UNSIGNED, CBOR_KEY_DATAPOINTS);
+        cbor_open(w, CBOR_ARRAY);
+        return;
+    }
+    append(w, "{\"cpId\":");
+    append_string(w, config->device.cpid ? config->device.cpid : "");
+    append(w, ",\"dtg\":");
+    append_string(w, config->telemetry.dtg ? config->telemetry.dtg : "");
+    append(w, ",\"mt\":0,\"sdk\":{\"l\":\"" CONFIG_IOTCONNECT_SDK_NAME "\",\"v\":\"" CONFIG_IOTCONNECT_SDK_VERSION "\",\"e\":");
+    append_string(w, config->device.env ? config->device.env : "");
+    append(w, "},\"t\":");
+    append_iso_time(w, now);
+    append(w, ",\"d\":[");
+}
+
+void telemetry_writer_begin_datapoint(telemetry_writer *w, time_t timestamp) {
+    if (TELEMETRY_FORMAT_CBOR == w->format) {
+        w->has_datapoint = true;
+        cbor_open(w, CBOR_MAP);
+        cbor_head(w, CBOR_UNSIGNED, CBOR_KEY_DATAPOINT_TIME);
+        cbor_int(w, (int64_t) (timestamp - w->message_time));
+        return;
+    }
+    IotclConfig *config = iotcl_get_config();
+    if (w->has_datapoint) {
+        append_raw(w, ",", 1);
+    }
+    w->has_datapoint = true;
+    w->has_field = false;
+    append(w, "{\"id\":");
+    append_string(w, (config && config->device.duid) ? config->device.duid : "");
+    append(w, ",\"tg\":\"\",\"dt\":");
+    append_iso_time(w, timestamp);
+    append(w, ",\"d\":{");
+}
+
+void telemetry_writer_add_string(telemetry_writer *w, const char *name, const char *value) {
+    if (TELEMETRY_FORMAT_CBOR == w->format) {
+        cbor_field_name(w, name);
+        cbor_text(w, value);
+        return;
+    }
+    append_field_name(w, name);
+    append_string(w, value);
+}
+
+void telemetry_writer_add_number(telemetry_writer *w, const char *name, double value) {
+    if (TELEMETRY_FORMAT_CBOR == w->format) {
+        cbor_field_name(w, name);
+        cbor_number(w, value);
+        return;
+    }
+    append_field_name(w, name);
+    if (isnan(value) || isinf(value)) {
+        append(w, "null"); // same as cJSON
+    } else {
+        append_json_number(w, value);
+    }
+}
+
+void telemetry_writer_end_datapoint(telemetry_writer *w) {
+    if (TELEMETRY_FORMAT_CBOR == w->format) {
+        cbor_byte(w, CBOR_BREAK);
+        return;
+    }
+    append(w, "}}");
+}
+
+void telemetry_writer_add_sample(telemetry_writer *w, const char *version, const telemetry_sample *sample) {
+    telemetry_writer_begin_datapoint(w, sample->timestamp);
+    telemetry_writer_add_string(w, "version", version);
+    if (sample->has_sensor_values) {
+        telemetry_writer_add_number(w, "temperature", sample->temperature);
+        telemetry_writer_add_number(w, "button_counter", sample->button_counter);
+    }
+    telemetry_writer_end_datapoint(w);
+}
+
+const char *telemetry_writer_finish(telemetry_writer *w) {
+    if (TELEMETRY_FORMAT_CBOR == w->format) {
+        cbor_byte(w, CBOR_BREAK); // data points
+        cbor_byte(w, CBOR_BREAK); // message
+        if (w->overflow) {
+            return NULL;
+        }
+        base64_encode_in_place(w);
+        return w->buffer;
+    }
+    append(w, "]}");
+    if (w->overflow) {
+        return NULL;
+    }
+    return w->buffer;
+}
@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+#
+# Copyright: Avnet 2023
+#
+# Compresses a firmware image (or a delta from delta-generate.py) into the container that
+# rot-sample/src/lzss_stream.c decompresses while the update is downloaded.
+# The bit stream is the same as the one of heatshrink with the same window and lookahead sizes.
+# The firmware driver decompresses a file that starts with the "HSZ1" magic of the container and programs
+# any other file as it is, so the file uploaded for an update can be compressed or not.
+# host/tests/test_lzss_stream.c decompresses the output of this script with lzss_stream.c.
+#
+# Usage:
+#   compress-image.py [-w window_bits] [-l lookahead_bits] <image> <output>
+#   compress-image.py --bench [-w window_bits] [-l lookahead_bits] <image> [<image> ...]
+#     - report compression ratio and decoder RAM for each image
+
+import struct
+import sys
+
+MAGIC = 0x315A5348  # "HSZ1"
+HEADER_SIZE = 12
+DECODER_STATE_SIZE = 64      # lzss_stream fields other than the window and the output buffer
+DECODER_OUTPUT_SIZE = 128    # LZSS_STREAM_OUTPUT_SIZE
+MAX_WINDOW_BITS = 11         # LZSS_STREAM_MAX_WINDOW_BITS
+MAX_CHAIN = 64               # match candidates to try at each position
+
+
+class BitWriter:
+    def __init__(self):
+        self.out = bytearray()
+        self.current = 0
+        self.count = 0
+
+    def put(self, value, bits):
+        for i in range(bits - 1, -1, -1):
+            self.current = (self.current << 1) | ((value >> i) & 1)
+            self.count += 1
+            if self.count == 8:
+                self.out.append(self.current)
+                self.current = 0
+                self.count = 0
+
+    def finish(self):
+        if self.count:
+            self.out.append(self.current << (8 - self.count))
+        return bytes(self.out)
+
+
+def compress(data, window_bits, lookahead_bits):
+    window = 1 << window_bits
+    max_count = 1 << lookahead_bits
+    # a back reference must be shorter than the literals it replaces
+    min_count = (1 + window_bits + lookahead_bits) // 9 + 1
+    chains = {}
+    writer = BitWriter()
+    position = 0
+    while position < len(data):
+        best_count, best_distance = 0, 0
+        key = data[position:position + 3]
+        if len(key) == 3:
+            for candidate in reversed(chains.get(key, [])[-MAX_CHAIN:]):
+                distance = position - candidate
+                if distance > window:
+                    break
+                count = 0
+                while count < max_count and position + count < len(data) \
+                        and data[candidate + count] == data[position + count]:
+                    count += 1
+                if count > best_count:
+                    best_count, best_distance = count, distance
+                    if count == max_count:
+                        break
+        step = 1
+        if best_count >= max(min_count, 3):
+            writer.put(0, 1)
+            writer.put(best_distance - 1, window_bits)
+            writer.put(best_count - 1, lookahead_bits)
+            step = best_count
+        else:
+            writer.put(1, 1)
+            writer.put(data[position], 8)
+        for i in range(position, position + step):
+            k = data[i:i + 3]
+            if len(k) == 3:
+                chain = chains.setdefault(k, [])
+                chain.append(i)
+                if len(chain) > 2 * MAX_CHAIN:
+                    del chain[:MAX_CHAIN]
+        position += step
+    header = struct.pack('<IBBHI', MAGIC, window_bits, lookahead_bits, 0, len(data))
+    return header + writer.finish()
+
+
+def decompress(blob):
+    magic, window_bits, lookahead_bits, _, size = struct.unpack_from('<IBBHI', blob, 0)
+    if magic != MAGIC:
+        raise ValueError('Not a compressed image')
+    out = bytearray()
+    bit_position = HEADER_SIZE * 8
+
+    def get(bits):
+        nonlocal bit_position
+        value = 0
+        for _ in range(bits):
+            byte = blob[bit_position >> 3]
+            value = (value << 1) | ((byte >> (7 - (bit_position & 7))) & 1)
+            bit_position += 1
+        return value
+
+    while len(out) < size:
+        if get(1):
+            out.append(get(8))
+        else:
+            distance = get(window_bits) + 1
+            count = get(lookahead_bits) + 1
+            for _ in range(count):
+                out.append(out[-distance] if distance <= len(out) else 0)
+    if len(out) != size or (bit_position + 7) // 8 != len(blob):
+        raise ValueError('Corrupted compressed image')
+    return bytes(out)
+
+
+def parse_args(args):
+    options = {'-w': 11, '-l': 4}
+    files = []
+    while args:
+        arg = args.pop(0)
+        if arg in options:
+            options[arg] = int(args.pop(0))
+        else:
+            files.append(arg)
+    if not 4 <= options['-w'] <= MAX_WINDOW_BITS or not 3 <= options['-l'] < options['-w']:
+        sys.exit('Window bits must be 4..%d and lookahead bits 3..window bits - 1' % MAX_WINDOW_BITS)
+    return options['-w'], options['-l'], files
+
+
+def main():
+    args = sys.argv[1:]
+    bench = bool(args) and args[0] == '--bench'
+    if bench:
+        args.pop(0)
+    window_bits, lookahead_bits, files = parse_args(args)
+
+    if bench and files:
+        # The decoder RAM is static, sized by LZSS_STREAM_MAX_WINDOW_BITS rather than by the stream
+        ram = (1 << MAX_WINDOW_BITS) + DECODER_OUTPUT_SIZE + DECODER_STATE_SIZE
+        print('Window %d bits, lookahead %d bits. Peak decoder RAM: about %d bytes'
+              % (window_bits, lookahead_bits, ram))
+        print('%-40s %10s %10s %8s' % ('image', 'size', 'compressed', 'ratio'))
+        for path in files:
+            with open(path, 'rb') as f:
+                data = f.read()
+            blob = compress(data, window_bits, lookahead_bits)
+            if decompress(blob) != data:
+                sys.exit('ERROR: %s does not decompress to the original' % path)
+            print('%-40s %10d %10d %7.1f%%' % (path[-40:], len(data), len(blob),
+                                               100.0 * len(blob) / max(len(data), 1)))
+    elif not bench and len(files) == 2:
+        with open(files[0], 'rb') as f:
+            data = f.read()
+        blob = compress(data, window_bits, lookahead_bits)
+        if decompress(blob) != data:
+            sys.exit('ERROR: The image does not decompress to the original')
+        with open(files[1], 'wb') as f:
+            f.write(blob)
+        print('Wrote %d bytes (%.1f%% of %d)' % (len(blob), 100.0 * len(blob) / max(len(data), 1), len(data)))
+    else:
+        sys.exit('Usage: compress-image.py [-w window_bits] [-l lookahead_bits] <image> <output>\n'
+                 '       compress-image.py --bench [-w window_bits] [-l lookahead_bits] <image> [<image> ...]')
+
+
+if __name__ == '__main__':
+    main()
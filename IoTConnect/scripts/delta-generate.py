@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+#
+# Copyright: Avnet 2023
+#
+# Generates a binary delta between the image in the active slot of the device and a new image,
+# in the format applied by rot-sample/src/delta_patch.c while the update is downloaded.
+#
+# Both images must be the signed, but not encrypted, non-secure images, exactly as they are
+# stored in the slot, because the delta is applied against the flash contents.
+# The device accepts deltas only if its firmware driver is built with ADU_PSA_DRIVER_DELTA and the
+# address of the active slot (see NetXDuo/App/nx_azure_iot_adu_agent_psa_driver.c).
+# host/tests/test_delta_patch.c applies the output of this script with delta_patch.c.
+#
+# Usage:
+#   delta-generate.py <old image> <new image> <delta>   - write the delta
+#   delta-generate.py --bench <old image> <new image>   - report transferred bytes vs. the full image
+
+import hashlib
+import struct
+import sys
+import time
+
+MAGIC = 0x31544C44  # "DLT1"
+OP_COPY = 0x01
+OP_INSERT = 0x02
+OP_ADD = 0x03
+
+BLOCK = 32          # minimum length of a COPY match
+MIN_ADD_ZEROS = 0.5  # use ADD instead of INSERT when at least this fraction of the differences is zero
+
+
+def index_source(source):
+    index = {}
+    for offset in range(0, len(source) - BLOCK + 1):
+        index.setdefault(source[offset:offset + BLOCK], offset)
+    return index
+
+
+def emit_literal(ops, source, target, start, end, source_hint):
+    # Code that only moved keeps most bytes equal to the source at the same relative position,
+    # which ADD turns into zeros that compress well.
+    length = end - start
+    if length == 0:
+        return
+    if 0 <= source_hint and source_hint + length <= len(source):
+        diff = bytes((target[start + i] - source[source_hint + i]) & 0xFF for i in range(length))
+        if diff.count(0) >= length * MIN_ADD_ZEROS:
+            ops.append(struct.pack('<BII', OP_ADD, length, source_hint) + diff)
+            return
+    ops.append(struct.pack('<BI', OP_INSERT, length) + target[start:end])
+
+
+def generate(source, target):
+    index = index_source(source)
+    ops = []
+    # source_hint is the source position that corresponds to literal_start, following the last COPY
+    literal_start = 0
+    source_hint = 0
+    position = 0
+    while position + BLOCK <= len(target):
+        match = index.get(target[position:position + BLOCK])
+        if match is None:
+            position += 1
+            continue
+        length = BLOCK
+        while position + length < len(target) and match + length < len(source) \
+                and target[position + length] == source[match + length]:
+            length += 1
+        emit_literal(ops, source, target, literal_start, position, source_hint)
+        ops.append(struct.pack('<BII', OP_COPY, length, match))
+        position += length
+        literal_start = position
+        source_hint = match + length
+    emit_literal(ops, source, target, literal_start, len(target), source_hint)
+
+    header = struct.pack('<IIII', MAGIC, len(source), len(target), 0) + hashlib.sha256(source).digest()
+    return header + b''.join(ops)
+
+
+def apply(source, delta):
+    magic, source_size, target_size, flags = struct.unpack_from('<IIII', delta, 0)
+    if magic != MAGIC or flags != 0:
+        raise ValueError('Not a delta')
+    if source_size != len(source) or delta[16:48] != hashlib.sha256(source).digest():
+        raise ValueError('The delta was made against a different image')
+    target = bytearray()
+    position = 48
+    while len(target) < target_size:
+        op = delta[position]
+        if op == OP_COPY:
+            length, offset = struct.unpack_from('<II', delta, position + 1)
+            target += source[offset:offset + length]
+            position += 9
+        elif op == OP_INSERT:
+            length, = struct.unpack_from('<I', delta, position + 1)
+            target += delta[position + 5:position + 5 + length]
+            position += 5 + length
+        elif op == OP_ADD:
+            length, offset = struct.unpack_from('<II', delta, position + 1)
+            data = delta[position + 9:position + 9 + length]
+            target += bytes((source[offset + i] + data[i]) & 0xFF for i in range(length))
+            position += 9 + length
+        else:
+            raise ValueError('Unknown op 0x%x at %d' % (op, position))
+    if position != len(delta):
+        raise ValueError('Trailing data')
+    return bytes(target)
+
+
+def read(path):
+    with open(path, 'rb') as f:
+        return f.read()
+
+
+def main():
+    if len(sys.argv) == 4 and sys.argv[1] == '--bench':
+        source, target = read(sys.argv[2]), read(sys.argv[3])
+        start = time.perf_counter()
+        delta = generate(source, target)
+        generate_time = time.perf_counter() - start
+        if apply(source, delta) != target:
+            sys.exit('ERROR: The delta does not reproduce the new image')
+        print('Full image:  %8d bytes' % len(target))
+        print('Delta:       %8d bytes (%.1f%% of the full image)' % (len(delta), 100.0 * len(delta) / len(target)))
+        print('Generate:    %8.3f s' % generate_time)
+    elif len(sys.argv) == 4:
+        source, target = read(sys.argv[1]), read(sys.argv[2])
+        delta = generate(source, target)
+        if apply(source, delta) != target:
+            sys.exit('ERROR: The delta does not reproduce the new image')
+        with open(sys.argv[3], 'wb') as f:
+            f.write(delta)
+        print('Wrote %d bytes (%.1f%% of %d)' % (len(delta), 100.0 * len(delta) / len(target), len(target)))
+    else:
+        sys.exit('Usage: delta-generate.py <old image> <new image> <delta>\n'
+                 '       delta-generate.py --bench <old image> <new image>')
+
+
+if __name__ == '__main__':
+    main()
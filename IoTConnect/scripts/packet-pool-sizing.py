@@ -0,0 +1,295 @@
+#!/usr/bin/env python3
+#
+# Copyright: Avnet 2023
+#
+# Replays device traffic through a model of the NetX packet pool that MX_NetXDuo_Init() creates (AppPool)
+# at different packet payload sizes. Reports pool exhaustion, packet chaining and wasted payload bytes
+# and recommends PAYLOAD_SIZE and NX_PACKET_POOL_SIZE.
+#
+# This is a sizing model, not a test. It does not run NetX or the Ethernet driver, and its results are only
+# as good as the constants below and the trace. Check a recommendation on the board with the pool statistics
+# of nx_packet_pool_info_get() before relying on it. With --config, the pool size and the current payload size
+# are read from the app_netxduo.h of the CubeMX project, which is generated and not kept in this repository.
+#
+# The traffic is a CSV trace with one TLS record per line:
+#   time_ms,direction,kind,bytes
+# direction is rx or tx, kind is a free form label (mqtt, tls, http...) and bytes is the length of the record
+# on the wire, including the 5 byte record header. A trace can be taken from a capture with, for example:
+#   tshark -r capture.pcapng -Y tls.record -T fields -E separator=, -e frame.time_relative -e ip.src -e tls.record.length
+# and converted to milliseconds, rx/tx by the device address, and the record length + 5.
+# Without a trace, a synthetic one is generated from the app configuration: a connect, telemetry, commands
+# and a firmware download. Write it out with --write-trace to edit it.
+#
+# Model:
+# - TX records are split into TCP segments of up to MSS bytes. Each segment takes the TCP/IP/Ethernet headers
+#   and is a chain of packets if it does not fit into one. Segments are held until they are acknowledged.
+# - RX frames are received into a packet each, chained if the frame does not fit. NetX Secure holds all
+#   segments of a record until the record is complete and decrypted.
+# - The Ethernet driver keeps DRIVER_RX_PACKETS packets queued for reception at all times.
+# - The pool memory is the same for every payload size, so smaller payloads give more packets.
+# The STM32 Ethernet driver receives each frame into a single packet, so payload sizes that do not fit a full
+# frame are reported, but only recommended with --rx-chaining, for a driver that chains received frames.
+#
+# Usage: packet-pool-sizing.py [trace.csv|synthetic] [pool bytes] [--config app_netxduo.h] [--write-trace file]
+#                              [--rx-chaining]
+
+import heapq
+import math
+import random
+import re
+import sys
+
+PACKET_HEADER = 56          # sizeof(NX_PACKET) on Cortex-M33 with NetX Secure
+PACKET_ALIGNMENT = 4
+FRAME_HEADERS = 14 + 20 + 20 + 2  # Ethernet, IPv4 and TCP headers, and the 2 byte alignment of the driver
+MSS = 1460
+MAX_FRAME = MSS + FRAME_HEADERS
+DRIVER_RX_PACKETS = 4
+LINK_BYTES_PER_MS = 1250    # 10 Mbit/s effective
+RTT_MS = 40                 # TX segments stay in the pool until they are acknowledged
+RECORD_PROCESSING_MS = 5    # decryption and hand over of a complete RX record
+PAYLOAD_SIZES = (256, 512, 768, 1024, 1200, 1536, 1600, 2048)
+DEFAULT_POOL_SIZE = (1536 + PACKET_HEADER) * 60
+HEADROOM = 1.25             # margin over the peak use for the recommendation
+
+# synthetic trace, see iotconnect_app_config.h
+TELEMETRY_INTERVAL_MS = 5000    # APP_TELEMETRY_SAMPLE_INTERVAL_MS
+TELEMETRY_BYTES = 280
+COMMAND_INTERVAL_MS = 60000
+OTA_IMAGE_SIZE = 512 * 1024
+OTA_RECORD_SIZE = 16384     # blob storage sends full size TLS records
+TLS_OVERHEAD = 5 + 8 + 16   # record header, explicit nonce and tag of AES-GCM
+SYNTHETIC_DURATION_MS = 600000
+
+
+def align(size):
+    return (size + PACKET_ALIGNMENT - 1) // PACKET_ALIGNMENT * PACKET_ALIGNMENT
+
+
+def synthetic_trace(seed=1):
+    rng = random.Random(seed)
+    trace = []
+
+    def record(time_ms, direction, kind, size):
+        trace.append((time_ms, direction, kind, size))
+
+    # TLS handshake: client hello, server hello with the certificate chain, client certificate and verify
+    record(0, 'tx', 'tls', 250)
+    record(40, 'rx', 'tls', 110)
+    record(41, 'rx', 'tls', 4800)
+    record(42, 'rx', 'tls', 350)
+    record(43, 'rx', 'tls', 120)
+    record(300, 'tx', 'tls', 900)
+    record(301, 'tx', 'tls', 120)
+    record(302, 'tx', 'tls', 80)
+    record(350, 'rx', 'tls', 60)
+    # MQTT connect, subscribe and the twin/sync response
+    record(400, 'tx', 'mqtt', 220 + TLS_OVERHEAD)
+    record(450, 'rx', 'mqtt', 4 + TLS_OVERHEAD)
+    record(460, 'tx', 'mqtt', 80 + TLS_OVERHEAD)
+    record(510, 'rx', 'mqtt', 900 + TLS_OVERHEAD)
+
+    time_ms = 1000
+    while time_ms < SYNTHETIC_DURATION_MS:
+        record(time_ms, 'tx', 'mqtt', TELEMETRY_BYTES + rng.randint(0, 40) + TLS_OVERHEAD)
+        record(time_ms + RTT_MS, 'rx', 'mqtt', 4 + TLS_OVERHEAD)
+        time_ms += TELEMETRY_INTERVAL_MS
+
+    time_ms = COMMAND_INTERVAL_MS
+    while time_ms < SYNTHETIC_DURATION_MS:
+        record(time_ms, 'rx', 'mqtt', rng.randint(250, 400) + TLS_OVERHEAD)
+        record(time_ms + 20, 'tx', 'mqtt', rng.randint(150, 250) + TLS_OVERHEAD)
+        time_ms += COMMAND_INTERVAL_MS
+
+    # firmware download over a second TLS connection, while the telemetry continues
+    time_ms = SYNTHETIC_DURATION_MS // 2
+    record(time_ms, 'tx', 'tls', 250)
+    record(time_ms + 40, 'rx', 'tls', 5200)
+    record(time_ms + 300, 'tx', 'tls', 200)
+    record(time_ms + 340, 'tx', 'http', 600 + TLS_OVERHEAD)
+    time_ms += 400
+    remaining = OTA_IMAGE_SIZE
+    while remaining > 0:
+        size = min(OTA_RECORD_SIZE, remaining)
+        record(time_ms, 'rx', 'http', size + TLS_OVERHEAD)
+        # the next record starts arriving once this one is on the wire
+        time_ms += math.ceil((size + TLS_OVERHEAD) / LINK_BYTES_PER_MS)
+        remaining -= size
+    return sorted(trace)
+
+
+def read_trace(path):
+    trace = []
+    with open(path) as f:
+        for line_number, line in enumerate(f, 1):
+            line = line.strip()
+            if not line or line.startswith('#'):
+                continue
+            fields = [field.strip() for field in line.split(',')]
+            if len(fields) != 4 or fields[1] not in ('rx', 'tx'):
+                raise ValueError('%s:%d: expected time_ms,rx|tx,kind,bytes' % (path, line_number))
+            trace.append((float(fields[0]), fields[1], fields[2], int(fields[3])))
+    return sorted(trace)
+
+
+def write_trace(path, trace):
+    with open(path, 'w') as f:
+        f.write('# time_ms,direction,kind,bytes\n')
+        for time_ms, direction, kind, size in trace:
+            f.write('%g,%s,%s,%d\n' % (time_ms, direction, kind, size))
+
+
+def segments(size):
+    while size > 0:
+        segment = min(MSS, size)
+        yield segment
+        size -= segment
+
+
+class Result:
+    def __init__(self, payload_size, packet_count):
+        self.payload_size = payload_size
+        self.packet_count = packet_count
+        self.peak = 0
+        self.exhausted = 0          # allocations that found the pool empty
+        self.exhausted_kinds = {}
+        self.max_chain = 0
+        self.chains = 0
+        self.frames = 0
+        self.used_bytes = 0
+        self.allocated_bytes = 0
+
+
+def simulate(trace, payload_size, packet_count):
+    # Releases are kept in a heap of (time, packets). Allocation failures are counted, and the packets
+    # that could not be allocated are not held, like a dropped frame or a failed send.
+    result = Result(payload_size, packet_count)
+    in_use = DRIVER_RX_PACKETS * math.ceil(MAX_FRAME / payload_size)
+    result.peak = in_use
+    releases = []
+    for time_ms, direction, kind, size in trace:
+        while releases and releases[0][0] <= time_ms:
+            in_use -= heapq.heappop(releases)[1]
+        record_packets = 0
+        record_end_ms = time_ms
+        failed = False
+        for segment in segments(size):
+            frame = segment + FRAME_HEADERS
+            chain = math.ceil(frame / payload_size)
+            result.frames += 1
+            result.max_chain = max(result.max_chain, chain)
+            if chain > 1:
+                result.chains += 1
+            result.used_bytes += frame
+            result.allocated_bytes += chain * payload_size
+            if in_use + record_packets + chain > packet_count:
+                failed = True
+                continue
+            record_packets += chain
+            record_end_ms += frame / LINK_BYTES_PER_MS
+            if 'tx' == direction:
+                # each segment is released when it is acknowledged
+                heapq.heappush(releases, (record_end_ms + RTT_MS, chain))
+        if failed:
+            result.exhausted += 1
+            result.exhausted_kinds[kind] = result.exhausted_kinds.get(kind, 0) + 1
+        if 'tx' == direction:
+            in_use += record_packets
+        else:
+            # all segments of the record are held until the record is complete and decrypted
+            in_use += record_packets
+            heapq.heappush(releases, (record_end_ms + RECORD_PROCESSING_MS, record_packets))
+        result.peak = max(result.peak, in_use)
+    return result
+
+
+def packet_count(pool_size, payload_size):
+    return pool_size // (align(payload_size) + PACKET_HEADER)
+
+
+def read_config(path):
+    # PAYLOAD_SIZE and NX_PACKET_POOL_SIZE, written as ((PAYLOAD_SIZE + sizeof(NX_PACKET)) * packets) by CubeMX,
+    # or as a number of bytes
+    with open(path) as f:
+        text = f.read()
+    payload = re.search(r'#define\s+PAYLOAD_SIZE\s+\(?\s*(\d+)', text)
+    pool = re.search(r'#define\s+NX_PACKET_POOL_SIZE\s+(.+)', text)
+    if not payload or not pool:
+        raise ValueError('%s: PAYLOAD_SIZE or NX_PACKET_POOL_SIZE not found' % path)
+    payload_size = int(payload.group(1))
+    packets = re.search(r'sizeof\s*\(\s*NX_PACKET\s*\)\s*\)\s*\*\s*(\d+)', pool.group(1))
+    if packets:
+        return payload_size, (align(payload_size) + PACKET_HEADER) * int(packets.group(1))
+    size = re.match(r'\(?\s*(\d+)', pool.group(1))
+    if not size:
+        raise ValueError('%s: can not evaluate NX_PACKET_POOL_SIZE %s' % (path, pool.group(1).strip()))
+    return payload_size, int(size.group(1))
+
+
+def main():
+    args = sys.argv[1:]
+    rx_chaining = '--rx-chaining' in args
+    if rx_chaining:
+        args.remove('--rx-chaining')
+    trace_output = None
+    if '--write-trace' in args:
+        i = args.index('--write-trace')
+        trace_output = args[i + 1]
+        del args[i:i + 2]
+    configured_payload = None
+    pool_size = DEFAULT_POOL_SIZE
+    if '--config' in args:
+        i = args.index('--config')
+        configured_payload, pool_size = read_config(args[i + 1])
+        del args[i:i + 2]
+    source = args[0] if len(args) > 0 else 'synthetic'
+    pool_size = int(args[1]) if len(args) > 1 else pool_size
+
+    trace = synthetic_trace() if 'synthetic' == source else read_trace(source)
+    if trace_output:
+        write_trace(trace_output, trace)
+    rx_bytes = sum(record[3] for record in trace if 'rx' == record[1])
+    tx_bytes = sum(record[3] for record in trace if 'tx' == record[1])
+    print('Trace: %s, %d records, %d bytes received, %d bytes sent' % (source, len(trace), rx_bytes, tx_bytes))
+    print('Pool: %d bytes, %d byte packet header\n' % (pool_size, PACKET_HEADER))
+
+    print('%8s %8s %8s %10s %10s %8s %8s %12s' % ('payload', 'packets', 'peak', 'exhausted', 'chained', 'depth',
+                                                  'waste', 'needed pool'))
+    recommendations = []
+    payload_sizes = sorted(set(PAYLOAD_SIZES + ((configured_payload,) if configured_payload else ())))
+    for payload_size in payload_sizes:
+        result = simulate(trace, payload_size, packet_count(pool_size, payload_size))
+        # the same trace with a pool that can not run out gives the peak demand
+        unlimited = simulate(trace, payload_size, 1 << 30)
+        needed_packets = math.ceil(unlimited.peak * HEADROOM)
+        needed_pool = needed_packets * (align(payload_size) + PACKET_HEADER)
+        waste = 100.0 * (result.allocated_bytes - result.used_bytes) / result.allocated_bytes
+        exhausted = '%d' % result.exhausted
+        if result.exhausted_kinds:
+            exhausted += ' ' + '/'.join(sorted(result.exhausted_kinds))
+        fits_frame = payload_size >= MAX_FRAME
+        print('%s%6d%s %8d %8d %10s %9.1f%% %8d %7.1f%% %12d' % (
+            '>' if payload_size == configured_payload else ' ', payload_size, ' ' if fits_frame else '*',
+            result.packet_count, result.peak, exhausted,
+            100.0 * result.chains / result.frames, result.max_chain, waste, needed_pool))
+        if fits_frame or rx_chaining:
+            recommendations.append((needed_pool, unlimited.max_chain, payload_size, needed_packets))
+
+    # the least pool memory without running out, and the shallower chains of the bigger payloads on a tie
+    needed_pool, _, payload_size, needed_packets = min(recommendations)
+    print('\n"exhausted" counts the records that found the pool empty and the kinds of traffic they were,')
+    print('"chained" the frames that needed more than one packet, "depth" the longest chain and "waste" the')
+    print('allocated payload bytes that were not used. "needed pool" fits the peak use with %d%% headroom.'
+          % round((HEADROOM - 1) * 100))
+    if configured_payload:
+        print('> the PAYLOAD_SIZE of the configuration.')
+    if not rx_chaining:
+        print('* does not fit a %d byte frame, which the Ethernet driver needs. See --rx-chaining.' % MAX_FRAME)
+    print('\nRecommended configuration for app_netxduo.h:')
+    print('#define PAYLOAD_SIZE          %d' % payload_size)
+    print('#define NX_PACKET_POOL_SIZE   ((PAYLOAD_SIZE + sizeof(NX_PACKET)) * %d) // %d bytes'
+          % (needed_packets, needed_pool))
+
+
+if __name__ == '__main__':
+    main()
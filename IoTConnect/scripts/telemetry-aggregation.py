@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+#
+# Copyright: Avnet 2023
+#
+# Runs a telemetry trace through the telemetry aggregator (rot-sample/src/telemetry_aggregator.c), compiled for
+# the host with stubs for ThreadX and the IoTConnect library, and reports for each window length and deadband:
+# - the number of messages sent, compared to one message per sample (APP_TELEMETRY_BATCH_SIZE 1),
+# - the bytes of the messages, as formatted by telemetry_writer.c,
+# - the host CPU time of telemetry_aggregator_add() per sample. The mutex is a stub, so add its cost on the
+#   device, a few hundred cycles, to scale the result to the Cortex-M33.
+#
+# The trace is a CSV file with one sample per line:
+#   timestamp,temperature,button_counter
+# with the timestamp in seconds. Without a trace, a synthetic day of samples every
+# APP_TELEMETRY_SAMPLE_INTERVAL_MS is generated: a slow daily temperature swing with sensor noise, a few steps
+# and occasional button pushes. Write it out with --write-trace to edit it.
+#
+# Usage: telemetry-aggregation.py [trace.csv|synthetic] [heartbeat windows] [--write-trace file]
+
+import math
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+SAMPLE_INTERVAL_S = 5           # APP_TELEMETRY_SAMPLE_INTERVAL_MS
+BUTTON_DEADBAND = 0.5           # APP_AGGREGATION_BUTTON_DEADBAND, any push
+WINDOWS_S = [0, 30, 60, 300, 900]
+TEMPERATURE_DEADBANDS = [0, 0.25, 0.5, 1.0]
+MIN_TIMED_SAMPLES = 2000000
+SRC = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'rot-sample')
+
+TX_API_H = r'''
+#define TX_SUCCESS 0
+#define TX_INHERIT 1
+#define TX_WAIT_FOREVER 0xFFFFFFFFUL
+typedef unsigned long ULONG;
+typedef unsigned int UINT;
+typedef int TX_MUTEX;
+#define tx_mutex_create(m, name, inherit) TX_SUCCESS
+#define tx_mutex_get(m, wait) TX_SUCCESS
+#define tx_mutex_put(m) TX_SUCCESS
+'''
+
+IOTCONNECT_LIB_H = r'''
+typedef struct {
+    struct { const char *cpid; const char *env; const char *duid; } device;
+    struct { const char *dtg; } telemetry;
+} IotclConfig;
+IotclConfig *iotcl_get_config(void);
+'''
+
+HARNESS_C = r'''
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "iotconnect_lib.h"
+#include "telemetry_aggregator.h"
+
+static IotclConfig config = {{"avtds", "poc", "stm32h5-0123456789"}, {"5a2b3c4d-0000-4000-8000-0123456789ab"}};
+IotclConfig *iotcl_get_config(void) { return &config; }
+
+static char buffer[4096];
+
+static size_t aggregate_bytes(const telemetry_aggregate *aggregate) {
+    telemetry_writer w;
+    telemetry_writer_init(&w, buffer, sizeof(buffer));
+    telemetry_writer_begin_message(&w, aggregate->start);
+    telemetry_writer_begin_datapoint(&w, aggregate->start);
+    telemetry_writer_add_string(&w, "version", "1.1.0");
+    telemetry_aggregator_write_fields(&w, aggregate);
+    telemetry_writer_end_datapoint(&w);
+    return strlen(telemetry_writer_finish(&w));
+}
+
+static size_t sample_bytes(const telemetry_sample *sample) {
+    telemetry_writer w;
+    telemetry_writer_init(&w, buffer, sizeof(buffer));
+    telemetry_writer_begin_message(&w, sample->timestamp);
+    telemetry_writer_add_sample(&w, "1.1.0", sample);
+    return strlen(telemetry_writer_finish(&w));
+}
+
+static void start(telemetry_aggregator *aggregator, uint32_t window_s, double deadband, double button_deadband,
+        uint32_t heartbeat) {
+    telemetry_aggregator_init(aggregator, window_s, heartbeat);
+    telemetry_aggregator_add_field(aggregator, "temperature", deadband);
+    telemetry_aggregator_add_field(aggregator, "button_counter", button_deadband);
+}
+
+// Usage: harness trace window_s deadband button_deadband heartbeat timed_samples
+// Prints: samples messages bytes ns_per_sample
+int main(int argc, char *argv[]) {
+    FILE *f = fopen(argv[1], "r");
+    size_t count = 0, capacity = 1024;
+    telemetry_sample *samples = malloc(capacity * sizeof(*samples));
+    long timestamp;
+    double temperature;
+    unsigned long button_counter;
+    while (3 == fscanf(f, "%ld,%lf,%lu", &timestamp, &temperature, &button_counter)) {
+        if (count == capacity) {
+            capacity *= 2;
+            samples = realloc(samples, capacity * sizeof(*samples));
+        }
+        samples[count].timestamp = (time_t) timestamp;
+        samples[count].temperature = temperature;
+        samples[count].button_counter = (uint32_t) button_counter;
+        samples[count].has_sensor_values = true;
+        count++;
+    }
+    fclose(f);
+    const uint32_t window_s = (uint32_t) atol(argv[2]);
+    const double deadband = atof(argv[3]);
+    const double button_deadband = atof(argv[4]);
+    const uint32_t heartbeat = (uint32_t) atol(argv[5]);
+    const long timed_samples = atol(argv[6]);
+
+    static telemetry_aggregator aggregator;
+    telemetry_aggregate aggregate;
+    bool report;
+    unsigned long messages = 0, bytes = 0;
+    start(&aggregator, window_s, deadband, button_deadband, heartbeat);
+    for (size_t i = 0; i < count; i++) {
+        const double values[] = {samples[i].temperature, samples[i].button_counter};
+        const bool aggregated = telemetry_aggregator_add(&aggregator, samples[i].timestamp, values, &aggregate,
+                &report);
+        if (report) {
+            messages++;
+            bytes += aggregate_bytes(&aggregate);
+        }
+        if (!aggregated) {
+            messages++;
+            bytes += sample_bytes(&samples[i]);
+        }
+    }
+    if (count && telemetry_aggregator_poll(&aggregator, samples[count - 1].timestamp + window_s, &aggregate)) {
+        messages++;
+        bytes += aggregate_bytes(&aggregate);
+    }
+
+    double ns_per_sample = 0;
+    if (window_s && count) {
+        unsigned long reported = 0;
+        long timed = 0;
+        const long span = (long) (samples[count - 1].timestamp - samples[0].timestamp) + window_s;
+        struct timespec begin, end;
+        start(&aggregator, window_s, deadband, button_deadband, heartbeat);
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        for (long offset = 0; timed < timed_samples; offset += span) {
+            for (size_t i = 0; i < count; i++, timed++) {
+                const double values[] = {samples[i].temperature, samples[i].button_counter};
+                telemetry_aggregator_add(&aggregator, samples[i].timestamp + offset, values, &aggregate, &report);
+                reported += report;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        ns_per_sample = ((end.tv_sec - begin.tv_sec) * 1e9 + (end.tv_nsec - begin.tv_nsec)) / timed;
+        if (0 == reported) {
+            fprintf(stderr, "nothing reported\n"); // keeps the loop from being optimized away
+        }
+    }
+    printf("%lu %lu %lu %.1f\n", (unsigned long) count, messages, bytes, ns_per_sample);
+    return 0;
+}
+'''
+
+
+def synthetic_trace():
+    rng = random.Random(1)
+    trace = []
+    start = 1700000000 - 1700000000 % 86400
+    step = 0.0
+    buttons = 0
+    for i in range(86400 // SAMPLE_INTERVAL_S):
+        t = i * SAMPLE_INTERVAL_S
+        if rng.random() < 0.0005:
+            step = rng.uniform(-2.0, 2.0)  # a door opens, the heating starts...
+        if rng.random() < 0.002:
+            buttons += 1
+        temperature = 22.0 + 3.0 * math.sin(2 * math.pi * t / 86400.0) + step + rng.gauss(0, 0.1)
+        trace.append((start + t, round(temperature, 2), buttons))
+    return trace
+
+
+def build(directory):
+    for name, content in (('tx_api.h', TX_API_H), ('iotconnect_lib.h', IOTCONNECT_LIB_H),
+                          ('harness.c', HARNESS_C)):
+        with open(os.path.join(directory, name), 'w') as f:
+            f.write(content)
+    binary = os.path.join(directory, 'harness')
+    subprocess.check_call([os.environ.get('CC', 'cc'), '-O2', '-I', directory, '-I', os.path.join(SRC, 'include'),
+                           os.path.join(directory, 'harness.c'),
+                           os.path.join(SRC, 'src', 'telemetry_aggregator.c'),
+                           os.path.join(SRC, 'src', 'telemetry_writer.c'), '-lm', '-o', binary])
+    return binary
+
+
+def main():
+    args = sys.argv[1:]
+    write_trace = None
+    if '--write-trace' in args:
+        i = args.index('--write-trace')
+        write_trace = args[i + 1]
+        del args[i:i + 2]
+    source = args[0] if len(args) > 0 else 'synthetic'
+    heartbeat = int(args[1]) if len(args) > 1 else 10  # APP_AGGREGATION_HEARTBEAT_WINDOWS
+
+    directory = tempfile.mkdtemp()
+    trace_path = os.path.join(directory, 'trace.csv')
+    if source == 'synthetic':
+        with open(trace_path, 'w') as f:
+            for sample in synthetic_trace():
+                f.write('%d,%g,%d\n' % sample)
+    else:
+        with open(source) as f, open(trace_path, 'w') as out:
+            out.writelines(line for line in f if line[:1].isdigit())  # without a header
+    if write_trace:
+        with open(trace_path) as f, open(write_trace, 'w') as out:
+            out.write('timestamp,temperature,button_counter\n' + f.read())
+
+    binary = build(directory)
+    print('Trace: %s, heartbeat every %d windows\n' % (source, heartbeat))
+    print('%8s %9s %9s %10s %9s %10s %9s' % ('window s', 'deadband', 'messages', 'reduction', 'KB', 'bytes red.',
+                                             'ns/sample'))
+    raw_messages = raw_bytes = None
+    for window_s in WINDOWS_S:
+        for deadband in TEMPERATURE_DEADBANDS if window_s else [0]:
+            output = subprocess.check_output([binary, trace_path, str(window_s), str(deadband),
+                                              str(BUTTON_DEADBAND if deadband else 0), str(heartbeat),
+                                              str(MIN_TIMED_SAMPLES)])
+            samples, messages, size, ns = output.split()
+            messages, size = int(messages), int(size)
+            if raw_messages is None:
+                raw_messages, raw_bytes = messages, size
+            print('%8s %9g %9d %9.1fx %9.1f %9.1fx %9s' % (window_s or 'raw', deadband, messages,
+                                                           raw_messages / float(max(messages, 1)), size / 1024.0,
+                                                           raw_bytes / float(max(size, 1)),
+                                                           ns.decode() if window_s else '-'))
+    print('\n%s samples' % samples.decode())
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+#
+# Copyright: Avnet 2023
+#
+# Compares the JSON and the CBOR telemetry format of telemetry_writer.c (rot-sample/src), compiled for the host
+# with a stub of the IoTConnect library, for batches of 1 to 64 samples: the size of the message as published,
+# the size of the CBOR before base64, and the host CPU time to format a whole batch with telemetry_batch.c.
+# The JSON is the same text that iotcl_create_serialized_string() produced for the same data points, so its
+# size is that of the iotc-c-lib message. iotc-c-lib is not part of this repository, so its cJSON based
+# encode time is not measured. It is slower than the JSON writer, which does not allocate.
+#
+# Every CBOR message is decoded and checked against the JSON message of the same batch.
+#
+# Usage: telemetry-encoding.py [batch size ...]
+
+import base64
+import json
+import math
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+from datetime import datetime, timezone
+
+DEFAULT_BATCH_SIZES = [1, 2, 4, 8, 16, 32, 64]
+MIN_TIMED_SAMPLES = 200000
+SRC = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'rot-sample')
+CPID, DTG, ENV, DUID = 'avtds', '5a2b3c4d-0000-4000-8000-0123456789ab', 'poc', 'stm32h5-0123456789'
+CBOR_FIELD_NAMES = {1: 'version', 2: 'temperature', 3: 'button_counter'}  # TELEMETRY_CBOR_KEY_*
+
+IOTCONNECT_LIB_H = r'''
+typedef struct {
+    struct { const char *cpid; const char *env; const char *duid; } device;
+    struct { const char *dtg; } telemetry;
+} IotclConfig;
+IotclConfig *iotcl_get_config(void);
+'''
+
+HARNESS_C = r'''
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "iotconnect_lib.h"
+#include "telemetry_batch.h"
+
+static IotclConfig config = {{"%s", "%s", "%s"}, {"%s"}};
+IotclConfig *iotcl_get_config(void) { return &config; }
+
+static char buffer[32768];
+
+// Temperatures as they come from the DTS window mean, in milli degrees Celsius
+static void make_sample(telemetry_sample *sample, size_t i) {
+    sample->timestamp = 1700000000 + 5 * (time_t) i;
+    sample->temperature = (23000 + (int) ((i * 7919) %% 1500)) / 1000.0;
+    sample->button_counter = (uint32_t) (i / 10);
+    sample->has_sensor_values = true;
+}
+
+static const char *format_batch(telemetry_batch *batch, telemetry_format format, size_t count) {
+    telemetry_batch_set_format(batch, format);
+    telemetry_batch_reset(batch);
+    for (size_t i = 0; i < count; i++) {
+        telemetry_sample sample;
+        make_sample(&sample, i);
+        telemetry_batch_add(batch, &sample, 0);
+    }
+    return telemetry_batch_finish(batch);
+}
+
+// Usage: harness json|cbor batch_size timed_samples
+// Prints the message, then the ns per message on the next line
+int main(int argc, char *argv[]) {
+    const telemetry_format format = 0 == strcmp(argv[1], "cbor") ? TELEMETRY_FORMAT_CBOR : TELEMETRY_FORMAT_JSON;
+    const size_t count = (size_t) atol(argv[2]);
+    const long rounds = atol(argv[3]) / (long) count + 1;
+    const telemetry_batch_policy policy = {count, 0, 0};
+    static telemetry_batch batch;
+    telemetry_batch_init(&batch, &policy, "1.1.0", buffer, sizeof(buffer));
+    const char *message = format_batch(&batch, format, count);
+    if (NULL == message) {
+        return 1;
+    }
+    printf("%%s\n", message);
+
+    size_t length = 0;
+    struct timespec begin, end;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (long i = 0; i < rounds; i++) {
+        length += strlen(format_batch(&batch, format, count));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    printf("%%.0f\n", ((end.tv_sec - begin.tv_sec) * 1e9 + (end.tv_nsec - begin.tv_nsec)) / rounds);
+    return 0 == length;
+}
+''' % (CPID, ENV, DUID, DTG)
+
+
+def cbor_decode(data, offset=0):
+    # returns the item and the offset after it. Only what telemetry_writer.c produces.
+    initial = data[offset]
+    major, info = initial >> 5, initial & 0x1f
+    offset += 1
+    if initial == 0xff:
+        return StopIteration, offset
+    if major == 7:
+        if info == 22:
+            return None, offset
+        if info == 26:
+            return struct.unpack('>f', data[offset:offset + 4])[0], offset + 4
+        if info == 27:
+            return struct.unpack('>d', data[offset:offset + 8])[0], offset + 8
+        raise ValueError('simple value %d' % info)
+    if info == 31:
+        items = []
+        while True:
+            item, offset = cbor_decode(data, offset)
+            if item is StopIteration:
+                break
+            items.append(item)
+        if major == 4:
+            return items, offset
+        if major == 5:
+            return dict(zip(items[0::2], items[1::2])), offset
+        raise ValueError('indefinite major type %d' % major)
+    if info < 24:
+        value = info
+    else:
+        size = 1 << (info - 24)
+        value = int.from_bytes(data[offset:offset + size], 'big')
+        offset += size
+    if major == 0:
+        return value, offset
+    if major == 1:
+        return -1 - value, offset
+    if major == 3:
+        return data[offset:offset + value].decode(), offset + value
+    raise ValueError('major type %d' % major)
+
+
+def iso_time(seconds):
+    return datetime.fromtimestamp(seconds, timezone.utc).strftime('%Y-%m-%dT%H:%M:%S.000Z')
+
+
+def check(json_text, cbor_text):
+    expected = json.loads(json_text)
+    binary = base64.b64decode(cbor_text)
+    message, offset = cbor_decode(binary)
+    assert offset == len(binary), 'trailing bytes'
+    assert message[0] == 1 and message[1] == expected['cpId'] and message[2] == expected['dtg'] \
+        and message[3] == expected['sdk']['e'] and iso_time(message[5]) == expected['t'], message
+    assert len(message[6]) == len(expected['d'])
+    for datapoint, expected_datapoint in zip(message[6], expected['d']):
+        assert message[4] == expected_datapoint['id']
+        assert iso_time(message[5] + datapoint.pop(0)) == expected_datapoint['dt']
+        fields = {CBOR_FIELD_NAMES.get(key, key): value for key, value in datapoint.items()}
+        assert fields.keys() == expected_datapoint['d'].keys(), fields
+        for name, value in fields.items():
+            expected_value = expected_datapoint['d'][name]
+            if isinstance(value, float):
+                assert math.isclose(value, expected_value, rel_tol=1e-14), (name, value, expected_value)
+            else:
+                assert value == expected_value, (name, value, expected_value)
+    return len(binary)
+
+
+def build(directory):
+    for name, content in (('iotconnect_lib.h', IOTCONNECT_LIB_H), ('harness.c', HARNESS_C)):
+        with open(os.path.join(directory, name), 'w') as f:
+            f.write(content)
+    binary = os.path.join(directory, 'harness')
+    subprocess.check_call([os.environ.get('CC', 'cc'), '-O2', '-I', directory, '-I', os.path.join(SRC, 'include'),
+                           os.path.join(directory, 'harness.c'), os.path.join(SRC, 'src', 'telemetry_writer.c'),
+                           os.path.join(SRC, 'src', 'telemetry_batch.c'), '-lm', '-o', binary])
+    return binary
+
+
+def run(binary, format_name, batch_size):
+    output = subprocess.check_output([binary, format_name, str(batch_size), str(MIN_TIMED_SAMPLES)]).decode()
+    message, ns = output.splitlines()
+    return message, float(ns)
+
+
+def main():
+    batch_sizes = [int(arg) for arg in sys.argv[1:]] or DEFAULT_BATCH_SIZES
+    binary = build(tempfile.mkdtemp())
+    print('%6s %11s %11s %11s %7s %11s %11s %9s' % ('batch', 'JSON bytes', 'CBOR bytes', 'CBOR binary', 'ratio',
+                                                   'JSON us', 'CBOR us', 'speedup'))
+    for batch_size in batch_sizes:
+        json_text, json_ns = run(binary, 'json', batch_size)
+        cbor_text, cbor_ns = run(binary, 'cbor', batch_size)
+        cbor_binary = check(json_text, cbor_text)
+        print('%6d %11d %11d %11d %6.2fx %11.2f %11.2f %8.2fx' % (
+            batch_size, len(json_text), len(cbor_text), cbor_binary, len(json_text) / float(len(cbor_text)),
+            json_ns / 1000.0, cbor_ns / 1000.0, json_ns / cbor_ns))
+    print('\nAll CBOR messages decode to their JSON message')
+
+
+if __name__ == '__main__':
+    main()
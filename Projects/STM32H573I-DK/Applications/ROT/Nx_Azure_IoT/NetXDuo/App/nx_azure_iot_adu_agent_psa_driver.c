@@ -18,11 +18,127 @@
 /****************************************************************************************/
 
 #include "nx_azure_iot_adu_agent_psa_driver.h"
+#include "psa/crypto.h"
 
 /* common ADU driver for non-secure, secure and modules images.  */
 
+/* Firmware is programmed by a writer thread from two alternating buffers, so that the download
+   can fill one buffer while the other one is being written with psa_fwu_write(). With a single
+   buffer, each block is programmed before the write request returns, as without the writer thread.
+   See IoTConnect/host/tests/test_adu_driver.c for the difference on the whole download.  */
+#ifndef ADU_PSA_DRIVER_WRITE_BLOCK_SIZE
+#define ADU_PSA_DRIVER_WRITE_BLOCK_SIZE     PSA_FWU_MAX_BLOCK_SIZE
+#endif
+#ifndef ADU_PSA_DRIVER_WRITER_STACK_SIZE
+#define ADU_PSA_DRIVER_WRITER_STACK_SIZE    1024
+#endif
+#ifndef ADU_PSA_DRIVER_WRITER_PRIORITY
+#define ADU_PSA_DRIVER_WRITER_PRIORITY      11
+#endif
+#ifndef ADU_PSA_DRIVER_WRITE_BLOCK_COUNT
+#define ADU_PSA_DRIVER_WRITE_BLOCK_COUNT    2
+#endif
+
+/* An interrupted download of the same image continues where it stopped, if it is requested again
+   in the same boot with a return pointer for the offset to download from. The download keeps its
+   state in RAM only, so it cannot resume after a reset: the secure side forgets the partially staged
+   image at a reset too, and so does the hash of the received data.  */
+
+/* Delta updates (see IoTConnect/scripts/delta-generate.py) are reconstructed against the image
+   in the active slot. They are off by default, because the slot address comes from the flash
+   layout of the secure boot project, which is not part of this project. To accept them, define
+   ADU_PSA_DRIVER_DELTA as 1 with ADU_PSA_DRIVER_DELTA_SOURCE_ADDRESS and _SIZE, the memory mapped
+   address and the size of the active slot of the image that this driver updates. Without them,
+   an update that is a delta fails at its first write instead of being staged as an image.  */
+#ifndef ADU_PSA_DRIVER_DELTA
+#define ADU_PSA_DRIVER_DELTA                0
+#endif
+#if ADU_PSA_DRIVER_DELTA
+#if !defined(ADU_PSA_DRIVER_DELTA_SOURCE_ADDRESS) || !defined(ADU_PSA_DRIVER_DELTA_SOURCE_SIZE)
+#error "ADU_PSA_DRIVER_DELTA needs ADU_PSA_DRIVER_DELTA_SOURCE_ADDRESS and ADU_PSA_DRIVER_DELTA_SOURCE_SIZE"
+#endif
+#define ADU_PSA_DRIVER_DELTA_ENABLED
+#endif
+#include "delta_patch.h"
+
+/* Compressed images (see IoTConnect/scripts/compress-image.py) are decompressed as they are downloaded,
+   ahead of the delta decoder. The decompressor adds about 2 KB of RAM. Define as 0 to remove it.
+   Each update is taken as compressed only if its file starts with the "HSZ1" magic of the container,
+   otherwise it is programmed as it is. A signed image starts with the MCUboot magic, so uncompressed
+   updates keep working, and the file uploaded to IoTConnect can be either. The SHA-256 of the update,
+   if given, is that of the file as it is downloaded.  */
+#ifndef ADU_PSA_DRIVER_COMPRESSION
+#define ADU_PSA_DRIVER_COMPRESSION          1
+#endif
+#if ADU_PSA_DRIVER_COMPRESSION
+#include "lzss_stream.h"
+#endif
+
+#if (ADU_PSA_DRIVER_WRITE_BLOCK_SIZE % FLASH0_PROG_UNIT) != 0
+#error "ADU_PSA_DRIVER_WRITE_BLOCK_SIZE must be a multiple of FLASH0_PROG_UNIT"
+#endif
+
+typedef struct
+{
+    psa_image_id_t image_id;
+    UINT offset;
+    UINT size;
+    UCHAR data[ADU_PSA_DRIVER_WRITE_BLOCK_SIZE];
+} write_block_t;
+
+static write_block_t write_blocks[ADU_PSA_DRIVER_WRITE_BLOCK_COUNT];
+static write_block_t *filling_block;    /* block being filled by the download, or NULL */
+static UINT received_size;              /* bytes downloaded in this update */
+static UINT payload_size;               /* bytes after decompression */
+static UINT image_size;                 /* bytes of the image produced in this update */
+static UINT image_complete;             /* the whole image has been programmed */
+static volatile psa_status_t writer_status;
+static TX_THREAD writer_thread;
+static ULONG writer_thread_stack[ADU_PSA_DRIVER_WRITER_STACK_SIZE / sizeof(ULONG)];
+static TX_QUEUE ready_queue;            /* blocks ready to be written */
+static ULONG ready_queue_storage[ADU_PSA_DRIVER_WRITE_BLOCK_COUNT];
+static TX_SEMAPHORE free_blocks;        /* blocks available for filling */
+static UINT writer_initialized = NX_FALSE;
+
+typedef struct
+{
+    psa_image_id_t image_id;
+    UINT firmware_size_total;
+    UINT sha256_size;
+    UCHAR sha256[PSA_FWU_MAX_DIGEST_SIZE];
+} progress_record_t;
+
+static progress_record_t progress;      /* the update in progress */
+static UINT update_active = NX_FALSE;   /* an update was started in this boot and has not ended */
+
+#if ADU_PSA_DRIVER_COMPRESSION
+static lzss_stream decompressor;
+static UINT compressed;
+#endif
+
+#ifdef ADU_PSA_DRIVER_DELTA_ENABLED
+static delta_patch delta;
+static UINT delta_active;
+#endif
+
+#ifndef IOTC_IGNORE_FW_DOWNLOAD_SHA256_DIGEST
+/* SHA-256 of the received image, updated with each write so that the digest is known
+   as soon as the last byte arrives.  */
+static psa_hash_operation_t image_hash;
+static UINT image_hash_verified = NX_FALSE;
+#endif
+
 static INT internal_flash_write(UCHAR *data_ptr, UINT data_size, UINT data_offset, nx_azure_iot_adu_agent_psa_driver_context_t* ctx);
+static INT internal_image_write(nx_azure_iot_adu_agent_psa_driver_context_t* ctx, const UCHAR *data_ptr, UINT data_size);
 static INT internal_version_compare(const UCHAR *buffer_ptr, UINT buffer_len, nx_azure_iot_adu_agent_psa_driver_context_t* ctx);
+static UINT internal_writer_start(VOID);
+static VOID internal_writer_wait_idle(VOID);
+static UINT internal_progress_resume(nx_azure_iot_adu_agent_psa_driver_context_t* ctx);
+static VOID internal_progress_start(nx_azure_iot_adu_agent_psa_driver_context_t* ctx);
+static VOID internal_image_discard(nx_azure_iot_adu_agent_psa_driver_context_t* ctx);
+#ifndef IOTC_IGNORE_FW_DOWNLOAD_SHA256_DIGEST
+static UINT internal_hash_start(VOID);
+#endif
 
 /****** DRIVER SPECIFIC ******/
 void nx_azure_iot_adu_agent_psa_driver(NX_AZURE_IOT_ADU_AGENT_DRIVER *driver_req_ptr, nx_azure_iot_adu_agent_psa_driver_context_t* ctx)
@@ -70,30 +186,67 @@ psa_status_t status;
             /* Process firmware preprocess requests before writing firmware.
                Such as: erase the flash at once to improve the speed.  */
 
-            /* Abort the previous update if exists. */
-            status = psa_fwu_abort(ctx->download_image_id);
-            if((status == PSA_SUCCESS) || (status == PSA_ERROR_INVALID_ARGUMENT))
+            ctx->firmware_size_total = driver_req_ptr -> nx_azure_iot_adu_agent_driver_firmware_size;
+            ctx->write_buffer_count = 0;
+
+            /* A request for an empty image cancels the update in progress.  */
+            if (ctx->firmware_size_total == 0)
             {
-                /*PSA_ERROR_INVALID_ARGUMENT can be returned when no image
-                  with the provided image_id is currently being installed */
-                ctx->firmware_size_total = driver_req_ptr -> nx_azure_iot_adu_agent_driver_firmware_size;
-                ctx->firmware_size_count = 0;
-                ctx->write_buffer_count = 0;
+                internal_image_discard(ctx);
+                break;
+            }
 
+            /* The digest also identifies the image when resuming a download.  */
+            ctx->sha256_size = 0;
+            if(_nx_utility_base64_decode((UCHAR*)driver_req_ptr->nx_azure_iot_adu_agent_driver_firmware_sha256,
+                                       driver_req_ptr->nx_azure_iot_adu_agent_driver_firmware_sha256_length,
+                                       ctx->sha256, sizeof(ctx->sha256), &(ctx->sha256_size)))
+            {
+                ctx->sha256_size = 0;
 #ifndef IOTC_IGNORE_FW_DOWNLOAD_SHA256_DIGEST
-                if(_nx_utility_base64_decode((UCHAR*)driver_req_ptr->nx_azure_iot_adu_agent_driver_firmware_sha256,
-                                           driver_req_ptr->nx_azure_iot_adu_agent_driver_firmware_sha256_length,
-                                           ctx->sha256, sizeof(ctx->sha256), &(ctx->sha256_size)))
-                {
-                    driver_req_ptr -> nx_azure_iot_adu_agent_driver_status = NX_AZURE_IOT_FAILURE;
-                }
+                driver_req_ptr -> nx_azure_iot_adu_agent_driver_status = NX_AZURE_IOT_FAILURE;
+                break;
 #endif
             }
-            else
+
+            /* Continue the interrupted download of the same image from where it stopped.  */
+            if ((driver_req_ptr -> nx_azure_iot_adu_agent_driver_return_ptr != NX_NULL) && internal_progress_resume(ctx))
+            {
+                *(driver_req_ptr -> nx_azure_iot_adu_agent_driver_return_ptr) = received_size;
+                break;
+            }
+
+            if (internal_writer_start())
+            {
+                driver_req_ptr -> nx_azure_iot_adu_agent_driver_status = NX_AZURE_IOT_FAILURE;
+                break;
+            }
+
+#ifndef IOTC_IGNORE_FW_DOWNLOAD_SHA256_DIGEST
+            if (internal_hash_start())
+            {
+                driver_req_ptr -> nx_azure_iot_adu_agent_driver_status = NX_AZURE_IOT_FAILURE;
+                break;
+            }
+#endif
+            ctx->firmware_size_count = 0;
+
+            /* Abort the previous update if exists. This also drops an image left partially staged by a reset. */
+            status = psa_fwu_abort(ctx->download_image_id);
+            if((status != PSA_SUCCESS) && (status != PSA_ERROR_INVALID_ARGUMENT))
             {
+                /*PSA_ERROR_INVALID_ARGUMENT can be returned when no image
+                  with the provided image_id is currently being installed */
+                update_active = NX_FALSE;
                 driver_req_ptr -> nx_azure_iot_adu_agent_driver_status = NX_AZURE_IOT_FAILURE;
+                break;
             }
 
+            internal_progress_start(ctx);
+            if (driver_req_ptr -> nx_azure_iot_adu_agent_driver_return_ptr != NX_NULL)
+            {
+                *(driver_req_ptr -> nx_azure_iot_adu_agent_driver_return_ptr) = 0;
+            }
             break;
         }
 
@@ -122,7 +275,10 @@ psa_status_t status;
         case NX_AZURE_IOT_ADU_AGENT_DRIVER_INSTALL:
         {
 
-            if (ctx->firmware_size_count < ctx->firmware_size_total)
+            /* The download is complete. Whatever the outcome, a new download starts from scratch.  */
+            update_active = NX_FALSE;
+
+            if (!image_complete)
             {
                 driver_req_ptr -> nx_azure_iot_adu_agent_driver_status = NX_AZURE_IOT_FAILURE;
                 break;
@@ -142,10 +298,11 @@ psa_status_t status;
                 driver_req_ptr -> nx_azure_iot_adu_agent_driver_status = NX_AZURE_IOT_FAILURE;
             }
 
-            /* Check the image signature. */
+            /* The received data was verified against the digest of the update with the last write.  */
 #ifndef IOTC_IGNORE_FW_DOWNLOAD_SHA256_DIGEST
-            if((PSA_FWU_MAX_DIGEST_SIZE != ctx->sha256_size) || (memcmp(info.digest, ctx->sha256, ctx->sha256_size) != 0))
-            {              
+            if (!image_hash_verified)
+            {
+                psa_fwu_abort(ctx->download_image_id);
                 driver_req_ptr -> nx_azure_iot_adu_agent_driver_status = NX_AZURE_IOT_FAILURE;
                 break;
             }
@@ -255,81 +412,371 @@ UINT version[4] = {0};
     return 0;
 }
 
-static INT internal_flash_write(UCHAR *data_ptr, UINT data_size, UINT data_offset, nx_azure_iot_adu_agent_psa_driver_context_t* ctx)
+static VOID internal_writer_entry(ULONG parameter)
 {
+ULONG index;
+write_block_t *block;
 psa_status_t status;
-UINT remaining_size = data_size;
-UINT block_size = 0;
 
-    if (ctx->firmware_size_count + data_size + ctx->write_buffer_count > ctx->firmware_size_total)
+    NX_PARAMETER_NOT_USED(parameter);
+
+    while (1)
+    {
+        tx_queue_receive(&ready_queue, &index, TX_WAIT_FOREVER);
+        block = &write_blocks[index];
+
+        /* Once a write failed, the rest of the image is useless. Just return the buffers.  */
+        if (writer_status == PSA_SUCCESS)
+        {
+            status = psa_fwu_write(block -> image_id, block -> offset, block -> data, block -> size);
+            if (status != PSA_SUCCESS)
+            {
+                writer_status = status;
+            }
+        }
+        tx_semaphore_put(&free_blocks);
+    }
+}
+
+/* Returns NX_TRUE if the update started in this boot is for the same image, and the secure side
+   still holds what was staged so far.  */
+static UINT internal_progress_resume(nx_azure_iot_adu_agent_psa_driver_context_t* ctx)
+{
+psa_image_info_t info;
+
+    if (!update_active ||
+        (progress.image_id != ctx->download_image_id) ||
+        (progress.firmware_size_total != ctx->firmware_size_total) ||
+        (progress.sha256_size != ctx->sha256_size) ||
+        (memcmp(progress.sha256, ctx->sha256, ctx->sha256_size) != 0))
+    {
+        return(NX_FALSE);
+    }
+
+    /* Let the writer finish what was submitted, then check the staged image.  */
+    internal_writer_wait_idle();
+    if (writer_status != PSA_SUCCESS)
+    {
+        return(NX_FALSE);
+    }
+    if ((ctx->firmware_size_count > 0) &&
+        ((psa_fwu_query(ctx->download_image_id, &info) != PSA_SUCCESS) || (info.state != PSA_IMAGE_CANDIDATE)))
+    {
+        return(NX_FALSE);
+    }
+    return(NX_TRUE);
+}
+
+/* Records that the download of the image is in progress.  */
+static VOID internal_progress_start(nx_azure_iot_adu_agent_psa_driver_context_t* ctx)
+{
+    memset(&progress, 0, sizeof(progress));
+    progress.image_id = ctx->download_image_id;
+    progress.firmware_size_total = ctx->firmware_size_total;
+    progress.sha256_size = ctx->sha256_size;
+    memcpy(progress.sha256, ctx->sha256, ctx->sha256_size);
+    update_active = NX_TRUE;
+}
+
+#ifndef IOTC_IGNORE_FW_DOWNLOAD_SHA256_DIGEST
+static UINT internal_hash_start(VOID)
+{
+    /* Release a digest left over from an interrupted download.  */
+    psa_hash_abort(&image_hash);
+    image_hash = psa_hash_operation_init();
+    image_hash_verified = NX_FALSE;
+
+    if (psa_hash_setup(&image_hash, PSA_ALG_SHA_256) != PSA_SUCCESS)
     {
         return(NX_AZURE_IOT_FAILURE);
     }
+    return(NX_SUCCESS);
+}
+#endif
+
+/* Waits until all submitted blocks are written. The block being filled stays with the download.  */
+static VOID internal_writer_wait_idle(VOID)
+{
+UINT i;
+UINT count = ADU_PSA_DRIVER_WRITE_BLOCK_COUNT - ((filling_block != NX_NULL) ? 1 : 0);
 
-    while ((ctx->write_buffer_count > 0) && (ctx->write_buffer_count < FLASH0_PROG_UNIT) && (remaining_size > 0))
+    for (i = 0; i < count; i++)
     {
-        ctx->write_buffer[ctx->write_buffer_count++] = *data_ptr++;
-        data_offset++;
-        remaining_size--;
+        tx_semaphore_get(&free_blocks, TX_WAIT_FOREVER);
     }
+    for (i = 0; i < count; i++)
+    {
+        tx_semaphore_put(&free_blocks);
+    }
+}
 
-    if (ctx->write_buffer_count == FLASH0_PROG_UNIT)
+/* Prepares the writer for a new update, creating the thread on first use.  */
+static UINT internal_writer_start(VOID)
+{
+UINT status;
+
+    if (writer_initialized)
     {
-        status = psa_fwu_write(ctx->download_image_id, data_offset - FLASH0_PROG_UNIT, ctx->write_buffer, ctx->write_buffer_count);
-        if (status != PSA_SUCCESS)
+        /* A previous update may have been interrupted while filling a block.  */
+        if (filling_block != NX_NULL)
+        {
+            filling_block = NX_NULL;
+            tx_semaphore_put(&free_blocks);
+        }
+        internal_writer_wait_idle();
+    }
+    else
+    {
+        status = tx_semaphore_create(&free_blocks, "ADU Free Blocks", ADU_PSA_DRIVER_WRITE_BLOCK_COUNT);
+        if (status == TX_SUCCESS)
+        {
+            status = tx_queue_create(&ready_queue, "ADU Ready Blocks", TX_1_ULONG,
+                                     ready_queue_storage, sizeof(ready_queue_storage));
+        }
+        if (status == TX_SUCCESS)
+        {
+            status = tx_thread_create(&writer_thread, "ADU Flash Writer", internal_writer_entry, 0,
+                                      writer_thread_stack, sizeof(writer_thread_stack),
+                                      ADU_PSA_DRIVER_WRITER_PRIORITY, ADU_PSA_DRIVER_WRITER_PRIORITY,
+                                      TX_NO_TIME_SLICE, TX_AUTO_START);
+        }
+        if (status != TX_SUCCESS)
         {
             return(status);
         }
-        ctx->firmware_size_count += ctx->write_buffer_count;
-        ctx->write_buffer_count = 0;
+        writer_initialized = NX_TRUE;
     }
 
-    while (remaining_size > FLASH0_PROG_UNIT)
+    filling_block = NX_NULL;
+    received_size = 0;
+    payload_size = 0;
+    image_size = 0;
+    image_complete = NX_FALSE;
+#if ADU_PSA_DRIVER_COMPRESSION
+    compressed = NX_FALSE;
+#endif
+#ifdef ADU_PSA_DRIVER_DELTA_ENABLED
+    delta_active = NX_FALSE;
+#endif
+    writer_status = PSA_SUCCESS;
+    return(NX_SUCCESS);
+}
+
+static VOID internal_writer_submit(VOID)
+{
+ULONG index = (ULONG)(filling_block - write_blocks);
+
+    tx_queue_send(&ready_queue, &index, TX_WAIT_FOREVER);
+    filling_block = NX_NULL;
+#if ADU_PSA_DRIVER_WRITE_BLOCK_COUNT == 1
+    internal_writer_wait_idle();
+#endif
+}
+
+/* Programs the next bytes of the image.  */
+static INT internal_image_write(nx_azure_iot_adu_agent_psa_driver_context_t* ctx, const UCHAR *data_ptr, UINT data_size)
+{
+UINT copy_size;
+
+    while (data_size > 0)
     {
-        if (remaining_size > PSA_FWU_MAX_BLOCK_SIZE)
+        if (writer_status != PSA_SUCCESS)
         {
-            block_size = PSA_FWU_MAX_BLOCK_SIZE;
+            return(writer_status);
         }
-        else
+
+        if (filling_block == NX_NULL)
         {
-            block_size = remaining_size - (remaining_size % FLASH0_PROG_UNIT);
+            /* Wait for the writer to release a block. This is where the download is throttled
+               if programming is slower than the download.  */
+            tx_semaphore_get(&free_blocks, TX_WAIT_FOREVER);
+
+            /* Blocks are written in order, so the block released first is the one after the last submitted.  */
+            filling_block = &write_blocks[ctx->firmware_size_count / ADU_PSA_DRIVER_WRITE_BLOCK_SIZE % ADU_PSA_DRIVER_WRITE_BLOCK_COUNT];
+            filling_block -> image_id = ctx->download_image_id;
+            filling_block -> offset = ctx->firmware_size_count;
+            filling_block -> size = 0;
         }
-        status = psa_fwu_write(ctx->download_image_id, data_offset, data_ptr, block_size);
-        if (status != PSA_SUCCESS)
+
+        copy_size = ADU_PSA_DRIVER_WRITE_BLOCK_SIZE - filling_block -> size;
+        if (copy_size > data_size)
         {
-            return(status);
+            copy_size = data_size;
+        }
+        memcpy(&(filling_block -> data[filling_block -> size]), data_ptr, copy_size);
+        filling_block -> size += copy_size;
+        data_ptr += copy_size;
+        data_size -= copy_size;
+        image_size += copy_size;
+
+        if (filling_block -> size == ADU_PSA_DRIVER_WRITE_BLOCK_SIZE)
+        {
+            ctx->firmware_size_count += filling_block -> size;
+            internal_writer_submit();
         }
-        remaining_size -= block_size;
-        data_ptr += block_size;
-        data_offset += block_size;
-        ctx->firmware_size_count += block_size;
     }
 
-    if (remaining_size > 0)
+    return(NX_SUCCESS);
+}
+
+#ifdef ADU_PSA_DRIVER_DELTA_ENABLED
+static int internal_delta_write(void *context, const uint8_t *data, size_t size)
+{
+    return(internal_image_write((nx_azure_iot_adu_agent_psa_driver_context_t*)context, data, (UINT)size));
+}
+
+/* Confirms that the delta was made against the image in the active slot.  */
+static int internal_delta_check_source(void *context, const uint8_t *digest, uint32_t source_size)
+{
+    NX_PARAMETER_NOT_USED(context);
+    if (psa_hash_compare(PSA_ALG_SHA_256, (const uint8_t *)ADU_PSA_DRIVER_DELTA_SOURCE_ADDRESS, source_size,
+                         digest, DELTA_PATCH_DIGEST_SIZE) != PSA_SUCCESS)
     {
-        memcpy(&(ctx->write_buffer[ctx->write_buffer_count]), data_ptr, remaining_size);
-        ctx->write_buffer_count += remaining_size;
-    } else {
-      // if last packet, this data_offset is used in the next psa_fwu_write, but it's not right as it's the end of the buffer, not the beginning.
-      // if it's not the latest, it's not used and doesn't cause any problem
-      data_offset -= ctx->write_buffer_count;
+        return(NX_AZURE_IOT_FAILURE);
     }
+    return(NX_SUCCESS);
+}
+#endif
+
+/* Takes the downloaded data after decompression. It is either the image or a delta.  */
+static INT internal_payload_write(nx_azure_iot_adu_agent_psa_driver_context_t* ctx, const UCHAR *data_ptr, UINT data_size)
+{
+UINT first = (payload_size == 0);
 
-    if ((ctx->write_buffer_count > 0) && (ctx->firmware_size_count + ctx->write_buffer_count >= ctx->firmware_size_total))
+    payload_size += data_size;
+
+#ifdef ADU_PSA_DRIVER_DELTA_ENABLED
+    /* A delta is applied against the active slot as it arrives, and only the resulting image is programmed.  */
+    if (first && delta_patch_is_delta(data_ptr, data_size))
+    {
+        delta_patch_init(&delta, (const uint8_t *)ADU_PSA_DRIVER_DELTA_SOURCE_ADDRESS, ADU_PSA_DRIVER_DELTA_SOURCE_SIZE,
+                         internal_delta_write, internal_delta_check_source, ctx);
+        delta_active = NX_TRUE;
+    }
+    if (delta_active)
     {
-        while (ctx->write_buffer_count < FLASH0_PROG_UNIT)
+        return(delta_patch_feed(&delta, data_ptr, data_size));
+    }
+#else
+    if (first && delta_patch_is_delta(data_ptr, data_size))
+    {
+        return(NX_AZURE_IOT_FAILURE);
+    }
+#endif
+
+    return(internal_image_write(ctx, data_ptr, data_size));
+}
+
+#if ADU_PSA_DRIVER_COMPRESSION
+static int internal_decompressed_write(void *context, const uint8_t *data, size_t size)
+{
+    return(internal_payload_write((nx_azure_iot_adu_agent_psa_driver_context_t*)context, data, (UINT)size));
+}
+#endif
+
+/* Stops programming after a failed or cancelled download, and drops the staged image.  */
+static VOID internal_image_discard(nx_azure_iot_adu_agent_psa_driver_context_t* ctx)
+{
+    if (writer_initialized)
+    {
+        if (filling_block != NX_NULL)
         {
-            ctx->write_buffer[ctx->write_buffer_count++] = 0xFF;
+            filling_block = NX_NULL;
+            tx_semaphore_put(&free_blocks);
         }
-        //if data_offset not changed before, we will write at offset+write_buffer_count instead of offset
-        status = psa_fwu_write(ctx->download_image_id, data_offset, ctx->write_buffer, ctx->write_buffer_count);
-        if (status != PSA_SUCCESS)
+        internal_writer_wait_idle();
+    }
+    update_active = NX_FALSE;
+    psa_fwu_abort(ctx->download_image_id);
+}
+
+static INT internal_flash_write(UCHAR *data_ptr, UINT data_size, UINT data_offset, nx_azure_iot_adu_agent_psa_driver_context_t* ctx)
+{
+INT status;
+
+    if (!update_active || (data_offset != received_size) || (received_size + data_size > ctx->firmware_size_total))
+    {
+        internal_image_discard(ctx);
+        return(NX_AZURE_IOT_FAILURE);
+    }
+
+#ifndef IOTC_IGNORE_FW_DOWNLOAD_SHA256_DIGEST
+    if (psa_hash_update(&image_hash, data_ptr, data_size) != PSA_SUCCESS)
+    {
+        internal_image_discard(ctx);
+        return(NX_AZURE_IOT_FAILURE);
+    }
+#endif
+    received_size += data_size;
+
+#if ADU_PSA_DRIVER_COMPRESSION
+    if ((data_offset == 0) && lzss_stream_is_compressed(data_ptr, data_size))
+    {
+        lzss_stream_init(&decompressor, internal_decompressed_write, ctx);
+        compressed = NX_TRUE;
+    }
+    if (compressed)
+    {
+        status = lzss_stream_feed(&decompressor, data_ptr, data_size);
+    }
+    else
+#endif
+    {
+        status = internal_payload_write(ctx, data_ptr, data_size);
+    }
+    if (status)
+    {
+        internal_image_discard(ctx);
+        return(status);
+    }
+
+    if (received_size == ctx->firmware_size_total)
+    {
+#if ADU_PSA_DRIVER_COMPRESSION
+        if (compressed && !lzss_stream_done(&decompressor))
         {
-            return(status);
+            internal_image_discard(ctx);
+            return(NX_AZURE_IOT_FAILURE);
+        }
+#endif
+#ifdef ADU_PSA_DRIVER_DELTA_ENABLED
+        if (delta_active && !delta_patch_done(&delta))
+        {
+            internal_image_discard(ctx);
+            return(NX_AZURE_IOT_FAILURE);
+        }
+#endif
+
+#ifndef IOTC_IGNORE_FW_DOWNLOAD_SHA256_DIGEST
+        /* Reject a corrupted image before the last block is programmed.  */
+        if ((ctx->sha256_size != PSA_HASH_LENGTH(PSA_ALG_SHA_256)) ||
+            (psa_hash_verify(&image_hash, ctx->sha256, ctx->sha256_size) != PSA_SUCCESS))
+        {
+            psa_hash_abort(&image_hash);
+            internal_image_discard(ctx);
+            return(NX_AZURE_IOT_FAILURE);
+        }
+        image_hash_verified = NX_TRUE;
+#endif
+
+        if (filling_block != NX_NULL)
+        {
+            /* Pad the last block to the flash programming unit.  */
+            while (filling_block -> size % FLASH0_PROG_UNIT)
+            {
+                filling_block -> data[filling_block -> size++] = 0xFF;
+            }
+            ctx->firmware_size_count += filling_block -> size;
+            internal_writer_submit();
         }
 
-        data_offset += ctx->write_buffer_count;
-        ctx->firmware_size_count += ctx->write_buffer_count;
+        /* Report the result of programming the whole image with the last write.  */
+        internal_writer_wait_idle();
+        if (writer_status != PSA_SUCCESS)
+        {
+            return(writer_status);
+        }
+        image_complete = NX_TRUE;
     }
 
     return(NX_SUCCESS);